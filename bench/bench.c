@@ -0,0 +1,492 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "zipf_corpus.h"
+#include "hashtable.h"
+#include "text_processor.h"
+#include "vector_math.h"
+#include "file_manager.h"
+#include "sim_stats.h"
+
+// 微基准与规模测试。
+//   bench [--quick] [--sizes 100,1000,...] [--words N] [--cjk R] [--matrix-mb MB]
+//         [--json 输出] [--compare 基线] [--threshold 0.1]
+//   bench gen <目录> [--docs N] [--words N] [--vocab N] [--cjk R] [--zipf S] [--seed S]
+//
+// 每项结果为 ns/op；--compare 读取之前 --json 写出的文件，
+// 慢于基线超过 threshold 的项标记为回归，并以退出码 1 结束。
+
+#define WORD_STREAM 100000
+#define MICRO_DOCS 200
+#define MAX_RESULTS 64
+#define MAX_SIZES 16
+
+typedef struct BenchResult {
+    char name[48];
+    size_t size;
+    uint64_t iterations;
+    double ns_per_op;
+    bool sampled;
+} BenchResult;
+
+typedef struct BenchConfig {
+    double min_time_ns;
+    size_t sizes[MAX_SIZES];
+    size_t size_count;
+    size_t matrix_budget;       // 完整矩阵的字节上限，超过时只抽样计算前若干行
+    ZipfCorpusOptions corpus;
+    const char *json_path;
+    const char *compare_path;
+    double threshold;
+} BenchConfig;
+
+typedef struct BenchRun {
+    BenchResult results[MAX_RESULTS];
+    size_t count;
+} BenchRun;
+
+// 单次执行基准主体；返回完成的操作数，*elapsed 为计入的耗时（不含准备与清理）
+typedef uint64_t (*BenchFn)(void *ctx, uint64_t *elapsed);
+
+static void record(BenchRun *run, const char *name, size_t size, uint64_t ops, uint64_t ns, bool sampled) {
+    if (run->count >= MAX_RESULTS || ops == 0) return;
+    BenchResult *r = &run->results[run->count++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->size = size;
+    r->iterations = ops;
+    r->ns_per_op = (double)ns / (double)ops;
+    r->sampled = sampled;
+    printf("  %-28s %8zu %14.1f ns/op %14.0f ops/s%s\n", name, size, r->ns_per_op,
+           r->ns_per_op > 0 ? 1e9 / r->ns_per_op : 0.0, sampled ? "  (抽样)" : "");
+    fflush(stdout);
+}
+
+// 预热一次后重复执行，直到累计耗时达到 min_time
+static void measure(BenchRun *run, const BenchConfig *config, const char *name, size_t size,
+                    BenchFn fn, void *ctx) {
+    uint64_t elapsed = 0;
+    fn(ctx, &elapsed);
+
+    uint64_t ops = 0, total = 0;
+    while (total < (uint64_t)config->min_time_ns) {
+        elapsed = 0;
+        ops += fn(ctx, &elapsed);
+        total += elapsed;
+    }
+    record(run, name, size, ops, total, false);
+}
+
+// ---------- 微基准 ----------
+
+typedef struct WordsCtx {
+    const char **words;
+    size_t count;
+    HashTable *table;
+} WordsCtx;
+
+static uint64_t bench_hash_insert(void *ctx, uint64_t *elapsed) {
+    WordsCtx *w = (WordsCtx*)ctx;
+    HashTable *table = hash_table_create(101);
+    uint64_t start = similarity_stats_now();
+    for (size_t i = 0; i < w->count; i++) {
+        hash_table_insert(table, w->words[i], 1);
+    }
+    *elapsed = similarity_stats_now() - start;
+    hash_table_destroy(table);
+    return w->count;
+}
+
+static uint64_t bench_hash_get(void *ctx, uint64_t *elapsed) {
+    WordsCtx *w = (WordsCtx*)ctx;
+    volatile int sink = 0;
+    uint64_t start = similarity_stats_now();
+    for (size_t i = 0; i < w->count; i++) {
+        sink += hash_table_get(w->table, w->words[i]);
+    }
+    *elapsed = similarity_stats_now() - start;
+    (void)sink;
+    return w->count;
+}
+
+typedef struct TextCtx {
+    char *text;
+} TextCtx;
+
+static uint64_t bench_next_word(void *ctx, uint64_t *elapsed) {
+    TextCtx *t = (TextCtx*)ctx;
+    char *cursor = t->text;
+    char *word;
+    uint64_t count = 0;
+    uint64_t start = similarity_stats_now();
+    while ((word = get_next_word(&cursor)) != NULL) {
+        free(word);
+        count++;
+    }
+    *elapsed = similarity_stats_now() - start;
+    return count;
+}
+
+typedef struct DocsCtx {
+    char **texts;
+    size_t *lengths;
+    size_t count;
+    StopWords *stop_words;
+    Document **docs;
+} DocsCtx;
+
+static uint64_t bench_document_process(void *ctx, uint64_t *elapsed) {
+    DocsCtx *d = (DocsCtx*)ctx;
+    uint64_t total = 0;
+    for (size_t i = 0; i < d->count; i++) {
+        uint64_t start = similarity_stats_now();
+        Document *doc = document_create_from_buffer("bench.txt", d->texts[i], d->lengths[i]);
+        document_process(doc, d->stop_words);
+        total += similarity_stats_now() - start;
+        document_destroy(doc);
+    }
+    *elapsed = total;
+    return d->count;
+}
+
+static uint64_t bench_cosine(void *ctx, uint64_t *elapsed) {
+    DocsCtx *d = (DocsCtx*)ctx;
+    volatile double sink = 0.0;
+    uint64_t start = similarity_stats_now();
+    for (size_t i = 0; i + 1 < d->count; i++) {
+        sink += document_cosine_similarity(d->docs[i], d->docs[i + 1]);
+    }
+    *elapsed = similarity_stats_now() - start;
+    (void)sink;
+    return d->count - 1;
+}
+
+static uint64_t bench_jaccard(void *ctx, uint64_t *elapsed) {
+    DocsCtx *d = (DocsCtx*)ctx;
+    volatile double sink = 0.0;
+    uint64_t start = similarity_stats_now();
+    for (size_t i = 0; i + 1 < d->count; i++) {
+        sink += jaccard_similarity(d->docs[i]->word_freq, d->docs[i + 1]->word_freq);
+    }
+    *elapsed = similarity_stats_now() - start;
+    (void)sink;
+    return d->count - 1;
+}
+
+static uint64_t bench_vector_cosine(void *ctx, uint64_t *elapsed) {
+    DocsCtx *d = (DocsCtx*)ctx;
+    volatile double sink = 0.0;
+    uint64_t start = similarity_stats_now();
+    for (size_t i = 0; i + 1 < d->count; i++) {
+        sink += document_vector_similarity(d->docs[i], d->docs[i + 1]);
+    }
+    *elapsed = similarity_stats_now() - start;
+    (void)sink;
+    return d->count - 1;
+}
+
+static void run_micro(BenchRun *run, const BenchConfig *config, ZipfCorpus *corpus) {
+    printf("微基准:\n");
+
+    WordsCtx words;
+    words.count = WORD_STREAM;
+    words.words = (const char**)malloc(WORD_STREAM * sizeof(char*));
+    zipf_corpus_sample_words(corpus, words.words, WORD_STREAM, 1);
+    words.table = hash_table_create(101);
+    for (size_t i = 0; i < words.count; i++) hash_table_insert(words.table, words.words[i], 1);
+    measure(run, config, "hash_table_insert", WORD_STREAM, bench_hash_insert, &words);
+    measure(run, config, "hash_table_get", WORD_STREAM, bench_hash_get, &words);
+    hash_table_destroy(words.table);
+    free(words.words);
+
+    DocsCtx docs;
+    docs.count = MICRO_DOCS;
+    docs.texts = (char**)malloc(MICRO_DOCS * sizeof(char*));
+    docs.lengths = (size_t*)malloc(MICRO_DOCS * sizeof(size_t));
+    docs.docs = (Document**)malloc(MICRO_DOCS * sizeof(Document*));
+    docs.stop_words = stop_words_create();
+    for (size_t i = 0; i < MICRO_DOCS; i++) {
+        docs.texts[i] = zipf_corpus_document(corpus, i, &docs.lengths[i]);
+    }
+
+    // 分词基准使用所有文档拼接成的一段文本
+    TextCtx text;
+    size_t text_len = 0;
+    for (size_t i = 0; i < MICRO_DOCS; i++) text_len += docs.lengths[i] + 1;
+    text.text = (char*)malloc(text_len + 1);
+    text_len = 0;
+    for (size_t i = 0; i < MICRO_DOCS; i++) {
+        memcpy(text.text + text_len, docs.texts[i], docs.lengths[i]);
+        text_len += docs.lengths[i];
+        text.text[text_len++] = '\n';
+    }
+    text.text[text_len] = '\0';
+    measure(run, config, "get_next_word", text_len, bench_next_word, &text);
+    free(text.text);
+
+    measure(run, config, "document_process", MICRO_DOCS, bench_document_process, &docs);
+
+    for (size_t i = 0; i < MICRO_DOCS; i++) {
+        docs.docs[i] = document_create_from_buffer("bench.txt", docs.texts[i], docs.lengths[i]);
+        document_process(docs.docs[i], docs.stop_words);
+        document_vector(docs.docs[i]);
+    }
+    measure(run, config, "document_cosine_similarity", MICRO_DOCS, bench_cosine, &docs);
+    measure(run, config, "jaccard_similarity", MICRO_DOCS, bench_jaccard, &docs);
+    measure(run, config, "document_vector_similarity", MICRO_DOCS, bench_vector_cosine, &docs);
+
+    for (size_t i = 0; i < MICRO_DOCS; i++) {
+        document_destroy(docs.docs[i]);
+        free(docs.texts[i]);
+    }
+    free(docs.docs);
+    free(docs.texts);
+    free(docs.lengths);
+    stop_words_destroy(docs.stop_words);
+}
+
+// ---------- 规模测试 ----------
+
+static void run_scaling(BenchRun *run, const BenchConfig *config, ZipfCorpus *corpus, size_t n) {
+    printf("规模 %zu 篇文档:\n", n);
+
+    StopWords *stop_words = stop_words_create();
+    DocumentCollection *col = collection_create(n);
+    uint64_t process_ns = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t len;
+        char *text = zipf_corpus_document(corpus, i, &len);
+        uint64_t start = similarity_stats_now();
+        Document *doc = document_create_from_buffer("bench.txt", text, len);
+        document_process(doc, stop_words);
+        process_ns += similarity_stats_now() - start;
+        free(text);
+        // 正文处理后不再需要，释放以控制大规模测试的内存
+        document_release_content(doc);
+        collection_add_document(col, doc);
+    }
+    record(run, "corpus_process", n, n, process_ns, false);
+
+    uint64_t start = similarity_stats_now();
+    for (size_t i = 0; i < n; i++) document_vector(col->documents[i]);
+    record(run, "corpus_vectorize", n, n, similarity_stats_now() - start, false);
+
+    // 矩阵放得下时完整计算，否则按 similarity_matrix_create 的顺序计算前若干行
+    if (n >= 2 && n * n * sizeof(double) <= config->matrix_budget) {
+        start = similarity_stats_now();
+        SimilarityMatrix *matrix = similarity_matrix_create(col);
+        uint64_t ns = similarity_stats_now() - start;
+        record(run, "similarity_matrix_create", n, (uint64_t)n * (n - 1) / 2, ns, false);
+        similarity_matrix_destroy(matrix);
+    } else if (n >= 2) {
+        // 抽样行数受矩阵预算限制，并在累计时间达到 min_time 的 10 倍后停止
+        size_t rows = config->matrix_budget / sizeof(double) / n;
+        if (rows == 0) rows = 1;
+        if (rows > n - 1) rows = n - 1;
+        double *row = (double*)malloc(n * sizeof(double));
+        uint64_t pairs = 0;
+        start = similarity_stats_now();
+        for (size_t i = 0; i < rows && similarity_stats_now() - start < 10 * config->min_time_ns; i++) {
+            for (size_t j = i + 1; j < n; j++) {
+                row[j] = document_vector_similarity(col->documents[i], col->documents[j]);
+            }
+            pairs += n - i - 1;
+        }
+        record(run, "similarity_matrix_create", n, pairs, similarity_stats_now() - start, true);
+        free(row);
+    }
+
+    collection_destroy(col);
+    stop_words_destroy(stop_words);
+}
+
+// ---------- JSON 与基线比较 ----------
+
+static bool write_json(const BenchRun *run, const BenchConfig *config, const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "错误: 无法写入 %s\n", path);
+        return false;
+    }
+    fprintf(file, "{\"corpus\": {\"words_per_doc\": %zu, \"vocabulary\": %zu, \"zipf\": %.2f, "
+            "\"cjk_ratio\": %.2f, \"seed\": %llu},\n \"results\": [\n",
+            config->corpus.words_per_doc, config->corpus.vocabulary, config->corpus.exponent,
+            config->corpus.cjk_ratio, (unsigned long long)config->corpus.seed);
+    // 每条结果单独一行，便于比较模式逐行读取
+    for (size_t i = 0; i < run->count; i++) {
+        const BenchResult *r = &run->results[i];
+        fprintf(file, "  {\"name\": \"%s\", \"size\": %zu, \"iterations\": %llu, "
+                "\"ns_per_op\": %.3f, \"sampled\": %s}%s\n",
+                r->name, r->size, (unsigned long long)r->iterations, r->ns_per_op,
+                r->sampled ? "true" : "false", i + 1 < run->count ? "," : "");
+    }
+    fprintf(file, " ]}\n");
+    return fclose(file) == 0;
+}
+
+static bool parse_result_line(const char *line, BenchResult *r) {
+    const char *p = strstr(line, "\"name\": \"");
+    if (!p) return false;
+    p += 9;
+    const char *end = strchr(p, '"');
+    if (!end || (size_t)(end - p) >= sizeof(r->name)) return false;
+    memcpy(r->name, p, (size_t)(end - p));
+    r->name[end - p] = '\0';
+
+    const char *size = strstr(line, "\"size\": ");
+    const char *ns = strstr(line, "\"ns_per_op\": ");
+    if (!size || !ns) return false;
+    r->size = (size_t)strtoull(size + 8, NULL, 10);
+    r->ns_per_op = strtod(ns + 13, NULL);
+    return true;
+}
+
+// 返回回归项数；无法读取基线时返回 -1
+static int compare_baseline(const BenchRun *run, const char *path, double threshold) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "错误: 无法打开基线 %s\n", path);
+        return -1;
+    }
+
+    BenchResult baseline[MAX_RESULTS];
+    size_t count = 0;
+    char line[512];
+    while (count < MAX_RESULTS && fgets(line, sizeof(line), file)) {
+        if (parse_result_line(line, &baseline[count])) count++;
+    }
+    fclose(file);
+
+    printf("\n与基线 %s 比较（阈值 %.0f%%）:\n", path, threshold * 100);
+    int regressions = 0;
+    for (size_t i = 0; i < run->count; i++) {
+        const BenchResult *r = &run->results[i];
+        const BenchResult *b = NULL;
+        for (size_t k = 0; k < count && !b; k++) {
+            if (strcmp(baseline[k].name, r->name) == 0 && baseline[k].size == r->size) b = &baseline[k];
+        }
+        if (!b || b->ns_per_op <= 0) {
+            printf("  %-28s %8zu  基线中没有该项\n", r->name, r->size);
+            continue;
+        }
+        double change = r->ns_per_op / b->ns_per_op - 1.0;
+        const char *mark = "";
+        if (change > threshold) {
+            mark = "  <-- 回归";
+            regressions++;
+        } else if (change < -threshold) {
+            mark = "  (提升)";
+        }
+        printf("  %-28s %8zu %12.1f -> %12.1f ns/op %+7.1f%%%s\n",
+               r->name, r->size, b->ns_per_op, r->ns_per_op, change * 100, mark);
+    }
+    return regressions;
+}
+
+// ---------- 命令行 ----------
+
+static size_t parse_sizes(const char *arg, size_t *sizes) {
+    size_t count = 0;
+    char *end;
+    while (*arg && count < MAX_SIZES) {
+        size_t value = (size_t)strtoull(arg, &end, 10);
+        if (end == arg) break;
+        if (value > 0) sizes[count++] = value;
+        arg = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+static int generate_mode(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "用法: %s gen <目录> [--docs N] [--words N] [--vocab N] [--cjk R] [--zipf S] [--seed S]\n",
+                argv[0]);
+        return 1;
+    }
+    ZipfCorpusOptions options = zipf_corpus_default_options();
+    for (int i = 3; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--docs") == 0) options.documents = (size_t)atol(argv[i + 1]);
+        else if (strcmp(argv[i], "--words") == 0) options.words_per_doc = (size_t)atol(argv[i + 1]);
+        else if (strcmp(argv[i], "--vocab") == 0) options.vocabulary = (size_t)atol(argv[i + 1]);
+        else if (strcmp(argv[i], "--cjk") == 0) options.cjk_ratio = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--zipf") == 0) options.exponent = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) options.seed = (uint64_t)strtoull(argv[i + 1], NULL, 10);
+    }
+
+    ZipfCorpus *corpus = zipf_corpus_create(&options);
+    bool ok = corpus && zipf_corpus_write_dir(corpus, argv[2]);
+    zipf_corpus_destroy(corpus);
+    if (ok) printf("已在 %s 生成 %zu 篇文档\n", argv[2], options.documents);
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "gen") == 0) {
+        return generate_mode(argc, argv);
+    }
+
+    BenchConfig config;
+    memset(&config, 0, sizeof(config));
+    config.min_time_ns = 0.3e9;
+    config.size_count = parse_sizes("100,1000,10000,100000", config.sizes);
+    config.matrix_budget = 256UL * 1024 * 1024;
+    config.corpus = zipf_corpus_default_options();
+    config.corpus.words_per_doc = 200;
+    config.threshold = 0.10;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            config.min_time_ns = 0.05e9;
+            config.size_count = parse_sizes("100,1000", config.sizes);
+        } else if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            config.size_count = parse_sizes(argv[++i], config.sizes);
+        } else if (strcmp(argv[i], "--words") == 0 && i + 1 < argc) {
+            config.corpus.words_per_doc = (size_t)atol(argv[++i]);
+        } else if (strcmp(argv[i], "--cjk") == 0 && i + 1 < argc) {
+            config.corpus.cjk_ratio = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--matrix-mb") == 0 && i + 1 < argc) {
+            config.matrix_budget = (size_t)atol(argv[++i]) * 1024 * 1024;
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            config.json_path = argv[++i];
+        } else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            config.compare_path = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            config.threshold = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "未知参数: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    ZipfCorpus *corpus = zipf_corpus_create(&config.corpus);
+    if (!corpus) {
+        fprintf(stderr, "错误: 无法创建语料生成器\n");
+        return 1;
+    }
+
+    printf("语料: 平均 %zu 词/篇, 词表 %zu, Zipf 指数 %.2f, 中文比例 %.2f\n",
+           config.corpus.words_per_doc, config.corpus.vocabulary, config.corpus.exponent,
+           config.corpus.cjk_ratio);
+
+    BenchRun run;
+    run.count = 0;
+    run_micro(&run, &config, corpus);
+    for (size_t i = 0; i < config.size_count; i++) {
+        run_scaling(&run, &config, corpus, config.sizes[i]);
+    }
+    zipf_corpus_destroy(corpus);
+
+    if (config.json_path && write_json(&run, &config, config.json_path)) {
+        printf("结果已写入 %s\n", config.json_path);
+    }
+
+    if (config.compare_path) {
+        int regressions = compare_baseline(&run, config.compare_path, config.threshold);
+        if (regressions < 0) return 1;
+        if (regressions > 0) {
+            printf("发现 %d 项性能回归\n", regressions);
+            return 1;
+        }
+        printf("没有性能回归\n");
+    }
+    return 0;
+}
@@ -0,0 +1,232 @@
+#include "zipf_corpus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define CJK_BASE 0x4E00
+#define CJK_RANGE 4096
+
+static const char *syllables[] = {
+    "ka", "to", "ri", "ne", "mo", "sa", "lu", "pe", "di", "ga",
+    "ro", "vi", "an", "el", "ost", "ur", "bre", "cla", "fin", "gor",
+    "hal", "jen", "kul", "mar", "nor", "pil", "qua", "ser", "tav", "wex"
+};
+#define SYLLABLE_COUNT (sizeof(syllables) / sizeof(syllables[0]))
+
+struct ZipfCorpus {
+    ZipfCorpusOptions options;
+    double *cdf;
+    char **english;
+    char **cjk;
+};
+
+// splitmix64：把种子打散成独立的随机流
+static uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// xorshift64*
+static uint64_t next_random(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static double next_double(uint64_t *state) {
+    return (next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static size_t sample_rank(const ZipfCorpus *corpus, uint64_t *state) {
+    double u = next_double(state);
+    size_t lo = 0, hi = corpus->options.vocabulary - 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (corpus->cdf[mid] < u) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// 排名的双射进制编码保证不同排名得到不同的词
+static char* english_word(size_t rank) {
+    char buffer[64];
+    size_t len = 0;
+    size_t n = rank + 1;
+    while (n > 0 && len + 4 < sizeof(buffer)) {
+        n--;
+        const char *s = syllables[n % SYLLABLE_COUNT];
+        size_t s_len = strlen(s);
+        memcpy(buffer + len, s, s_len);
+        len += s_len;
+        n /= SYLLABLE_COUNT;
+    }
+    buffer[len] = '\0';
+    return strdup(buffer);
+}
+
+static size_t put_cjk(char *out, unsigned index) {
+    unsigned cp = CJK_BASE + index % CJK_RANGE;
+    out[0] = (char)(0xE0 | (cp >> 12));
+    out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[2] = (char)(0x80 | (cp & 0x3F));
+    return 3;
+}
+
+// 双字词：(第一字, 第二字) 与排名一一对应，第二字混入第一字使常用词不集中于同一字
+static char* cjk_word(size_t rank) {
+    char buffer[8];
+    unsigned first = (unsigned)(rank % CJK_RANGE);
+    unsigned second = (unsigned)((rank / CJK_RANGE + first * 7) % CJK_RANGE);
+    size_t len = put_cjk(buffer, first);
+    len += put_cjk(buffer + len, second);
+    buffer[len] = '\0';
+    return strdup(buffer);
+}
+
+ZipfCorpusOptions zipf_corpus_default_options(void) {
+    ZipfCorpusOptions options;
+    options.documents = 1000;
+    options.words_per_doc = 300;
+    options.vocabulary = 50000;
+    options.exponent = 1.0;
+    options.cjk_ratio = 0.0;
+    options.seed = 42;
+    return options;
+}
+
+ZipfCorpus* zipf_corpus_create(const ZipfCorpusOptions *options) {
+    ZipfCorpus *corpus = (ZipfCorpus*)calloc(1, sizeof(ZipfCorpus));
+    if (!corpus) return NULL;
+
+    corpus->options = options ? *options : zipf_corpus_default_options();
+    if (corpus->options.vocabulary == 0) corpus->options.vocabulary = 1;
+    if (corpus->options.vocabulary > (size_t)CJK_RANGE * CJK_RANGE) {
+        corpus->options.vocabulary = (size_t)CJK_RANGE * CJK_RANGE;
+    }
+    if (corpus->options.words_per_doc == 0) corpus->options.words_per_doc = 1;
+    size_t v = corpus->options.vocabulary;
+
+    corpus->cdf = (double*)malloc(v * sizeof(double));
+    corpus->english = (char**)calloc(v, sizeof(char*));
+    corpus->cjk = (char**)calloc(v, sizeof(char*));
+    if (!corpus->cdf || !corpus->english || !corpus->cjk) {
+        zipf_corpus_destroy(corpus);
+        return NULL;
+    }
+
+    double total = 0.0;
+    for (size_t r = 0; r < v; r++) {
+        total += 1.0 / pow((double)(r + 1), corpus->options.exponent);
+        corpus->cdf[r] = total;
+    }
+    for (size_t r = 0; r < v; r++) {
+        corpus->cdf[r] /= total;
+        corpus->english[r] = english_word(r);
+        corpus->cjk[r] = cjk_word(r);
+        if (!corpus->english[r] || !corpus->cjk[r]) {
+            zipf_corpus_destroy(corpus);
+            return NULL;
+        }
+    }
+    corpus->cdf[v - 1] = 1.0;
+    return corpus;
+}
+
+void zipf_corpus_destroy(ZipfCorpus *corpus) {
+    if (!corpus) return;
+    for (size_t r = 0; r < corpus->options.vocabulary; r++) {
+        if (corpus->english) free(corpus->english[r]);
+        if (corpus->cjk) free(corpus->cjk[r]);
+    }
+    free(corpus->english);
+    free(corpus->cjk);
+    free(corpus->cdf);
+    free(corpus);
+}
+
+char* zipf_corpus_document(ZipfCorpus *corpus, size_t index, size_t *len) {
+    if (!corpus) return NULL;
+
+    uint64_t state = mix64(corpus->options.seed ^ mix64(index)) | 1;
+    size_t w = corpus->options.words_per_doc;
+    size_t words = w / 2 + (size_t)(next_random(&state) % (w + 1));
+    if (words == 0) words = 1;
+
+    size_t capacity = words * 16 + 16;
+    char *text = (char*)malloc(capacity);
+    if (!text) return NULL;
+
+    size_t used = 0;
+    size_t clause = 0;
+    size_t clause_target = 0;
+    for (size_t i = 0; i < words; i++) {
+        bool cjk = next_double(&state) < corpus->options.cjk_ratio;
+        const char *word = cjk ? corpus->cjk[sample_rank(corpus, &state)]
+                               : corpus->english[sample_rank(corpus, &state)];
+        size_t word_len = strlen(word);
+
+        if (used + word_len + 2 > capacity) {
+            capacity = capacity * 2 + word_len;
+            char *grown = (char*)realloc(text, capacity);
+            if (!grown) {
+                free(text);
+                return NULL;
+            }
+            text = grown;
+        }
+
+        // 同一分句内的中文词直接相连
+        bool join = cjk && clause > 0 && clause < clause_target;
+        if (used > 0 && !join) text[used++] = ' ';
+        if (cjk) {
+            if (!join) {
+                clause = 0;
+                clause_target = 2 + (size_t)(next_random(&state) % 5);
+            }
+            clause++;
+        } else {
+            clause = 0;
+        }
+        memcpy(text + used, word, word_len);
+        used += word_len;
+    }
+    text[used] = '\0';
+    if (len) *len = used;
+    return text;
+}
+
+void zipf_corpus_sample_words(ZipfCorpus *corpus, const char **words, size_t count, uint64_t seed) {
+    uint64_t state = mix64(seed) | 1;
+    for (size_t i = 0; i < count; i++) {
+        bool cjk = next_double(&state) < corpus->options.cjk_ratio;
+        size_t rank = sample_rank(corpus, &state);
+        words[i] = cjk ? corpus->cjk[rank] : corpus->english[rank];
+    }
+}
+
+bool zipf_corpus_write_dir(ZipfCorpus *corpus, const char *dir) {
+    if (!corpus || !dir) return false;
+
+    char path[1024];
+    for (size_t d = 0; d < corpus->options.documents; d++) {
+        size_t len;
+        char *text = zipf_corpus_document(corpus, d, &len);
+        if (!text) return false;
+
+        snprintf(path, sizeof(path), "%s/doc%05zu.txt", dir, d);
+        FILE *file = fopen(path, "wb");
+        bool ok = file && fwrite(text, 1, len, file) == len;
+        if (file && fclose(file) != 0) ok = false;
+        free(text);
+        if (!ok) {
+            fprintf(stderr, "错误: 无法写入 %s\n", path);
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,37 @@
+#ifndef ZIPF_CORPUS_H
+#define ZIPF_CORPUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// 合成语料生成器：词频服从 Zipf 分布（第 r 个词的概率正比于 1/r^s），
+// 可按比例混合英文与中文词。同一组选项和种子总是生成相同的文档。
+//
+// 英文词由音节按排名编码而成，中文词由 CJK 统一汉字组成。中文词之间不加空格，
+// 连续 2~6 个组成一个分句后再接空格，与真实中文文本在当前分词器下的切分方式一致。
+typedef struct ZipfCorpusOptions {
+    size_t documents;           // 文档数
+    size_t words_per_doc;       // 平均每篇词数，实际在 [w/2, 3w/2] 内均匀分布
+    size_t vocabulary;          // 每种语言的词表大小
+    double exponent;            // Zipf 指数 s
+    double cjk_ratio;           // 中文词所占比例 [0, 1]
+    uint64_t seed;
+} ZipfCorpusOptions;
+
+typedef struct ZipfCorpus ZipfCorpus;
+
+ZipfCorpusOptions zipf_corpus_default_options(void);
+
+ZipfCorpus* zipf_corpus_create(const ZipfCorpusOptions *options);
+void zipf_corpus_destroy(ZipfCorpus *corpus);
+
+// 生成第 index 篇文档，返回以 '\0' 结尾的文本（调用方 free），*len 为字节数
+char* zipf_corpus_document(ZipfCorpus *corpus, size_t index, size_t *len);
+// 按 Zipf 分布抽取 count 个词，写入 words（指向语料内部的词表，随语料释放）
+void zipf_corpus_sample_words(ZipfCorpus *corpus, const char **words, size_t count, uint64_t seed);
+
+// 在 dir 中写出 doc00000.txt ... 供命令行批处理使用，dir 需已存在
+bool zipf_corpus_write_dir(ZipfCorpus *corpus, const char *dir);
+
+#endif
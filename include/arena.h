@@ -0,0 +1,26 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include "sim_memory.h"
+
+// 块式内存池：顺序分配、整体释放，适合生命周期相同的大量小对象
+typedef struct Arena Arena;
+
+// block_size 为 0 时使用默认块大小（64 KB）；块内存计入 MEM_DOCUMENT
+Arena* arena_create(size_t block_size);
+// 第一个块为 first_block 字节，之后每块翻倍直到 max_block，适合大小差异很大的小对象集合；
+// 块内存计入 tag
+Arena* arena_create_growing(size_t first_block, size_t max_block, MemoryTag tag);
+void arena_destroy(Arena *arena);
+
+// 按 16 字节对齐分配；超过块大小的请求单独成块
+void* arena_alloc(Arena *arena, size_t size);
+// 复制 len 个字节并追加 '\0'
+char* arena_strndup(Arena *arena, const char *str, size_t len);
+
+// 释放全部分配，保留第一个块供下次使用
+void arena_reset(Arena *arena);
+size_t arena_bytes_used(const Arena *arena);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef CSV_WRITER_H
+#define CSV_WRITER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// 单个单元格格式化后的最大长度（含回退到 snprintf 的极端值）
+#define CSV_CELL_MAX 336
+
+// 高吞吐 CSV 写出器：大块用户态缓冲，超出缓冲的数据与缓冲内容用 writev 一次写出
+typedef struct CsvWriter CsvWriter;
+
+CsvWriter* csv_writer_open(const char *path);
+bool csv_writer_close(CsvWriter *writer);
+bool csv_writer_write(CsvWriter *writer, const char *data, size_t len);
+bool csv_writer_write_header(CsvWriter *writer, char **filenames, size_t count);
+bool csv_writer_write_row(CsvWriter *writer, const char *name, const double *values, size_t count);
+bool csv_writer_write_row_f32(CsvWriter *writer, const char *name, const float *values, size_t count);
+
+// 定点格式化，输出与 printf("%.4f") 逐字节一致（不写结尾 '\0'）
+size_t csv_format_cell(char *out, double value);
+
+#endif
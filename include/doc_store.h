@@ -0,0 +1,39 @@
+#ifndef DOC_STORE_H
+#define DOC_STORE_H
+
+#include "file_manager.h"
+#include "job_control.h"
+#include <stdint.h>
+
+// 常驻文档仓库：按内容哈希去重，保存处理后的稀疏向量（LRU + 内存预算），
+// 并缓存文档对的相似度，供多次调用（如 Web 请求）复用。线程安全。
+typedef struct DocumentStore DocumentStore;
+
+typedef struct DocStoreStats {
+    size_t documents;       // 当前驻留的文档数
+    size_t bytes;           // 驻留向量占用的字节数（估算）
+    size_t doc_hits;        // 命中已处理文档的次数
+    size_t doc_misses;      // 需要重新分词的次数
+    size_t evictions;       // 因超出预算被淘汰的文档数
+    size_t pair_hits;       // 命中相似度缓存的文档对
+    size_t pair_misses;     // 重新计算的文档对
+} DocStoreStats;
+
+// stop_words 由调用方持有，生命周期须长于仓库，其中文切分长度是缓存键的一部分；
+// pair_cache_entries 为 0 时关闭对缓存
+DocumentStore* doc_store_create(StopWords *stop_words, size_t memory_budget, size_t pair_cache_entries);
+void doc_store_destroy(DocumentStore *store);
+
+// 计算一组内存文档的相似度矩阵，只处理仓库中没有的内容；空文档被跳过
+SimilarityMatrix* doc_store_matrix(DocumentStore *store, const char **names, const char **buffers,
+                                   const size_t *lengths, size_t count);
+// 同上，job 可为 NULL；被取消时返回 NULL，已处理的文档仍留在仓库中
+SimilarityMatrix* doc_store_matrix_job(DocumentStore *store, const char **names, const char **buffers,
+                                       const size_t *lengths, size_t count, JobControl *job);
+
+void doc_store_get_stats(DocumentStore *store, DocStoreStats *stats);
+void doc_store_clear(DocumentStore *store);
+
+uint64_t content_hash64(const char *data, size_t len);
+
+#endif
@@ -3,6 +3,9 @@
 
 #include "text_processor.h"
 #include "vector_math.h"
+#include "job_control.h"
+#include "weighting.h"
+#include "shingle.h"
 #include <stdbool.h>
 
 // 文档集合
@@ -10,13 +13,17 @@ typedef struct DocumentCollection {
     Document **documents;
     size_t count;
     size_t capacity;
+    TermWeights *weights;   // 非 NULL 时文档缓存的是按集合统计加权并归一化的向量
+    ShingleOptions shingles;    // 启用时文档缓存的是 shingle 特征向量
 } DocumentCollection;
 
 // 相似度矩阵
 typedef struct SimilarityMatrix {
-    double **matrix;
+    double **matrix;    // 行指针，指向 data 中的各行
     char **filenames;
     size_t size;
+    size_t capacity;    // 已分配的行数/每行列数，增量添加时按倍数扩容
+    double *data;       // capacity × capacity 的连续行主序缓冲区，行距为 capacity
 } SimilarityMatrix;
 
 // 相似度对
@@ -26,20 +33,61 @@ typedef struct SimilarityPair {
     double similarity;
 } SimilarityPair;
 
+// 目录遍历回调：返回 true 表示接管文档，否则由调用方销毁
+typedef bool (*DocumentVisitor)(Document *doc, const char *name, void *userdata);
+
 // 文档集合函数
 DocumentCollection* collection_create(size_t capacity);
 bool collection_add_document(DocumentCollection *col, Document *doc);
+bool collection_remove_document(DocumentCollection *col, size_t index);
+bool collection_find_document(DocumentCollection *col, const char *filename, size_t *index);
 void collection_destroy(DocumentCollection *col);
+// 统计一遍文档频率并把每个文档的缓存向量换成加权、归一化的向量；之后加入或移除的文档
+// 增量更新统计，新文档按当时的统计加权，已有文档的向量不重新计算
+bool collection_set_weighting(DocumentCollection *col, WeightScheme scheme);
+// 把每个文档的缓存向量换成正文的 shingle 特征（需要正文仍在），之后加入的文档同样处理；
+// width 为 0 时恢复词频特征。与加权互斥
+bool collection_set_shingles(DocumentCollection *col, const ShingleOptions *options);
 DocumentCollection* load_documents_from_dir(const char *dir_path, StopWords *stop_words);
+DocumentCollection* load_documents_from_dir_job(const char *dir_path, StopWords *stop_words,
+                                                JobControl *job);
+DocumentCollection* load_documents_from_buffers(const char **names, const char **buffers,
+                                                const size_t *lengths, size_t count,
+                                                StopWords *stop_words);
+size_t for_each_document_in_dir(const char *dir_path, StopWords *stop_words,
+                                DocumentVisitor visitor, void *userdata);
+// job 可为 NULL；被取消时提前结束遍历，返回已处理的文档数
+size_t for_each_document_in_dir_job(const char *dir_path, StopWords *stop_words,
+                                    DocumentVisitor visitor, void *userdata, JobControl *job);
 
 // 相似度矩阵函数
+SimilarityMatrix* similarity_matrix_alloc(DocumentCollection *col);
+SimilarityMatrix* similarity_matrix_alloc_named(const char **names, size_t count);
 SimilarityMatrix* similarity_matrix_create(DocumentCollection *col);
+SimilarityMatrix* similarity_matrix_from_buffers(const char **names, const char **buffers,
+                                                 const size_t *lengths, size_t count,
+                                                 StopWords *stop_words);
 void similarity_matrix_destroy(SimilarityMatrix *matrix);
+bool similarity_matrix_add_document(SimilarityMatrix *matrix, DocumentCollection *col, Document *doc);
+bool similarity_matrix_remove_document(SimilarityMatrix *matrix, DocumentCollection *col, size_t index);
+bool similarity_matrix_update_document(SimilarityMatrix *matrix, DocumentCollection *col,
+                                       size_t index, Document *doc);
 bool similarity_matrix_save_csv(SimilarityMatrix *matrix, const char *filename);
+const double* similarity_matrix_data(const SimilarityMatrix *matrix);
+void similarity_matrix_shape(const SimilarityMatrix *matrix, size_t *rows, size_t *cols);
+size_t similarity_matrix_stride(const SimilarityMatrix *matrix);
+double* similarity_matrix_detach_data(SimilarityMatrix *matrix, size_t *size, size_t *stride);
+float* similarity_matrix_to_f32(const SimilarityMatrix *matrix);
+void similarity_buffer_free(void *buffer);
+bool similarity_matrix_save_csv_atomic(SimilarityMatrix *matrix, const char *filename);
 void similarity_matrix_print(SimilarityMatrix *matrix);
 
 // 相似度对函数
 SimilarityPair* find_top_similarities(SimilarityMatrix *matrix, size_t top_n, size_t *result_count);
 void sort_similarity_pairs(SimilarityPair *pairs, size_t count);
+bool save_top_pairs_report(SimilarityMatrix *matrix, size_t top_n, const char *filename);
+
+// 输出文件工具：写入临时文件后原子替换目标文件
+bool replace_file_atomic(const char *tmp_path, const char *path);
 
 #endif
\ No newline at end of file
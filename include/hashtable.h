@@ -4,6 +4,8 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+struct Arena;
+
 // 哈希表节点
 typedef struct Entry {
     char *key;
@@ -18,10 +20,13 @@ typedef struct HashTable {
     size_t size;
     size_t unique_words;
     size_t collisions;
+    struct Arena *pool;     // 非 NULL 时条目与键分配在内存池中，随表一次释放
 } HashTable;
 
 // 哈希表操作函数
 HashTable* hash_table_create(size_t capacity);
+// 条目与键从表自带的内存池顺序分配，销毁时整体释放；删除的条目在销毁前不归还
+HashTable* hash_table_create_pooled(size_t capacity);
 void hash_table_destroy(HashTable *table);
 size_t hash_function(const char *key, size_t capacity);
 bool hash_table_insert(HashTable *table, const char *key, int value);
@@ -0,0 +1,31 @@
+#ifndef INVERTED_INDEX_H
+#define INVERTED_INDEX_H
+
+#include "text_processor.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// 持久化倒排索引（只读，打开后按需映射文件）
+// 倒排表按文档号升序存储，采用 delta+varint 压缩，每 128 条一个跳表块，
+// 每个词项记录最大权重 tf/|d|，查询时用于 WAND 提前终止。
+typedef struct InvertedIndex InvertedIndex;
+
+// 查询命中结果
+typedef struct IndexHit {
+    uint32_t doc_id;
+    double score;
+} IndexHit;
+
+// 索引构建与读取
+bool inverted_index_build(const char *dir_path, StopWords *stop_words, const char *index_path);
+InvertedIndex* inverted_index_open(const char *index_path);
+void inverted_index_close(InvertedIndex *idx);
+size_t inverted_index_doc_count(const InvertedIndex *idx);
+size_t inverted_index_term_count(const InvertedIndex *idx);
+const char* inverted_index_doc_name(const InvertedIndex *idx, uint32_t doc_id);
+
+// 查询：返回与 query 余弦相似度最高的 top_k 个文档（按分数降序写入 hits），返回命中数
+size_t inverted_index_query(const InvertedIndex *idx, Document *query, size_t top_k, IndexHit *hits);
+
+#endif
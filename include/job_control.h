@@ -0,0 +1,40 @@
+#ifndef JOB_CONTROL_H
+#define JOB_CONTROL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// 长时间任务的进度回调与协作式取消。加载器与矩阵引擎按块（一个文件、一行或一个行块）
+// 检查取消标志并报告进度，取消后尽快返回 NULL/false。
+typedef struct JobControl JobControl;
+
+typedef enum JobStage {
+    JOB_STAGE_LOAD = 0,     // 读取与分词：done 为已处理的文档数
+    JOB_STAGE_MATRIX = 1    // 矩阵计算：done 为已完成的文档对数
+} JobStage;
+
+typedef struct JobProgress {
+    JobStage stage;
+    size_t done;
+    size_t total;           // 0 表示总量未知（如逐个遍历目录时，遍历结束后才报告总数）
+    size_t bytes;           // 已读入的文本字节数
+} JobProgress;
+
+// 进度回调，在发起任务的线程中调用；返回 false 表示取消任务
+typedef bool (*JobProgressCallback)(const JobProgress *progress, void *userdata);
+
+// on_progress 可为 NULL，只使用取消与轮询
+JobControl* job_control_create(JobProgressCallback on_progress, void *userdata);
+void job_control_destroy(JobControl *job);
+
+// 可在任意线程调用
+void job_control_cancel(JobControl *job);
+bool job_control_cancelled(JobControl *job);
+void job_control_get_progress(JobControl *job, JobProgress *progress);
+
+// 由计算代码调用：记录进度并调用回调，返回 false 表示任务已被取消。job 为 NULL 时总是返回 true
+bool job_control_report(JobControl *job, JobStage stage, size_t done, size_t total);
+// 累加已读入的字节数（不调用回调）
+void job_control_add_bytes(JobControl *job, size_t bytes);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef JOB_QUEUE_H
+#define JOB_QUEUE_H
+
+#include "file_manager.h"
+#include "doc_store.h"
+#include "job_control.h"
+#include <stdint.h>
+
+// 后台任务队列：提交一组内存文档，由工作线程池在后台计算相似度矩阵，
+// 结果在内存预算内保留，供之后轮询与取回。线程安全。
+//
+// 调度：输入不超过 small_job_bytes 的任务为小任务。有两个以上工作线程时，
+// 第一个线程只处理小任务，其余线程按提交顺序处理所有任务，
+// 因此大任务占满通用线程时小任务仍能及时完成。
+typedef struct JobQueue JobQueue;
+
+typedef enum JobState {
+    JOB_STATE_QUEUED = 0,
+    JOB_STATE_RUNNING = 1,
+    JOB_STATE_DONE = 2,
+    JOB_STATE_FAILED = 3,
+    JOB_STATE_CANCELLED = 4,
+    JOB_STATE_EXPIRED = 5       // 已完成，但结果因超出内存预算被释放
+} JobState;
+
+typedef struct JobQueueConfig {
+    size_t workers;             // 工作线程数，0 表示 CPU 核心数（至少 2）
+    size_t threads_per_job;     // 每个任务计算矩阵的线程数
+    size_t max_pending;         // 排队任务数上限
+    size_t max_pending_bytes;   // 排队任务的输入总字节上限
+    size_t small_job_bytes;     // 小任务的输入字节上限
+    size_t result_budget;       // 保留结果的总字节上限，超出时释放最早完成的结果
+    size_t max_finished;        // 保留的已结束任务记录数上限
+    DocumentStore *shared_store; // 非空时所有工作线程共享该文档仓库（调用方持有）
+} JobQueueConfig;
+
+typedef struct JobStatus {
+    JobState state;
+    JobProgress progress;       // 运行中为实时进度，结束后为最终进度
+    size_t documents;
+    size_t input_bytes;
+    size_t result_bytes;
+    size_t queue_position;      // 排队时同一队列中排在前面的任务数
+    char error[128];            // FAILED 时的原因
+} JobStatus;
+
+JobQueueConfig job_queue_default_config(void);
+
+// config 为 NULL 时使用默认配置
+JobQueue* job_queue_create(const JobQueueConfig *config);
+// 取消所有任务，等待工作线程退出后释放
+void job_queue_destroy(JobQueue *queue);
+
+// 复制输入并排队，成功时 *id 为任务编号（从 1 开始）。队列已满或参数无效时返回 false
+bool job_queue_submit(JobQueue *queue, const char **names, const char **buffers,
+                      const size_t *lengths, size_t count, uint64_t *id);
+bool job_queue_status(JobQueue *queue, uint64_t id, JobStatus *status);
+// 返回结果矩阵的副本（调用方用 similarity_matrix_destroy 释放）；任务未完成或结果已释放时返回 NULL
+SimilarityMatrix* job_queue_copy_result(JobQueue *queue, uint64_t id);
+// 排队中的任务立即取消，运行中的任务在下一个检查点停止
+bool job_queue_cancel(JobQueue *queue, uint64_t id);
+// 取消并删除任务记录与结果
+bool job_queue_remove(JobQueue *queue, uint64_t id);
+
+const char* job_state_name(JobState state);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef LEAN_DOCUMENT_H
+#define LEAN_DOCUMENT_H
+
+#include "file_manager.h"
+#include "job_control.h"
+#include <stdint.h>
+
+// 精简文档集合：文档处理完成后只保留计算相似度所需的词频。
+// 正文与词频哈希表在加入集合后即可释放；文件名与词项驻留在集合共享的字符串池中，
+// 每个文档只保存按词项编号升序排列的 (词项, 词频) 数组及其模长。
+// 相似度与 document_vector_similarity 相同（按原始词频的余弦），
+// 不同之处是词项按编号精确比较，不存在 64 位哈希碰撞。
+typedef struct LeanCollection LeanCollection;
+
+typedef enum LeanEncoding {
+    LEAN_PAIRS = 0,     // 定长 (uint32 词项, uint32 词频) 数组，每个词项 8 字节
+    LEAN_VARINT         // 词项编号差值与词频的 varint 编码，通常每个词项 2~3 字节
+} LeanEncoding;
+
+typedef struct LeanTerm {
+    uint32_t term;      // 词项在集合词项池中的编号
+    uint32_t count;
+} LeanTerm;
+
+LeanCollection* lean_collection_create(LeanEncoding encoding);
+void lean_collection_destroy(LeanCollection *col);
+
+// 冻结一个已处理的文档并加入集合；不接管 doc，调用方随后可直接销毁它
+bool lean_collection_add(LeanCollection *col, const Document *doc);
+// 逐个加载目录中的文档，每个文档冻结后立即销毁；job 可为 NULL，被取消时返回 NULL
+LeanCollection* lean_collection_load_dir(const char *dir_path, StopWords *stop_words,
+                                         LeanEncoding encoding, JobControl *job);
+
+size_t lean_collection_count(const LeanCollection *col);
+const char* lean_collection_name(const LeanCollection *col, size_t index);
+size_t lean_collection_term_count(const LeanCollection *col, size_t index);
+// 把文档的词项解码到 out（至少 term_count 个元素），按编号升序；返回词项数
+size_t lean_collection_terms(const LeanCollection *col, size_t index, LeanTerm *out);
+const char* lean_collection_term(const LeanCollection *col, uint32_t term);
+
+double lean_collection_cosine(const LeanCollection *col, size_t i, size_t j);
+// 计算完整的相似度矩阵（对角线为 1）；job 可为 NULL
+SimilarityMatrix* lean_collection_similarity_matrix(const LeanCollection *col, JobControl *job);
+
+// 集合常驻的全部字节数：文档表、词频数据与两个字符串池
+size_t lean_collection_bytes(const LeanCollection *col);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef MATRIX_ENGINE_H
+#define MATRIX_ENGINE_H
+
+#include "file_manager.h"
+#include "job_control.h"
+
+// 行完成回调：按行号升序调用，values 为完整的一行（n 个值）；返回 false 中止计算
+typedef bool (*MatrixRowCallback)(size_t row, const double *values, size_t count, void *userdata);
+
+// 多线程计算相似度矩阵，结果与 similarity_matrix_create 逐位一致
+// threads 为 0 时使用 CPU 核心数；on_row 可为 NULL
+SimilarityMatrix* similarity_matrix_create_parallel(DocumentCollection *col, size_t threads,
+                                                    MatrixRowCallback on_row, void *userdata);
+
+// 同上，可选的 job 用于报告进度（已完成的文档对数）与取消；被取消时返回 NULL
+SimilarityMatrix* similarity_matrix_create_parallel_job(DocumentCollection *col, size_t threads,
+                                                        MatrixRowCallback on_row, void *userdata,
+                                                        JobControl *job);
+
+// 由现成的稀疏向量多线程计算矩阵，不需要 DocumentCollection；向量在计算期间必须保持不变
+// （由调用方保证，例如先复制一份快照），NULL 向量与其他向量的相似度为 -1
+SimilarityMatrix* similarity_matrix_create_from_vectors(const char **names, SparseVector **vectors,
+                                                        size_t count, size_t threads);
+
+// 边计算边写出 CSV，文件内容与 similarity_matrix_save_csv 相同；job 可为 NULL
+SimilarityMatrix* similarity_matrix_create_streaming_csv(DocumentCollection *col, size_t threads,
+                                                         const char *filename, JobControl *job);
+
+size_t matrix_engine_default_threads(void);
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef MATRIX_FILE_H
+#define MATRIX_FILE_H
+
+#include "file_manager.h"
+#include <stdint.h>
+
+// 二进制相似度矩阵文件 (.simx)
+// 布局: 64 字节头部 | 文件名表 (以 '\0' 分隔) | 单元格数据 (64 字节对齐, 小端)
+// 未压缩时每行连续存放，可直接 mmap 零拷贝访问；压缩时按行块做游程编码。
+typedef enum {
+    MATRIX_DTYPE_F32 = 1,
+    MATRIX_DTYPE_F64 = 2,
+    MATRIX_DTYPE_U8 = 3,        // 量化: round(v * 255)，适用于 [0, 1] 范围
+    MATRIX_DTYPE_F16 = 4        // IEEE 754 半精度，最近偶数舍入
+} MatrixDType;
+
+typedef enum {
+    MATRIX_LAYOUT_FULL = 0,
+    MATRIX_LAYOUT_UPPER = 1     // 上三角（含对角线），第 i 行只存 j >= i
+} MatrixLayout;
+
+typedef enum {
+    MATRIX_COMPRESS_NONE = 0,
+    MATRIX_COMPRESS_RLE = 1     // 每 tile_rows 行一块, (varint 游程长度, 单元格) 序列
+} MatrixCompression;
+
+typedef struct MatrixFileOptions {
+    MatrixDType dtype;
+    MatrixLayout layout;
+    MatrixCompression compression;
+    uint32_t tile_rows;
+} MatrixFileOptions;
+
+// 行数据源：把第 row 行的全部 n 个值写入 out
+typedef bool (*MatrixRowSource)(size_t row, double *out, void *userdata);
+
+// 写出
+MatrixFileOptions matrix_file_default_options(void);
+bool matrix_file_write(const char *path, size_t size, char **filenames,
+                       MatrixRowSource source, void *userdata,
+                       const MatrixFileOptions *options);
+bool similarity_matrix_save_binary(SimilarityMatrix *matrix, const char *path,
+                                   const MatrixFileOptions *options);
+
+// 把矩阵编码为与文件数据区相同的紧凑单元格块（小端，按 layout 排列，无对齐填充），
+// 供网络传输使用；*bytes 返回长度，结果用 similarity_buffer_free 释放
+void* similarity_matrix_encode(const SimilarityMatrix *matrix, MatrixDType dtype,
+                               MatrixLayout layout, size_t *bytes);
+
+// 读取（POSIX 下 mmap）
+typedef struct MatrixFile MatrixFile;
+
+MatrixFile* matrix_file_open(const char *path);
+void matrix_file_close(MatrixFile *mf);
+size_t matrix_file_size(const MatrixFile *mf);
+int matrix_file_dtype(const MatrixFile *mf);
+int matrix_file_layout(const MatrixFile *mf);
+int matrix_file_compression(const MatrixFile *mf);
+const char* matrix_file_name(const MatrixFile *mf, size_t index);
+const void* matrix_file_row_data(const MatrixFile *mf, size_t row, size_t *count);
+bool matrix_file_read_row(MatrixFile *mf, size_t row, float *out);
+double matrix_file_get(MatrixFile *mf, size_t row, size_t col);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef NEIGHBORS_H
+#define NEIGHBORS_H
+
+#include "file_manager.h"
+#include <stdint.h>
+
+// 稀疏结果：只包含需要的文档对，大小随结果而不是 N² 增长。
+// 三个数组按列存放，第 k 条边为 (rows[k], cols[k], scores[k])。
+typedef struct SimilarityEdges {
+    size_t count;
+    uint32_t *rows;
+    uint32_t *cols;
+    float *scores;
+    size_t capacity;            // 三个数组已分配的元素数
+} SimilarityEdges;
+
+// 每个文档相似度最高的 k 个邻居（不含自身，且不低于 min_score）。
+// 按行号升序，同一行内按分数降序、分数相同时按列号升序
+SimilarityEdges* similarity_matrix_top_k(const SimilarityMatrix *matrix, size_t k, double min_score);
+
+// 相似度不低于 threshold 的文档对 (i < j)，按行主序排列
+SimilarityEdges* similarity_matrix_pairs_above(const SimilarityMatrix *matrix, double threshold);
+
+void similarity_edges_destroy(SimilarityEdges *edges);
+
+#endif
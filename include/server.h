@@ -0,0 +1,56 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "text_processor.h"
+#include <stdint.h>
+
+// 常驻相似度服务：监听 Unix 域套接字，语料的稀疏向量常驻内存。
+// 帧格式（小端）：请求为 u32 长度 | u8 操作码 | 负载，响应为 u32 长度 | u8 状态 | 负载，
+// 长度包含操作码/状态字节。一个连接上可以顺序发送任意多个请求。
+typedef enum {
+    SERVER_OP_ADD = 1,      // u16 名称长度 | 名称 | 文本    -> u32 下标 | u32 文档数（同名文档被替换）
+    SERVER_OP_QUERY = 2,    // u32 k | 文本                 -> u32 条数 | 条数 × (u32 下标 | f64 分数 | u16 名称长度 | 名称)
+    SERVER_OP_MATRIX = 3,   // u8 dtype | u8 layout         -> u32 n | n × (u16 名称长度 | 名称) | 单元格
+    SERVER_OP_REMOVE = 4,   // u16 名称长度 | 名称          -> u32 文档数
+    SERVER_OP_STATS = 5     // (空)                         -> u32 文档数 | u64 查询数 | u64 批次数 | u32 最大批次
+} ServerOp;
+
+typedef enum {
+    SERVER_STATUS_OK = 0,
+    SERVER_STATUS_BAD_REQUEST = 1,  // 失败时负载为 UTF-8 错误信息
+    SERVER_STATUS_NOT_FOUND = 2,
+    SERVER_STATUS_ERROR = 3
+} ServerStatus;
+
+// 单帧上限：与文档大小限制 (100MB) 相同，另留协议头的余量
+#define SERVER_MAX_FRAME (100u * 1024 * 1024 + 64)
+
+typedef struct ServerOptions {
+    const char *socket_path;
+    const char *preload_dir;    // 启动时加载的目录，可为 NULL
+    size_t max_batch;           // 一次扫描最多合并的查询数，0 表示默认 (64)
+} ServerOptions;
+
+typedef struct ServerStats {
+    size_t documents;
+    uint64_t queries;
+    uint64_t batches;           // 语料扫描次数；queries / batches 即平均批大小
+    size_t largest_batch;
+} ServerStats;
+
+typedef struct SimServer SimServer;
+
+// 绑定并监听套接字（已存在的同名套接字文件会被替换），返回后客户端即可连接。
+// stop_words 由调用方持有，生命周期须长于服务
+SimServer* sim_server_create(const ServerOptions *options, StopWords *stop_words);
+// 处理连接直到 sim_server_stop 被调用；返回 0 表示正常退出
+int sim_server_run(SimServer *server);
+// 请求停止，可在任意线程或信号处理函数中调用
+void sim_server_stop(SimServer *server);
+void sim_server_destroy(SimServer *server);
+void sim_server_get_stats(SimServer *server, ServerStats *stats);
+
+// 命令行入口：创建服务并运行，收到 SIGINT/SIGTERM 时返回 0
+int serve_socket(const ServerOptions *options, StopWords *stop_words);
+
+#endif
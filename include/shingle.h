@@ -0,0 +1,31 @@
+#ifndef SHINGLE_H
+#define SHINGLE_H
+
+#include "text_processor.h"
+#include "vector_math.h"
+
+// w-shingle 特征：连续 w 个词（中日韩文字按单字）构成一个 shingle。
+// 词袋余弦分不清照搬的段落与只是用词相近、顺序打乱的文本，shingle 保留了词序。
+// 哈希在零复制的词流上用滚动多项式计算，每前进一个词只做一次乘加，不拼接字符串；
+// 特征只保存 64 位哈希。停用词不去除，它们同样携带词序信息。
+//
+// 结果是 SparseVector（键为 shingle 哈希，值为出现次数），可直接替换文档的缓存向量，
+// 由余弦矩阵引擎、sparse_vector_jaccard 与 minhash_signature 使用。
+#define SHINGLE_MAX_WIDTH 16
+
+typedef struct ShingleOptions {
+    size_t width;           // 每个 shingle 的词数（1 ~ SHINGLE_MAX_WIDTH）；0 表示使用词频特征
+    uint64_t sample_mod;    // 只保留哈希 mod p 为 0 的 shingle，约保留 1/p；0 或 1 保留全部。
+                            // 一个也未选中时保留哈希最小的 shingle
+} ShingleOptions;
+
+void shingle_options_init(ShingleOptions *options);
+// 是否启用了 shingle 特征
+bool shingle_options_active(const ShingleOptions *options);
+
+// 由文本生成 shingle 特征向量；词数少于 width 时整段作为一个 shingle，没有词时返回空向量
+SparseVector* shingle_vector(const char *text, const ShingleOptions *options);
+// 用正文的 shingle 特征替换文档的缓存向量；正文已释放或内存不足时返回 false
+bool document_shingle(Document *doc, const ShingleOptions *options);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef SIM_CONTEXT_H
+#define SIM_CONTEXT_H
+
+#include "file_manager.h"
+#include "doc_store.h"
+#include "job_control.h"
+
+// 计算上下文：持有自己的配置、停用词、临时内存池和错误信息，不向 stdout 打印。
+// 线程安全约定：
+//   - 同一上下文同一时刻只能由一个线程使用；
+//   - 不同上下文之间没有共享的可变状态，可以在不同线程中同时使用；
+//   - 多个上下文可以共享同一个 DocumentStore（仓库自身加锁）。
+typedef struct SimContext SimContext;
+
+typedef struct SimConfig {
+    size_t threads;             // 矩阵计算线程数，0 表示使用 CPU 核心数，1 表示单线程
+    size_t store_budget;        // 私有文档仓库的内存预算，0 表示不使用仓库
+    size_t pair_cache_entries;  // 私有仓库的文档对缓存容量
+    DocumentStore *shared_store; // 非空时使用该共享仓库（调用方持有，使用其停用词），忽略上面两项
+    WeightScheme weighting;     // 非 WEIGHT_RAW 时按本次调用的文档统计加权，不经过文档仓库
+    size_t cjk_ngram;           // 中日韩文字切分长度（1 ~ CJK_NGRAM_MAX），0 为默认；共享仓库时使用仓库的设置
+} SimConfig;
+
+SimConfig sim_config_default(void);
+
+// config 为 NULL 时使用默认配置
+SimContext* sim_context_create(const SimConfig *config);
+void sim_context_destroy(SimContext *ctx);
+
+// 停用词属于上下文，修改不影响其他上下文
+bool sim_context_add_stop_word(SimContext *ctx, const char *word);
+bool sim_context_load_stop_words(SimContext *ctx, const char *path);
+
+// 计算内存文档的相似度矩阵；空文档被跳过。失败返回 NULL，原因见 sim_context_last_error
+SimilarityMatrix* sim_context_matrix_from_buffers(SimContext *ctx, const char **names,
+                                                  const char **buffers, const size_t *lengths,
+                                                  size_t count);
+// 计算目录中 .txt 文档的相似度矩阵
+SimilarityMatrix* sim_context_matrix_from_dir(SimContext *ctx, const char *dir_path);
+
+// 之后的调用通过 job 报告进度并响应取消（job 由调用方持有，传 NULL 解除）。
+// 被取消的调用返回 NULL，错误信息为“任务已取消”
+void sim_context_set_job(SimContext *ctx, JobControl *job);
+
+// 最近一次失败的原因，没有错误时返回空字符串
+const char* sim_context_last_error(const SimContext *ctx);
+void sim_context_clear_error(SimContext *ctx);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef SIM_MEMORY_H
+#define SIM_MEMORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// 分类内存统计：按子系统记录当前与峰值字节数，并可设置硬性内存预算。
+//
+// 释放时由调用方给出分配时的字节数，不在分配块前加头部，小对象没有额外开销。
+// 计数使用全局原子变量，始终启用（预算检查依赖它），与 SIM_STATS 无关。
+// 设置预算后，超出预算的分配直接失败并返回 NULL，调用方按内存不足处理，
+// 而不是让进程在交换中拖死或被 OOM 杀掉；sim_memory_budget_exceeded 记录是否发生过。
+//
+// 交给调用方用 free() 释放的结果（如 find_top_similarities 的返回值）不计入统计。
+typedef enum MemoryTag {
+    MEM_HASHTABLE = 0,      // 词频哈希表的桶数组、条目与键
+    MEM_DOCUMENT,           // 文档结构与正文、文档集合、停用词表
+    MEM_VECTOR,             // 稀疏向量与词表
+    MEM_MATRIX,             // 相似度矩阵与分块缓冲区
+    MEM_PAIRS,              // SimilarityPair 缓冲区与稀疏边
+    MEM_UI,                 // 界面与输出缓冲区
+    MEM_TAG_COUNT
+} MemoryTag;
+
+typedef struct MemoryStats {
+    size_t current[MEM_TAG_COUNT];
+    size_t peak[MEM_TAG_COUNT];
+    size_t current_total;
+    size_t peak_total;              // 所有子系统合计的峰值（不是各峰值之和）
+    size_t budget;                  // 0 表示不限制
+    uint64_t rejected;              // 因超出预算而失败的分配次数
+} MemoryStats;
+
+// 记账：reserve 超出预算时返回 false 且不计入；release 与之配对
+bool sim_memory_reserve(MemoryTag tag, size_t bytes);
+void sim_memory_release(MemoryTag tag, size_t bytes);
+
+// 带记账的分配函数；失败返回 NULL，sim_memory_free 的 bytes 必须与分配时一致
+void* sim_memory_alloc(MemoryTag tag, size_t bytes);
+void* sim_memory_calloc(MemoryTag tag, size_t count, size_t size);
+void* sim_memory_realloc(MemoryTag tag, void *ptr, size_t old_bytes, size_t new_bytes);
+char* sim_memory_strdup(MemoryTag tag, const char *str);
+void sim_memory_free(MemoryTag tag, void *ptr, size_t bytes);
+
+// 设置预算（字节，0 为不限制），同时清除超出标记
+void sim_memory_set_budget(size_t bytes);
+bool sim_memory_budget_exceeded(void);
+
+void sim_memory_get(MemoryStats *stats);
+// 把各峰值重置为当前值
+void sim_memory_reset_peak(void);
+const char* memory_tag_name(MemoryTag tag);
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef SIM_STATS_H
+#define SIM_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sim_memory.h"
+
+// 运行统计：各处理阶段的耗时与计数器。
+//
+// 埋点通过 STATS_* 宏写入，仅在编译时定义 SIM_STATS（make stats）时生效，
+// 默认构建中宏展开为空，热路径没有任何额外开销。计数器按线程累加，
+// 线程首次写入时登记，读取时汇总所有线程（包括已退出的线程）。
+// 阶段耗时为各线程耗时之和，多线程阶段可能超过实际经过的时间。
+// 各子系统的内存占用（sim_memory.h）始终记录，不依赖 SIM_STATS。
+typedef enum StatPhase {
+    STAT_PHASE_SCAN = 0,        // 目录遍历
+    STAT_PHASE_READ,            // 读取文件
+    STAT_PHASE_TOKENIZE,        // 分词与小写化；document_process 按文档计时，含停用词过滤与词频插入
+    STAT_PHASE_STOP_WORDS,      // 停用词过滤；目前并入 tokenize，不单独计时，保留以固定输出格式
+    STAT_PHASE_HASH_INSERT,     // 词频哈希表插入；document_process 中只含中日韩 n-gram 的合并
+    STAT_PHASE_VECTORIZE,       // 构建稀疏向量
+    STAT_PHASE_SCORE,           // 文档对相似度计算
+    STAT_PHASE_OUTPUT,          // 写出结果
+    STAT_PHASE_COUNT
+} StatPhase;
+
+typedef enum StatCounter {
+    STAT_FILES = 0,             // 读取的文件数
+    STAT_BYTES_READ,            // 读取的字节数
+    STAT_TOKENS,                // 分出的词数
+    STAT_STOP_WORDS,            // 被过滤的停用词数
+    STAT_HASH_INSERTS,          // 哈希表插入次数
+    STAT_HASH_PROBES,           // 哈希表查找时比较的条目数
+    STAT_HASH_RESIZES,          // 哈希表扩容次数
+    STAT_ALLOCATIONS,           // 热路径上的内存分配次数
+    STAT_VECTORS,               // 构建的稀疏向量数
+    STAT_PAIRS,                 // 计算的文档对数
+    STAT_OUTPUT_BYTES,          // 写出的字节数
+    STAT_COUNTER_COUNT
+} StatCounter;
+
+typedef struct SimilarityStats {
+    bool enabled;                               // 库是否以 SIM_STATS 编译
+    uint64_t phase_ns[STAT_PHASE_COUNT];
+    uint64_t counters[STAT_COUNTER_COUNT];
+    MemoryStats memory;
+} SimilarityStats;
+
+// 汇总所有线程的统计
+void similarity_stats_get(SimilarityStats *stats);
+// 清零所有线程的统计并把内存峰值重置为当前值；应在没有其他线程写入时调用
+void similarity_stats_reset(void);
+bool similarity_stats_enabled(void);
+
+// 单调时钟，纳秒
+uint64_t similarity_stats_now(void);
+void similarity_stats_add(StatCounter counter, uint64_t n);
+void similarity_stats_add_time(StatPhase phase, uint64_t ns);
+
+const char* stat_phase_name(StatPhase phase);
+const char* stat_counter_name(StatCounter counter);
+
+// 输出阶段耗时、计数器、吞吐率（词/秒、字节/秒、文档对/秒）与各子系统内存；json 为 false 时输出表格
+void similarity_stats_print(const SimilarityStats *stats, FILE *out, bool json);
+
+#ifdef SIM_STATS
+#define STATS_COUNT(counter, n) similarity_stats_add((counter), (uint64_t)(n))
+#define STATS_TIMER_START(t) uint64_t t = similarity_stats_now()
+// 把自 t 以来的时间计入 phase，并把 t 推进到当前时刻，便于连续计时相邻阶段
+#define STATS_TIMER_LAP(t, phase) do { \
+        uint64_t stats_now_ = similarity_stats_now(); \
+        similarity_stats_add_time((phase), stats_now_ - (t)); \
+        (t) = stats_now_; \
+    } while (0)
+// 丢弃自 t 以来的时间（已由其他阶段计入）
+#define STATS_TIMER_RESTART(t) ((t) = similarity_stats_now())
+#else
+#define STATS_COUNT(counter, n) ((void)0)
+#define STATS_TIMER_START(t) ((void)0)
+#define STATS_TIMER_LAP(t, phase) ((void)0)
+#define STATS_TIMER_RESTART(t) ((void)0)
+#endif
+
+#endif
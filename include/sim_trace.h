@@ -0,0 +1,36 @@
+#ifndef SIM_TRACE_H
+#define SIM_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// 事件追踪：记录各线程处理阶段的起止时间，结束时导出为 Chrome Trace Event JSON，
+// 可在 chrome://tracing 或 Perfetto 中按线程查看时间线，找出拖后腿的线程与负载不均。
+//
+// 每个线程首次记录时分配一个环形缓冲区，写入不加锁；缓冲区写满后覆盖最早的事件。
+// 未开启时每个埋点只有一次原子读。已退出线程的缓冲区保留事件，并由之后的新线程接着使用。
+//
+// 覆盖的阶段：file_load（读文件）、tokenize（分词建表）、vocab（合并全局词汇表）、
+// vectorize（构建词项向量）、shingle、weighting、prune、freeze（各类特征处理）、matrix_row / matrix_tile（矩阵行与外存分块）、output_flush / matrix_file_write（写出）、
+// job（后台任务队列中的一个任务）。
+
+#define SIM_TRACE_DEFAULT_EVENTS 65536
+
+// 开始记录，清空之前的事件；events_per_thread 为 0 时使用默认容量
+void sim_trace_start(size_t events_per_thread);
+bool sim_trace_enabled(void);
+
+// 未开启时返回 0；name 必须是静态字符串，arg 会写入事件的 args
+uint64_t sim_trace_begin(void);
+void sim_trace_end(const char *name, uint64_t begin, uint64_t arg);
+
+// 停止记录并写出 JSON；应在工作线程结束后调用
+bool sim_trace_stop(const char *path);
+// 当前记录的事件数（含各线程缓冲区被覆盖前的有效部分）
+size_t sim_trace_event_count(void);
+
+#define TRACE_BEGIN(t) uint64_t t = sim_trace_begin()
+#define TRACE_END(t, name, arg) do { if (t) sim_trace_end((name), (t), (uint64_t)(arg)); } while (0)
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// 字符串驻留池：相同的字符串只保存一份，并分配从 0 开始的连续 32 位编号。
+// 字符串存放在块式内存池中，整体释放；内存计入 MEM_DOCUMENT。非线程安全。
+typedef struct StringPool StringPool;
+
+#define STRING_POOL_INVALID UINT32_MAX
+
+StringPool* string_pool_create(void);
+void string_pool_destroy(StringPool *pool);
+
+// 返回字符串的编号，首次出现时复制并分配新编号；失败返回 STRING_POOL_INVALID
+uint32_t string_pool_intern(StringPool *pool, const char *str);
+// 只查找不插入
+bool string_pool_find(const StringPool *pool, const char *str, uint32_t *id);
+// 编号无效时返回 NULL；返回的指针在池销毁前有效
+const char* string_pool_get(const StringPool *pool, uint32_t id);
+
+size_t string_pool_count(const StringPool *pool);
+// 池占用的全部字节数（字符串、编号表与索引）
+size_t string_pool_bytes(const StringPool *pool);
+
+#endif
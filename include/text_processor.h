@@ -3,27 +3,36 @@
 
 #include "hashtable.h"
 #include <stdbool.h>
+#include <stdint.h>
 
-// 停用词表
+// 停用词表，同时携带分词设置；处理文档时随停用词一起传入，不同表之间互不影响
 typedef struct StopWords {
     char **words;
     size_t size;
     size_t capacity;
+    size_t cjk_ngram;           // 中日韩文字的切分长度，见 stop_words_set_cjk_ngram
 } StopWords;
 
+struct SparseVector;
+
 // 文档结构
 typedef struct Document {
     char filename[256];
     HashTable *word_freq;
     char *content;
     size_t word_count;
+    struct SparseVector *vector;    // 缓存的稀疏词频向量，由 document_vector 按需生成
+    size_t content_size;            // content 的分配大小（含结尾 '\0'），用于内存统计
 } Document;
 
 // 文本处理函数
 Document* document_create(const char *filename);
 void document_destroy(Document *doc);
+Document* document_create_from_buffer(const char *name, const char *data, size_t len);
 bool document_load_from_file(Document *doc, const char *filename);
+bool document_load_from_buffer(Document *doc, const char *data, size_t len);
 bool document_process(Document *doc, StopWords *stop_words);
+void document_release_content(Document *doc);
 void document_print_stats(Document *doc);
 
 // 停用词表函数
@@ -32,10 +41,47 @@ bool stop_words_load_from_file(StopWords *sw, const char *filename);
 bool stop_words_add(StopWords *sw, const char *word);
 bool is_stop_word(StopWords *sw, const char *word);
 void stop_words_destroy(StopWords *sw);
+// 中日韩文字的切分长度（1 ~ CJK_NGRAM_MAX），应在用该表处理文档前设置；
+// stop_words 为 NULL 时按默认长度切分
+bool stop_words_set_cjk_ngram(StopWords *sw, size_t n);
+size_t stop_words_cjk_ngram(const StopWords *sw);
+
+// 分词：正文按 UTF-8 解码，码点按文字分类。拉丁字母等其他文字组成单词；
+// 中日韩文字没有空格分隔，连续的一段切成重叠的 N 字片段（默认 2，比 N 短的整段保留），
+// 片段在统计时以码点打包成的整数为键，每个不同片段最后才写入词频表一次。
+#define UTF8_INVALID 0xFFFFFFFFu
+#define CJK_NGRAM_MAX 3         // 三个 21 位码点正好装进 64 位键
+#define CJK_NGRAM_DEFAULT 2
+
+typedef enum CharClass {
+    CHAR_SEPARATOR = 0,         // 空白、数字、标点与符号（含全角标点）
+    CHAR_WORD,                  // 英文字母、撇号与其他文字的字母
+    CHAR_CJK                    // 汉字、假名与谚文
+} CharClass;
+
+typedef enum TokenKind {
+    TOKEN_WORD = 0,
+    TOKEN_CJK                   // 一段连续的中日韩文字，由 document_process 切成 N 字片段
+} TokenKind;
+
+// 指向正文的片段，不复制
+typedef struct Token {
+    const char *start;
+    size_t length;              // 字节数
+    TokenKind kind;
+} Token;
+
+// 解码 s 处的一个码点，返回消耗的字节数（遇到 '\0' 返回 0）；
+// 非法序列只消耗一个字节并得到 UTF8_INVALID
+size_t utf8_decode(const char *s, uint32_t *cp);
+CharClass char_class(uint32_t cp);
+// 读取下一个单词或中日韩文字段并前移 *text_ptr；没有更多时返回 false
+bool next_token(const char **text_ptr, Token *token);
 
 // 工具函数
 char* str_to_lower(char *str);
 bool is_word_char(char c);
+// 返回下一个单词或中日韩文字段的副本，调用方 free
 char* get_next_word(char **text_ptr);
 
 #endif
\ No newline at end of file
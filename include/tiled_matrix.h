@@ -0,0 +1,30 @@
+#ifndef TILED_MATRIX_H
+#define TILED_MATRIX_H
+
+#include "file_manager.h"
+#include "vector_store.h"
+
+// 外存分块相似度矩阵：按行块（tile）在内存预算内计算，完成的块写入磁盘文件，
+// 之后以流方式读回供 CSV、Top-K 与阈值筛选使用。单元格以 float32 存储，
+// 只落盘上三角，读回时按对称性补全。
+typedef struct TiledMatrix TiledMatrix;
+
+// 阈值筛选回调
+typedef void (*PairVisitor)(const char *doc1, const char *doc2, double similarity, void *userdata);
+
+// job 可为 NULL，每个行块开始前报告进度并检查取消，被取消时返回 NULL
+TiledMatrix* similarity_matrix_create_tiled(VectorStore *store, size_t memory_budget,
+                                            const char *path, JobControl *job);
+void tiled_matrix_destroy(TiledMatrix *tm);
+size_t tiled_matrix_size(const TiledMatrix *tm);
+size_t tiled_matrix_tile_rows(const TiledMatrix *tm);
+const char* tiled_matrix_filename(const TiledMatrix *tm, size_t index);
+
+// 流式读取
+bool tiled_matrix_read_row(TiledMatrix *tm, size_t row, float *out);
+bool tiled_matrix_save_csv(TiledMatrix *tm, const char *filename);
+SimilarityPair* tiled_matrix_top_similarities(TiledMatrix *tm, size_t top_n, size_t *result_count);
+size_t tiled_matrix_filter_pairs(TiledMatrix *tm, double threshold,
+                                 PairVisitor visitor, void *userdata);
+
+#endif
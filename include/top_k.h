@@ -0,0 +1,68 @@
+#ifndef TOP_K_H
+#define TOP_K_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Top-K 候选的小顶堆，供近邻图与服务端查询共用。
+// 排名规则：分数高者优先，分数相同时下标小者优先，结果与输入顺序无关。
+
+typedef struct Candidate {
+    double score;
+    uint32_t index;
+} Candidate;
+
+// a 排在 b 之前
+static inline bool candidate_ranks_before(const Candidate *a, const Candidate *b) {
+    return a->score > b->score || (a->score == b->score && a->index < b->index);
+}
+
+// qsort 比较函数，按排名升序
+static inline int candidate_compare(const void *a, const void *b) {
+    const Candidate *ca = (const Candidate*)a;
+    const Candidate *cb = (const Candidate*)b;
+    if (candidate_ranks_before(ca, cb)) return -1;
+    if (candidate_ranks_before(cb, ca)) return 1;
+    return 0;
+}
+
+// 小顶堆（堆顶为当前 k 个中排名最后的候选）
+static inline void top_k_sift_down(Candidate *heap, size_t size, size_t i) {
+    for (;;) {
+        size_t worst = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+        if (left < size && candidate_ranks_before(&heap[worst], &heap[left])) worst = left;
+        if (right < size && candidate_ranks_before(&heap[worst], &heap[right])) worst = right;
+        if (worst == i) return;
+        Candidate tmp = heap[i];
+        heap[i] = heap[worst];
+        heap[worst] = tmp;
+        i = worst;
+    }
+}
+
+static inline void top_k_sift_up(Candidate *heap, size_t i) {
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!candidate_ranks_before(&heap[parent], &heap[i])) return;
+        Candidate tmp = heap[i];
+        heap[i] = heap[parent];
+        heap[parent] = tmp;
+        i = parent;
+    }
+}
+
+// 放入候选：未满时加入，已满时只替换排名最后的堆顶
+static inline void top_k_push(Candidate *heap, size_t *size, size_t k, Candidate c) {
+    if (*size < k) {
+        heap[*size] = c;
+        top_k_sift_up(heap, (*size)++);
+    } else if (k > 0 && candidate_ranks_before(&c, &heap[0])) {
+        heap[0] = c;
+        top_k_sift_down(heap, k, 0);
+    }
+}
+
+#endif
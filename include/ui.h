@@ -12,7 +12,9 @@ typedef enum {
     MENU_SHOW_TOP_PAIRS,
     MENU_FILTER_PAIRS,
     MENU_SHOW_HEATMAP,
-    MENU_STATISTICS
+    MENU_STATISTICS,
+    MENU_ADD_DOCUMENT,
+    MENU_REMOVE_DOCUMENT
 } MenuOption;
 
 // 用户界面函数
@@ -22,8 +24,11 @@ void print_menu();
 MenuOption get_menu_choice();
 void process_menu_choice(MenuOption choice, DocumentCollection **col_ptr, 
                         SimilarityMatrix **matrix_ptr, StopWords **stop_words_ptr);
-void compare_two_documents();
+void compare_two_documents(StopWords *stop_words);
 void show_statistics(DocumentCollection *col);
+void add_document_to_collection(DocumentCollection **col_ptr, SimilarityMatrix *matrix,
+                                StopWords *stop_words);
+void remove_document_from_collection(DocumentCollection *col, SimilarityMatrix *matrix);
 void show_top_similarity_pairs(SimilarityMatrix *matrix, size_t top_n);
 void filter_similarity_pairs(SimilarityMatrix *matrix, double threshold);
 void show_heatmap(SimilarityMatrix *matrix);
@@ -3,6 +3,7 @@
 
 #include "hashtable.h"
 #include "text_processor.h"
+#include <stdint.h>
 
 // 向量结构
 typedef struct Vector {
@@ -11,6 +12,14 @@ typedef struct Vector {
     size_t capacity;
 } Vector;
 
+// 稀疏向量：按词项哈希升序存储非零分量
+typedef struct SparseVector {
+    uint64_t *keys;
+    double *values;
+    size_t size;
+    double norm;
+} SparseVector;
+
 // 向量操作函数
 Vector* vector_create(size_t capacity);
 void vector_destroy(Vector *vec);
@@ -27,7 +36,22 @@ double jaccard_similarity(HashTable *ht1, HashTable *ht2);
 
 // 文档相似度函数
 double document_cosine_similarity(Document *doc1, Document *doc2);
+double document_vector_similarity(Document *doc1, Document *doc2);
 char** build_vocabulary(Document **docs, size_t doc_count, size_t *vocab_size);
 void document_to_vector(Document *doc, Vector *vec, char **vocab, size_t vocab_size);
 
+// 稀疏向量函数
+uint64_t term_hash64(const char *term);
+SparseVector* sparse_vector_alloc(size_t size);
+SparseVector* sparse_vector_from_table(HashTable *ht);
+void sparse_vector_destroy(SparseVector *vec);
+double sparse_vector_dot(const SparseVector *a, const SparseVector *b);
+double sparse_vector_cosine(const SparseVector *a, const SparseVector *b);
+// 按键集合计算的 Jaccard 相似度（忽略分量值）；两个空向量为 0
+double sparse_vector_jaccard(const SparseVector *a, const SparseVector *b);
+// MinHash：对键集合做 k 次独立置换取最小值；两个签名相同位置的比例是 Jaccard 的无偏估计
+void minhash_signature(const SparseVector *vec, uint64_t *signature, size_t k);
+double minhash_similarity(const uint64_t *a, const uint64_t *b, size_t k);
+SparseVector* document_vector(Document *doc);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef VECTOR_STORE_H
+#define VECTOR_STORE_H
+
+#include "vector_math.h"
+#include "job_control.h"
+#include <stdio.h>
+
+// 磁盘上的文档向量仓库：向量按追加顺序写入文件，内存中只保留
+// 文件名与偏移表，按需分页读回，使数据集规模受磁盘而非内存限制。
+typedef struct VectorStore VectorStore;
+
+VectorStore* vector_store_create(const char *path);
+void vector_store_destroy(VectorStore *store);
+bool vector_store_append(VectorStore *store, const char *name, const SparseVector *vec);
+// job 可为 NULL；被取消时删除仓库文件并返回 NULL
+VectorStore* vector_store_build_from_dir(const char *dir_path, StopWords *stop_words,
+                                         const char *path, JobControl *job);
+
+size_t vector_store_count(const VectorStore *store);
+const char* vector_store_name(const VectorStore *store, size_t index);
+size_t vector_store_vector_bytes(const VectorStore *store, size_t index);
+SparseVector* vector_store_load(VectorStore *store, size_t index);
+
+#endif
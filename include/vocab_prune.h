@@ -0,0 +1,33 @@
+#ifndef VOCAB_PRUNE_H
+#define VOCAB_PRUNE_H
+
+#include "file_manager.h"
+
+// 集合级词表裁剪：在加载之后、计算相似度之前，按文档频率去掉只出现一两次的长尾词
+// 和几乎每个文档都有的词，并可限制每个文档保留的词项数。裁剪直接作用于各文档的
+// 词频表并丢弃缓存向量，之后 build_vocabulary、document_to_vector 与各矩阵引擎
+// 都在缩小后的词项空间上工作。
+typedef struct PruneOptions {
+    size_t min_df;          // 文档频率低于它的词项被去除；0 或 1 不限制
+    double max_df;          // 文档频率超过文档数的该比例时去除，取值 (0, 1]；0 不限制
+    size_t max_vocab;       // 按文档频率从高到低保留的最大词表规模；0 不限制
+    size_t top_terms;       // 每个文档按权重（词频）保留的最多词项数；0 不限制
+    size_t threads;         // 并行处理文档的线程数；0 使用 CPU 核心数
+} PruneOptions;
+
+typedef struct PruneStats {
+    size_t vocab_before;    // 裁剪前的不同词项数
+    size_t vocab_after;     // 全局规则（min_df/max_df/max_vocab）保留的词项数
+    size_t terms_before;    // 各文档词项数之和
+    size_t terms_after;
+} PruneStats;
+
+void prune_options_init(PruneOptions *options);
+// 是否设置了任何裁剪规则
+bool prune_options_active(const PruneOptions *options);
+
+// 裁剪集合中所有文档；stats 可为 NULL。内存不足时返回 false，此时部分文档可能已被裁剪。
+// 必须在 collection_set_weighting / collection_set_shingles 之前调用，集合已启用二者时返回 false
+bool collection_prune(DocumentCollection *col, const PruneOptions *options, PruneStats *stats);
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef WATCHER_H
+#define WATCHER_H
+
+#include "file_manager.h"
+#include "matrix_file.h"
+
+// 监视模式配置
+typedef struct WatchOptions {
+    const char *dir_path;
+    const char *output_file;    // 相似度矩阵，默认 CSV
+    const MatrixFileOptions *binary;    // 非 NULL 时按该格式写出二进制矩阵
+    const char *report_file;    // 最相似文档对报告
+    size_t top_n;
+    int debounce_ms;            // 最后一次事件后静默多久才处理一批变更
+} WatchOptions;
+
+// 监视目录：首次全量加载，之后只重新处理发生变化的 .txt 文件，
+// 每批变更后原子地重写输出文件。收到 SIGINT/SIGTERM 时返回 0。
+int watch_directory(const WatchOptions *options, StopWords *stop_words);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef WEIGHTING_H
+#define WEIGHTING_H
+
+#include "text_processor.h"
+#include "vector_math.h"
+
+// 词项加权方案
+typedef enum WeightScheme {
+    WEIGHT_RAW = 0,     // 原始词频 tf
+    WEIGHT_LOG_TF,      // 1 + ln(tf)
+    WEIGHT_TFIDF,       // tf × idf，idf = ln((N + 1) / (df + 1)) + 1
+    WEIGHT_BM25         // idf × tf(k1 + 1) / (tf + k1(1 - b + b·len/avglen))，
+                        // idf = ln(1 + (N - df + 0.5) / (df + 0.5))，k1 = 1.2，b = 0.75
+} WeightScheme;
+
+// 集合级词项统计：文档数、各词项的文档频率与文档总长度。
+// 文档加入或移除时只更新它自己的词项，O(文档词项数)，不需要重新扫描集合。
+// 非线程安全；term_weights_vector 只读，可在多个线程中同时调用。
+typedef struct TermWeights TermWeights;
+
+TermWeights* term_weights_create(WeightScheme scheme);
+void term_weights_destroy(TermWeights *tw);
+WeightScheme term_weights_scheme(const TermWeights *tw);
+
+bool term_weights_add_document(TermWeights *tw, const Document *doc);
+// doc 必须是之前加入过、且词频表未被修改的文档
+void term_weights_remove_document(TermWeights *tw, const Document *doc);
+
+size_t term_weights_doc_count(const TermWeights *tw);
+size_t term_weights_df(const TermWeights *tw, const char *term);
+// RAW 与 LOG_TF 方案返回 1
+double term_weights_idf(const TermWeights *tw, const char *term);
+
+// 按当前统计生成加权并归一化的稀疏向量：模长为 1（没有词项时为 0），
+// 两个这样的向量的点积就是余弦相似度
+SparseVector* term_weights_vector(const TermWeights *tw, const Document *doc);
+
+// 方案名：raw、log、tfidf、bm25
+bool weight_scheme_parse(const char *name, WeightScheme *scheme);
+const char* weight_scheme_name(WeightScheme scheme);
+
+#endif
@@ -0,0 +1,143 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define ARENA_DEFAULT_BLOCK (64 * 1024)
+#define ARENA_ALIGN 16
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;        // 可用字节数
+    size_t used;
+    // 数据紧随其后
+} ArenaBlock;
+
+struct Arena {
+    ArenaBlock *head;   // 当前块，链表按分配顺序倒序
+    size_t block_size;  // 第一个块的大小
+    size_t next_block;  // 下一个标准块的大小
+    size_t max_block;
+    size_t bytes_used;
+    MemoryTag tag;
+};
+
+// 块头向上取整到对齐边界，保证数据区对齐
+#define BLOCK_HEADER ((sizeof(ArenaBlock) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+static ArenaBlock* block_create(Arena *arena, size_t size) {
+    ArenaBlock *block = (ArenaBlock*)sim_memory_alloc(arena->tag, BLOCK_HEADER + size);
+    if (!block) return NULL;
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+static void block_free(Arena *arena, ArenaBlock *block) {
+    sim_memory_free(arena->tag, block, BLOCK_HEADER + block->size);
+}
+
+static unsigned char* block_data(ArenaBlock *block) {
+    return (unsigned char*)block + BLOCK_HEADER;
+}
+
+Arena* arena_create(size_t block_size) {
+    if (block_size == 0) block_size = ARENA_DEFAULT_BLOCK;
+    return arena_create_growing(block_size, block_size, MEM_DOCUMENT);
+}
+
+Arena* arena_create_growing(size_t first_block, size_t max_block, MemoryTag tag) {
+    Arena *arena = (Arena*)sim_memory_calloc(tag, 1, sizeof(Arena));
+    if (!arena) return NULL;
+    arena->block_size = first_block > 0 ? first_block : ARENA_DEFAULT_BLOCK;
+    arena->max_block = max_block > arena->block_size ? max_block : arena->block_size;
+    arena->next_block = arena->block_size;
+    arena->tag = tag;
+    return arena;
+}
+
+void arena_destroy(Arena *arena) {
+    if (!arena) return;
+    ArenaBlock *block = arena->head;
+    while (block) {
+        ArenaBlock *next = block->next;
+        block_free(arena, block);
+        block = next;
+    }
+    sim_memory_free(arena->tag, arena, sizeof(Arena));
+}
+
+void* arena_alloc(Arena *arena, size_t size) {
+    if (!arena) return NULL;
+    if (size == 0) size = 1;
+    if (size > SIZE_MAX - ARENA_ALIGN - BLOCK_HEADER) return NULL;
+    size_t rounded = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    ArenaBlock *block = arena->head;
+    if (!block || block->size - block->used < rounded) {
+        // 大对象单独成块并挂在当前块之后，当前块剩余空间继续可用
+        if (rounded > arena->next_block / 2 && block) {
+            ArenaBlock *big = block_create(arena, rounded);
+            if (!big) return NULL;
+            big->used = rounded;
+            big->next = block->next;
+            block->next = big;
+            arena->bytes_used += rounded;
+            return block_data(big);
+        }
+        size_t size_new = rounded > arena->next_block ? rounded : arena->next_block;
+        block = block_create(arena, size_new);
+        if (!block) return NULL;
+        if (arena->next_block < arena->max_block) {
+            arena->next_block = arena->next_block * 2 < arena->max_block ? arena->next_block * 2
+                                                                         : arena->max_block;
+        }
+        block->next = arena->head;
+        arena->head = block;
+    }
+
+    void *ptr = block_data(block) + block->used;
+    block->used += rounded;
+    arena->bytes_used += rounded;
+    return ptr;
+}
+
+char* arena_strndup(Arena *arena, const char *str, size_t len) {
+    if (!str || len == SIZE_MAX) return NULL;
+    char *copy = (char*)arena_alloc(arena, len + 1);
+    if (!copy) return NULL;
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+void arena_reset(Arena *arena) {
+    if (!arena || !arena->head) return;
+
+    // 保留最早分配的标准块（链表末尾），其余全部释放
+    ArenaBlock *keep = NULL;
+    ArenaBlock *block = arena->head;
+    while (block) {
+        ArenaBlock *next = block->next;
+        if (!next && block->size == arena->block_size) {
+            keep = block;
+        } else {
+            block_free(arena, block);
+        }
+        block = next;
+    }
+
+    if (keep) {
+        keep->used = 0;
+        keep->next = NULL;
+    }
+    arena->head = keep;
+    arena->bytes_used = 0;
+    arena->next_block = keep && arena->block_size < arena->max_block ? arena->block_size * 2
+                                                                     : arena->block_size;
+}
+
+size_t arena_bytes_used(const Arena *arena) {
+    return arena ? arena->bytes_used : 0;
+}
@@ -0,0 +1,257 @@
+#include "csv_writer.h"
+#include "sim_stats.h"
+#include "sim_trace.h"
+#include "sim_memory.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+
+#define CSV_BUFFER_SIZE (1 << 20)
+
+// 快速路径的取值范围与舍入保护带：放大后的小数部分离 .5 太近时交给 snprintf
+#define CSV_FAST_LIMIT 1e4
+#define CSV_TIE_GUARD 1e-6
+
+struct CsvWriter {
+#ifdef _WIN32
+    FILE *file;
+#else
+    int fd;
+#endif
+    char *path;
+    char *buffer;
+    size_t used;
+    bool ok;
+};
+
+size_t csv_format_cell(char *out, double value) {
+    double magnitude = fabs(value);
+    if (!(magnitude < CSV_FAST_LIMIT)) {
+        // NaN、无穷与大数走标准库
+        return (size_t)snprintf(out, CSV_CELL_MAX, "%.4f", value);
+    }
+
+    double scaled = magnitude * 10000.0;
+    double whole = floor(scaled);
+    double frac = scaled - whole;
+    if (fabs(frac - 0.5) < CSV_TIE_GUARD) {
+        // 恰好或接近进位边界，printf 按精确十进制值舍入
+        return (size_t)snprintf(out, CSV_CELL_MAX, "%.4f", value);
+    }
+
+    uint64_t units = (uint64_t)whole + (frac > 0.5 ? 1 : 0);
+    uint64_t integer = units / 10000;
+    unsigned decimals = (unsigned)(units % 10000);
+
+    char *p = out;
+    if (signbit(value)) *p++ = '-';
+
+    char digits[24];
+    size_t len = 0;
+    do {
+        digits[len++] = (char)('0' + integer % 10);
+        integer /= 10;
+    } while (integer > 0);
+    while (len > 0) *p++ = digits[--len];
+
+    p[0] = '.';
+    p[1] = (char)('0' + decimals / 1000);
+    p[2] = (char)('0' + decimals / 100 % 10);
+    p[3] = (char)('0' + decimals / 10 % 10);
+    p[4] = (char)('0' + decimals % 10);
+    return (size_t)(p + 5 - out);
+}
+
+// 把缓冲区与（可选的）额外数据一并写出
+static bool flush_with(CsvWriter *writer, const char *extra, size_t extra_len) {
+    if (!writer->ok) return false;
+    TRACE_BEGIN(span);
+
+#ifdef _WIN32
+    if (fwrite(writer->buffer, 1, writer->used, writer->file) != writer->used ||
+        (extra_len > 0 && fwrite(extra, 1, extra_len, writer->file) != extra_len)) {
+        writer->ok = false;
+    }
+#else
+    struct iovec iov[2];
+    int count = 0;
+    if (writer->used > 0) {
+        iov[count].iov_base = writer->buffer;
+        iov[count].iov_len = writer->used;
+        count++;
+    }
+    if (extra_len > 0) {
+        iov[count].iov_base = (void*)extra;
+        iov[count].iov_len = extra_len;
+        count++;
+    }
+
+    struct iovec *pending = iov;
+    while (count > 0) {
+        ssize_t written = writev(writer->fd, pending, count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            writer->ok = false;
+            break;
+        }
+
+        // 处理部分写入
+        size_t remaining = (size_t)written;
+        while (count > 0 && remaining >= pending->iov_len) {
+            remaining -= pending->iov_len;
+            pending++;
+            count--;
+        }
+        if (count > 0) {
+            pending->iov_base = (char*)pending->iov_base + remaining;
+            pending->iov_len -= remaining;
+        }
+    }
+#endif
+
+    if (!writer->ok) {
+        fprintf(stderr, "错误: 写入文件失败 %s\n", writer->path);
+    }
+    STATS_COUNT(STAT_OUTPUT_BYTES, writer->used + extra_len);
+    TRACE_END(span, "output_flush", writer->used + extra_len);
+    writer->used = 0;
+    return writer->ok;
+}
+
+// 保证缓冲区至少还有 len 字节空间
+static bool reserve(CsvWriter *writer, size_t len) {
+    if (writer->used + len <= CSV_BUFFER_SIZE) return writer->ok;
+    return flush_with(writer, NULL, 0);
+}
+
+CsvWriter* csv_writer_open(const char *path) {
+    if (!path) return NULL;
+
+    CsvWriter *writer = (CsvWriter*)calloc(1, sizeof(CsvWriter));
+    if (!writer) return NULL;
+
+    writer->path = strdup(path);
+    writer->buffer = (char*)sim_memory_alloc(MEM_UI, CSV_BUFFER_SIZE);
+    writer->ok = true;
+#ifdef _WIN32
+    writer->file = fopen(path, "w");
+    bool opened = writer->file != NULL;
+#else
+    writer->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool opened = writer->fd >= 0;
+#endif
+
+    if (!opened || !writer->path || !writer->buffer) {
+        fprintf(stderr, "错误: 无法创建文件 %s\n", path);
+#ifdef _WIN32
+        if (writer->file) fclose(writer->file);
+#else
+        if (writer->fd >= 0) close(writer->fd);
+#endif
+        free(writer->path);
+        sim_memory_free(MEM_UI, writer->buffer, CSV_BUFFER_SIZE);
+        free(writer);
+        return NULL;
+    }
+
+    return writer;
+}
+
+// 刷新并关闭，返回整个写出过程是否成功
+bool csv_writer_close(CsvWriter *writer) {
+    if (!writer) return false;
+
+    bool ok = flush_with(writer, NULL, 0);
+#ifdef _WIN32
+    if (fclose(writer->file) != 0) ok = false;
+#else
+    if (close(writer->fd) != 0) ok = false;
+#endif
+
+    free(writer->path);
+    sim_memory_free(MEM_UI, writer->buffer, CSV_BUFFER_SIZE);
+    free(writer);
+    return ok;
+}
+
+bool csv_writer_write(CsvWriter *writer, const char *data, size_t len) {
+    if (!writer || !writer->ok) return false;
+
+    if (writer->used + len <= CSV_BUFFER_SIZE) {
+        memcpy(writer->buffer + writer->used, data, len);
+        writer->used += len;
+        return true;
+    }
+
+    // 放不下时不再拷贝，缓冲区与新数据合并为一次 writev
+    return flush_with(writer, data, len);
+}
+
+static bool write_string(CsvWriter *writer, char prefix, const char *str) {
+    if (prefix && !csv_writer_write(writer, &prefix, 1)) return false;
+    return csv_writer_write(writer, str, strlen(str));
+}
+
+static bool write_header(CsvWriter *writer, char **filenames, size_t count) {
+    if (!write_string(writer, 0, "Filename")) return false;
+    for (size_t i = 0; i < count; i++) {
+        if (!write_string(writer, ',', filenames[i])) return false;
+    }
+    return csv_writer_write(writer, "\n", 1);
+}
+
+static bool write_row(CsvWriter *writer, const char *name, const double *values, size_t count) {
+    if (!write_string(writer, 0, name)) return false;
+
+    for (size_t j = 0; j < count; j++) {
+        if (!reserve(writer, CSV_CELL_MAX + 1)) return false;
+        writer->buffer[writer->used++] = ',';
+        writer->used += csv_format_cell(writer->buffer + writer->used, values[j]);
+    }
+
+    return csv_writer_write(writer, "\n", 1);
+}
+
+static bool write_row_f32(CsvWriter *writer, const char *name, const float *values, size_t count) {
+    if (!write_string(writer, 0, name)) return false;
+
+    for (size_t j = 0; j < count; j++) {
+        if (!reserve(writer, CSV_CELL_MAX + 1)) return false;
+        writer->buffer[writer->used++] = ',';
+        writer->used += csv_format_cell(writer->buffer + writer->used, values[j]);
+    }
+
+    return csv_writer_write(writer, "\n", 1);
+}
+
+// 标题行: Filename,<文件名>...
+bool csv_writer_write_header(CsvWriter *writer, char **filenames, size_t count) {
+    STATS_TIMER_START(timer);
+    bool ok = write_header(writer, filenames, count);
+    STATS_TIMER_LAP(timer, STAT_PHASE_OUTPUT);
+    return ok;
+}
+
+// 数据行: <文件名>,<值>...，单元格直接格式化进缓冲区
+bool csv_writer_write_row(CsvWriter *writer, const char *name, const double *values, size_t count) {
+    STATS_TIMER_START(timer);
+    bool ok = write_row(writer, name, values, count);
+    STATS_TIMER_LAP(timer, STAT_PHASE_OUTPUT);
+    return ok;
+}
+
+bool csv_writer_write_row_f32(CsvWriter *writer, const char *name, const float *values, size_t count) {
+    STATS_TIMER_START(timer);
+    bool ok = write_row_f32(writer, name, values, count);
+    STATS_TIMER_LAP(timer, STAT_PHASE_OUTPUT);
+    return ok;
+}
@@ -0,0 +1,515 @@
+#include "doc_store.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define STORE_INITIAL_BUCKETS 64
+#define PAIR_CACHE_WAYS 4
+
+// 文档键：两个独立的 64 位内容哈希加长度。仓库不保留原文，无法逐字节比较，
+// 两个哈希同时碰撞才会把不同内容当作同一文档
+typedef struct StoreKey {
+    uint64_t hash;                  // FNV-1a，决定哈希桶
+    uint64_t check;                 // 按 8 字节分组的乘法混合哈希
+    size_t length;
+} StoreKey;
+
+// 仓库中的一个文档：只保留处理后的向量，原文与词频表在处理完后即释放
+typedef struct StoreEntry {
+    StoreKey key;
+    SparseVector *vector;
+    size_t bytes;
+    size_t pins;                    // 正在使用它的调用数，被钉住的条目不会被淘汰
+    struct StoreEntry *prev;        // LRU 链表，头部为最近使用
+    struct StoreEntry *next;
+    struct StoreEntry *chain;       // 哈希桶链
+} StoreEntry;
+
+// 相似度缓存槽：按两个文档的键寻址，不引用条目本身，文档被淘汰后缓存仍然有效
+typedef struct PairSlot {
+    StoreKey a;
+    StoreKey b;
+    double score;
+    uint64_t stamp;                 // 0 表示空槽，否则为最近访问时间
+} PairSlot;
+
+struct DocumentStore {
+    StopWords *stop_words;
+    size_t budget;
+    StoreEntry **buckets;
+    size_t bucket_count;
+    StoreEntry *lru_head;
+    StoreEntry *lru_tail;
+    PairSlot *pairs;
+    size_t pair_sets;
+    uint64_t pair_clock;
+    DocStoreStats stats;
+    pthread_mutex_t lock;
+};
+
+// 内容哈希 (FNV-1a 64)
+uint64_t content_hash64(const char *data, size_t len) {
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 31;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 29;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 32;
+    return x;
+}
+
+// 与 FNV-1a 独立的第二个哈希，每次处理 8 字节
+static uint64_t content_check64(const char *data, size_t len) {
+    uint64_t hash = 0x243F6A8885A308D3ULL ^ len;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ mix64(word)) * 0x9E3779B97F4A7C15ULL;
+    }
+    uint64_t tail = 0;
+    for (size_t k = 0; i + k < len; k++) {
+        tail |= (uint64_t)(unsigned char)data[i + k] << (8 * k);
+    }
+    return mix64(hash ^ mix64(tail));
+}
+
+// 同一内容按不同切分长度得到不同的向量，长度并入键中，文档对缓存随之区分
+static StoreKey store_key(const char *data, size_t len, size_t ngram) {
+    StoreKey key;
+    key.hash = content_hash64(data, len) ^ ((uint64_t)ngram * 0x9E3779B97F4A7C15ULL);
+    key.check = content_check64(data, len) ^ ngram;
+    key.length = len;
+    return key;
+}
+
+static bool key_equal(const StoreKey *x, const StoreKey *y) {
+    return x->hash == y->hash && x->check == y->check && x->length == y->length;
+}
+
+static bool key_less(const StoreKey *x, const StoreKey *y) {
+    if (x->hash != y->hash) return x->hash < y->hash;
+    if (x->check != y->check) return x->check < y->check;
+    return x->length < y->length;
+}
+
+DocumentStore* doc_store_create(StopWords *stop_words, size_t memory_budget, size_t pair_cache_entries) {
+    DocumentStore *store = (DocumentStore*)calloc(1, sizeof(DocumentStore));
+    if (!store) return NULL;
+
+    store->stop_words = stop_words;
+    store->budget = memory_budget;
+    store->bucket_count = STORE_INITIAL_BUCKETS;
+    store->buckets = (StoreEntry**)calloc(store->bucket_count, sizeof(StoreEntry*));
+
+    // 组数取不超过 entries / ways 的 2 的幂
+    size_t sets = 0;
+    if (pair_cache_entries >= PAIR_CACHE_WAYS) {
+        sets = 1;
+        while (sets * 2 * PAIR_CACHE_WAYS <= pair_cache_entries) sets *= 2;
+        store->pairs = (PairSlot*)calloc(sets * PAIR_CACHE_WAYS, sizeof(PairSlot));
+    }
+    store->pair_sets = store->pairs ? sets : 0;
+
+    if (!store->buckets || (sets > 0 && !store->pairs)) {
+        free(store->buckets);
+        free(store->pairs);
+        free(store);
+        return NULL;
+    }
+
+    pthread_mutex_init(&store->lock, NULL);
+    return store;
+}
+
+static void entry_free(StoreEntry *entry) {
+    sparse_vector_destroy(entry->vector);
+    free(entry);
+}
+
+static void lru_unlink(DocumentStore *store, StoreEntry *entry) {
+    if (entry->prev) entry->prev->next = entry->next;
+    else store->lru_head = entry->next;
+    if (entry->next) entry->next->prev = entry->prev;
+    else store->lru_tail = entry->prev;
+    entry->prev = entry->next = NULL;
+}
+
+static void lru_push_front(DocumentStore *store, StoreEntry *entry) {
+    entry->prev = NULL;
+    entry->next = store->lru_head;
+    if (store->lru_head) store->lru_head->prev = entry;
+    store->lru_head = entry;
+    if (!store->lru_tail) store->lru_tail = entry;
+}
+
+static void clear_entries(DocumentStore *store) {
+    StoreEntry *entry = store->lru_head;
+    while (entry) {
+        StoreEntry *next = entry->next;
+        entry_free(entry);
+        entry = next;
+    }
+    memset(store->buckets, 0, store->bucket_count * sizeof(StoreEntry*));
+    store->lru_head = store->lru_tail = NULL;
+    store->stats.documents = 0;
+    store->stats.bytes = 0;
+}
+
+void doc_store_destroy(DocumentStore *store) {
+    if (!store) return;
+
+    clear_entries(store);
+    pthread_mutex_destroy(&store->lock);
+    free(store->buckets);
+    free(store->pairs);
+    free(store);
+}
+
+// 清空驻留文档与相似度缓存，统计计数保留
+void doc_store_clear(DocumentStore *store) {
+    if (!store) return;
+
+    pthread_mutex_lock(&store->lock);
+    clear_entries(store);
+    if (store->pairs) {
+        memset(store->pairs, 0, store->pair_sets * PAIR_CACHE_WAYS * sizeof(PairSlot));
+    }
+    pthread_mutex_unlock(&store->lock);
+}
+
+void doc_store_get_stats(DocumentStore *store, DocStoreStats *stats) {
+    if (!store || !stats) return;
+
+    pthread_mutex_lock(&store->lock);
+    *stats = store->stats;
+    pthread_mutex_unlock(&store->lock);
+}
+
+static StoreEntry* find_entry(DocumentStore *store, const StoreKey *key) {
+    StoreEntry *entry = store->buckets[key->hash & (store->bucket_count - 1)];
+    while (entry && !key_equal(&entry->key, key)) {
+        entry = entry->chain;
+    }
+    return entry;
+}
+
+static void unlink_chain(DocumentStore *store, StoreEntry *entry) {
+    StoreEntry **slot = &store->buckets[entry->key.hash & (store->bucket_count - 1)];
+    while (*slot != entry) slot = &(*slot)->chain;
+    *slot = entry->chain;
+}
+
+// 文档数超过桶数时桶数翻倍
+static void maybe_grow_buckets(DocumentStore *store) {
+    if (store->stats.documents < store->bucket_count) return;
+
+    size_t new_count = store->bucket_count * 2;
+    StoreEntry **new_buckets = (StoreEntry**)calloc(new_count, sizeof(StoreEntry*));
+    if (!new_buckets) return;
+
+    for (StoreEntry *entry = store->lru_head; entry; entry = entry->next) {
+        size_t index = entry->key.hash & (new_count - 1);
+        entry->chain = new_buckets[index];
+        new_buckets[index] = entry;
+    }
+
+    free(store->buckets);
+    store->buckets = new_buckets;
+    store->bucket_count = new_count;
+}
+
+// 分词并向量化一个新文档（不访问仓库状态，可在锁外执行）
+static SparseVector* vectorize(const char *name, const char *data, size_t length, StopWords *stop_words) {
+    Document *doc = document_create_from_buffer(name, data, length);
+    if (!doc) return NULL;
+
+    SparseVector *vector = NULL;
+    if (document_process(doc, stop_words) && document_vector(doc)) {
+        // 接管缓存向量，文档其余部分立即释放
+        vector = doc->vector;
+        doc->vector = NULL;
+    }
+    document_destroy(doc);
+    return vector;
+}
+
+// 把新向量加入仓库，需持有锁
+static StoreEntry* insert_entry(DocumentStore *store, const StoreKey *key, SparseVector *vector) {
+    StoreEntry *entry = (StoreEntry*)calloc(1, sizeof(StoreEntry));
+    if (!entry) return NULL;
+
+    entry->key = *key;
+    entry->vector = vector;
+    entry->bytes = sizeof(StoreEntry) + sizeof(SparseVector) +
+                   vector->size * (sizeof(uint64_t) + sizeof(double));
+
+    size_t index = key->hash & (store->bucket_count - 1);
+    entry->chain = store->buckets[index];
+    store->buckets[index] = entry;
+    lru_push_front(store, entry);
+
+    store->stats.documents++;
+    store->stats.bytes += entry->bytes;
+    maybe_grow_buckets(store);
+    return entry;
+}
+
+// 从 LRU 尾部淘汰，直到回到预算以内；被钉住的条目跳过
+static void evict_over_budget(DocumentStore *store) {
+    StoreEntry *entry = store->lru_tail;
+    while (entry && store->stats.bytes > store->budget) {
+        StoreEntry *prev = entry->prev;
+        if (entry->pins == 0) {
+            lru_unlink(store, entry);
+            unlink_chain(store, entry);
+            store->stats.documents--;
+            store->stats.bytes -= entry->bytes;
+            store->stats.evictions++;
+            entry_free(entry);
+        }
+        entry = prev;
+    }
+}
+
+static size_t pair_set(const StoreKey *a, const StoreKey *b, size_t sets) {
+    uint64_t key = a->hash ^ (b->hash * 0x9E3779B97F4A7C15ULL);
+    key ^= key >> 31;
+    key *= 0xBF58476D1CE4E5B9ULL;
+    key ^= key >> 29;
+    return (size_t)(key & (sets - 1));
+}
+
+static bool pair_matches(const PairSlot *slot, const StoreKey *a, const StoreKey *b) {
+    return slot->stamp != 0 && key_equal(&slot->a, a) && key_equal(&slot->b, b);
+}
+
+// 查找缓存的文档对相似度，需持有锁
+static bool pair_lookup(DocumentStore *store, const StoreKey *x, const StoreKey *y, double *score) {
+    // 余弦相似度对称，键按大小排序
+    const StoreKey *a = key_less(x, y) ? x : y;
+    const StoreKey *b = key_less(x, y) ? y : x;
+    PairSlot *set = store->pairs + pair_set(a, b, store->pair_sets) * PAIR_CACHE_WAYS;
+
+    for (size_t w = 0; w < PAIR_CACHE_WAYS; w++) {
+        if (pair_matches(&set[w], a, b)) {
+            set[w].stamp = ++store->pair_clock;
+            *score = set[w].score;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 写入文档对相似度，替换组内最久未访问的槽，需持有锁
+static void pair_store(DocumentStore *store, const StoreKey *x, const StoreKey *y, double score) {
+    const StoreKey *a = key_less(x, y) ? x : y;
+    const StoreKey *b = key_less(x, y) ? y : x;
+    PairSlot *set = store->pairs + pair_set(a, b, store->pair_sets) * PAIR_CACHE_WAYS;
+
+    PairSlot *victim = &set[0];
+    for (size_t w = 0; w < PAIR_CACHE_WAYS; w++) {
+        if (pair_matches(&set[w], a, b)) {
+            victim = &set[w];
+            break;
+        }
+        if (set[w].stamp < victim->stamp) victim = &set[w];
+    }
+
+    victim->a = *a;
+    victim->b = *b;
+    victim->score = score;
+    victim->stamp = ++store->pair_clock;
+}
+
+// 找到或钉住已有条目，需持有锁
+static StoreEntry* pin_existing(DocumentStore *store, const StoreKey *key) {
+    StoreEntry *entry = find_entry(store, key);
+    if (entry) {
+        entry->pins++;
+        lru_unlink(store, entry);
+        lru_push_front(store, entry);
+    }
+    return entry;
+}
+
+// 计算一组内存文档的相似度矩阵
+// 锁只在查表/插入时持有：新文档的分词与未命中文档对的计算都在锁外进行，
+// 期间用到的条目被钉住，因此多个调用可以并发执行。
+SimilarityMatrix* doc_store_matrix(DocumentStore *store, const char **names, const char **buffers,
+                                   const size_t *lengths, size_t count) {
+    return doc_store_matrix_job(store, names, buffers, lengths, count, NULL);
+}
+
+SimilarityMatrix* doc_store_matrix_job(DocumentStore *store, const char **names, const char **buffers,
+                                       const size_t *lengths, size_t count, JobControl *job) {
+    if (!store || !names || !buffers || !lengths || count == 0) return NULL;
+
+    StoreEntry **entries = (StoreEntry**)calloc(count, sizeof(StoreEntry*));
+    StoreKey *keys = (StoreKey*)calloc(count, sizeof(StoreKey));
+    SparseVector **fresh = (SparseVector**)calloc(count, sizeof(SparseVector*));
+    size_t *alias = (size_t*)malloc(count * sizeof(size_t));
+    size_t *pending = (size_t*)malloc(count * sizeof(size_t));
+    if (!entries || !keys || !fresh || !alias || !pending) {
+        free(entries);
+        free(keys);
+        free(fresh);
+        free(alias);
+        free(pending);
+        return NULL;
+    }
+
+    size_t ngram = stop_words_cjk_ngram(store->stop_words);
+    for (size_t i = 0; i < count; i++) {
+        if (buffers[i] && lengths[i] > 0) keys[i] = store_key(buffers[i], lengths[i], ngram);
+    }
+
+    // 1. 查找已驻留的文档；本次调用内重复的新内容只处理第一份（原文都在，逐字节比较）
+    size_t pending_count = 0;
+    pthread_mutex_lock(&store->lock);
+    for (size_t i = 0; i < count; i++) {
+        alias[i] = SIZE_MAX;
+        if (!buffers[i] || lengths[i] == 0) continue;
+        entries[i] = pin_existing(store, &keys[i]);
+        if (entries[i]) {
+            store->stats.doc_hits++;
+            continue;
+        }
+
+        for (size_t k = 0; k < pending_count; k++) {
+            size_t j = pending[k];
+            if (key_equal(&keys[j], &keys[i]) && memcmp(buffers[j], buffers[i], lengths[i]) == 0) {
+                alias[i] = j;
+                break;
+            }
+        }
+        if (alias[i] != SIZE_MAX) {
+            store->stats.doc_hits++;
+        } else {
+            store->stats.doc_misses++;
+            pending[pending_count++] = i;
+        }
+    }
+    pthread_mutex_unlock(&store->lock);
+    free(pending);
+
+    // 2. 锁外处理新内容，每个文档后报告进度并检查取消
+    bool ok = true;
+    for (size_t i = 0; ok && i < count; i++) {
+        if (!entries[i] && alias[i] == SIZE_MAX && buffers[i] && lengths[i] > 0) {
+            fresh[i] = vectorize(names[i], buffers[i], lengths[i], store->stop_words);
+            job_control_add_bytes(job, lengths[i]);
+        }
+        ok = job_control_report(job, JOB_STAGE_LOAD, i + 1, count);
+    }
+
+    // 3. 插入新向量；其他调用可能已插入相同内容，此时复用已有条目
+    pthread_mutex_lock(&store->lock);
+    for (size_t i = 0; i < count; i++) {
+        if (!fresh[i]) continue;
+        entries[i] = pin_existing(store, &keys[i]);
+        if (!entries[i]) {
+            entries[i] = insert_entry(store, &keys[i], fresh[i]);
+            if (entries[i]) {
+                entries[i]->pins = 1;
+                fresh[i] = NULL;
+            }
+        }
+        sparse_vector_destroy(fresh[i]);
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (alias[i] != SIZE_MAX && entries[alias[i]]) {
+            entries[i] = entries[alias[i]];
+            entries[i]->pins++;
+        }
+    }
+    pthread_mutex_unlock(&store->lock);
+    free(fresh);
+    free(alias);
+
+    // 只保留成功处理的文档
+    size_t n = 0;
+    const char **kept = (const char**)malloc(count * sizeof(char*));
+    for (size_t i = 0; i < count; i++) {
+        if (entries[i]) {
+            if (kept) kept[n] = names[i];
+            entries[n] = entries[i];
+            n++;
+        }
+    }
+    SimilarityMatrix *matrix = kept && ok ? similarity_matrix_alloc_named(kept, n) : NULL;
+    free(kept);
+
+    // 4. 先从缓存取已知的文档对，未命中的记入位图
+    size_t pair_total = n * n;
+    unsigned char *missed = matrix ? (unsigned char*)calloc(pair_total / 8 + 1, 1) : NULL;
+    if (matrix && missed) {
+        pthread_mutex_lock(&store->lock);
+        for (size_t i = 0; i < n; i++) {
+            matrix->matrix[i][i] = 1.0;
+            for (size_t j = i + 1; j < n; j++) {
+                double score;
+                if (store->pairs && pair_lookup(store, &entries[i]->key, &entries[j]->key, &score)) {
+                    store->stats.pair_hits++;
+                    matrix->matrix[i][j] = score;
+                    matrix->matrix[j][i] = score;
+                } else {
+                    store->stats.pair_misses++;
+                    missed[(i * n + j) / 8] |= (unsigned char)(1u << ((i * n + j) % 8));
+                }
+            }
+        }
+        pthread_mutex_unlock(&store->lock);
+
+        // 5. 锁外计算未命中的文档对（条目已钉住，向量不会被释放），每行检查取消
+        size_t total_pairs = n * (n - 1) / 2;
+        size_t pairs_done = 0;
+        for (size_t i = 0; ok && i < n; i++) {
+            for (size_t j = i + 1; j < n; j++) {
+                if (missed[(i * n + j) / 8] & (1u << ((i * n + j) % 8))) {
+                    double score = sparse_vector_cosine(entries[i]->vector, entries[j]->vector);
+                    matrix->matrix[i][j] = score;
+                    matrix->matrix[j][i] = score;
+                }
+            }
+            pairs_done += n - i - 1;
+            ok = job_control_report(job, JOB_STAGE_MATRIX, pairs_done, total_pairs);
+        }
+    }
+    if (!ok || !missed) {
+        similarity_matrix_destroy(matrix);
+        matrix = NULL;
+    }
+
+    // 6. 写回缓存、解除钉住并按预算淘汰
+    pthread_mutex_lock(&store->lock);
+    for (size_t i = 0; matrix && store->pairs && i < n; i++) {
+        for (size_t j = i + 1; j < n; j++) {
+            if (missed[(i * n + j) / 8] & (1u << ((i * n + j) % 8))) {
+                pair_store(store, &entries[i]->key, &entries[j]->key, matrix->matrix[i][j]);
+            }
+        }
+    }
+    // 先淘汰再解除钉住：本次用到的文档至少保留到下一次调用
+    evict_over_budget(store);
+    for (size_t i = 0; i < n; i++) {
+        entries[i]->pins--;
+    }
+    pthread_mutex_unlock(&store->lock);
+
+    free(missed);
+    free(entries);
+    free(keys);
+    return matrix;
+}
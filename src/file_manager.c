@@ -1,4 +1,8 @@
 #include "file_manager.h"
+#include "csv_writer.h"
+#include "sim_stats.h"
+#include "sim_trace.h"
+#include "sim_memory.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,39 +10,92 @@
 #include <sys/stat.h>
 
 #define COLLECTION_INITIAL_CAPACITY 10
+#define MATRIX_MIN_CAPACITY 8
 
 // 创建文档集合
 DocumentCollection* collection_create(size_t capacity) {
-    DocumentCollection *col = (DocumentCollection*)malloc(sizeof(DocumentCollection));
+    DocumentCollection *col = (DocumentCollection*)sim_memory_alloc(MEM_DOCUMENT, sizeof(DocumentCollection));
     if (!col) return NULL;
     
     col->capacity = capacity > 0 ? capacity : COLLECTION_INITIAL_CAPACITY;
     col->count = 0;
-    col->documents = (Document**)malloc(col->capacity * sizeof(Document*));
+    col->weights = NULL;
+    shingle_options_init(&col->shingles);
+    col->documents = (Document**)sim_memory_alloc(MEM_DOCUMENT, col->capacity * sizeof(Document*));
     
     if (!col->documents) {
-        free(col);
+        sim_memory_free(MEM_DOCUMENT, col, sizeof(DocumentCollection));
         return NULL;
     }
     
     return col;
 }
 
+// 用加权向量替换文档的缓存向量
+static bool weigh_document(TermWeights *weights, Document *doc) {
+    SparseVector *vec = term_weights_vector(weights, doc);
+    if (!vec) return false;
+    sparse_vector_destroy(doc->vector);
+    doc->vector = vec;
+    return true;
+}
+
+// 已启用加权时登记文档并生成加权向量，已启用 shingle 时生成 shingle 特征
+static bool collection_register_document(DocumentCollection *col, Document *doc) {
+    if (shingle_options_active(&col->shingles)) return document_shingle(doc, &col->shingles);
+    if (!col->weights) return true;
+    if (!term_weights_add_document(col->weights, doc)) return false;
+    if (!weigh_document(col->weights, doc)) {
+        term_weights_remove_document(col->weights, doc);
+        return false;
+    }
+    return true;
+}
+
 // 向集合添加文档
 bool collection_add_document(DocumentCollection *col, Document *doc) {
     if (!col || !doc) return false;
     
     if (col->count >= col->capacity) {
-        col->capacity *= 2;
-        Document **new_docs = realloc(col->documents, col->capacity * sizeof(Document*));
+        Document **new_docs = sim_memory_realloc(MEM_DOCUMENT, col->documents,
+                                                 col->capacity * sizeof(Document*),
+                                                 col->capacity * 2 * sizeof(Document*));
         if (!new_docs) return false;
         col->documents = new_docs;
+        col->capacity *= 2;
     }
     
+    if (!collection_register_document(col, doc)) return false;
     col->documents[col->count++] = doc;
     return true;
 }
 
+// 从集合中移除并销毁文档，保持其余文档顺序
+bool collection_remove_document(DocumentCollection *col, size_t index) {
+    if (!col || index >= col->count) return false;
+    
+    term_weights_remove_document(col->weights, col->documents[index]);
+    document_destroy(col->documents[index]);
+    memmove(&col->documents[index], &col->documents[index + 1],
+            (col->count - index - 1) * sizeof(Document*));
+    col->count--;
+    return true;
+}
+
+// 按文件名查找文档
+bool collection_find_document(DocumentCollection *col, const char *filename, size_t *index) {
+    if (!col || !filename) return false;
+    
+    for (size_t i = 0; i < col->count; i++) {
+        if (strcmp(col->documents[i]->filename, filename) == 0) {
+            if (index) *index = i;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
 // 销毁文档集合
 void collection_destroy(DocumentCollection *col) {
     if (!col) return;
@@ -47,28 +104,115 @@ void collection_destroy(DocumentCollection *col) {
         document_destroy(col->documents[i]);
     }
     
-    free(col->documents);
-    free(col);
+    term_weights_destroy(col->weights);
+    sim_memory_free(MEM_DOCUMENT, col->documents, col->capacity * sizeof(Document*));
+    sim_memory_free(MEM_DOCUMENT, col, sizeof(DocumentCollection));
 }
 
-// 从目录加载文档
-DocumentCollection* load_documents_from_dir(const char *dir_path, StopWords *stop_words) {
+// 丢弃所有缓存向量，之后按词频重建
+static void collection_drop_vectors(DocumentCollection *col) {
+    for (size_t i = 0; i < col->count; i++) {
+        sparse_vector_destroy(col->documents[i]->vector);
+        col->documents[i]->vector = NULL;
+    }
+}
+
+// 启用或更换加权方案：一遍统计文档频率，再为每个文档生成加权向量
+bool collection_set_weighting(DocumentCollection *col, WeightScheme scheme) {
+    if (!col) return false;
+    if (shingle_options_active(&col->shingles)) {
+        fprintf(stderr, "错误: 加权只适用于词频特征，集合已使用 shingle 特征\n");
+        return false;
+    }
+    
+    TermWeights *weights = term_weights_create(scheme);
+    if (!weights) return false;
+    for (size_t i = 0; i < col->count; i++) {
+        if (!term_weights_add_document(weights, col->documents[i])) {
+            term_weights_destroy(weights);
+            return false;
+        }
+    }
+    
+    STATS_TIMER_START(timer);
+    TRACE_BEGIN(span);
+    for (size_t i = 0; i < col->count; i++) {
+        if (!weigh_document(weights, col->documents[i])) {
+            // 新旧方案的向量混在一起，全部丢弃，之后按原始词频重建
+            collection_drop_vectors(col);
+            term_weights_destroy(weights);
+            term_weights_destroy(col->weights);
+            col->weights = NULL;
+            return false;
+        }
+    }
+    TRACE_END(span, "weighting", col->count);
+    STATS_TIMER_LAP(timer, STAT_PHASE_VECTORIZE);
+    STATS_COUNT(STAT_VECTORS, col->count);
+    
+    term_weights_destroy(col->weights);
+    col->weights = weights;
+    return true;
+}
+
+// 启用或更换 shingle 特征
+bool collection_set_shingles(DocumentCollection *col, const ShingleOptions *options) {
+    if (!col || !options) return false;
+    if (col->weights) {
+        fprintf(stderr, "错误: 集合已启用词项加权，不能同时使用 shingle 特征\n");
+        return false;
+    }
+    
+    if (!shingle_options_active(options)) {
+        if (shingle_options_active(&col->shingles)) collection_drop_vectors(col);
+        shingle_options_init(&col->shingles);
+        return true;
+    }
+    
+    for (size_t i = 0; i < col->count; i++) {
+        if (!document_shingle(col->documents[i], options)) {
+            // 新旧特征的向量混在一起，全部丢弃，之后按词频重建
+            collection_drop_vectors(col);
+            shingle_options_init(&col->shingles);
+            return false;
+        }
+    }
+    col->shingles = *options;
+    return true;
+}
+
+// 遍历目录中的文档，逐个加载处理后交给回调
+size_t for_each_document_in_dir(const char *dir_path, StopWords *stop_words,
+                                DocumentVisitor visitor, void *userdata) {
+    return for_each_document_in_dir_job(dir_path, stop_words, visitor, userdata, NULL);
+}
+
+// 同上，每个文件处理完后报告进度并检查取消
+size_t for_each_document_in_dir_job(const char *dir_path, StopWords *stop_words,
+                                    DocumentVisitor visitor, void *userdata, JobControl *job) {
+    if (!dir_path || !visitor) return 0;
+    
     DIR *dir = opendir(dir_path);
     if (!dir) {
         fprintf(stderr, "错误: 无法打开目录 %s\n", dir_path);
-        return NULL;
-    }
-    
-    DocumentCollection *col = collection_create(COLLECTION_INITIAL_CAPACITY);
-    if (!col) {
-        closedir(dir);
-        return NULL;
+        return 0;
     }
     
     struct dirent *entry;
     char filepath[512];
+    size_t visited = 0;
     
+    // 遍历计时不含文件读取与文本处理，二者在各自函数内计时
+    STATS_TIMER_START(timer);
     while ((entry = readdir(dir)) != NULL) {
+        if (job && !job_control_report(job, JOB_STAGE_LOAD, visited, 0)) {
+            break;
+        }
+        // 超出内存预算后继续加载只会得到不完整的结果
+        if (sim_memory_budget_exceeded()) {
+            break;
+        }
+        
         // 检查文件扩展名
         char *dot = strrchr(entry->d_name, '.');
         if (!dot || strcmp(dot, ".txt") != 0) {
@@ -84,6 +228,8 @@ DocumentCollection* load_documents_from_dir(const char *dir_path, StopWords *sto
             continue;
         }
         
+        STATS_TIMER_LAP(timer, STAT_PHASE_SCAN);
+        
         // 创建并处理文档
         Document *doc = document_create(entry->d_name);
         if (!doc) {
@@ -92,59 +238,159 @@ DocumentCollection* load_documents_from_dir(const char *dir_path, StopWords *sto
         
         if (document_load_from_file(doc, filepath) &&
             document_process(doc, stop_words)) {
-            collection_add_document(col, doc);
-            printf("已加载文档: %s\n", entry->d_name);
+            visited++;
+            job_control_add_bytes(job, (size_t)path_stat.st_size);
+            // 回调返回 true 表示接管了文档的所有权
+            if (!visitor(doc, entry->d_name, userdata)) {
+                document_destroy(doc);
+            }
         } else {
             document_destroy(doc);
         }
+        STATS_TIMER_RESTART(timer);
     }
     
     closedir(dir);
+    STATS_TIMER_LAP(timer, STAT_PHASE_SCAN);
+    // 遍历结束后总量已知
+    if (!job_control_cancelled(job)) {
+        job_control_report(job, JOB_STAGE_LOAD, visited, visited);
+    }
+    return visited;
+}
+
+// 将文档加入集合的回调
+static bool collect_document(Document *doc, const char *name, void *userdata) {
+    DocumentCollection *col = (DocumentCollection*)userdata;
+    if (!collection_add_document(col, doc)) {
+        return false;
+    }
+    printf("已加载文档: %s\n", name);
+    return true;
+}
+
+// 从目录加载文档
+DocumentCollection* load_documents_from_dir(const char *dir_path, StopWords *stop_words) {
+    return load_documents_from_dir_job(dir_path, stop_words, NULL);
+}
+
+// 从目录加载文档，可报告进度与取消；被取消时返回 NULL
+DocumentCollection* load_documents_from_dir_job(const char *dir_path, StopWords *stop_words,
+                                                JobControl *job) {
+    DIR *dir = opendir(dir_path);
+    if (!dir) {
+        fprintf(stderr, "错误: 无法打开目录 %s\n", dir_path);
+        return NULL;
+    }
+    closedir(dir);
+    
+    DocumentCollection *col = collection_create(COLLECTION_INITIAL_CAPACITY);
+    if (!col) {
+        return NULL;
+    }
+    
+    for_each_document_in_dir_job(dir_path, stop_words, collect_document, col, job);
+    if (job_control_cancelled(job)) {
+        collection_destroy(col);
+        return NULL;
+    }
     return col;
 }
 
-// 创建相似度矩阵
-SimilarityMatrix* similarity_matrix_create(DocumentCollection *col) {
+// 从内存缓冲区数组构建集合，空文档或处理失败的文档被跳过
+DocumentCollection* load_documents_from_buffers(const char **names, const char **buffers,
+                                                const size_t *lengths, size_t count,
+                                                StopWords *stop_words) {
+    if (!names || !buffers || !lengths) return NULL;
+    
+    DocumentCollection *col = collection_create(count > 0 ? count : 1);
+    if (!col) return NULL;
+    
+    for (size_t i = 0; i < count; i++) {
+        Document *doc = document_create_from_buffer(names[i], buffers[i], lengths[i]);
+        if (!doc) continue;
+        
+        if (!document_process(doc, stop_words) || !collect_document(doc, names[i], col)) {
+            document_destroy(doc);
+        }
+    }
+    
+    return col;
+}
+
+// 直接由内存中的文本计算相似度矩阵，不经过文件系统
+SimilarityMatrix* similarity_matrix_from_buffers(const char **names, const char **buffers,
+                                                 const size_t *lengths, size_t count,
+                                                 StopWords *stop_words) {
+    DocumentCollection *col = load_documents_from_buffers(names, buffers, lengths, count, stop_words);
+    if (!col) return NULL;
+    
+    // 矩阵持有文件名副本，集合可以立即释放
+    SimilarityMatrix *matrix = similarity_matrix_create(col);
+    collection_destroy(col);
+    return matrix;
+}
+
+// 分配与集合对应的空矩阵（单元格全为 0）
+SimilarityMatrix* similarity_matrix_alloc(DocumentCollection *col) {
     if (!col || col->count == 0) return NULL;
     
-    SimilarityMatrix *matrix = (SimilarityMatrix*)malloc(sizeof(SimilarityMatrix));
+    const char **names = (const char**)malloc(col->count * sizeof(char*));
+    if (!names) return NULL;
+    for (size_t i = 0; i < col->count; i++) {
+        names[i] = col->documents[i]->filename;
+    }
+    
+    SimilarityMatrix *matrix = similarity_matrix_alloc_named(names, col->count);
+    free(names);
+    return matrix;
+}
+
+// 按给定文件名分配空矩阵，文件名会被复制
+SimilarityMatrix* similarity_matrix_alloc_named(const char **names, size_t count) {
+    if (!names || count == 0) return NULL;
+    
+    SimilarityMatrix *matrix = (SimilarityMatrix*)sim_memory_calloc(MEM_MATRIX, 1, sizeof(SimilarityMatrix));
     if (!matrix) return NULL;
     
-    matrix->size = col->count;
-    matrix->filenames = (char**)malloc(matrix->size * sizeof(char*));
-    matrix->matrix = (double**)malloc(matrix->size * sizeof(double*));
+    matrix->capacity = count;
+    matrix->filenames = (char**)sim_memory_alloc(MEM_MATRIX, matrix->capacity * sizeof(char*));
+    matrix->matrix = (double**)sim_memory_alloc(MEM_MATRIX, matrix->capacity * sizeof(double*));
+    matrix->data = (double*)sim_memory_calloc(MEM_MATRIX, matrix->capacity * matrix->capacity, sizeof(double));
     
-    if (!matrix->filenames || !matrix->matrix) {
-        free(matrix->filenames);
-        free(matrix->matrix);
-        free(matrix);
+    if (!matrix->filenames || !matrix->matrix || !matrix->data) {
+        similarity_matrix_destroy(matrix);
         return NULL;
     }
     
-    // 分配内存并初始化矩阵
-    for (size_t i = 0; i < matrix->size; i++) {
-        matrix->filenames[i] = strdup(col->documents[i]->filename);
-        matrix->matrix[i] = (double*)calloc(matrix->size, sizeof(double));
+    // 行指针指向连续缓冲区，行距为容量
+    for (size_t i = 0; i < count; i++) {
+        matrix->filenames[i] = sim_memory_strdup(MEM_MATRIX, names[i]);
+        matrix->matrix[i] = matrix->data + i * matrix->capacity;
         
-        if (!matrix->filenames[i] || !matrix->matrix[i]) {
-            // 清理已分配的内存
-            for (size_t j = 0; j <= i; j++) {
-                free(matrix->filenames[j]);
-                free(matrix->matrix[j]);
-            }
-            free(matrix->filenames);
-            free(matrix->matrix);
-            free(matrix);
+        if (!matrix->filenames[i]) {
+            similarity_matrix_destroy(matrix);
             return NULL;
         }
+        matrix->size++;
     }
     
-    // 计算相似度
+    return matrix;
+}
+
+// 创建相似度矩阵
+SimilarityMatrix* similarity_matrix_create(DocumentCollection *col) {
+    SimilarityMatrix *matrix = similarity_matrix_alloc(col);
+    if (!matrix) return NULL;
+    
+    // 计算相似度（使用每个文档缓存的稀疏向量）
     for (size_t i = 0; i < matrix->size; i++) {
+        STATS_TIMER_START(timer);
+        TRACE_BEGIN(span);
         matrix->matrix[i][i] = 1.0; // 对角线为1
         
         for (size_t j = i + 1; j < matrix->size; j++) {
-            double similarity = document_cosine_similarity(
+            double similarity = document_vector_similarity(
                 col->documents[i], 
                 col->documents[j]
             );
@@ -152,6 +398,9 @@ SimilarityMatrix* similarity_matrix_create(DocumentCollection *col) {
             matrix->matrix[i][j] = similarity;
             matrix->matrix[j][i] = similarity;
         }
+        STATS_TIMER_LAP(timer, STAT_PHASE_SCORE);
+        STATS_COUNT(STAT_PAIRS, matrix->size - i - 1);
+        TRACE_END(span, "matrix_row", i);
     }
     
     return matrix;
@@ -162,44 +411,252 @@ void similarity_matrix_destroy(SimilarityMatrix *matrix) {
     if (!matrix) return;
     
     for (size_t i = 0; i < matrix->size; i++) {
-        free(matrix->filenames[i]);
-        free(matrix->matrix[i]);
+        sim_memory_free(MEM_MATRIX, matrix->filenames[i], strlen(matrix->filenames[i]) + 1);
+    }
+    
+    sim_memory_free(MEM_MATRIX, matrix->filenames, matrix->capacity * sizeof(char*));
+    sim_memory_free(MEM_MATRIX, matrix->matrix, matrix->capacity * sizeof(double*));
+    sim_memory_free(MEM_MATRIX, matrix->data, matrix->capacity * matrix->capacity * sizeof(double));
+    sim_memory_free(MEM_MATRIX, matrix, sizeof(SimilarityMatrix));
+}
+
+// 连续缓冲区访问：第 i 行第 j 列位于 data[i * stride + j]
+const double* similarity_matrix_data(const SimilarityMatrix *matrix) {
+    return matrix ? matrix->data : NULL;
+}
+
+void similarity_matrix_shape(const SimilarityMatrix *matrix, size_t *rows, size_t *cols) {
+    size_t size = matrix ? matrix->size : 0;
+    if (rows) *rows = size;
+    if (cols) *cols = size;
+}
+
+// 行距（元素个数），增量更新后可能大于列数
+size_t similarity_matrix_stride(const SimilarityMatrix *matrix) {
+    return matrix ? matrix->capacity : 0;
+}
+
+// 取走连续缓冲区并销毁矩阵其余部分，缓冲区需用 similarity_buffer_free 释放
+double* similarity_matrix_detach_data(SimilarityMatrix *matrix, size_t *size, size_t *stride) {
+    if (!matrix) return NULL;
+    
+    double *data = matrix->data;
+    if (size) *size = matrix->size;
+    if (stride) *stride = matrix->capacity;
+    
+    // 缓冲区交给调用方，不再计入矩阵的内存统计
+    sim_memory_release(MEM_MATRIX, matrix->capacity * matrix->capacity * sizeof(double));
+    matrix->data = NULL;
+    similarity_matrix_destroy(matrix);
+    return data;
+}
+
+// 紧凑的 n × n 单精度副本，需用 similarity_buffer_free 释放
+float* similarity_matrix_to_f32(const SimilarityMatrix *matrix) {
+    if (!matrix) return NULL;
+    
+    float *out = (float*)malloc((matrix->size ? matrix->size * matrix->size : 1) * sizeof(float));
+    if (!out) return NULL;
+    
+    for (size_t i = 0; i < matrix->size; i++) {
+        for (size_t j = 0; j < matrix->size; j++) {
+            out[i * matrix->size + j] = (float)matrix->matrix[i][j];
+        }
+    }
+    return out;
+}
+
+// 释放由本库分配并交给调用方的缓冲区（跨语言调用时必须用库自己的 free）
+void similarity_buffer_free(void *buffer) {
+    free(buffer);
+}
+
+// 调整矩阵容量：按新行距重新分配连续缓冲区并复制已有的行
+static bool similarity_matrix_reserve(SimilarityMatrix *matrix, size_t new_capacity) {
+    if (new_capacity < matrix->size) return false;
+    if (new_capacity == matrix->capacity) return true;
+    
+    size_t old_capacity = matrix->capacity;
+    double *new_data = (double*)sim_memory_calloc(MEM_MATRIX, new_capacity * new_capacity, sizeof(double));
+    if (!new_data) return false;
+    
+    char **new_names = sim_memory_alloc(MEM_MATRIX, new_capacity * sizeof(char*));
+    double **new_rows = sim_memory_alloc(MEM_MATRIX, new_capacity * sizeof(double*));
+    if (!new_names || !new_rows) {
+        sim_memory_free(MEM_MATRIX, new_names, new_capacity * sizeof(char*));
+        sim_memory_free(MEM_MATRIX, new_rows, new_capacity * sizeof(double*));
+        sim_memory_free(MEM_MATRIX, new_data, new_capacity * new_capacity * sizeof(double));
+        return false;
     }
+    memcpy(new_names, matrix->filenames, matrix->size * sizeof(char*));
+    sim_memory_free(MEM_MATRIX, matrix->filenames, old_capacity * sizeof(char*));
+    matrix->filenames = new_names;
     
-    free(matrix->filenames);
-    free(matrix->matrix);
-    free(matrix);
+    for (size_t i = 0; i < matrix->size; i++) {
+        memcpy(new_data + i * new_capacity, matrix->matrix[i], matrix->size * sizeof(double));
+    }
+    for (size_t i = 0; i < new_capacity; i++) {
+        new_rows[i] = new_data + i * new_capacity;
+    }
+    sim_memory_free(MEM_MATRIX, matrix->matrix, old_capacity * sizeof(double*));
+    matrix->matrix = new_rows;
+    
+    sim_memory_free(MEM_MATRIX, matrix->data, old_capacity * old_capacity * sizeof(double));
+    matrix->data = new_data;
+    matrix->capacity = new_capacity;
+    return true;
+}
+
+// 向集合与矩阵增量添加文档：只计算新行，O(N) 次比较
+bool similarity_matrix_add_document(SimilarityMatrix *matrix, DocumentCollection *col, Document *doc) {
+    if (!matrix || !col || !doc || matrix->size != col->count) return false;
+    
+    if (matrix->size >= matrix->capacity) {
+        size_t new_capacity = matrix->capacity * 2;
+        if (new_capacity < MATRIX_MIN_CAPACITY) new_capacity = MATRIX_MIN_CAPACITY;
+        if (!similarity_matrix_reserve(matrix, new_capacity)) {
+            fprintf(stderr, "错误: 无法扩容相似度矩阵\n");
+            return false;
+        }
+    }
+    
+    size_t n = matrix->size;
+    char *name = sim_memory_strdup(MEM_MATRIX, doc->filename);
+    if (!name || !collection_add_document(col, doc)) {
+        sim_memory_free(MEM_MATRIX, name, name ? strlen(name) + 1 : 0);
+        return false;
+    }
+    
+    double *row = matrix->matrix[n];
+    
+    for (size_t j = 0; j < n; j++) {
+        double similarity = document_vector_similarity(doc, col->documents[j]);
+        row[j] = similarity;
+        matrix->matrix[j][n] = similarity;
+    }
+    row[n] = 1.0;
+    
+    matrix->filenames[n] = name;
+    matrix->size++;
+    return true;
+}
+
+// 从集合与矩阵中移除文档：删除对应行列，不重新计算
+bool similarity_matrix_remove_document(SimilarityMatrix *matrix, DocumentCollection *col, size_t index) {
+    if (!matrix || !col || matrix->size != col->count || index >= matrix->size) return false;
+    
+    sim_memory_free(MEM_MATRIX, matrix->filenames[index], strlen(matrix->filenames[index]) + 1);
+    
+    // 行指针固定，把后续行的数据整体上移一行
+    size_t tail = matrix->size - index - 1;
+    memmove(&matrix->filenames[index], &matrix->filenames[index + 1], tail * sizeof(char*));
+    if (tail > 0) {
+        memmove(matrix->matrix[index], matrix->matrix[index + 1],
+                tail * matrix->capacity * sizeof(double));
+    }
+    matrix->size--;
+    
+    for (size_t i = 0; i < matrix->size; i++) {
+        memmove(&matrix->matrix[i][index], &matrix->matrix[i][index + 1], tail * sizeof(double));
+    }
+    
+    collection_remove_document(col, index);
+    
+    // 占用不足四分之一时收缩一半
+    if (matrix->capacity > MATRIX_MIN_CAPACITY && matrix->size < matrix->capacity / 4) {
+        similarity_matrix_reserve(matrix, matrix->capacity / 2);
+    }
+    
+    return true;
+}
+
+// 用新版本替换集合中的文档，只重新计算该文档所在的行列
+bool similarity_matrix_update_document(SimilarityMatrix *matrix, DocumentCollection *col,
+                                       size_t index, Document *doc) {
+    if (!matrix || !col || !doc || matrix->size != col->count || index >= matrix->size) {
+        return false;
+    }
+    
+    char *name = sim_memory_strdup(MEM_MATRIX, doc->filename);
+    if (!name) return false;
+    
+    // 加权统计中用新版本替换旧版本
+    term_weights_remove_document(col->weights, col->documents[index]);
+    if (!collection_register_document(col, doc)) {
+        term_weights_add_document(col->weights, col->documents[index]);
+        sim_memory_free(MEM_MATRIX, name, strlen(name) + 1);
+        return false;
+    }
+    document_destroy(col->documents[index]);
+    col->documents[index] = doc;
+    sim_memory_free(MEM_MATRIX, matrix->filenames[index], strlen(matrix->filenames[index]) + 1);
+    matrix->filenames[index] = name;
+    
+    for (size_t j = 0; j < matrix->size; j++) {
+        double similarity = j == index ? 1.0 :
+            document_vector_similarity(doc, col->documents[j]);
+        matrix->matrix[index][j] = similarity;
+        matrix->matrix[j][index] = similarity;
+    }
+    
+    return true;
+}
+
+// 用临时文件原子替换目标文件
+bool replace_file_atomic(const char *tmp_path, const char *path) {
+#ifdef _WIN32
+    // Windows 下 rename 不覆盖已存在的文件
+    remove(path);
+#endif
+    if (rename(tmp_path, path) != 0) {
+        fprintf(stderr, "错误: 无法替换文件 %s\n", path);
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+// 将矩阵写成CSV
+static bool write_matrix_csv(SimilarityMatrix *matrix, const char *filename) {
+    CsvWriter *writer = csv_writer_open(filename);
+    if (!writer) return false;
+    
+    bool ok = csv_writer_write_header(writer, matrix->filenames, matrix->size);
+    for (size_t i = 0; ok && i < matrix->size; i++) {
+        ok = csv_writer_write_row(writer, matrix->filenames[i], matrix->matrix[i], matrix->size);
+    }
+    
+    return csv_writer_close(writer) && ok;
 }
 
 // 保存相似度矩阵到CSV文件
 bool similarity_matrix_save_csv(SimilarityMatrix *matrix, const char *filename) {
     if (!matrix || !filename) return false;
     
-    FILE *file = fopen(filename, "w");
-    if (!file) {
-        fprintf(stderr, "错误: 无法创建文件 %s\n", filename);
+    if (!write_matrix_csv(matrix, filename)) {
         return false;
     }
     
-    // 写入标题行
-    fprintf(file, "Filename");
-    for (size_t i = 0; i < matrix->size; i++) {
-        fprintf(file, ",%s", matrix->filenames[i]);
+    printf("相似度矩阵已保存到 %s\n", filename);
+    return true;
+}
+
+// 原子地保存CSV：读者要么看到旧文件，要么看到完整的新文件
+bool similarity_matrix_save_csv_atomic(SimilarityMatrix *matrix, const char *filename) {
+    if (!matrix || !filename) return false;
+    
+    char tmp_path[1024];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", filename);
+    
+    if (!write_matrix_csv(matrix, tmp_path)) {
+        remove(tmp_path);
+        return false;
     }
-    fprintf(file, "\n");
     
-    // 写入数据行
-    for (size_t i = 0; i < matrix->size; i++) {
-        fprintf(file, "%s", matrix->filenames[i]);
-        
-        for (size_t j = 0; j < matrix->size; j++) {
-            fprintf(file, ",%.4f", matrix->matrix[i][j]);
-        }
-        
-        fprintf(file, "\n");
+    if (!replace_file_atomic(tmp_path, filename)) {
+        return false;
     }
     
-    fclose(file);
     printf("相似度矩阵已保存到 %s\n", filename);
     return true;
 }
@@ -256,7 +713,7 @@ SimilarityPair* find_top_similarities(SimilarityMatrix *matrix, size_t top_n, si
     size_t total_pairs = matrix->size * (matrix->size - 1) / 2;
     
     // 分配内存存储所有对
-    SimilarityPair *all_pairs = (SimilarityPair*)malloc(total_pairs * sizeof(SimilarityPair));
+    SimilarityPair *all_pairs = (SimilarityPair*)sim_memory_alloc(MEM_PAIRS, total_pairs * sizeof(SimilarityPair));
     if (!all_pairs) return NULL;
     
     // 收集所有相似度对
@@ -276,18 +733,54 @@ SimilarityPair* find_top_similarities(SimilarityMatrix *matrix, size_t top_n, si
     // 返回前N个
     *result_count = pair_count < top_n ? pair_count : top_n;
     
+    // 结果交给调用方用 free() 释放，不计入统计
     SimilarityPair *top_pairs = (SimilarityPair*)malloc(*result_count * sizeof(SimilarityPair));
     if (!top_pairs) {
-        free(all_pairs);
+        sim_memory_free(MEM_PAIRS, all_pairs, total_pairs * sizeof(SimilarityPair));
         return NULL;
     }
     
     memcpy(top_pairs, all_pairs, *result_count * sizeof(SimilarityPair));
-    free(all_pairs);
+    sim_memory_free(MEM_PAIRS, all_pairs, total_pairs * sizeof(SimilarityPair));
     
     return top_pairs;
 }
 
+// 将前N个最相似对原子地写入报告文件
+bool save_top_pairs_report(SimilarityMatrix *matrix, size_t top_n, const char *filename) {
+    if (!matrix || !filename) return false;
+    
+    char tmp_path[1024];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", filename);
+    
+    FILE *file = fopen(tmp_path, "w");
+    if (!file) {
+        fprintf(stderr, "错误: 无法创建文件 %s\n", tmp_path);
+        return false;
+    }
+    
+    size_t result_count = 0;
+    SimilarityPair *pairs = find_top_similarities(matrix, top_n, &result_count);
+    
+    fprintf(file, "文档数: %zu\n", matrix->size);
+    fprintf(file, "前%zu个最相似文档对:\n", result_count);
+    for (size_t i = 0; i < result_count; i++) {
+        fprintf(file, "%2zu. %-20s <-> %-20s : %.4f\n", 
+                i + 1, 
+                pairs[i].doc1, 
+                pairs[i].doc2, 
+                pairs[i].similarity);
+    }
+    free(pairs);
+    
+    if (fclose(file) != 0) {
+        remove(tmp_path);
+        return false;
+    }
+    
+    return replace_file_atomic(tmp_path, filename);
+}
+
 // 排序相似度对
 void sort_similarity_pairs(SimilarityPair *pairs, size_t count) {
     if (!pairs || count == 0) return;
@@ -1,25 +1,59 @@
 #include "hashtable.h"
+#include "sim_stats.h"
+#include "sim_memory.h"
+#include "arena.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <math.h>
 
 #define LOAD_FACTOR_THRESHOLD 0.75
 #define INITIAL_CAPACITY 101
+// 内存池首块可容纳约 40 个词，之后倍增，避免小文档占用整块
+#define POOL_FIRST_BLOCK 2048
+#define POOL_MAX_BLOCK (64 * 1024)
+
+// 条目与键一起记账，释放时键长由 strlen 得到
+static size_t entry_bytes(const Entry *entry) {
+    return sizeof(Entry) + strlen(entry->key) + 1;
+}
+
+static void entry_free(HashTable *table, Entry *entry) {
+    if (table->pool) return;
+    sim_memory_release(MEM_HASHTABLE, entry_bytes(entry));
+    free(entry->key);
+    free(entry);
+}
 
 // 创建哈希表
 HashTable* hash_table_create(size_t capacity) {
-    HashTable *table = (HashTable*)malloc(sizeof(HashTable));
+    HashTable *table = (HashTable*)sim_memory_alloc(MEM_HASHTABLE, sizeof(HashTable));
     if (!table) return NULL;
     
     table->capacity = capacity > 0 ? capacity : INITIAL_CAPACITY;
     table->size = 0;
     table->unique_words = 0;
     table->collisions = 0;
+    table->pool = NULL;
     
-    table->buckets = (Entry**)calloc(table->capacity, sizeof(Entry*));
+    table->buckets = (Entry**)sim_memory_calloc(MEM_HASHTABLE, table->capacity, sizeof(Entry*));
     if (!table->buckets) {
-        free(table);
+        sim_memory_free(MEM_HASHTABLE, table, sizeof(HashTable));
+        return NULL;
+    }
+    
+    return table;
+}
+
+// 创建使用内存池的哈希表
+HashTable* hash_table_create_pooled(size_t capacity) {
+    HashTable *table = hash_table_create(capacity);
+    if (!table) return NULL;
+    
+    table->pool = arena_create_growing(POOL_FIRST_BLOCK, POOL_MAX_BLOCK, MEM_HASHTABLE);
+    if (!table->pool) {
+        hash_table_destroy(table);
         return NULL;
     }
     
@@ -30,18 +64,22 @@ HashTable* hash_table_create(size_t capacity) {
 void hash_table_destroy(HashTable *table) {
     if (!table) return;
     
-    for (size_t i = 0; i < table->capacity; i++) {
-        Entry *entry = table->buckets[i];
-        while (entry) {
-            Entry *next = entry->next;
-            free(entry->key);
-            free(entry);
-            entry = next;
+    if (table->pool) {
+        // 条目与键都在内存池中，无需逐个释放
+        arena_destroy(table->pool);
+    } else {
+        for (size_t i = 0; i < table->capacity; i++) {
+            Entry *entry = table->buckets[i];
+            while (entry) {
+                Entry *next = entry->next;
+                entry_free(table, entry);
+                entry = next;
+            }
         }
     }
     
-    free(table->buckets);
-    free(table);
+    sim_memory_free(MEM_HASHTABLE, table->buckets, table->capacity * sizeof(Entry*));
+    sim_memory_free(MEM_HASHTABLE, table, sizeof(HashTable));
 }
 
 // 哈希函数 (djb2算法)
@@ -56,6 +94,22 @@ size_t hash_function(const char *key, size_t capacity) {
     return hash % capacity;
 }
 
+// 把新条目插入到桶链表头部
+static bool link_entry(HashTable *table, size_t index, Entry *entry) {
+    entry->next = table->buckets[index];
+    table->buckets[index] = entry;
+    
+    // 统计碰撞
+    if (entry->next) {
+        table->collisions++;
+    }
+    
+    table->size++;
+    table->unique_words++;
+    
+    return true;
+}
+
 // 插入键值对
 bool hash_table_insert(HashTable *table, const char *key, int value) {
     if (!table || !key) return false;
@@ -65,11 +119,13 @@ bool hash_table_insert(HashTable *table, const char *key, int value) {
         hash_table_resize(table);
     }
     
+    STATS_COUNT(STAT_HASH_INSERTS, 1);
     size_t index = hash_function(key, table->capacity);
     Entry *entry = table->buckets[index];
     
     // 检查是否已存在
     while (entry) {
+        STATS_COUNT(STAT_HASH_PROBES, 1);
         if (strcmp(entry->key, key) == 0) {
             entry->value += value; // 累加词频
             return true;
@@ -78,34 +134,42 @@ bool hash_table_insert(HashTable *table, const char *key, int value) {
     }
     
     // 创建新节点
+    size_t key_size = strlen(key) + 1;
+    if (table->pool) {
+        // 条目与键放在同一次分配中，键紧随条目之后
+        Entry *pooled = (Entry*)arena_alloc(table->pool, sizeof(Entry) + key_size);
+        if (!pooled) {
+            fprintf(stderr, "错误: 无法分配内存用于新哈希表条目\n");
+            return false;
+        }
+        pooled->key = (char*)(pooled + 1);
+        memcpy(pooled->key, key, key_size);
+        pooled->value = value;
+        return link_entry(table, index, pooled);
+    }
+    if (!sim_memory_reserve(MEM_HASHTABLE, sizeof(Entry) + key_size)) {
+        return false;
+    }
     Entry *new_entry = (Entry*)malloc(sizeof(Entry));
     if (!new_entry) {
         fprintf(stderr, "错误: 无法分配内存用于新哈希表条目\n");
+        sim_memory_release(MEM_HASHTABLE, sizeof(Entry) + key_size);
         return false;
     }
     
-    new_entry->key = strdup(key);
+    new_entry->key = (char*)malloc(key_size);
     if (!new_entry->key) {
         fprintf(stderr, "错误: 无法分配内存用于键\n");
         free(new_entry);
+        sim_memory_release(MEM_HASHTABLE, sizeof(Entry) + key_size);
         return false;
     }
+    memcpy(new_entry->key, key, key_size);
     
     new_entry->value = value;
+    STATS_COUNT(STAT_ALLOCATIONS, 2);
     
-    // 插入到链表头部
-    new_entry->next = table->buckets[index];
-    table->buckets[index] = new_entry;
-    
-    // 统计碰撞
-    if (new_entry->next) {
-        table->collisions++;
-    }
-    
-    table->size++;
-    table->unique_words++;
-    
-    return true;
+    return link_entry(table, index, new_entry);
 }
 
 // 查找键值
@@ -116,6 +180,7 @@ int hash_table_get(HashTable *table, const char *key) {
     Entry *entry = table->buckets[index];
     
     while (entry) {
+        STATS_COUNT(STAT_HASH_PROBES, 1);
         if (strcmp(entry->key, key) == 0) {
             return entry->value;
         }
@@ -141,8 +206,7 @@ bool hash_table_remove(HashTable *table, const char *key) {
                 table->buckets[index] = entry->next;
             }
             
-            free(entry->key);
-            free(entry);
+            entry_free(table, entry);
             table->size--;
             return true;
         }
@@ -164,7 +228,7 @@ void hash_table_resize(HashTable *table) {
     }
     
     size_t new_capacity = table->capacity * 2 + 1;
-    Entry **new_buckets = (Entry**)calloc(new_capacity, sizeof(Entry*));
+    Entry **new_buckets = (Entry**)sim_memory_calloc(MEM_HASHTABLE, new_capacity, sizeof(Entry*));
     
     if (!new_buckets) {
         fprintf(stderr, "错误: 无法分配内存用于扩容哈希表\n");
@@ -186,7 +250,8 @@ void hash_table_resize(HashTable *table) {
         }
     }
     
-    free(table->buckets);
+    sim_memory_free(MEM_HASHTABLE, table->buckets, table->capacity * sizeof(Entry*));
+    STATS_COUNT(STAT_HASH_RESIZES, 1);
     table->buckets = new_buckets;
     table->capacity = new_capacity;
     table->collisions = 0; // 重置碰撞计数
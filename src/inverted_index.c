@@ -0,0 +1,717 @@
+#include "inverted_index.h"
+#include "file_manager.h"
+#include "byte_order.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define INDEX_MAGIC "TSIX"
+#define INDEX_VERSION 1
+#define INDEX_HEADER_SIZE 64
+#define INDEX_DOC_ENTRY_SIZE 16
+#define INDEX_TERM_ENTRY_SIZE 32
+#define INDEX_SKIP_ENTRY_SIZE 8
+#define POSTING_BLOCK_SIZE 128
+#define DOC_ID_END UINT32_MAX
+
+// ---------------------------------------------------------------------------
+// 构建阶段：内存中的倒排表
+// ---------------------------------------------------------------------------
+
+typedef struct PostingList {
+    uint8_t *data;          // varint 编码的 (delta, tf) 序列
+    size_t length;
+    size_t capacity;
+    uint32_t *skips;        // 每块 (last_doc, offset)
+    size_t skip_count;
+    size_t skip_capacity;
+    uint32_t df;
+    uint32_t last_doc;
+    double max_weight;
+} PostingList;
+
+typedef struct IndexBuilder {
+    HashTable *term_ids;    // 词项 -> 编号
+    char **terms;
+    PostingList *postings;
+    size_t term_count;
+    size_t term_capacity;
+    char **doc_names;
+    double *doc_norms;
+    size_t doc_count;
+    size_t doc_capacity;
+    bool failed;
+} IndexBuilder;
+
+static bool posting_reserve(PostingList *pl, size_t extra) {
+    if (pl->length + extra <= pl->capacity) return true;
+    size_t new_capacity = pl->capacity ? pl->capacity * 2 : 16;
+    while (new_capacity < pl->length + extra) new_capacity *= 2;
+    uint8_t *new_data = realloc(pl->data, new_capacity);
+    if (!new_data) return false;
+    pl->data = new_data;
+    pl->capacity = new_capacity;
+    return true;
+}
+
+static void posting_put_varint(PostingList *pl, uint32_t v) {
+    while (v >= 0x80) {
+        pl->data[pl->length++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    pl->data[pl->length++] = (uint8_t)v;
+}
+
+static bool posting_append(PostingList *pl, uint32_t doc_id, uint32_t tf, double weight) {
+    // 每个块开头记录跳表项
+    if (pl->df % POSTING_BLOCK_SIZE == 0) {
+        if (pl->skip_count >= pl->skip_capacity) {
+            size_t new_capacity = pl->skip_capacity ? pl->skip_capacity * 2 : 4;
+            uint32_t *new_skips = realloc(pl->skips, new_capacity * 2 * sizeof(uint32_t));
+            if (!new_skips) return false;
+            pl->skips = new_skips;
+            pl->skip_capacity = new_capacity;
+        }
+        pl->skips[pl->skip_count * 2 + 1] = (uint32_t)pl->length;
+        pl->skip_count++;
+    }
+
+    if (!posting_reserve(pl, 10)) return false;
+    posting_put_varint(pl, doc_id - pl->last_doc);
+    posting_put_varint(pl, tf);
+
+    pl->last_doc = doc_id;
+    pl->skips[(pl->skip_count - 1) * 2] = doc_id;
+    pl->df++;
+    if (weight > pl->max_weight) pl->max_weight = weight;
+    return true;
+}
+
+static int builder_term_id(IndexBuilder *b, const char *term) {
+    int id = hash_table_get(b->term_ids, term);
+    if (id != -1) return id;
+
+    if (b->term_count >= b->term_capacity) {
+        size_t new_capacity = b->term_capacity ? b->term_capacity * 2 : 1024;
+        char **new_terms = realloc(b->terms, new_capacity * sizeof(char*));
+        if (!new_terms) return -1;
+        b->terms = new_terms;
+        PostingList *new_postings = realloc(b->postings, new_capacity * sizeof(PostingList));
+        if (!new_postings) return -1;
+        b->postings = new_postings;
+        b->term_capacity = new_capacity;
+    }
+
+    char *copy = strdup(term);
+    if (!copy) return -1;
+
+    id = (int)b->term_count;
+    if (!hash_table_insert(b->term_ids, term, id)) {
+        free(copy);
+        return -1;
+    }
+    b->terms[id] = copy;
+    memset(&b->postings[id], 0, sizeof(PostingList));
+    b->term_count++;
+    return id;
+}
+
+// 目录遍历回调：把文档追加到倒排表
+static bool builder_add_document(Document *doc, const char *name, void *userdata) {
+    IndexBuilder *b = (IndexBuilder*)userdata;
+    if (b->failed) return false;
+
+    if (b->doc_count >= b->doc_capacity) {
+        size_t new_capacity = b->doc_capacity ? b->doc_capacity * 2 : 256;
+        char **new_names = realloc(b->doc_names, new_capacity * sizeof(char*));
+        if (!new_names) { b->failed = true; return false; }
+        b->doc_names = new_names;
+        double *new_norms = realloc(b->doc_norms, new_capacity * sizeof(double));
+        if (!new_norms) { b->failed = true; return false; }
+        b->doc_norms = new_norms;
+        b->doc_capacity = new_capacity;
+    }
+
+    // 先计算文档向量模长
+    HashTable *ht = doc->word_freq;
+    double sum = 0.0;
+    for (size_t i = 0; i < ht->capacity; i++) {
+        for (Entry *e = ht->buckets[i]; e; e = e->next) {
+            sum += (double)e->value * e->value;
+        }
+    }
+    double norm = sqrt(sum);
+
+    uint32_t doc_id = (uint32_t)b->doc_count;
+    b->doc_names[doc_id] = strdup(name);
+    if (!b->doc_names[doc_id]) { b->failed = true; return false; }
+    b->doc_norms[doc_id] = norm;
+    b->doc_count++;
+
+    if (norm == 0) return false;
+
+    for (size_t i = 0; i < ht->capacity; i++) {
+        for (Entry *e = ht->buckets[i]; e; e = e->next) {
+            int id = builder_term_id(b, e->key);
+            if (id < 0 || !posting_append(&b->postings[id], doc_id, (uint32_t)e->value,
+                                          (double)e->value / norm)) {
+                b->failed = true;
+                return false;
+            }
+        }
+    }
+
+    return false; // 文档本身不再需要
+}
+
+static void builder_destroy(IndexBuilder *b) {
+    hash_table_destroy(b->term_ids);
+    for (size_t i = 0; i < b->term_count; i++) {
+        free(b->terms[i]);
+        free(b->postings[i].data);
+        free(b->postings[i].skips);
+    }
+    for (size_t i = 0; i < b->doc_count; i++) {
+        free(b->doc_names[i]);
+    }
+    free(b->terms);
+    free(b->postings);
+    free(b->doc_names);
+    free(b->doc_norms);
+}
+
+static const IndexBuilder *sort_builder;
+
+static int compare_term_ids(const void *a, const void *b) {
+    uint32_t ia = *(const uint32_t*)a;
+    uint32_t ib = *(const uint32_t*)b;
+    return strcmp(sort_builder->terms[ia], sort_builder->terms[ib]);
+}
+
+static bool write_bytes(FILE *file, const void *data, size_t size) {
+    return size == 0 || fwrite(data, 1, size, file) == size;
+}
+
+// 将构建结果写入索引文件
+static bool builder_write(IndexBuilder *b, const char *index_path) {
+    uint32_t *order = (uint32_t*)malloc((b->term_count ? b->term_count : 1) * sizeof(uint32_t));
+    if (!order) return false;
+    for (size_t i = 0; i < b->term_count; i++) order[i] = (uint32_t)i;
+    sort_builder = b;
+    qsort(order, b->term_count, sizeof(uint32_t), compare_term_ids);
+
+    // 计算各区段偏移
+    uint64_t doc_table_offset = INDEX_HEADER_SIZE;
+    uint64_t dict_offset = doc_table_offset + (uint64_t)b->doc_count * INDEX_DOC_ENTRY_SIZE;
+    uint64_t strings_offset = dict_offset + (uint64_t)b->term_count * INDEX_TERM_ENTRY_SIZE;
+    uint64_t strings_size = 0;
+    for (size_t i = 0; i < b->doc_count; i++) strings_size += strlen(b->doc_names[i]) + 1;
+    for (size_t i = 0; i < b->term_count; i++) strings_size += strlen(b->terms[i]) + 1;
+    uint64_t postings_offset = strings_offset + strings_size;
+    uint64_t postings_size = 0;
+    for (size_t i = 0; i < b->term_count; i++) {
+        postings_size += b->postings[i].skip_count * INDEX_SKIP_ENTRY_SIZE + b->postings[i].length;
+    }
+
+    FILE *file = fopen(index_path, "wb");
+    if (!file) {
+        fprintf(stderr, "错误: 无法创建索引文件 %s\n", index_path);
+        free(order);
+        return false;
+    }
+
+    bool ok = true;
+    uint8_t header[INDEX_HEADER_SIZE] = {0};
+    memcpy(header, INDEX_MAGIC, 4);
+    put_u32(header + 4, INDEX_VERSION);
+    put_u32(header + 8, (uint32_t)b->doc_count);
+    put_u32(header + 12, (uint32_t)b->term_count);
+    put_u64(header + 16, doc_table_offset);
+    put_u64(header + 24, dict_offset);
+    put_u64(header + 32, strings_offset);
+    put_u64(header + 40, postings_offset);
+    put_u64(header + 48, postings_offset + postings_size);
+    ok = ok && write_bytes(file, header, sizeof(header));
+
+    // 文档表：名称偏移 + 模长
+    uint64_t string_pos = 0;
+    for (size_t i = 0; ok && i < b->doc_count; i++) {
+        uint8_t entry[INDEX_DOC_ENTRY_SIZE];
+        put_u64(entry, string_pos);
+        put_f64(entry + 8, b->doc_norms[i]);
+        ok = write_bytes(file, entry, sizeof(entry));
+        string_pos += strlen(b->doc_names[i]) + 1;
+    }
+
+    // 词典：按词项字典序排列，便于二分查找
+    uint64_t posting_pos = 0;
+    for (size_t i = 0; ok && i < b->term_count; i++) {
+        const PostingList *pl = &b->postings[order[i]];
+        uint8_t entry[INDEX_TERM_ENTRY_SIZE];
+        put_u64(entry, string_pos);
+        put_u64(entry + 8, posting_pos);
+        put_f64(entry + 16, pl->max_weight);
+        put_u32(entry + 24, pl->df);
+        put_u32(entry + 28, (uint32_t)pl->length);
+        ok = write_bytes(file, entry, sizeof(entry));
+        string_pos += strlen(b->terms[order[i]]) + 1;
+        posting_pos += pl->skip_count * INDEX_SKIP_ENTRY_SIZE + pl->length;
+    }
+
+    // 字符串区
+    for (size_t i = 0; ok && i < b->doc_count; i++) {
+        ok = write_bytes(file, b->doc_names[i], strlen(b->doc_names[i]) + 1);
+    }
+    for (size_t i = 0; ok && i < b->term_count; i++) {
+        ok = write_bytes(file, b->terms[order[i]], strlen(b->terms[order[i]]) + 1);
+    }
+
+    // 倒排表：跳表 + 压缩数据
+    for (size_t i = 0; ok && i < b->term_count; i++) {
+        const PostingList *pl = &b->postings[order[i]];
+        for (size_t s = 0; ok && s < pl->skip_count; s++) {
+            uint8_t entry[INDEX_SKIP_ENTRY_SIZE];
+            put_u32(entry, pl->skips[s * 2]);
+            put_u32(entry + 4, pl->skips[s * 2 + 1]);
+            ok = write_bytes(file, entry, sizeof(entry));
+        }
+        ok = ok && write_bytes(file, pl->data, pl->length);
+    }
+
+    if (fclose(file) != 0) ok = false;
+    if (!ok) {
+        fprintf(stderr, "错误: 写入索引文件失败 %s\n", index_path);
+        remove(index_path);
+    }
+
+    free(order);
+    return ok;
+}
+
+// 扫描目录并构建索引文件
+bool inverted_index_build(const char *dir_path, StopWords *stop_words, const char *index_path) {
+    if (!dir_path || !index_path) return false;
+
+    IndexBuilder builder;
+    memset(&builder, 0, sizeof(builder));
+    builder.term_ids = hash_table_create_pooled(4096);
+    if (!builder.term_ids) return false;
+
+    for_each_document_in_dir(dir_path, stop_words, builder_add_document, &builder);
+
+    bool ok = false;
+    if (builder.failed) {
+        fprintf(stderr, "错误: 构建索引时内存不足\n");
+    } else if (builder.doc_count == 0) {
+        fprintf(stderr, "错误: 目录中没有可索引的文档 %s\n", dir_path);
+    } else {
+        ok = builder_write(&builder, index_path);
+        if (ok) {
+            printf("索引构建完成: %zu 个文档, %zu 个词项 -> %s\n",
+                   builder.doc_count, builder.term_count, index_path);
+        }
+    }
+
+    builder_destroy(&builder);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// 读取阶段
+// ---------------------------------------------------------------------------
+
+struct InvertedIndex {
+    uint8_t *base;
+    size_t size;
+    bool mapped;
+    uint32_t doc_count;
+    uint32_t term_count;
+    const uint8_t *doc_table;
+    const uint8_t *dict;
+    const char *strings;
+    const uint8_t *postings;
+};
+
+// 检查文档表与词典中的偏移都落在各自区段内；字符串区以 '\0' 结尾，
+// 因此区段内的任一偏移都指向一个完整的字符串
+static bool index_tables_valid(const InvertedIndex *idx, uint64_t strings_size, uint64_t postings_size) {
+    if (idx->doc_count + (uint64_t)idx->term_count > 0 &&
+        (strings_size == 0 || idx->strings[strings_size - 1] != '\0')) {
+        return false;
+    }
+    for (uint32_t i = 0; i < idx->doc_count; i++) {
+        if (get_u64(idx->doc_table + (size_t)i * INDEX_DOC_ENTRY_SIZE) >= strings_size) return false;
+    }
+    for (uint32_t i = 0; i < idx->term_count; i++) {
+        const uint8_t *entry = idx->dict + (size_t)i * INDEX_TERM_ENTRY_SIZE;
+        uint64_t blocks = (get_u32(entry + 24) + (uint64_t)POSTING_BLOCK_SIZE - 1) / POSTING_BLOCK_SIZE;
+        uint64_t posting_offset = get_u64(entry + 8);
+        if (get_u64(entry) >= strings_size || posting_offset > postings_size ||
+            blocks * INDEX_SKIP_ENTRY_SIZE + get_u32(entry + 28) > postings_size - posting_offset) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 打开索引文件（POSIX 下使用 mmap，只有被访问的页才会读入内存）
+InvertedIndex* inverted_index_open(const char *index_path) {
+    if (!index_path) return NULL;
+
+    InvertedIndex *idx = (InvertedIndex*)calloc(1, sizeof(InvertedIndex));
+    if (!idx) return NULL;
+
+#ifndef _WIN32
+    int fd = open(index_path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "错误: 无法打开索引文件 %s\n", index_path);
+        free(idx);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < INDEX_HEADER_SIZE) {
+        fprintf(stderr, "错误: 索引文件无效 %s\n", index_path);
+        close(fd);
+        free(idx);
+        return NULL;
+    }
+    idx->size = (size_t)st.st_size;
+    void *addr = mmap(NULL, idx->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        fprintf(stderr, "错误: 无法映射索引文件 %s\n", index_path);
+        free(idx);
+        return NULL;
+    }
+    idx->base = (uint8_t*)addr;
+    idx->mapped = true;
+#else
+    FILE *file = fopen(index_path, "rb");
+    if (!file) {
+        fprintf(stderr, "错误: 无法打开索引文件 %s\n", index_path);
+        free(idx);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (file_size < INDEX_HEADER_SIZE) {
+        fprintf(stderr, "错误: 索引文件无效 %s\n", index_path);
+        fclose(file);
+        free(idx);
+        return NULL;
+    }
+    idx->size = (size_t)file_size;
+    idx->base = (uint8_t*)malloc(idx->size);
+    if (!idx->base || fread(idx->base, 1, idx->size, file) != idx->size) {
+        fprintf(stderr, "错误: 无法读取索引文件 %s\n", index_path);
+        fclose(file);
+        free(idx->base);
+        free(idx);
+        return NULL;
+    }
+    fclose(file);
+#endif
+
+    const uint8_t *h = idx->base;
+    if (memcmp(h, INDEX_MAGIC, 4) != 0 || get_u32(h + 4) != INDEX_VERSION ||
+        get_u64(h + 48) != idx->size) {
+        fprintf(stderr, "错误: 索引文件格式不匹配 %s\n", index_path);
+        inverted_index_close(idx);
+        return NULL;
+    }
+
+    idx->doc_count = get_u32(h + 8);
+    idx->term_count = get_u32(h + 12);
+    uint64_t doc_table_offset = get_u64(h + 16);
+    uint64_t dict_offset = get_u64(h + 24);
+    uint64_t strings_offset = get_u64(h + 32);
+    uint64_t postings_offset = get_u64(h + 40);
+
+    if (doc_table_offset + (uint64_t)idx->doc_count * INDEX_DOC_ENTRY_SIZE > dict_offset ||
+        dict_offset + (uint64_t)idx->term_count * INDEX_TERM_ENTRY_SIZE > strings_offset ||
+        strings_offset > postings_offset || postings_offset > idx->size) {
+        fprintf(stderr, "错误: 索引文件已损坏 %s\n", index_path);
+        inverted_index_close(idx);
+        return NULL;
+    }
+
+    idx->doc_table = idx->base + doc_table_offset;
+    idx->dict = idx->base + dict_offset;
+    idx->strings = (const char*)(idx->base + strings_offset);
+    idx->postings = idx->base + postings_offset;
+    if (!index_tables_valid(idx, postings_offset - strings_offset, idx->size - postings_offset)) {
+        fprintf(stderr, "错误: 索引文件已损坏 %s\n", index_path);
+        inverted_index_close(idx);
+        return NULL;
+    }
+    return idx;
+}
+
+// 关闭索引
+void inverted_index_close(InvertedIndex *idx) {
+    if (!idx) return;
+
+#ifndef _WIN32
+    if (idx->mapped) {
+        munmap(idx->base, idx->size);
+    }
+#else
+    free(idx->base);
+#endif
+    free(idx);
+}
+
+size_t inverted_index_doc_count(const InvertedIndex *idx) {
+    return idx ? idx->doc_count : 0;
+}
+
+size_t inverted_index_term_count(const InvertedIndex *idx) {
+    return idx ? idx->term_count : 0;
+}
+
+const char* inverted_index_doc_name(const InvertedIndex *idx, uint32_t doc_id) {
+    if (!idx || doc_id >= idx->doc_count) return NULL;
+    return idx->strings + get_u64(idx->doc_table + (size_t)doc_id * INDEX_DOC_ENTRY_SIZE);
+}
+
+static double index_doc_norm(const InvertedIndex *idx, uint32_t doc_id) {
+    return get_f64(idx->doc_table + (size_t)doc_id * INDEX_DOC_ENTRY_SIZE + 8);
+}
+
+// 二分查找词项，返回词典项指针
+static const uint8_t* index_find_term(const InvertedIndex *idx, const char *term) {
+    size_t lo = 0, hi = idx->term_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const uint8_t *entry = idx->dict + mid * INDEX_TERM_ENTRY_SIZE;
+        int cmp = strcmp(idx->strings + get_u64(entry), term);
+        if (cmp == 0) return entry;
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+// 倒排表游标：按块解码，支持跳转到 >= target 的文档
+typedef struct PostingCursor {
+    const uint8_t *skips;
+    const uint8_t *data;
+    uint32_t df;
+    uint32_t block_count;
+    uint32_t block;
+    uint32_t pos;
+    uint32_t count;
+    uint32_t doc;
+    uint32_t tf;
+    double weight;          // q_t / |q|
+    double upper;           // weight * max_weight
+    uint32_t docs[POSTING_BLOCK_SIZE];
+    uint32_t tfs[POSTING_BLOCK_SIZE];
+} PostingCursor;
+
+static uint32_t get_varint(const uint8_t **p) {
+    uint32_t v = 0;
+    int shift = 0;
+    while (**p & 0x80) {
+        v |= (uint32_t)(**p & 0x7F) << shift;
+        shift += 7;
+        (*p)++;
+    }
+    v |= (uint32_t)(**p) << shift;
+    (*p)++;
+    return v;
+}
+
+static void cursor_decode_block(PostingCursor *c, uint32_t block) {
+    uint32_t doc = block ? get_u32(c->skips + (block - 1) * INDEX_SKIP_ENTRY_SIZE) : 0;
+    const uint8_t *p = c->data + get_u32(c->skips + block * INDEX_SKIP_ENTRY_SIZE + 4);
+    uint32_t remaining = c->df - block * POSTING_BLOCK_SIZE;
+    c->count = remaining < POSTING_BLOCK_SIZE ? remaining : POSTING_BLOCK_SIZE;
+    for (uint32_t i = 0; i < c->count; i++) {
+        doc += get_varint(&p);
+        c->docs[i] = doc;
+        c->tfs[i] = get_varint(&p);
+    }
+    c->block = block;
+    c->pos = 0;
+    c->doc = c->docs[0];
+    c->tf = c->tfs[0];
+}
+
+static void cursor_next(PostingCursor *c) {
+    if (++c->pos < c->count) {
+        c->doc = c->docs[c->pos];
+        c->tf = c->tfs[c->pos];
+    } else if (c->block + 1 < c->block_count) {
+        cursor_decode_block(c, c->block + 1);
+    } else {
+        c->doc = DOC_ID_END;
+    }
+}
+
+static void cursor_seek(PostingCursor *c, uint32_t target) {
+    if (c->doc >= target) return;
+
+    // 利用跳表越过整块
+    uint32_t block = c->block;
+    while (block < c->block_count &&
+           get_u32(c->skips + block * INDEX_SKIP_ENTRY_SIZE) < target) {
+        block++;
+    }
+    if (block >= c->block_count) {
+        c->doc = DOC_ID_END;
+        return;
+    }
+    if (block != c->block) {
+        cursor_decode_block(c, block);
+    }
+    while (c->docs[c->pos] < target) c->pos++;
+    c->doc = c->docs[c->pos];
+    c->tf = c->tfs[c->pos];
+}
+
+// 小顶堆维护当前 top_k
+static void heap_sift_down(IndexHit *heap, size_t size, size_t i) {
+    for (;;) {
+        size_t smallest = i;
+        size_t l = 2 * i + 1, r = 2 * i + 2;
+        if (l < size && heap[l].score < heap[smallest].score) smallest = l;
+        if (r < size && heap[r].score < heap[smallest].score) smallest = r;
+        if (smallest == i) return;
+        IndexHit tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+static void heap_push(IndexHit *heap, size_t *size, size_t top_k, IndexHit hit) {
+    if (*size < top_k) {
+        size_t i = (*size)++;
+        heap[i] = hit;
+        while (i > 0 && heap[(i - 1) / 2].score > heap[i].score) {
+            IndexHit tmp = heap[i];
+            heap[i] = heap[(i - 1) / 2];
+            heap[(i - 1) / 2] = tmp;
+            i = (i - 1) / 2;
+        }
+    } else if (hit.score > heap[0].score) {
+        heap[0] = hit;
+        heap_sift_down(heap, *size, 0);
+    }
+}
+
+static void sort_cursors(PostingCursor **cursors, size_t count) {
+    // 游标数量通常不多且基本有序，插入排序即可
+    for (size_t i = 1; i < count; i++) {
+        PostingCursor *c = cursors[i];
+        size_t j = i;
+        while (j > 0 && cursors[j - 1]->doc > c->doc) {
+            cursors[j] = cursors[j - 1];
+            j--;
+        }
+        cursors[j] = c;
+    }
+}
+
+// WAND 查询
+size_t inverted_index_query(const InvertedIndex *idx, Document *query, size_t top_k, IndexHit *hits) {
+    if (!idx || !query || !query->word_freq || top_k == 0 || !hits) return 0;
+
+    HashTable *ht = query->word_freq;
+    double sum = 0.0;
+    size_t found = 0;
+    for (size_t i = 0; i < ht->capacity; i++) {
+        for (Entry *e = ht->buckets[i]; e; e = e->next) {
+            sum += (double)e->value * e->value;
+            if (index_find_term(idx, e->key)) found++;
+        }
+    }
+    double query_norm = sqrt(sum);
+    if (found == 0 || query_norm == 0) return 0;
+
+    PostingCursor *storage = (PostingCursor*)malloc(found * sizeof(PostingCursor));
+    PostingCursor **cursors = (PostingCursor**)malloc(found * sizeof(PostingCursor*));
+    if (!storage || !cursors) {
+        free(storage);
+        free(cursors);
+        return 0;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < ht->capacity; i++) {
+        for (Entry *e = ht->buckets[i]; e; e = e->next) {
+            const uint8_t *entry = index_find_term(idx, e->key);
+            if (!entry) continue;
+            PostingCursor *c = &storage[count];
+            c->df = get_u32(entry + 24);
+            c->block_count = (c->df + POSTING_BLOCK_SIZE - 1) / POSTING_BLOCK_SIZE;
+            c->skips = idx->postings + get_u64(entry + 8);
+            c->data = c->skips + (size_t)c->block_count * INDEX_SKIP_ENTRY_SIZE;
+            c->weight = (double)e->value / query_norm;
+            c->upper = c->weight * get_f64(entry + 16);
+            cursor_decode_block(c, 0);
+            cursors[count++] = c;
+        }
+    }
+
+    size_t heap_size = 0;
+    for (;;) {
+        sort_cursors(cursors, count);
+        double threshold = heap_size < top_k ? 0.0 : hits[0].score;
+
+        // 寻找枢轴：上界累加首次达到阈值的位置
+        double bound = 0.0;
+        size_t pivot = count;
+        for (size_t i = 0; i < count && cursors[i]->doc != DOC_ID_END; i++) {
+            bound += cursors[i]->upper;
+            if (bound >= threshold) {
+                pivot = i;
+                break;
+            }
+        }
+        if (pivot == count) break;
+
+        uint32_t pivot_doc = cursors[pivot]->doc;
+        if (cursors[0]->doc == pivot_doc) {
+            // 完整打分
+            double norm = index_doc_norm(idx, pivot_doc);
+            double score = 0.0;
+            for (size_t i = 0; i < count && cursors[i]->doc == pivot_doc; i++) {
+                score += cursors[i]->weight * ((double)cursors[i]->tf / norm);
+                cursor_next(cursors[i]);
+            }
+            if (score > 0) {
+                IndexHit hit = {pivot_doc, score};
+                heap_push(hits, &heap_size, top_k, hit);
+            }
+        } else {
+            // 跳过不可能进入 top_k 的文档
+            for (size_t i = 0; i < pivot && cursors[i]->doc < pivot_doc; i++) {
+                cursor_seek(cursors[i], pivot_doc);
+            }
+        }
+    }
+
+    free(storage);
+    free(cursors);
+
+    // 堆排序为降序输出
+    for (size_t n = heap_size; n > 1; n--) {
+        IndexHit tmp = hits[0];
+        hits[0] = hits[n - 1];
+        hits[n - 1] = tmp;
+        heap_sift_down(hits, n - 1, 0);
+    }
+
+    return heap_size;
+}
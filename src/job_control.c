@@ -0,0 +1,75 @@
+#include "job_control.h"
+#include <stdlib.h>
+#include <pthread.h>
+
+struct JobControl {
+    JobProgressCallback on_progress;
+    void *userdata;
+    pthread_mutex_t lock;
+    bool cancelled;
+    JobProgress progress;
+};
+
+JobControl* job_control_create(JobProgressCallback on_progress, void *userdata) {
+    JobControl *job = (JobControl*)calloc(1, sizeof(JobControl));
+    if (!job) return NULL;
+
+    job->on_progress = on_progress;
+    job->userdata = userdata;
+    pthread_mutex_init(&job->lock, NULL);
+    return job;
+}
+
+void job_control_destroy(JobControl *job) {
+    if (!job) return;
+    pthread_mutex_destroy(&job->lock);
+    free(job);
+}
+
+void job_control_cancel(JobControl *job) {
+    if (!job) return;
+    pthread_mutex_lock(&job->lock);
+    job->cancelled = true;
+    pthread_mutex_unlock(&job->lock);
+}
+
+bool job_control_cancelled(JobControl *job) {
+    if (!job) return false;
+    pthread_mutex_lock(&job->lock);
+    bool cancelled = job->cancelled;
+    pthread_mutex_unlock(&job->lock);
+    return cancelled;
+}
+
+void job_control_get_progress(JobControl *job, JobProgress *progress) {
+    if (!job || !progress) return;
+    pthread_mutex_lock(&job->lock);
+    *progress = job->progress;
+    pthread_mutex_unlock(&job->lock);
+}
+
+bool job_control_report(JobControl *job, JobStage stage, size_t done, size_t total) {
+    if (!job) return true;
+
+    pthread_mutex_lock(&job->lock);
+    job->progress.stage = stage;
+    job->progress.done = done;
+    job->progress.total = total;
+    JobProgress snapshot = job->progress;
+    bool cancelled = job->cancelled;
+    pthread_mutex_unlock(&job->lock);
+
+    // 回调在锁外调用，回调中可以安全地调用 job_control_cancel
+    if (!cancelled && job->on_progress && !job->on_progress(&snapshot, job->userdata)) {
+        job_control_cancel(job);
+        cancelled = true;
+    }
+    return !cancelled && !job_control_cancelled(job);
+}
+
+void job_control_add_bytes(JobControl *job, size_t bytes) {
+    if (!job) return;
+    pthread_mutex_lock(&job->lock);
+    job->progress.bytes += bytes;
+    pthread_mutex_unlock(&job->lock);
+}
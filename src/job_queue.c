@@ -0,0 +1,504 @@
+#include "job_queue.h"
+#include "matrix_engine.h"
+#include "sim_context.h"
+#include "sim_trace.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JOB_LANE_SMALL 0
+#define JOB_LANE_LARGE 1
+
+typedef struct QueuedJob {
+    uint64_t id;
+    JobState state;
+    int lane;
+
+    // 输入副本：名称与内容连续存放在 input 中
+    char *input;
+    const char **names;
+    const char **buffers;
+    size_t *lengths;
+    size_t count;
+    size_t input_bytes;
+
+    JobControl *control;        // 运行期间有效
+    JobProgress progress;       // 结束时的最终进度
+    SimilarityMatrix *result;
+    size_t result_bytes;
+    uint64_t finished_seq;      // 结束顺序，淘汰时最早结束者优先
+    size_t pins;                // 正在复制结果的调用数
+    bool removed;               // 已请求删除，运行结束或解除固定后释放
+    char error[128];
+
+    struct QueuedJob *next_pending;
+    struct QueuedJob *prev;
+    struct QueuedJob *next;
+} QueuedJob;
+
+typedef struct JobLane {
+    QueuedJob *head;
+    QueuedJob *tail;
+} JobLane;
+
+typedef struct JobWorker {
+    JobQueue *queue;
+    size_t index;
+    SimContext *context;
+    pthread_t thread;
+} JobWorker;
+
+struct JobQueue {
+    JobQueueConfig config;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    bool shutdown;
+
+    QueuedJob *head;            // 全部任务记录，按提交顺序
+    QueuedJob *tail;
+    JobLane lanes[2];
+    size_t pending;
+    size_t pending_bytes;
+    size_t result_bytes;
+    size_t finished;
+    uint64_t next_id;
+    uint64_t next_finished_seq;
+
+    JobWorker *workers;
+    size_t worker_count;
+};
+
+JobQueueConfig job_queue_default_config(void) {
+    JobQueueConfig config;
+    config.workers = 0;
+    config.threads_per_job = 1;
+    config.max_pending = 64;
+    config.max_pending_bytes = 256UL * 1024 * 1024;
+    config.small_job_bytes = 1024 * 1024;
+    config.result_budget = 512UL * 1024 * 1024;
+    config.max_finished = 1024;
+    config.shared_store = NULL;
+    return config;
+}
+
+const char* job_state_name(JobState state) {
+    switch (state) {
+        case JOB_STATE_QUEUED: return "queued";
+        case JOB_STATE_RUNNING: return "running";
+        case JOB_STATE_DONE: return "done";
+        case JOB_STATE_FAILED: return "failed";
+        case JOB_STATE_CANCELLED: return "cancelled";
+        case JOB_STATE_EXPIRED: return "expired";
+    }
+    return "unknown";
+}
+
+static bool job_finished(const QueuedJob *job) {
+    return job->state >= JOB_STATE_DONE;
+}
+
+static size_t matrix_bytes(const SimilarityMatrix *matrix) {
+    size_t bytes = sizeof(SimilarityMatrix) +
+                   matrix->capacity * matrix->capacity * sizeof(double) +
+                   matrix->capacity * (sizeof(double*) + sizeof(char*));
+    for (size_t i = 0; i < matrix->size; i++) {
+        bytes += strlen(matrix->filenames[i]) + 1;
+    }
+    return bytes;
+}
+
+// ---- 任务记录（调用方持锁） ----
+
+static QueuedJob* find_job(JobQueue *queue, uint64_t id) {
+    for (QueuedJob *job = queue->head; job; job = job->next) {
+        if (job->id == id && !job->removed) return job;
+    }
+    return NULL;
+}
+
+static void release_result(JobQueue *queue, QueuedJob *job) {
+    if (!job->result) return;
+    similarity_matrix_destroy(job->result);
+    job->result = NULL;
+    queue->result_bytes -= job->result_bytes;
+    job->result_bytes = 0;
+}
+
+static void free_job(JobQueue *queue, QueuedJob *job) {
+    if (job->prev) job->prev->next = job->next;
+    else queue->head = job->next;
+    if (job->next) job->next->prev = job->prev;
+    else queue->tail = job->prev;
+
+    if (job_finished(job)) queue->finished--;
+    release_result(queue, job);
+    free(job->input);
+    free(job);
+}
+
+// 已删除的任务在不再被工作线程或复制操作使用时释放
+static void maybe_free_job(JobQueue *queue, QueuedJob *job) {
+    if (job->removed && job->state != JOB_STATE_RUNNING && job->pins == 0) {
+        free_job(queue, job);
+    }
+}
+
+static void lane_remove(JobQueue *queue, QueuedJob *job) {
+    JobLane *lane = &queue->lanes[job->lane];
+    QueuedJob *prev = NULL;
+    for (QueuedJob *it = lane->head; it; prev = it, it = it->next_pending) {
+        if (it != job) continue;
+        if (prev) prev->next_pending = job->next_pending;
+        else lane->head = job->next_pending;
+        if (lane->tail == job) lane->tail = prev;
+        job->next_pending = NULL;
+        queue->pending--;
+        queue->pending_bytes -= job->input_bytes;
+        return;
+    }
+}
+
+static void mark_finished(JobQueue *queue, QueuedJob *job, JobState state) {
+    job->state = state;
+    job->finished_seq = queue->next_finished_seq++;
+    queue->finished++;
+
+    // 输入只在计算时需要
+    free(job->input);
+    job->input = NULL;
+    job->names = NULL;
+    job->buffers = NULL;
+    job->lengths = NULL;
+}
+
+static QueuedJob* oldest_finished(JobQueue *queue, bool with_result) {
+    QueuedJob *oldest = NULL;
+    for (QueuedJob *job = queue->head; job; job = job->next) {
+        if (!job_finished(job) || job->pins > 0 || job->removed) continue;
+        if (with_result && !job->result) continue;
+        if (!oldest || job->finished_seq < oldest->finished_seq) oldest = job;
+    }
+    return oldest;
+}
+
+// 超出结果预算时释放最早完成的结果；记录数超出上限时删除最早结束的记录
+static void enforce_limits(JobQueue *queue) {
+    while (queue->result_bytes > queue->config.result_budget) {
+        QueuedJob *oldest = oldest_finished(queue, true);
+        if (!oldest) break;
+        release_result(queue, oldest);
+        oldest->state = JOB_STATE_EXPIRED;
+    }
+
+    while (queue->finished > queue->config.max_finished) {
+        QueuedJob *oldest = oldest_finished(queue, false);
+        if (!oldest) break;
+        free_job(queue, oldest);
+    }
+}
+
+// ---- 工作线程 ----
+
+// 第一个线程只取小任务；其余线程按提交顺序取任务；只有一个线程时小任务优先
+static QueuedJob* pick_job(JobQueue *queue, size_t worker) {
+    QueuedJob *small = queue->lanes[JOB_LANE_SMALL].head;
+    QueuedJob *large = queue->lanes[JOB_LANE_LARGE].head;
+
+    if (queue->config.workers >= 2 && worker == 0) return small;
+    if (queue->config.workers == 1) return small ? small : large;
+    if (!small) return large;
+    if (!large) return small;
+    return small->id < large->id ? small : large;
+}
+
+static void* worker_main(void *arg) {
+    JobWorker *worker = (JobWorker*)arg;
+    JobQueue *queue = worker->queue;
+
+    pthread_mutex_lock(&queue->lock);
+    while (!queue->shutdown) {
+        QueuedJob *job = pick_job(queue, worker->index);
+        if (!job) {
+            pthread_cond_wait(&queue->work_ready, &queue->lock);
+            continue;
+        }
+
+        lane_remove(queue, job);
+        job->state = JOB_STATE_RUNNING;
+        job->control = job_control_create(NULL, NULL);
+        pthread_mutex_unlock(&queue->lock);
+
+        SimilarityMatrix *matrix = NULL;
+        if (job->control) {
+            TRACE_BEGIN(span);
+            sim_context_set_job(worker->context, job->control);
+            matrix = sim_context_matrix_from_buffers(worker->context, job->names, job->buffers,
+                                                     job->lengths, job->count);
+            sim_context_set_job(worker->context, NULL);
+            TRACE_END(span, "job", job->id);
+        }
+
+        pthread_mutex_lock(&queue->lock);
+        bool started = job->control != NULL;
+        if (started) {
+            job_control_get_progress(job->control, &job->progress);
+            if (!matrix && job_control_cancelled(job->control)) {
+                mark_finished(queue, job, JOB_STATE_CANCELLED);
+            }
+            job_control_destroy(job->control);
+            job->control = NULL;
+        }
+
+        if (job->state == JOB_STATE_RUNNING) {
+            if (matrix) {
+                job->result = matrix;
+                job->result_bytes = matrix_bytes(matrix);
+                queue->result_bytes += job->result_bytes;
+                matrix = NULL;
+                mark_finished(queue, job, JOB_STATE_DONE);
+            } else {
+                const char *error = started ? sim_context_last_error(worker->context) : "";
+                snprintf(job->error, sizeof(job->error), "%s",
+                         error[0] ? error : "无法创建任务控制");
+                mark_finished(queue, job, JOB_STATE_FAILED);
+            }
+        }
+        similarity_matrix_destroy(matrix);
+        sim_context_clear_error(worker->context);
+
+        maybe_free_job(queue, job);
+        enforce_limits(queue);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return NULL;
+}
+
+// ---- 公共接口 ----
+
+JobQueue* job_queue_create(const JobQueueConfig *config) {
+    JobQueue *queue = (JobQueue*)calloc(1, sizeof(JobQueue));
+    if (!queue) return NULL;
+
+    queue->config = config ? *config : job_queue_default_config();
+    if (queue->config.workers == 0) {
+        size_t cores = matrix_engine_default_threads();
+        queue->config.workers = cores < 2 ? 2 : cores;
+    }
+    if (queue->config.threads_per_job == 0) queue->config.threads_per_job = 1;
+    queue->next_id = 1;
+
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->work_ready, NULL);
+
+    queue->workers = (JobWorker*)calloc(queue->config.workers, sizeof(JobWorker));
+    if (!queue->workers) {
+        job_queue_destroy(queue);
+        return NULL;
+    }
+
+    SimConfig sim_config = sim_config_default();
+    sim_config.threads = queue->config.threads_per_job;
+    sim_config.shared_store = queue->config.shared_store;
+    for (size_t i = 0; i < queue->config.workers; i++) {
+        JobWorker *worker = &queue->workers[i];
+        worker->queue = queue;
+        worker->index = i;
+        worker->context = sim_context_create(&sim_config);
+        if (!worker->context || pthread_create(&worker->thread, NULL, worker_main, worker) != 0) {
+            fprintf(stderr, "错误: 无法创建任务工作线程\n");
+            sim_context_destroy(worker->context);
+            worker->context = NULL;
+            job_queue_destroy(queue);
+            return NULL;
+        }
+        queue->worker_count++;
+    }
+
+    return queue;
+}
+
+void job_queue_destroy(JobQueue *queue) {
+    if (!queue) return;
+
+    pthread_mutex_lock(&queue->lock);
+    queue->shutdown = true;
+    for (QueuedJob *job = queue->head; job; job = job->next) {
+        if (job->control) job_control_cancel(job->control);
+    }
+    pthread_cond_broadcast(&queue->work_ready);
+    pthread_mutex_unlock(&queue->lock);
+
+    for (size_t i = 0; i < queue->worker_count; i++) {
+        pthread_join(queue->workers[i].thread, NULL);
+        sim_context_destroy(queue->workers[i].context);
+    }
+
+    while (queue->head) {
+        free_job(queue, queue->head);
+    }
+    free(queue->workers);
+    pthread_cond_destroy(&queue->work_ready);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue);
+}
+
+bool job_queue_submit(JobQueue *queue, const char **names, const char **buffers,
+                      const size_t *lengths, size_t count, uint64_t *id) {
+    if (!queue || !names || !buffers || !lengths || count == 0 || !id) return false;
+
+    // 名称、内容与指针表放进同一块内存
+    size_t text_bytes = 0;
+    size_t total = count * (2 * sizeof(char*) + sizeof(size_t));
+    for (size_t i = 0; i < count; i++) {
+        if (!names[i] || (!buffers[i] && lengths[i] > 0)) return false;
+        text_bytes += lengths[i];
+        total += strlen(names[i]) + 1 + lengths[i] + 1;
+    }
+
+    QueuedJob *job = (QueuedJob*)calloc(1, sizeof(QueuedJob));
+    char *input = job ? (char*)malloc(total) : NULL;
+    if (!input) {
+        free(job);
+        return false;
+    }
+
+    job->input = input;
+    job->names = (const char**)input;
+    job->buffers = job->names + count;
+    job->lengths = (size_t*)(job->buffers + count);
+    char *p = (char*)(job->lengths + count);
+    for (size_t i = 0; i < count; i++) {
+        size_t name_len = strlen(names[i]);
+        memcpy(p, names[i], name_len + 1);
+        job->names[i] = p;
+        p += name_len + 1;
+
+        if (lengths[i] > 0) memcpy(p, buffers[i], lengths[i]);
+        p[lengths[i]] = '\0';
+        job->buffers[i] = p;
+        job->lengths[i] = lengths[i];
+        p += lengths[i] + 1;
+    }
+    job->count = count;
+    job->input_bytes = text_bytes;
+    job->lane = text_bytes <= queue->config.small_job_bytes ? JOB_LANE_SMALL : JOB_LANE_LARGE;
+    job->state = JOB_STATE_QUEUED;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->shutdown || queue->pending >= queue->config.max_pending ||
+        queue->pending_bytes + text_bytes > queue->config.max_pending_bytes) {
+        pthread_mutex_unlock(&queue->lock);
+        free(input);
+        free(job);
+        return false;
+    }
+
+    job->id = queue->next_id++;
+    job->prev = queue->tail;
+    if (queue->tail) queue->tail->next = job;
+    else queue->head = job;
+    queue->tail = job;
+
+    JobLane *lane = &queue->lanes[job->lane];
+    if (lane->tail) lane->tail->next_pending = job;
+    else lane->head = job;
+    lane->tail = job;
+    queue->pending++;
+    queue->pending_bytes += text_bytes;
+
+    *id = job->id;
+    // 专用于小任务的线程也在等待，需要唤醒全部
+    pthread_cond_broadcast(&queue->work_ready);
+    pthread_mutex_unlock(&queue->lock);
+    return true;
+}
+
+bool job_queue_status(JobQueue *queue, uint64_t id, JobStatus *status) {
+    if (!queue || !status) return false;
+
+    pthread_mutex_lock(&queue->lock);
+    QueuedJob *job = find_job(queue, id);
+    if (job) {
+        memset(status, 0, sizeof(*status));
+        status->state = job->state;
+        status->documents = job->count;
+        status->input_bytes = job->input_bytes;
+        status->result_bytes = job->result_bytes;
+        if (job->control) {
+            job_control_get_progress(job->control, &status->progress);
+        } else {
+            status->progress = job->progress;
+        }
+        if (job->state == JOB_STATE_QUEUED) {
+            for (QueuedJob *it = queue->lanes[job->lane].head; it && it != job; it = it->next_pending) {
+                status->queue_position++;
+            }
+        }
+        memcpy(status->error, job->error, sizeof(status->error));
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return job != NULL;
+}
+
+SimilarityMatrix* job_queue_copy_result(JobQueue *queue, uint64_t id) {
+    if (!queue) return NULL;
+
+    pthread_mutex_lock(&queue->lock);
+    QueuedJob *job = find_job(queue, id);
+    if (!job || !job->result) {
+        pthread_mutex_unlock(&queue->lock);
+        return NULL;
+    }
+    // 固定结果后在锁外复制，避免大矩阵的复制阻塞其他调用
+    job->pins++;
+    pthread_mutex_unlock(&queue->lock);
+
+    const SimilarityMatrix *source = job->result;
+    SimilarityMatrix *copy = similarity_matrix_alloc_named((const char**)source->filenames, source->size);
+    if (copy) {
+        for (size_t i = 0; i < source->size; i++) {
+            memcpy(copy->matrix[i], source->matrix[i], source->size * sizeof(double));
+        }
+    }
+
+    pthread_mutex_lock(&queue->lock);
+    job->pins--;
+    maybe_free_job(queue, job);
+    enforce_limits(queue);
+    pthread_mutex_unlock(&queue->lock);
+    return copy;
+}
+
+bool job_queue_cancel(JobQueue *queue, uint64_t id) {
+    if (!queue) return false;
+
+    pthread_mutex_lock(&queue->lock);
+    QueuedJob *job = find_job(queue, id);
+    if (job) {
+        if (job->state == JOB_STATE_QUEUED) {
+            lane_remove(queue, job);
+            mark_finished(queue, job, JOB_STATE_CANCELLED);
+            enforce_limits(queue);
+        } else if (job->control) {
+            job_control_cancel(job->control);
+        }
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return job != NULL;
+}
+
+bool job_queue_remove(JobQueue *queue, uint64_t id) {
+    if (!queue) return false;
+
+    pthread_mutex_lock(&queue->lock);
+    QueuedJob *job = find_job(queue, id);
+    if (job) {
+        if (job->state == JOB_STATE_QUEUED) lane_remove(queue, job);
+        if (job->control) job_control_cancel(job->control);
+        job->removed = true;
+        maybe_free_job(queue, job);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return job != NULL;
+}
@@ -0,0 +1,321 @@
+#include "lean_document.h"
+#include "string_pool.h"
+#include "arena.h"
+#include "sim_memory.h"
+#include "sim_stats.h"
+#include "sim_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define LEAN_INITIAL_CAPACITY 64
+#define LEAN_FIRST_BLOCK (16 * 1024)
+#define LEAN_MAX_BLOCK (1024 * 1024)
+#define LEAN_VARINT_MAX 10      // 一个词项最多占用的编码字节数（两个 32 位 varint）
+
+// 每个文档 24 字节；terms 指向集合内存池中的 LeanTerm 数组或 varint 编码流
+typedef struct LeanDocument {
+    const void *terms;
+    double norm;
+    uint32_t name;
+    uint32_t term_count;
+} LeanDocument;
+
+struct LeanCollection {
+    LeanDocument *docs;
+    size_t count;
+    size_t capacity;
+    LeanEncoding encoding;
+    StringPool *names;
+    StringPool *terms;
+    Arena *arena;           // 全部文档的词频数据，随集合一次释放
+};
+
+// 按编号升序遍历一个文档的词项
+typedef struct TermCursor {
+    const uint8_t *p;
+    const LeanTerm *pairs;
+    uint32_t left;
+    uint32_t term;
+    uint32_t count;
+} TermCursor;
+
+static int compare_lean_term(const void *a, const void *b) {
+    uint32_t ta = ((const LeanTerm*)a)->term;
+    uint32_t tb = ((const LeanTerm*)b)->term;
+    return ta < tb ? -1 : (ta > tb ? 1 : 0);
+}
+
+static uint8_t* put_varint(uint8_t *p, uint32_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static uint32_t get_varint(const uint8_t **p) {
+    uint32_t v = 0;
+    int shift = 0;
+    while (**p & 0x80) {
+        v |= (uint32_t)(**p & 0x7F) << shift;
+        shift += 7;
+        (*p)++;
+    }
+    v |= (uint32_t)(**p) << shift;
+    (*p)++;
+    return v;
+}
+
+static void cursor_init(TermCursor *c, const LeanCollection *col, const LeanDocument *doc) {
+    c->p = col->encoding == LEAN_VARINT ? (const uint8_t*)doc->terms : NULL;
+    c->pairs = col->encoding == LEAN_PAIRS ? (const LeanTerm*)doc->terms : NULL;
+    c->left = doc->term_count;
+    c->term = 0;
+    c->count = 0;
+}
+
+// 前进到下一个词项，没有更多词项时返回 false
+static bool cursor_next(TermCursor *c) {
+    if (c->left == 0) return false;
+    c->left--;
+    if (c->pairs) {
+        c->term = c->pairs->term;
+        c->count = c->pairs->count;
+        c->pairs++;
+    } else {
+        c->term += get_varint(&c->p);
+        c->count = get_varint(&c->p);
+    }
+    return true;
+}
+
+LeanCollection* lean_collection_create(LeanEncoding encoding) {
+    LeanCollection *col = (LeanCollection*)sim_memory_calloc(MEM_DOCUMENT, 1, sizeof(LeanCollection));
+    if (!col) return NULL;
+
+    col->encoding = encoding == LEAN_VARINT ? LEAN_VARINT : LEAN_PAIRS;
+    col->names = string_pool_create();
+    col->terms = string_pool_create();
+    col->arena = arena_create_growing(LEAN_FIRST_BLOCK, LEAN_MAX_BLOCK, MEM_DOCUMENT);
+    if (!col->names || !col->terms || !col->arena) {
+        lean_collection_destroy(col);
+        return NULL;
+    }
+    return col;
+}
+
+void lean_collection_destroy(LeanCollection *col) {
+    if (!col) return;
+    sim_memory_free(MEM_DOCUMENT, col->docs, col->capacity * sizeof(LeanDocument));
+    string_pool_destroy(col->names);
+    string_pool_destroy(col->terms);
+    arena_destroy(col->arena);
+    sim_memory_free(MEM_DOCUMENT, col, sizeof(LeanCollection));
+}
+
+// 把排好序的词项写入集合内存池，返回数据地址
+static const void* store_terms(LeanCollection *col, const LeanTerm *sorted, size_t n) {
+    if (col->encoding == LEAN_PAIRS) {
+        LeanTerm *copy = (LeanTerm*)arena_alloc(col->arena, n * sizeof(LeanTerm));
+        if (copy) memcpy(copy, sorted, n * sizeof(LeanTerm));
+        return copy;
+    }
+
+    // 先编码到临时缓冲区，得到准确长度后再复制，内存池中不留空洞
+    size_t bound = n * LEAN_VARINT_MAX;
+    uint8_t *buffer = (uint8_t*)sim_memory_alloc(MEM_DOCUMENT, bound > 0 ? bound : 1);
+    if (!buffer) return NULL;
+    uint8_t *p = buffer;
+    uint32_t last = 0;
+    for (size_t i = 0; i < n; i++) {
+        p = put_varint(p, sorted[i].term - last);
+        p = put_varint(p, sorted[i].count);
+        last = sorted[i].term;
+    }
+    uint8_t *copy = (uint8_t*)arena_alloc(col->arena, (size_t)(p - buffer));
+    if (copy) memcpy(copy, buffer, (size_t)(p - buffer));
+    sim_memory_free(MEM_DOCUMENT, buffer, bound > 0 ? bound : 1);
+    return copy;
+}
+
+bool lean_collection_add(LeanCollection *col, const Document *doc) {
+    if (!col || !doc || !doc->word_freq) return false;
+
+    if (col->count >= col->capacity) {
+        size_t new_capacity = col->capacity ? col->capacity * 2 : LEAN_INITIAL_CAPACITY;
+        LeanDocument *new_docs = (LeanDocument*)sim_memory_realloc(MEM_DOCUMENT, col->docs,
+                                                                   col->capacity * sizeof(LeanDocument),
+                                                                   new_capacity * sizeof(LeanDocument));
+        if (!new_docs) return false;
+        col->docs = new_docs;
+        col->capacity = new_capacity;
+    }
+
+    HashTable *table = doc->word_freq;
+    size_t n = table->size;
+    size_t scratch_bytes = (n > 0 ? n : 1) * sizeof(LeanTerm);
+    LeanTerm *scratch = (LeanTerm*)sim_memory_alloc(MEM_DOCUMENT, scratch_bytes);
+    if (!scratch) return false;
+
+    STATS_TIMER_START(timer);
+    TRACE_BEGIN(span);
+    size_t k = 0;
+    double sum = 0.0;
+    bool ok = true;
+    for (size_t b = 0; b < table->capacity && ok; b++) {
+        for (Entry *entry = table->buckets[b]; entry && ok; entry = entry->next) {
+            uint32_t id = string_pool_intern(col->terms, entry->key);
+            ok = id != STRING_POOL_INVALID;
+            scratch[k].term = id;
+            scratch[k].count = (uint32_t)entry->value;
+            sum += (double)entry->value * (double)entry->value;
+            k++;
+        }
+    }
+    qsort(scratch, k, sizeof(LeanTerm), compare_lean_term);
+
+    LeanDocument *lean = &col->docs[col->count];
+    lean->name = ok ? string_pool_intern(col->names, doc->filename) : STRING_POOL_INVALID;
+    lean->terms = lean->name != STRING_POOL_INVALID ? store_terms(col, scratch, k) : NULL;
+    lean->term_count = (uint32_t)k;
+    lean->norm = sqrt(sum);
+    sim_memory_free(MEM_DOCUMENT, scratch, scratch_bytes);
+    TRACE_END(span, "freeze", k);
+    STATS_TIMER_LAP(timer, STAT_PHASE_VECTORIZE);
+
+    if (!lean->terms) return false;
+    col->count++;
+    return true;
+}
+
+static bool collect_lean(Document *doc, const char *name, void *userdata) {
+    if (lean_collection_add((LeanCollection*)userdata, doc)) {
+        printf("已加载文档: %s\n", name);
+    }
+    // 不接管文档：正文与哈希表随即释放
+    return false;
+}
+
+LeanCollection* lean_collection_load_dir(const char *dir_path, StopWords *stop_words,
+                                         LeanEncoding encoding, JobControl *job) {
+    LeanCollection *col = lean_collection_create(encoding);
+    if (!col) return NULL;
+
+    for_each_document_in_dir_job(dir_path, stop_words, collect_lean, col, job);
+    if (job_control_cancelled(job)) {
+        lean_collection_destroy(col);
+        return NULL;
+    }
+    return col;
+}
+
+size_t lean_collection_count(const LeanCollection *col) {
+    return col ? col->count : 0;
+}
+
+const char* lean_collection_name(const LeanCollection *col, size_t index) {
+    if (!col || index >= col->count) return NULL;
+    return string_pool_get(col->names, col->docs[index].name);
+}
+
+size_t lean_collection_term_count(const LeanCollection *col, size_t index) {
+    if (!col || index >= col->count) return 0;
+    return col->docs[index].term_count;
+}
+
+size_t lean_collection_terms(const LeanCollection *col, size_t index, LeanTerm *out) {
+    if (!col || index >= col->count || !out) return 0;
+
+    TermCursor c;
+    cursor_init(&c, col, &col->docs[index]);
+    size_t n = 0;
+    while (cursor_next(&c)) {
+        out[n].term = c.term;
+        out[n].count = c.count;
+        n++;
+    }
+    return n;
+}
+
+const char* lean_collection_term(const LeanCollection *col, uint32_t term) {
+    return col ? string_pool_get(col->terms, term) : NULL;
+}
+
+// 两个有序词项序列的归并求点积
+static double lean_dot(const LeanCollection *col, const LeanDocument *a, const LeanDocument *b) {
+    TermCursor ca, cb;
+    cursor_init(&ca, col, a);
+    cursor_init(&cb, col, b);
+
+    double dot = 0.0;
+    bool more = cursor_next(&ca) && cursor_next(&cb);
+    while (more) {
+        if (ca.term == cb.term) {
+            dot += (double)ca.count * (double)cb.count;
+            more = cursor_next(&ca) && cursor_next(&cb);
+        } else if (ca.term < cb.term) {
+            more = cursor_next(&ca);
+        } else {
+            more = cursor_next(&cb);
+        }
+    }
+    return dot;
+}
+
+double lean_collection_cosine(const LeanCollection *col, size_t i, size_t j) {
+    if (!col || i >= col->count || j >= col->count) return -1.0;
+
+    const LeanDocument *a = &col->docs[i];
+    const LeanDocument *b = &col->docs[j];
+    if (a->norm == 0 || b->norm == 0) {
+        return 0.0;
+    }
+    return lean_dot(col, a, b) / (a->norm * b->norm);
+}
+
+SimilarityMatrix* lean_collection_similarity_matrix(const LeanCollection *col, JobControl *job) {
+    if (!col || col->count == 0) return NULL;
+
+    const char **names = (const char**)malloc(col->count * sizeof(char*));
+    if (!names) return NULL;
+    for (size_t i = 0; i < col->count; i++) {
+        names[i] = lean_collection_name(col, i);
+    }
+    SimilarityMatrix *matrix = similarity_matrix_alloc_named(names, col->count);
+    free(names);
+    if (!matrix) return NULL;
+
+    size_t n = col->count;
+    size_t total_pairs = n * (n - 1) / 2;
+    size_t pairs_done = 0;
+    for (size_t i = 0; i < n; i++) {
+        STATS_TIMER_START(timer);
+        TRACE_BEGIN(span);
+        matrix->matrix[i][i] = 1.0;
+        for (size_t j = i + 1; j < n; j++) {
+            double similarity = lean_collection_cosine(col, i, j);
+            matrix->matrix[i][j] = similarity;
+            matrix->matrix[j][i] = similarity;
+        }
+        STATS_TIMER_LAP(timer, STAT_PHASE_SCORE);
+        STATS_COUNT(STAT_PAIRS, n - i - 1);
+        TRACE_END(span, "matrix_row", i);
+
+        pairs_done += n - i - 1;
+        if (!job_control_report(job, JOB_STAGE_MATRIX, pairs_done, total_pairs)) {
+            similarity_matrix_destroy(matrix);
+            return NULL;
+        }
+    }
+    return matrix;
+}
+
+size_t lean_collection_bytes(const LeanCollection *col) {
+    if (!col) return 0;
+    return sizeof(LeanCollection) + col->capacity * sizeof(LeanDocument) +
+           arena_bytes_used(col->arena) +
+           string_pool_bytes(col->names) + string_pool_bytes(col->terms);
+}
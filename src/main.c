@@ -2,6 +2,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <locale.h>
+#include <ctype.h>
+#include <errno.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -10,15 +12,48 @@
 #include "text_processor.h"
 #include "vector_math.h"
 #include "file_manager.h"
+#include "inverted_index.h"
+#include "watcher.h"
+#include "server.h"
+#include "tiled_matrix.h"
+#include "matrix_file.h"
+#include "matrix_engine.h"
+#include "sim_stats.h"
+#include "sim_trace.h"
+#include "sim_memory.h"
+#include "lean_document.h"
+#include "vocab_prune.h"
+#include "shingle.h"
 #include "ui.h"
 
+// -t 的上限，远超常见的核心数，只用于拦截误输入
+#define MAX_THREADS 1024
+
 // 命令行参数处理
 typedef struct {
     char *input_dir;
     char *output_file;
     char *stop_words_file;
+    char *index_file;
+    char *index_build_dir;
+    char *query_file;
+    char *format;
+    char *serve_socket;
+    char *stats;
+    char *trace_file;
+    char *lean;
+    char *weighting;
+    PruneOptions prune;
+    ShingleOptions shingles;
+    size_t top_k;
+    size_t memory_budget_mb;
+    size_t max_memory_mb;
+    size_t ngram;
+    size_t threads;
     int use_gui;
     int batch_mode;
+    int watch;
+    int progress;
 } CommandLineArgs;
 
 // 保证在 Windows 控制台下使用 UTF-8 输出，避免中文乱码
@@ -35,6 +70,31 @@ static void setup_console_encoding(void) {
     }
 }
 
+// 解析非负整数参数；不是十进制数字或超出 [min, max] 时报错退出
+static unsigned long long parse_number(const char *flag, const char *text,
+                                       unsigned long long min, unsigned long long max) {
+    char *end = NULL;
+    errno = 0;
+    unsigned long long value = isdigit((unsigned char)text[0]) ? strtoull(text, &end, 10) : 0;
+    if (!end || *end != '\0' || errno == ERANGE || value < min || value > max) {
+        fprintf(stderr, "错误: %s 的取值必须是 %llu 到 %llu 之间的整数: %s\n", flag, min, max, text);
+        exit(1);
+    }
+    return value;
+}
+
+// 解析 (0, 1] 内的比例参数；不是数字或超出范围时报错退出
+static double parse_ratio(const char *flag, const char *text) {
+    char *end = NULL;
+    errno = 0;
+    double value = strtod(text, &end);
+    if (end == text || *end != '\0' || errno == ERANGE || !(value > 0.0 && value <= 1.0)) {
+        fprintf(stderr, "错误: %s 的取值必须大于 0 且不超过 1: %s\n", flag, text);
+        exit(1);
+    }
+    return value;
+}
+
 CommandLineArgs parse_arguments(int argc, char *argv[]) {
     CommandLineArgs args = {0};
     
@@ -46,14 +106,84 @@ CommandLineArgs parse_arguments(int argc, char *argv[]) {
             args.output_file = argv[++i];
         } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
             args.stop_words_file = argv[++i];
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            args.index_file = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            args.index_build_dir = argv[++i];
+        } else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) {
+            args.query_file = argv[++i];
+        } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            args.top_k = (size_t)parse_number("-k", argv[++i], 1, UINT32_MAX);
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            args.memory_budget_mb = (size_t)parse_number("-m", argv[++i], 1, SIZE_MAX >> 20);
+        } else if (strcmp(argv[i], "--max-memory") == 0 && i + 1 < argc) {
+            args.max_memory_mb = (size_t)parse_number("--max-memory", argv[++i], 1, SIZE_MAX >> 20);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            args.threads = (size_t)parse_number("-t", argv[++i], 1, MAX_THREADS);
+        } else if (strcmp(argv[i], "-F") == 0 && i + 1 < argc) {
+            args.format = argv[++i];
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            args.serve_socket = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            args.trace_file = argv[++i];
+        } else if (strcmp(argv[i], "--min-df") == 0 && i + 1 < argc) {
+            args.prune.min_df = (size_t)parse_number("--min-df", argv[++i], 1, SIZE_MAX);
+        } else if (strcmp(argv[i], "--max-df") == 0 && i + 1 < argc) {
+            args.prune.max_df = parse_ratio("--max-df", argv[++i]);
+        } else if (strcmp(argv[i], "--max-vocab") == 0 && i + 1 < argc) {
+            args.prune.max_vocab = (size_t)parse_number("--max-vocab", argv[++i], 1, SIZE_MAX);
+        } else if (strcmp(argv[i], "--top-terms") == 0 && i + 1 < argc) {
+            args.prune.top_terms = (size_t)parse_number("--top-terms", argv[++i], 1, SIZE_MAX);
+        } else if (strcmp(argv[i], "--ngram") == 0 && i + 1 < argc) {
+            args.ngram = (size_t)parse_number("--ngram", argv[++i], 1, CJK_NGRAM_MAX);
+        } else if (strcmp(argv[i], "--shingle") == 0 && i + 1 < argc) {
+            args.shingles.width = (size_t)parse_number("--shingle", argv[++i], 1, SHINGLE_MAX_WIDTH);
+        } else if (strcmp(argv[i], "--sample") == 0 && i + 1 < argc) {
+            args.shingles.sample_mod = parse_number("--sample", argv[++i], 1, UINT64_MAX);
+        } else if (strcmp(argv[i], "--weight") == 0 && i + 1 < argc) {
+            args.weighting = argv[++i];
+        } else if (strcmp(argv[i], "--lean") == 0) {
+            args.lean = "pairs";
+        } else if (strncmp(argv[i], "--lean=", 7) == 0) {
+            args.lean = argv[i] + 7;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            args.stats = "table";
+        } else if (strncmp(argv[i], "--stats=", 8) == 0) {
+            args.stats = argv[i] + 8;
+        } else if (strcmp(argv[i], "--watch") == 0 || strcmp(argv[i], "-w") == 0) {
+            args.watch = 1;
+        } else if (strcmp(argv[i], "--progress") == 0 || strcmp(argv[i], "-p") == 0) {
+            args.progress = 1;
         } else if (strcmp(argv[i], "-g") == 0) {
             args.use_gui = 1;
         } else if (strcmp(argv[i], "-h") == 0) {
             printf("用法: %s [选项]\n", argv[0]);
             printf("选项:\n");
             printf("  -d <目录>   指定文档目录路径\n");
-            printf("  -o <文件>   指定输出CSV文件\n");
+            printf("  -o <文件>   指定输出文件\n");
+            printf("  -F <格式>   输出格式: csv (默认), bin, bin-tri, bin-f16, bin-u8, bin-rle\n");
             printf("  -s <文件>   指定停用词文件\n");
+            printf("  -b <目录>   为目录构建倒排索引 (配合 -i)\n");
+            printf("  -q <文件>   在倒排索引中查询最相似文档 (配合 -i)\n");
+            printf("  -i <文件>   指定倒排索引文件\n");
+            printf("  -k <数量>   查询返回的文档数 (默认10)\n");
+            printf("  -t <数量>   计算矩阵的线程数 (1~%d，默认为CPU核心数)\n", MAX_THREADS);
+            printf("  -m <MB>     外存模式：在给定内存预算内分块计算矩阵\n");
+            printf("  --max-memory <MB> 内存硬上限，超出时分配失败并以错误退出\n");
+            printf("  --min-df <N>  去除出现在少于 N 个文档中的词项\n");
+            printf("  --max-df <比例> 去除出现在超过该比例文档中的词项 (大于 0，不超过 1)\n");
+            printf("  --max-vocab <N> 按文档频率只保留前 N 个词项\n");
+            printf("  --top-terms <N> 每个文档只保留词频最高的 N 个词项\n");
+            printf("  --ngram <N> 中日韩文字按 N 字重叠切分 (1~3，默认2)\n");
+            printf("  --weight <方案> 词项加权: raw (默认), log, tfidf, bm25\n");
+            printf("  --shingle <W> 以连续 W 个词的 shingle 哈希代替词频作为特征 (1~16)\n");
+            printf("  --sample <P> 只保留哈希 mod P 为 0 的 shingle，约为 1/P\n");
+            printf("  --lean[=varint] 精简文档模式：处理后只保留紧凑的词频数组，varint 编码更省内存\n");
+            printf("  -w, --watch 监视 -d 目录，文件变化时增量更新输出\n");
+            printf("  -p, --progress 在标准错误输出加载与计算进度\n");
+            printf("  --stats[=json] 批处理结束后输出各阶段耗时与计数 (需 make stats 构建) 及各子系统内存峰值\n");
+            printf("  --trace <文件> 记录各线程的处理阶段，结束时写出 Chrome Trace JSON\n");
+            printf("  --serve <套接字> 以常驻服务运行，监听 Unix 域套接字 (-d 指定预加载目录)\n");
             printf("  -g          使用图形界面模式\n");
             printf("  -h          显示此帮助信息\n");
             exit(0);
@@ -63,30 +193,145 @@ CommandLineArgs parse_arguments(int argc, char *argv[]) {
     return args;
 }
 
+// 解析输出格式；返回 false 表示 CSV
+static bool parse_output_format(const char *format, MatrixFileOptions *options) {
+    *options = matrix_file_default_options();
+    if (!format || strcmp(format, "csv") == 0) return false;
+    
+    if (strcmp(format, "bin-tri") == 0) {
+        options->layout = MATRIX_LAYOUT_UPPER;
+    } else if (strcmp(format, "bin-f16") == 0) {
+        options->dtype = MATRIX_DTYPE_F16;
+        options->layout = MATRIX_LAYOUT_UPPER;
+    } else if (strcmp(format, "bin-u8") == 0) {
+        options->dtype = MATRIX_DTYPE_U8;
+        options->layout = MATRIX_LAYOUT_UPPER;
+    } else if (strcmp(format, "bin-rle") == 0) {
+        options->dtype = MATRIX_DTYPE_U8;
+        options->layout = MATRIX_LAYOUT_UPPER;
+        options->compression = MATRIX_COMPRESS_RLE;
+    } else if (strcmp(format, "bin") != 0) {
+        printf("警告: 未知输出格式 %s，使用 bin\n", format);
+    }
+    return true;
+}
+
+// 未指定 -o 时的输出文件名，扩展名随格式
+static const char* default_output_file(const char *format) {
+    bool csv = !format || strcmp(format, "csv") == 0;
+    return csv ? "similarity_matrix.csv" : "similarity_matrix.simx";
+}
+
+// 进度显示：加载阶段每 100 个文档、计算阶段每 1% 刷新一次
+typedef struct ProgressDisplay {
+    JobStage stage;
+    size_t last;
+} ProgressDisplay;
+
+static bool print_progress(const JobProgress *progress, void *userdata) {
+    ProgressDisplay *display = (ProgressDisplay*)userdata;
+    if (progress->stage != display->stage) {
+        display->stage = progress->stage;
+        display->last = (size_t)-1;
+        fprintf(stderr, "\n");
+    }
+    
+    if (progress->stage == JOB_STAGE_LOAD) {
+        if (display->last == (size_t)-1 || progress->done >= display->last + 100 ||
+            progress->total > 0) {
+            display->last = progress->done;
+            fprintf(stderr, "\r进度: 已加载 %zu 个文档 (%.1f MB)", progress->done,
+                    progress->bytes / (1024.0 * 1024.0));
+        }
+    } else {
+        size_t percent = progress->total > 0 ? progress->done * 100 / progress->total : 100;
+        if (percent != display->last) {
+            display->last = percent;
+            fprintf(stderr, "\r进度: 矩阵计算 %3zu%%", percent);
+            if (percent == 100) fprintf(stderr, "\n");
+        }
+    }
+    return true;
+}
+
+static JobControl* create_progress_job(int enabled, ProgressDisplay *display) {
+    if (!enabled) return NULL;
+    display->stage = JOB_STAGE_LOAD;
+    display->last = (size_t)-1;
+    return job_control_create(print_progress, display);
+}
+
 // 批处理模式
 void batch_mode(const char *input_dir, const char *output_file, 
-                const char *stop_words_file) {
+                const char *stop_words_file, size_t ngram, const char *format, size_t threads,
+                const PruneOptions *prune, WeightScheme weighting,
+                const ShingleOptions *shingles, JobControl *job) {
     printf("批处理模式启动...\n");
     
     // 创建停用词表
     StopWords *stop_words = stop_words_create();
+    if (ngram > 0) stop_words_set_cjk_ngram(stop_words, ngram);
     if (stop_words_file) {
         stop_words_load_from_file(stop_words, stop_words_file);
         printf("已加载停用词文件: %s\n", stop_words_file);
     }
     
     // 加载文档
-    DocumentCollection *col = load_documents_from_dir(input_dir, stop_words);
-    if (!col || col->count == 0) {
+    DocumentCollection *col = load_documents_from_dir_job(input_dir, stop_words, job);
+    if (!col || col->count == 0 || sim_memory_budget_exceeded()) {
         printf("错误: 无法从目录加载文档\n");
+        collection_destroy(col);
         stop_words_destroy(stop_words);
         return;
     }
     
     printf("成功加载 %zu 个文档\n", col->count);
     
-    // 生成相似度矩阵
-    SimilarityMatrix *matrix = similarity_matrix_create(col);
+    // 在计算向量之前裁剪词表
+    if (prune_options_active(prune)) {
+        PruneOptions options = *prune;
+        options.threads = threads;
+        PruneStats stats;
+        if (!collection_prune(col, &options, &stats)) {
+            printf("错误: 词表裁剪失败\n");
+            collection_destroy(col);
+            stop_words_destroy(stop_words);
+            return;
+        }
+        printf("词表裁剪: %zu -> %zu 个词项, 文档词项合计 %zu -> %zu\n",
+               stats.vocab_before, stats.vocab_after, stats.terms_before, stats.terms_after);
+    }
+    
+    // 加权向量在矩阵计算前一次生成，之后文档对只需点积
+    if (weighting != WEIGHT_RAW) {
+        if (!collection_set_weighting(col, weighting)) {
+            printf("错误: 无法计算词项权重\n");
+            collection_destroy(col);
+            stop_words_destroy(stop_words);
+            return;
+        }
+        printf("词项加权: %s\n", weight_scheme_name(weighting));
+    }
+    
+    // shingle 特征替换词频向量，矩阵引擎照常按余弦计算
+    if (shingle_options_active(shingles)) {
+        if (!collection_set_shingles(col, shingles)) {
+            printf("错误: 无法生成 shingle 特征\n");
+            collection_destroy(col);
+            stop_words_destroy(stop_words);
+            return;
+        }
+        printf("shingle 特征: %zu 词, 抽样 1/%llu\n", shingles->width,
+               (unsigned long long)(shingles->sample_mod > 1 ? shingles->sample_mod : 1));
+    }
+    
+    // 生成相似度矩阵；CSV 输出在计算的同时按行写出
+    MatrixFileOptions options;
+    bool binary = parse_output_format(format, &options);
+    SimilarityMatrix *matrix = binary
+        ? similarity_matrix_create_parallel_job(col, threads, NULL, NULL, job)
+        : similarity_matrix_create_streaming_csv(col, threads,
+                                                 output_file ? output_file : "similarity_matrix.csv", job);
     if (!matrix) {
         printf("错误: 无法生成相似度矩阵\n");
         collection_destroy(col);
@@ -95,10 +340,9 @@ void batch_mode(const char *input_dir, const char *output_file,
     }
     
     // 保存到文件
-    if (output_file) {
-        similarity_matrix_save_csv(matrix, output_file);
-    } else {
-        similarity_matrix_save_csv(matrix, "similarity_matrix.csv");
+    if (binary) {
+        similarity_matrix_save_binary(matrix, output_file ? output_file : "similarity_matrix.simx",
+                                      &options);
     }
     
     // 显示前10个最相似对
@@ -125,11 +369,251 @@ void batch_mode(const char *input_dir, const char *output_file,
     printf("批处理完成！\n");
 }
 
+// 创建停用词表并按需加载停用词文件
+static StopWords* load_stop_words(const char *stop_words_file, size_t ngram) {
+    StopWords *stop_words = stop_words_create();
+    if (stop_words && ngram > 0) stop_words_set_cjk_ngram(stop_words, ngram);
+    if (stop_words && stop_words_file) {
+        stop_words_load_from_file(stop_words, stop_words_file);
+        printf("已加载停用词文件: %s\n", stop_words_file);
+    }
+    return stop_words;
+}
+
+// 精简文档模式：文档处理后即冻结为紧凑词频数组，正文与哈希表不再常驻
+int lean_batch_mode(const char *input_dir, const char *output_file,
+                    const char *stop_words_file, size_t ngram, const char *format,
+                    const char *encoding,
+                    JobControl *job) {
+    bool varint = strcmp(encoding, "varint") == 0;
+    printf("精简文档模式启动 (%s)...\n", varint ? "varint 编码" : "定长数组");
+    
+    StopWords *stop_words = load_stop_words(stop_words_file, ngram);
+    LeanCollection *col = lean_collection_load_dir(input_dir, stop_words,
+                                                   varint ? LEAN_VARINT : LEAN_PAIRS, job);
+    stop_words_destroy(stop_words);
+    if (!col || lean_collection_count(col) == 0 || sim_memory_budget_exceeded()) {
+        printf("错误: 无法从目录加载文档\n");
+        lean_collection_destroy(col);
+        return 1;
+    }
+    
+    size_t count = lean_collection_count(col);
+    printf("成功加载 %zu 个文档 (常驻 %zu KB, 平均每文档 %zu 字节)\n",
+           count, lean_collection_bytes(col) / 1024, lean_collection_bytes(col) / count);
+    
+    SimilarityMatrix *matrix = lean_collection_similarity_matrix(col, job);
+    lean_collection_destroy(col);
+    if (!matrix) {
+        printf("错误: 无法生成相似度矩阵\n");
+        return 1;
+    }
+    
+    MatrixFileOptions options;
+    if (parse_output_format(format, &options)) {
+        similarity_matrix_save_binary(matrix, output_file ? output_file : "similarity_matrix.simx",
+                                      &options);
+    } else {
+        similarity_matrix_save_csv(matrix, output_file ? output_file : "similarity_matrix.csv");
+    }
+    
+    size_t result_count;
+    SimilarityPair *pairs = find_top_similarities(matrix, 10, &result_count);
+    if (pairs) {
+        printf("\n前10个最相似文档对:\n");
+        for (size_t i = 0; i < result_count; i++) {
+            printf("%2zu. %-20s <-> %-20s : %.4f\n", 
+                   i + 1, 
+                   pairs[i].doc1, 
+                   pairs[i].doc2, 
+                   pairs[i].similarity);
+        }
+        free(pairs);
+    }
+    
+    similarity_matrix_destroy(matrix);
+    printf("批处理完成！\n");
+    return 0;
+}
+
+// 构建倒排索引
+int index_build_mode(const char *input_dir, const char *index_file,
+                     const char *stop_words_file, size_t ngram) {
+    StopWords *stop_words = load_stop_words(stop_words_file, ngram);
+    bool ok = inverted_index_build(input_dir, stop_words, index_file);
+    stop_words_destroy(stop_words);
+    return ok ? 0 : 1;
+}
+
+// 用单个文件查询倒排索引
+int index_query_mode(const char *index_file, const char *query_file,
+                     const char *stop_words_file, size_t ngram, size_t top_k) {
+    InvertedIndex *idx = inverted_index_open(index_file);
+    if (!idx) return 1;
+    
+    // 结果数不会超过文档数，按文档数限制缓冲区
+    size_t doc_count = inverted_index_doc_count(idx);
+    if (top_k > doc_count) top_k = doc_count > 0 ? doc_count : 1;
+    
+    StopWords *stop_words = load_stop_words(stop_words_file, ngram);
+    Document *query = document_create(query_file);
+    IndexHit *hits = (IndexHit*)malloc(top_k * sizeof(IndexHit));
+    int status = 1;
+    
+    if (query && hits && document_load_from_file(query, query_file) &&
+        document_process(query, stop_words)) {
+        size_t count = inverted_index_query(idx, query, top_k, hits);
+        
+        printf("索引包含 %zu 个文档, %zu 个词项\n",
+               inverted_index_doc_count(idx), inverted_index_term_count(idx));
+        printf("\n与 %s 最相似的 %zu 个文档:\n", query_file, count);
+        for (size_t i = 0; i < count; i++) {
+            printf("%2zu. %-40s : %.4f\n", 
+                   i + 1, 
+                   inverted_index_doc_name(idx, hits[i].doc_id), 
+                   hits[i].score);
+        }
+        status = 0;
+    } else {
+        printf("错误: 无法处理查询文件 %s\n", query_file);
+    }
+    
+    free(hits);
+    document_destroy(query);
+    stop_words_destroy(stop_words);
+    inverted_index_close(idx);
+    return status;
+}
+
+// 从分块矩阵逐行取值，各行共用一个读取缓冲
+typedef struct TiledRowSource {
+    TiledMatrix *tm;
+    float *values;
+} TiledRowSource;
+
+static bool tiled_row_source(size_t row, double *out, void *userdata) {
+    TiledRowSource *source = (TiledRowSource*)userdata;
+    size_t n = tiled_matrix_size(source->tm);
+    bool ok = tiled_matrix_read_row(source->tm, row, source->values);
+    for (size_t j = 0; ok && j < n; j++) {
+        out[j] = source->values[j];
+    }
+    return ok;
+}
+
+// 外存模式：向量与矩阵分块都落盘，内存占用受预算约束
+int out_of_core_mode(const char *input_dir, const char *output_file,
+                     const char *stop_words_file, size_t ngram, size_t memory_budget_mb,
+                     const char *format, JobControl *job) {
+    printf("外存模式启动 (内存预算 %zu MB)...\n", memory_budget_mb);
+    
+    StopWords *stop_words = load_stop_words(stop_words_file, ngram);
+    
+    char store_path[1024], tiles_path[1024];
+    snprintf(store_path, sizeof(store_path), "%s.vectors", output_file);
+    snprintf(tiles_path, sizeof(tiles_path), "%s.tiles", output_file);
+    
+    VectorStore *store = vector_store_build_from_dir(input_dir, stop_words, store_path, job);
+    stop_words_destroy(stop_words);
+    if (!store || vector_store_count(store) == 0) {
+        printf("错误: 无法从目录加载文档\n");
+        vector_store_destroy(store);
+        return 1;
+    }
+    
+    printf("成功加载 %zu 个文档\n", vector_store_count(store));
+    
+    TiledMatrix *tm = similarity_matrix_create_tiled(store, memory_budget_mb * 1024 * 1024, tiles_path, job);
+    vector_store_destroy(store);
+    if (!tm) {
+        printf("错误: 无法生成相似度矩阵\n");
+        return 1;
+    }
+    
+    MatrixFileOptions options;
+    if (parse_output_format(format, &options)) {
+        size_t n = tiled_matrix_size(tm);
+        char **names = (char**)malloc(n * sizeof(char*));
+        TiledRowSource source = {tm, (float*)malloc(n * sizeof(float))};
+        for (size_t i = 0; names && i < n; i++) {
+            names[i] = (char*)tiled_matrix_filename(tm, i);
+        }
+        if (names && source.values &&
+            matrix_file_write(output_file, n, names, tiled_row_source, &source, &options)) {
+            printf("相似度矩阵已保存到 %s\n", output_file);
+        }
+        free(source.values);
+        free(names);
+    } else {
+        tiled_matrix_save_csv(tm, output_file);
+    }
+    
+    size_t result_count;
+    SimilarityPair *pairs = tiled_matrix_top_similarities(tm, 10, &result_count);
+    if (pairs) {
+        printf("\n前10个最相似文档对:\n");
+        for (size_t i = 0; i < result_count; i++) {
+            printf("%2zu. %-20s <-> %-20s : %.4f\n", 
+                   i + 1, 
+                   pairs[i].doc1, 
+                   pairs[i].doc2, 
+                   pairs[i].similarity);
+        }
+        free(pairs);
+    }
+    
+    tiled_matrix_destroy(tm);
+    printf("批处理完成！\n");
+    return 0;
+}
+
+// 监视模式：常驻并增量维护矩阵与报告
+int watch_mode(const char *input_dir, const char *output_file,
+               const char *stop_words_file, size_t ngram, const char *format) {
+    printf("监视模式启动...\n");
+    
+    StopWords *stop_words = load_stop_words(stop_words_file, ngram);
+    
+    char report_file[1024];
+    snprintf(report_file, sizeof(report_file), "%s.top.txt", output_file);
+    
+    MatrixFileOptions binary;
+    WatchOptions options;
+    options.dir_path = input_dir;
+    options.output_file = output_file;
+    options.binary = parse_output_format(format, &binary) ? &binary : NULL;
+    options.report_file = report_file;
+    options.top_n = 10;
+    options.debounce_ms = 500;
+    
+    int status = watch_directory(&options, stop_words);
+    stop_words_destroy(stop_words);
+    return status;
+}
+
+// 服务模式：语料常驻内存，通过 Unix 域套接字接受请求
+int serve_mode(const char *socket_path, const char *preload_dir, const char *stop_words_file,
+               size_t ngram) {
+    printf("服务模式启动...\n");
+    
+    StopWords *stop_words = load_stop_words(stop_words_file, ngram);
+    
+    ServerOptions options;
+    options.socket_path = socket_path;
+    options.preload_dir = preload_dir;
+    options.max_batch = 0;
+    
+    int status = serve_socket(&options, stop_words);
+    stop_words_destroy(stop_words);
+    return status;
+}
+
 // 交互模式
-void interactive_mode() {
+void interactive_mode(size_t ngram) {
     DocumentCollection *col = NULL;
     SimilarityMatrix *matrix = NULL;
     StopWords *stop_words = stop_words_create();
+    if (stop_words && ngram > 0) stop_words_set_cjk_ngram(stop_words, ngram);
     
     clear_screen();
     print_banner();
@@ -160,8 +644,27 @@ int main(int argc, char *argv[]) {
     
     // 解析命令行参数
     CommandLineArgs args = parse_arguments(argc, argv);
+    if (args.max_memory_mb > 0) {
+        sim_memory_set_budget(args.max_memory_mb * 1024 * 1024);
+    }
     
-    if (args.batch_mode) {
+    if (args.serve_socket) {
+        return serve_mode(args.serve_socket, args.input_dir, args.stop_words_file, args.ngram);
+    } else if (args.index_build_dir || args.query_file) {
+        // 倒排索引模式
+        if (!args.index_file) {
+            printf("错误: 索引模式需要指定索引文件 (-i)\n");
+            printf("使用 -h 查看帮助信息\n");
+            return 1;
+        }
+        
+        if (args.index_build_dir) {
+            return index_build_mode(args.index_build_dir, args.index_file,
+                                    args.stop_words_file, args.ngram);
+        }
+        return index_query_mode(args.index_file, args.query_file, args.stop_words_file, args.ngram,
+                                args.top_k > 0 ? args.top_k : 10);
+    } else if (args.batch_mode) {
         // 批处理模式
         if (!args.input_dir) {
             printf("错误: 批处理模式需要指定输入目录 (-d)\n");
@@ -169,10 +672,74 @@ int main(int argc, char *argv[]) {
             return 1;
         }
         
-        batch_mode(args.input_dir, args.output_file, args.stop_words_file);
+        WeightScheme weighting = WEIGHT_RAW;
+        if (args.weighting && !weight_scheme_parse(args.weighting, &weighting)) {
+            printf("错误: 未知的加权方案 %s (可选 raw, log, tfidf, bm25)\n", args.weighting);
+            return 1;
+        }
+        
+        if (shingle_options_active(&args.shingles) &&
+            (weighting != WEIGHT_RAW || prune_options_active(&args.prune))) {
+            printf("错误: --shingle 不能与 --weight 或词表裁剪同时使用\n");
+            return 1;
+        }
+        
+        // 外存与精简模式只保留原始词频，这些参数在那里没有作用
+        if ((prune_options_active(&args.prune) || weighting != WEIGHT_RAW ||
+             shingle_options_active(&args.shingles)) &&
+            (args.memory_budget_mb > 0 || args.lean)) {
+            printf("错误: 词表裁剪、--weight 与 --shingle 只用于内存批处理模式，不能与 -m 或 --lean 同时使用\n");
+            return 1;
+        }
+        
+        if (args.watch) {
+            // 监视模式按原始词频增量维护矩阵，不支持这些批处理参数
+            if (weighting != WEIGHT_RAW || shingle_options_active(&args.shingles) ||
+                prune_options_active(&args.prune) || args.threads > 0) {
+                printf("错误: 监视模式不支持 --weight、--shingle、词表裁剪与 -t\n");
+                return 1;
+            }
+            return watch_mode(args.input_dir,
+                              args.output_file ? args.output_file : default_output_file(args.format),
+                              args.stop_words_file, args.ngram, args.format);
+        }
+        
+        ProgressDisplay display;
+        JobControl *job = create_progress_job(args.progress, &display);
+        
+        int status = 0;
+        similarity_stats_reset();
+        if (args.trace_file) sim_trace_start(0);
+        if (args.memory_budget_mb > 0) {
+            status = out_of_core_mode(args.input_dir,
+                                      args.output_file ? args.output_file : default_output_file(args.format),
+                                      args.stop_words_file, args.ngram, args.memory_budget_mb,
+                                      args.format, job);
+        } else if (args.lean) {
+            status = lean_batch_mode(args.input_dir, args.output_file, args.stop_words_file,
+                                     args.ngram, args.format, args.lean, job);
+        } else {
+            batch_mode(args.input_dir, args.output_file, args.stop_words_file, args.ngram,
+                       args.format, args.threads, &args.prune, weighting, &args.shingles, job);
+        }
+        job_control_destroy(job);
+        if (sim_memory_budget_exceeded()) {
+            fprintf(stderr, "错误: 运行超出 --max-memory %zu MB，结果不完整\n", args.max_memory_mb);
+            status = 1;
+        }
+        
+        if (args.trace_file && sim_trace_stop(args.trace_file)) {
+            printf("追踪已写入 %s (%zu 个事件)\n", args.trace_file, sim_trace_event_count());
+        }
+        if (args.stats) {
+            SimilarityStats stats;
+            similarity_stats_get(&stats);
+            similarity_stats_print(&stats, stdout, strcmp(args.stats, "json") == 0);
+        }
+        return status;
     } else {
         // 交互模式
-        interactive_mode();
+        interactive_mode(args.ngram);
     }
     
     return 0;
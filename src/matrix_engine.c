@@ -0,0 +1,232 @@
+#include "matrix_engine.h"
+#include "csv_writer.h"
+#include "sim_stats.h"
+#include "sim_trace.h"
+#include "sim_memory.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// 线程间共享状态
+// 工作线程按行号顺序领取上三角的行，第 i 行同时镜像写入第 i 列；
+// 第 i 行在第 0..i 行全部完成后才完整，由重排缓冲 (done 标记) 按序交给回调。
+typedef struct EngineState {
+    SparseVector **vectors;
+    SimilarityMatrix *matrix;
+    pthread_mutex_t lock;
+    pthread_cond_t row_done;
+    size_t next_row;        // 下一个待领取的行
+    bool *done;             // 第 i 行的上三角部分已算完
+    bool cancelled;
+} EngineState;
+
+size_t matrix_engine_default_threads(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (size_t)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t)count : 1;
+#endif
+}
+
+static void* engine_worker(void *arg) {
+    EngineState *state = (EngineState*)arg;
+    SimilarityMatrix *matrix = state->matrix;
+    SparseVector **vectors = state->vectors;
+
+    for (;;) {
+        pthread_mutex_lock(&state->lock);
+        size_t i = state->next_row++;
+        bool stop = state->cancelled;
+        pthread_mutex_unlock(&state->lock);
+        if (stop || i >= matrix->size) break;
+
+        STATS_TIMER_START(timer);
+        TRACE_BEGIN(span);
+        matrix->matrix[i][i] = 1.0;
+        for (size_t j = i + 1; j < matrix->size; j++) {
+            double similarity = sparse_vector_cosine(vectors[i], vectors[j]);
+            matrix->matrix[i][j] = similarity;
+            matrix->matrix[j][i] = similarity;
+        }
+        STATS_TIMER_LAP(timer, STAT_PHASE_SCORE);
+        STATS_COUNT(STAT_PAIRS, matrix->size - i - 1);
+        TRACE_END(span, "matrix_row", i);
+
+        pthread_mutex_lock(&state->lock);
+        state->done[i] = true;
+        pthread_cond_broadcast(&state->row_done);
+        pthread_mutex_unlock(&state->lock);
+    }
+
+    return NULL;
+}
+
+// 多线程计算相似度矩阵
+SimilarityMatrix* similarity_matrix_create_parallel(DocumentCollection *col, size_t threads,
+                                                    MatrixRowCallback on_row, void *userdata) {
+    return similarity_matrix_create_parallel_job(col, threads, on_row, userdata, NULL);
+}
+
+// 启动工作线程填满 matrix，并按行号顺序交付已完整的行；失败或被取消时返回 false
+static bool engine_run(SimilarityMatrix *matrix, SparseVector **vectors, size_t threads,
+                       MatrixRowCallback on_row, void *userdata, JobControl *job) {
+    if (threads == 0) threads = matrix_engine_default_threads();
+    if (threads > matrix->size) threads = matrix->size;
+
+    EngineState state;
+    memset(&state, 0, sizeof(state));
+    state.vectors = vectors;
+    state.matrix = matrix;
+    state.done = (bool*)sim_memory_calloc(MEM_MATRIX, matrix->size, sizeof(bool));
+    pthread_t *workers = (pthread_t*)malloc(threads * sizeof(pthread_t));
+    if (!state.done || !workers) {
+        sim_memory_free(MEM_MATRIX, state.done, matrix->size * sizeof(bool));
+        free(workers);
+        return false;
+    }
+    pthread_mutex_init(&state.lock, NULL);
+    pthread_cond_init(&state.row_done, NULL);
+
+    size_t started = 0;
+    for (; started < threads; started++) {
+        if (pthread_create(&workers[started], NULL, engine_worker, &state) != 0) break;
+    }
+    if (started == 0) {
+        // 无法创建线程时在当前线程完成计算
+        engine_worker(&state);
+    }
+
+    // 按行号顺序交付已完整的行；进度为第 0..row 行覆盖的文档对数，
+    // 约每完成 1/1000 报告一次，取消标志每行检查
+    size_t total_pairs = matrix->size * (matrix->size - 1) / 2;
+    size_t report_step = total_pairs / 1000 + 1;
+    size_t reported = 0;
+    bool ok = true;
+    for (size_t row = 0; (on_row || job) && ok && row < matrix->size; row++) {
+        pthread_mutex_lock(&state.lock);
+        while (!state.done[row]) {
+            pthread_cond_wait(&state.row_done, &state.lock);
+        }
+        pthread_mutex_unlock(&state.lock);
+
+        if (on_row) {
+            ok = on_row(row, matrix->matrix[row], matrix->size, userdata);
+        }
+        if (ok && job) {
+            size_t pairs_done = (row + 1) * matrix->size - (row + 1) * (row + 2) / 2;
+            if (pairs_done - reported >= report_step || row + 1 == matrix->size) {
+                ok = job_control_report(job, JOB_STAGE_MATRIX, pairs_done, total_pairs);
+                reported = pairs_done;
+            } else {
+                ok = !job_control_cancelled(job);
+            }
+        }
+        if (!ok) {
+            pthread_mutex_lock(&state.lock);
+            state.cancelled = true;
+            pthread_mutex_unlock(&state.lock);
+        }
+    }
+
+    for (size_t t = 0; t < started; t++) {
+        pthread_join(workers[t], NULL);
+    }
+
+    pthread_cond_destroy(&state.row_done);
+    pthread_mutex_destroy(&state.lock);
+    sim_memory_free(MEM_MATRIX, state.done, matrix->size * sizeof(bool));
+    free(workers);
+    return ok;
+}
+
+SimilarityMatrix* similarity_matrix_create_parallel_job(DocumentCollection *col, size_t threads,
+                                                        MatrixRowCallback on_row, void *userdata,
+                                                        JobControl *job) {
+    SimilarityMatrix *matrix = similarity_matrix_alloc(col);
+    if (!matrix) return NULL;
+    SparseVector **vectors = (SparseVector**)malloc((col->count ? col->count : 1) * sizeof(SparseVector*));
+    if (!vectors) {
+        similarity_matrix_destroy(matrix);
+        return NULL;
+    }
+
+    // 稀疏向量是惰性构建的，必须在启动线程前全部建好
+    for (size_t i = 0; i < col->count; i++) {
+        if (job && job_control_cancelled(job)) {
+            free(vectors);
+            similarity_matrix_destroy(matrix);
+            return NULL;
+        }
+        vectors[i] = document_vector(col->documents[i]);
+    }
+
+    bool ok = engine_run(matrix, vectors, threads, on_row, userdata, job);
+    free(vectors);
+    if (!ok) {
+        similarity_matrix_destroy(matrix);
+        return NULL;
+    }
+    return matrix;
+}
+
+SimilarityMatrix* similarity_matrix_create_from_vectors(const char **names, SparseVector **vectors,
+                                                        size_t count, size_t threads) {
+    if (!names || !vectors) return NULL;
+    SimilarityMatrix *matrix = similarity_matrix_alloc_named(names, count);
+    if (!matrix) return NULL;
+    if (!engine_run(matrix, vectors, threads, NULL, NULL, NULL)) {
+        similarity_matrix_destroy(matrix);
+        return NULL;
+    }
+    return matrix;
+}
+
+typedef struct CsvRowSink {
+    CsvWriter *writer;
+    char **filenames;
+} CsvRowSink;
+
+static bool write_csv_row(size_t row, const double *values, size_t count, void *userdata) {
+    CsvRowSink *sink = (CsvRowSink*)userdata;
+    return csv_writer_write_row(sink->writer, sink->filenames[row], values, count);
+}
+
+// 边计算边写出 CSV：写出第 i 行与计算后续行重叠进行
+SimilarityMatrix* similarity_matrix_create_streaming_csv(DocumentCollection *col, size_t threads,
+                                                         const char *filename, JobControl *job) {
+    if (!col || col->count == 0 || !filename) return NULL;
+
+    CsvRowSink sink;
+    sink.writer = csv_writer_open(filename);
+    if (!sink.writer) return NULL;
+
+    // 标题行只依赖文件名，先行写出
+    sink.filenames = (char**)malloc(col->count * sizeof(char*));
+    bool ok = sink.filenames != NULL;
+    for (size_t i = 0; ok && i < col->count; i++) {
+        sink.filenames[i] = col->documents[i]->filename;
+    }
+    ok = ok && csv_writer_write_header(sink.writer, sink.filenames, col->count);
+
+    SimilarityMatrix *matrix = ok ? similarity_matrix_create_parallel_job(col, threads, write_csv_row, &sink, job)
+                                  : NULL;
+    free(sink.filenames);
+
+    if (!csv_writer_close(sink.writer) || !matrix) {
+        similarity_matrix_destroy(matrix);
+        return NULL;
+    }
+
+    printf("相似度矩阵已保存到 %s\n", filename);
+    return matrix;
+}
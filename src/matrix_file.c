@@ -0,0 +1,725 @@
+#include "matrix_file.h"
+#include "byte_order.h"
+#include "sim_stats.h"
+#include "sim_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define SIMX_MAGIC "SIMX"
+#define SIMX_VERSION 1
+#define SIMX_HEADER_SIZE 64
+#define SIMX_DATA_ALIGN 64
+#define SIMX_DEFAULT_TILE_ROWS 64
+
+static size_t dtype_cell_size(int dtype) {
+    switch (dtype) {
+        case MATRIX_DTYPE_F32: return 4;
+        case MATRIX_DTYPE_F64: return 8;
+        case MATRIX_DTYPE_U8: return 1;
+        case MATRIX_DTYPE_F16: return 2;
+        default: return 0;
+    }
+}
+
+// float32 -> 半精度，最近偶数舍入，溢出为无穷大
+static uint16_t float_to_half(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    uint32_t exponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (exponent == 0xFF) {
+        return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    }
+
+    int e = (int)exponent - 127 + 15;
+    if (e >= 31) return (uint16_t)(sign | 0x7C00);
+
+    uint32_t half, rest, halfway;
+    if (e <= 0) {
+        // 非规格化数
+        if (e < -10) return sign;
+        mantissa |= 0x800000;
+        int shift = 14 - e;
+        half = mantissa >> shift;
+        rest = mantissa & ((1u << shift) - 1);
+        halfway = 1u << (shift - 1);
+    } else {
+        half = ((uint32_t)e << 10) | (mantissa >> 13);
+        rest = mantissa & 0x1FFF;
+        halfway = 0x1000;
+    }
+    // 进位可能使指数加一，编码上仍然正确
+    if (rest > halfway || (rest == halfway && (half & 1))) half++;
+    return (uint16_t)(sign | half);
+}
+
+static float half_to_float(uint16_t half) {
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+
+    if (exponent == 0) {
+        float value = ldexpf((float)mantissa, -24);
+        return sign ? -value : value;
+    }
+
+    uint32_t bits = exponent == 31
+        ? sign | 0x7F800000 | (mantissa << 13)
+        : sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void encode_cell(uint8_t *p, int dtype, double value) {
+    switch (dtype) {
+        case MATRIX_DTYPE_F32:
+            put_f32(p, (float)value);
+            break;
+        case MATRIX_DTYPE_F64:
+            put_f64(p, value);
+            break;
+        case MATRIX_DTYPE_F16:
+            put_u16(p, float_to_half((float)value));
+            break;
+        default: {
+            double clamped = value < 0 ? 0 : (value > 1 ? 1 : value);
+            p[0] = (uint8_t)lround(clamped * 255.0);
+            break;
+        }
+    }
+}
+
+static double decode_cell(const uint8_t *p, int dtype) {
+    switch (dtype) {
+        case MATRIX_DTYPE_F32: return get_f32(p);
+        case MATRIX_DTYPE_F64: return get_f64(p);
+        case MATRIX_DTYPE_F16: return half_to_float(get_u16(p));
+        default: return p[0] / 255.0;
+    }
+}
+
+// 第 row 行存储的首列
+static size_t row_first_col(int layout, size_t row) {
+    return layout == MATRIX_LAYOUT_UPPER ? row : 0;
+}
+
+// 第 row 行第一个单元格在数据区中的序号；上三角时为 sum(n - k), k < row
+static uint64_t row_start_cell(int layout, uint64_t n, uint64_t row) {
+    if (layout == MATRIX_LAYOUT_UPPER) {
+        return row == 0 ? 0 : row * n - row * (row - 1) / 2;
+    }
+    return row * n;
+}
+
+// ---------------------------------------------------------------------------
+// 写出
+// ---------------------------------------------------------------------------
+
+MatrixFileOptions matrix_file_default_options(void) {
+    MatrixFileOptions options;
+    options.dtype = MATRIX_DTYPE_F32;
+    options.layout = MATRIX_LAYOUT_FULL;
+    options.compression = MATRIX_COMPRESS_NONE;
+    options.tile_rows = SIMX_DEFAULT_TILE_ROWS;
+    return options;
+}
+
+// 游程编码器
+typedef struct RunEncoder {
+    FILE *file;
+    size_t cell_size;
+    uint8_t value[8];
+    uint64_t run;
+    uint64_t written;
+    bool ok;
+} RunEncoder;
+
+static void run_flush(RunEncoder *enc) {
+    if (enc->run == 0) return;
+
+    uint8_t buffer[16];
+    size_t len = 0;
+    uint64_t v = enc->run;
+    while (v >= 0x80) {
+        buffer[len++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    buffer[len++] = (uint8_t)v;
+    memcpy(buffer + len, enc->value, enc->cell_size);
+    len += enc->cell_size;
+
+    if (fwrite(buffer, 1, len, enc->file) != len) enc->ok = false;
+    enc->written += len;
+    enc->run = 0;
+}
+
+static void run_push(RunEncoder *enc, const uint8_t *cell) {
+    if (enc->run > 0 && memcmp(enc->value, cell, enc->cell_size) == 0) {
+        enc->run++;
+        return;
+    }
+    run_flush(enc);
+    memcpy(enc->value, cell, enc->cell_size);
+    enc->run = 1;
+}
+
+// 通用写出：逐行从数据源取值，先写临时文件再原子替换
+bool matrix_file_write(const char *path, size_t size, char **filenames,
+                       MatrixRowSource source, void *userdata,
+                       const MatrixFileOptions *options) {
+    if (!path || !filenames || !source) return false;
+
+    MatrixFileOptions opts = options ? *options : matrix_file_default_options();
+    size_t cell_size = dtype_cell_size(opts.dtype);
+    if (cell_size == 0) return false;
+    if (opts.tile_rows == 0) opts.tile_rows = SIMX_DEFAULT_TILE_ROWS;
+    // 行块不超过矩阵行数，读取时据此限制块缓存的大小
+    if (size > 0 && opts.tile_rows > size) opts.tile_rows = (uint32_t)size;
+
+    STATS_TIMER_START(timer);
+    TRACE_BEGIN(span);
+    char tmp_path[1024];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "wb");
+    if (!file) {
+        fprintf(stderr, "错误: 无法创建文件 %s\n", tmp_path);
+        return false;
+    }
+
+    double *row = (double*)malloc((size ? size : 1) * sizeof(double));
+    uint8_t *cells = (uint8_t*)malloc((size ? size : 1) * cell_size);
+    size_t tile_count = (size + opts.tile_rows - 1) / opts.tile_rows;
+    uint64_t *tile_offsets = (uint64_t*)malloc((tile_count + 1) * sizeof(uint64_t));
+    bool ok = row && cells && tile_offsets;
+
+    // 头部占位，文件名表
+    uint8_t header[SIMX_HEADER_SIZE] = {0};
+    ok = ok && fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    uint64_t pos = SIMX_HEADER_SIZE;
+    for (size_t i = 0; ok && i < size; i++) {
+        size_t len = strlen(filenames[i]) + 1;
+        ok = fwrite(filenames[i], 1, len, file) == len;
+        pos += len;
+    }
+    uint64_t data_offset = (pos + SIMX_DATA_ALIGN - 1) / SIMX_DATA_ALIGN * SIMX_DATA_ALIGN;
+    static const uint8_t zeros[SIMX_DATA_ALIGN] = {0};
+    ok = ok && fwrite(zeros, 1, data_offset - pos, file) == data_offset - pos;
+
+    // 单元格数据
+    RunEncoder enc;
+    memset(&enc, 0, sizeof(enc));
+    enc.file = file;
+    enc.cell_size = cell_size;
+    enc.ok = true;
+
+    uint64_t data_size = 0;
+    for (size_t i = 0; ok && i < size; i++) {
+        if (!source(i, row, userdata)) {
+            ok = false;
+            break;
+        }
+
+        size_t first = row_first_col(opts.layout, i);
+        size_t count = size - first;
+        for (size_t j = 0; j < count; j++) {
+            encode_cell(cells + j * cell_size, opts.dtype, row[first + j]);
+        }
+
+        if (opts.compression == MATRIX_COMPRESS_RLE) {
+            if (i % opts.tile_rows == 0) {
+                run_flush(&enc);
+                tile_offsets[i / opts.tile_rows] = enc.written;
+            }
+            for (size_t j = 0; j < count; j++) {
+                run_push(&enc, cells + j * cell_size);
+            }
+        } else {
+            ok = fwrite(cells, cell_size, count, file) == count;
+            data_size += (uint64_t)count * cell_size;
+        }
+    }
+
+    uint64_t tile_index_offset = 0;
+    if (ok && opts.compression == MATRIX_COMPRESS_RLE) {
+        run_flush(&enc);
+        ok = enc.ok;
+        data_size = enc.written;
+        tile_offsets[tile_count] = enc.written;
+
+        // 行块索引紧随数据之后
+        tile_index_offset = data_offset + data_size;
+        for (size_t t = 0; ok && t <= tile_count; t++) {
+            uint8_t entry[8];
+            put_u64(entry, tile_offsets[t]);
+            ok = fwrite(entry, 1, sizeof(entry), file) == sizeof(entry);
+        }
+    }
+
+    uint64_t file_size = data_offset + data_size +
+                         (tile_index_offset ? (tile_count + 1) * 8 : 0);
+    memcpy(header, SIMX_MAGIC, 4);
+    header[4] = SIMX_VERSION;
+    header[6] = (uint8_t)opts.dtype;
+    header[7] = (uint8_t)opts.layout;
+    header[8] = (uint8_t)opts.compression;
+    put_u32(header + 12, opts.tile_rows);
+    put_u64(header + 16, size);
+    put_u64(header + 24, SIMX_HEADER_SIZE);
+    put_u64(header + 32, data_offset);
+    put_u64(header + 40, data_size);
+    put_u64(header + 48, tile_index_offset);
+    put_u64(header + 56, file_size);
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 &&
+         fwrite(header, 1, sizeof(header), file) == sizeof(header);
+
+    if (fclose(file) != 0) ok = false;
+    free(row);
+    free(cells);
+    free(tile_offsets);
+
+    if (!ok) {
+        fprintf(stderr, "错误: 写入二进制矩阵失败 %s\n", path);
+        remove(tmp_path);
+        return false;
+    }
+
+    ok = replace_file_atomic(tmp_path, path);
+    STATS_TIMER_LAP(timer, STAT_PHASE_OUTPUT);
+    STATS_COUNT(STAT_OUTPUT_BYTES, file_size);
+    TRACE_END(span, "matrix_file_write", file_size);
+    return ok;
+}
+
+static bool matrix_row_source(size_t row, double *out, void *userdata) {
+    SimilarityMatrix *matrix = (SimilarityMatrix*)userdata;
+    memcpy(out, matrix->matrix[row], matrix->size * sizeof(double));
+    return true;
+}
+
+// 保存内存中的相似度矩阵
+bool similarity_matrix_save_binary(SimilarityMatrix *matrix, const char *path,
+                                   const MatrixFileOptions *options) {
+    if (!matrix) return false;
+
+    if (!matrix_file_write(path, matrix->size, matrix->filenames,
+                           matrix_row_source, matrix, options)) {
+        return false;
+    }
+
+    printf("相似度矩阵已保存到 %s\n", path);
+    return true;
+}
+
+// 编码为内存中的紧凑单元格块
+void* similarity_matrix_encode(const SimilarityMatrix *matrix, MatrixDType dtype,
+                               MatrixLayout layout, size_t *bytes) {
+    size_t cell_size = dtype_cell_size(dtype);
+    if (!matrix || cell_size == 0) return NULL;
+
+    size_t n = matrix->size;
+    size_t total = (size_t)row_start_cell(layout, n, n) * cell_size;
+    uint8_t *out = (uint8_t*)malloc(total > 0 ? total : 1);
+    if (!out) return NULL;
+
+    uint8_t *p = out;
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = row_first_col(layout, i); j < n; j++) {
+            encode_cell(p, dtype, matrix->matrix[i][j]);
+            p += cell_size;
+        }
+    }
+
+    if (bytes) *bytes = total;
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// 读取
+// ---------------------------------------------------------------------------
+
+// 上三角 RLE 文件中一行的解码位置。读第 row 行时左侧的单元格 (j, row) 位于第 j 行，
+// 每行保留一个只向右前进的游标，按行顺序读取时每个行程只解码一次
+typedef struct RleCursor {
+    const uint8_t *p;           // 下一个行程的起点
+    const uint8_t *end;         // 所在行块数据的结尾
+    uint64_t col;               // 游标所在列
+    uint64_t run_left;          // 当前行程从 col 起剩余的单元格数，0 表示从 p 读新行程
+    double value;
+} RleCursor;
+
+struct MatrixFile {
+    uint8_t *base;
+    size_t file_size;
+    bool mapped;
+    uint64_t size;
+    int dtype;
+    int layout;
+    int compression;
+    uint32_t tile_rows;
+    size_t cell_size;
+    const char **names;
+    const uint8_t *data;
+    uint64_t data_size;
+    const uint8_t *tile_index;
+    size_t tile_count;
+    double *tile_cache;         // 最近解码的行块
+    size_t cached_tile;
+    RleCursor *row_starts;      // 各行起点的解码状态（上三角 RLE，按行块首次用到时扫描）
+    RleCursor *cursors;         // 各行当前的解码状态
+    uint8_t *tile_scanned;
+};
+
+MatrixFile* matrix_file_open(const char *path) {
+    if (!path) return NULL;
+
+    MatrixFile *mf = (MatrixFile*)calloc(1, sizeof(MatrixFile));
+    if (!mf) return NULL;
+    mf->cached_tile = SIZE_MAX;
+
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "错误: 无法打开文件 %s\n", path);
+        free(mf);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < SIMX_HEADER_SIZE) {
+        fprintf(stderr, "错误: 二进制矩阵文件无效 %s\n", path);
+        close(fd);
+        free(mf);
+        return NULL;
+    }
+    mf->file_size = (size_t)st.st_size;
+    void *addr = mmap(NULL, mf->file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        fprintf(stderr, "错误: 无法映射文件 %s\n", path);
+        free(mf);
+        return NULL;
+    }
+    mf->base = (uint8_t*)addr;
+    mf->mapped = true;
+#else
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "错误: 无法打开文件 %s\n", path);
+        free(mf);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    mf->file_size = file_size > 0 ? (size_t)file_size : 0;
+    mf->base = (uint8_t*)malloc(mf->file_size ? mf->file_size : 1);
+    if (file_size < SIMX_HEADER_SIZE || !mf->base ||
+        fread(mf->base, 1, mf->file_size, file) != mf->file_size) {
+        fprintf(stderr, "错误: 无法读取文件 %s\n", path);
+        fclose(file);
+        free(mf->base);
+        free(mf);
+        return NULL;
+    }
+    fclose(file);
+#endif
+
+    const uint8_t *h = mf->base;
+    mf->dtype = h[6];
+    mf->layout = h[7];
+    mf->compression = h[8];
+    mf->tile_rows = get_u32(h + 12);
+    mf->size = get_u64(h + 16);
+    uint64_t names_offset = get_u64(h + 24);
+    uint64_t data_offset = get_u64(h + 32);
+    mf->data_size = get_u64(h + 40);
+    uint64_t tile_index_offset = get_u64(h + 48);
+    mf->cell_size = dtype_cell_size(mf->dtype);
+
+    bool valid = memcmp(h, SIMX_MAGIC, 4) == 0 && h[4] == SIMX_VERSION &&
+                 mf->cell_size > 0 && mf->layout <= MATRIX_LAYOUT_UPPER &&
+                 mf->compression <= MATRIX_COMPRESS_RLE &&
+                 get_u64(h + 56) == mf->file_size &&
+                 names_offset <= data_offset && data_offset + mf->data_size <= mf->file_size;
+    if (valid && mf->compression == MATRIX_COMPRESS_NONE) {
+        uint64_t cells = mf->layout == MATRIX_LAYOUT_UPPER ? mf->size * (mf->size + 1) / 2
+                                                           : mf->size * mf->size;
+        valid = cells * mf->cell_size == mf->data_size;
+    }
+    if (valid && mf->compression == MATRIX_COMPRESS_RLE) {
+        mf->tile_count = mf->tile_rows ? (mf->size + mf->tile_rows - 1) / mf->tile_rows : 0;
+        valid = mf->tile_rows > 0 && (mf->tile_rows <= mf->size || mf->size == 0) &&
+                tile_index_offset >= SIMX_HEADER_SIZE &&
+                mf->tile_count < mf->file_size / 8 &&
+                tile_index_offset + (mf->tile_count + 1) * 8 <= mf->file_size;
+        // 行块偏移必须递增且不超出数据区，解码时才不会读到映射之外
+        uint64_t previous = 0;
+        for (size_t t = 0; valid && t <= mf->tile_count; t++) {
+            uint64_t offset = get_u64(h + tile_index_offset + t * 8);
+            valid = offset >= previous && offset <= mf->data_size;
+            previous = offset;
+        }
+    }
+    if (!valid) {
+        fprintf(stderr, "错误: 二进制矩阵文件格式不匹配 %s\n", path);
+        matrix_file_close(mf);
+        return NULL;
+    }
+
+    mf->data = mf->base + data_offset;
+    mf->tile_index = tile_index_offset ? mf->base + tile_index_offset : NULL;
+
+    // 文件名表
+    mf->names = (const char**)malloc((mf->size ? mf->size : 1) * sizeof(char*));
+    if (!mf->names) {
+        matrix_file_close(mf);
+        return NULL;
+    }
+    const char *p = (const char*)(mf->base + names_offset);
+    const char *end = (const char*)mf->data;
+    for (uint64_t i = 0; i < mf->size; i++) {
+        const char *nul = p < end ? memchr(p, '\0', (size_t)(end - p)) : NULL;
+        if (!nul) {
+            fprintf(stderr, "错误: 二进制矩阵文件名表损坏 %s\n", path);
+            matrix_file_close(mf);
+            return NULL;
+        }
+        mf->names[i] = p;
+        p = nul + 1;
+    }
+
+    return mf;
+}
+
+void matrix_file_close(MatrixFile *mf) {
+    if (!mf) return;
+
+#ifndef _WIN32
+    if (mf->mapped) munmap(mf->base, mf->file_size);
+#else
+    free(mf->base);
+#endif
+    free(mf->names);
+    free(mf->tile_cache);
+    free(mf->row_starts);
+    free(mf->cursors);
+    free(mf->tile_scanned);
+    free(mf);
+}
+
+size_t matrix_file_size(const MatrixFile *mf) {
+    return mf ? (size_t)mf->size : 0;
+}
+
+int matrix_file_dtype(const MatrixFile *mf) {
+    return mf ? mf->dtype : 0;
+}
+
+int matrix_file_layout(const MatrixFile *mf) {
+    return mf ? mf->layout : -1;
+}
+
+int matrix_file_compression(const MatrixFile *mf) {
+    return mf ? mf->compression : -1;
+}
+
+const char* matrix_file_name(const MatrixFile *mf, size_t index) {
+    if (!mf || index >= mf->size) return NULL;
+    return mf->names[index];
+}
+
+// 零拷贝访问一行的原始小端数据（仅未压缩且主机为小端时可用）
+// 全矩阵布局返回 n 个单元格；上三角布局返回从对角线开始的 n - row 个单元格
+const void* matrix_file_row_data(const MatrixFile *mf, size_t row, size_t *count) {
+    if (!mf || row >= mf->size || mf->compression != MATRIX_COMPRESS_NONE ||
+        !host_is_little_endian()) {
+        return NULL;
+    }
+
+    if (count) *count = (size_t)(mf->size - row_first_col(mf->layout, row));
+    return mf->data + row_start_cell(mf->layout, mf->size, row) * mf->cell_size;
+}
+
+// 解码一个行块到缓存
+static bool decode_tile(MatrixFile *mf, size_t tile) {
+    if (mf->cached_tile == tile) return true;
+
+    uint64_t first_row = (uint64_t)tile * mf->tile_rows;
+    uint64_t last_row = first_row + mf->tile_rows;
+    if (last_row > mf->size) last_row = mf->size;
+    uint64_t cells = row_start_cell(mf->layout, mf->size, last_row) -
+                     row_start_cell(mf->layout, mf->size, first_row);
+
+    if (!mf->tile_cache) {
+        // tile_rows 来自文件，乘积先检查溢出，避免分配过小的缓存后越界写入
+        uint64_t rows = mf->tile_rows < mf->size ? mf->tile_rows : mf->size;
+        if (rows == 0 || mf->size > SIZE_MAX / sizeof(double) / rows) return false;
+        mf->tile_cache = (double*)malloc((size_t)(rows * mf->size) * sizeof(double));
+        if (!mf->tile_cache) return false;
+    }
+
+    const uint8_t *p = mf->data + get_u64(mf->tile_index + tile * 8);
+    const uint8_t *end = mf->data + get_u64(mf->tile_index + (tile + 1) * 8);
+    uint64_t filled = 0;
+    while (filled < cells && p < end) {
+        uint64_t run = 0;
+        int shift = 0;
+        while (p < end && (*p & 0x80)) {
+            run |= (uint64_t)(*p & 0x7F) << shift;
+            shift += 7;
+            p++;
+        }
+        if (p >= end) return false;
+        run |= (uint64_t)(*p++) << shift;
+        if (p + mf->cell_size > end || run > cells - filled) return false;
+
+        double value = decode_cell(p, mf->dtype);
+        p += mf->cell_size;
+        for (uint64_t k = 0; k < run; k++) {
+            mf->tile_cache[filled++] = value;
+        }
+    }
+
+    if (filled != cells) return false;
+    mf->cached_tile = tile;
+    return true;
+}
+
+// 读取单元格 (row, col)，上三角布局下自动利用对称性
+double matrix_file_get(MatrixFile *mf, size_t row, size_t col) {
+    if (!mf || row >= mf->size || col >= mf->size) return -1.0;
+
+    if (mf->layout == MATRIX_LAYOUT_UPPER && col < row) {
+        size_t tmp = row;
+        row = col;
+        col = tmp;
+    }
+
+    uint64_t cell = row_start_cell(mf->layout, mf->size, row) +
+                    (col - row_first_col(mf->layout, row));
+
+    if (mf->compression == MATRIX_COMPRESS_NONE) {
+        return decode_cell(mf->data + cell * mf->cell_size, mf->dtype);
+    }
+
+    size_t tile = row / mf->tile_rows;
+    if (!decode_tile(mf, tile)) return -1.0;
+    return mf->tile_cache[cell - row_start_cell(mf->layout, mf->size, (uint64_t)tile * mf->tile_rows)];
+}
+
+// 读取下一个行程的长度与值
+static bool cursor_next_run(const MatrixFile *mf, RleCursor *c) {
+    uint64_t run = 0;
+    int shift = 0;
+    while (c->p < c->end && (*c->p & 0x80) && shift < 63) {
+        run |= (uint64_t)(*c->p & 0x7F) << shift;
+        shift += 7;
+        c->p++;
+    }
+    if (c->p >= c->end) return false;
+    run |= (uint64_t)(*c->p++) << shift;
+    if (run == 0 || c->p + mf->cell_size > c->end) return false;
+
+    c->value = decode_cell(c->p, mf->dtype);
+    c->p += mf->cell_size;
+    c->run_left = run;
+    return true;
+}
+
+// 游标前进 count 个单元格
+static bool cursor_skip(const MatrixFile *mf, RleCursor *c, uint64_t count) {
+    c->col += count;
+    while (count > 0) {
+        if (c->run_left == 0 && !cursor_next_run(mf, c)) return false;
+        uint64_t take = c->run_left < count ? c->run_left : count;
+        c->run_left -= take;
+        count -= take;
+    }
+    return true;
+}
+
+// 一遍扫描行块，记下其中每行起点的解码状态
+static bool scan_tile_starts(MatrixFile *mf, size_t tile) {
+    if (mf->tile_scanned[tile]) return true;
+
+    RleCursor c;
+    c.p = mf->data + get_u64(mf->tile_index + tile * 8);
+    c.end = mf->data + get_u64(mf->tile_index + (tile + 1) * 8);
+    c.col = 0;
+    c.run_left = 0;
+    c.value = 0.0;
+
+    uint64_t first_row = (uint64_t)tile * mf->tile_rows;
+    uint64_t last_row = first_row + mf->tile_rows;
+    if (last_row > mf->size) last_row = mf->size;
+    for (uint64_t r = first_row; r < last_row; r++) {
+        c.col = r;
+        mf->row_starts[r] = c;
+        mf->cursors[r] = c;
+        if (!cursor_skip(mf, &c, mf->size - r)) return false;
+    }
+    mf->tile_scanned[tile] = 1;
+    return true;
+}
+
+// 读取单元格 (j, col)，j < col；游标已越过 col 时从行首重新开始
+static bool cursor_read(MatrixFile *mf, size_t j, size_t col, double *value) {
+    if (!scan_tile_starts(mf, j / mf->tile_rows)) return false;
+
+    RleCursor *c = &mf->cursors[j];
+    if (c->col > col) *c = mf->row_starts[j];
+    if (!cursor_skip(mf, c, col - c->col)) return false;
+    if (c->run_left == 0 && !cursor_next_run(mf, c)) return false;
+    *value = c->value;
+    return true;
+}
+
+// 解码完整的一行 (n 个值)；数据损坏时返回 false
+bool matrix_file_read_row(MatrixFile *mf, size_t row, float *out) {
+    if (!mf || !out || row >= mf->size) return false;
+
+    if (mf->compression == MATRIX_COMPRESS_NONE) {
+        for (size_t j = 0; j < mf->size; j++) {
+            out[j] = (float)matrix_file_get(mf, row, j);
+        }
+        return true;
+    }
+
+    // 对角线左侧的单元格来自之前各行
+    size_t first = row_first_col(mf->layout, row);
+    if (first > 0) {
+        if (!mf->cursors) {
+            mf->row_starts = (RleCursor*)malloc((size_t)mf->size * sizeof(RleCursor));
+            mf->cursors = (RleCursor*)malloc((size_t)mf->size * sizeof(RleCursor));
+            mf->tile_scanned = (uint8_t*)calloc(mf->tile_count, 1);
+            if (!mf->row_starts || !mf->cursors || !mf->tile_scanned) return false;
+        }
+        for (size_t j = 0; j < first; j++) {
+            double value;
+            if (!cursor_read(mf, j, row, &value)) return false;
+            out[j] = (float)value;
+        }
+    }
+
+    // 本行所在的行块只解码一次
+    size_t tile = row / mf->tile_rows;
+    if (!decode_tile(mf, tile)) return false;
+    const double *cells = mf->tile_cache +
+        (row_start_cell(mf->layout, mf->size, row) -
+         row_start_cell(mf->layout, mf->size, (uint64_t)tile * mf->tile_rows));
+    for (size_t j = first; j < mf->size; j++) {
+        out[j] = (float)cells[j - first];
+    }
+    return true;
+}
@@ -0,0 +1,125 @@
+#include "neighbors.h"
+#include "sim_memory.h"
+#include "top_k.h"
+#include <stdlib.h>
+
+#define EDGE_BYTES (2 * sizeof(uint32_t) + sizeof(float))
+
+static SimilarityEdges* edges_create(size_t capacity) {
+    // 至少分配一个元素，便于调用方直接访问空结果
+    if (capacity == 0) capacity = 1;
+    if (!sim_memory_reserve(MEM_PAIRS, sizeof(SimilarityEdges) + capacity * EDGE_BYTES)) return NULL;
+
+    SimilarityEdges *edges = (SimilarityEdges*)calloc(1, sizeof(SimilarityEdges));
+    if (!edges) {
+        sim_memory_release(MEM_PAIRS, sizeof(SimilarityEdges) + capacity * EDGE_BYTES);
+        return NULL;
+    }
+    edges->capacity = capacity;
+    edges->rows = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+    edges->cols = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+    edges->scores = (float*)malloc(capacity * sizeof(float));
+    if (!edges->rows || !edges->cols || !edges->scores) {
+        similarity_edges_destroy(edges);
+        return NULL;
+    }
+    return edges;
+}
+
+static bool edges_reserve(SimilarityEdges *edges, size_t needed) {
+    if (needed <= edges->capacity) return true;
+
+    size_t new_capacity = edges->capacity * 2 > needed ? edges->capacity * 2 : needed;
+    size_t extra = (new_capacity - edges->capacity) * EDGE_BYTES;
+    if (!sim_memory_reserve(MEM_PAIRS, extra)) return false;
+
+    uint32_t *rows = (uint32_t*)realloc(edges->rows, new_capacity * sizeof(uint32_t));
+    if (rows) edges->rows = rows;
+    uint32_t *cols = (uint32_t*)realloc(edges->cols, new_capacity * sizeof(uint32_t));
+    if (cols) edges->cols = cols;
+    float *scores = (float*)realloc(edges->scores, new_capacity * sizeof(float));
+    if (scores) edges->scores = scores;
+    if (!rows || !cols || !scores) {
+        sim_memory_release(MEM_PAIRS, extra);
+        return false;
+    }
+
+    edges->capacity = new_capacity;
+    return true;
+}
+
+// 每行的 Top-K 邻居
+SimilarityEdges* similarity_matrix_top_k(const SimilarityMatrix *matrix, size_t k, double min_score) {
+    if (!matrix || matrix->size > UINT32_MAX) return NULL;
+
+    size_t n = matrix->size;
+    if (k > n - (n > 0)) k = n - (n > 0);
+
+    SimilarityEdges *edges = edges_create(n * k);
+    Candidate *heap = (Candidate*)malloc((k > 0 ? k : 1) * sizeof(Candidate));
+    if (!edges || !heap) {
+        similarity_edges_destroy(edges);
+        free(heap);
+        return NULL;
+    }
+
+    for (size_t i = 0; k > 0 && i < n; i++) {
+        const double *row = matrix->matrix[i];
+        size_t size = 0;
+        for (size_t j = 0; j < n; j++) {
+            if (j == i || row[j] < min_score) continue;
+
+            Candidate candidate = {row[j], (uint32_t)j};
+            top_k_push(heap, &size, k, candidate);
+        }
+
+        // 依次取出堆顶（最差者）从后往前填充，得到降序
+        size_t base = edges->count;
+        for (size_t m = size; m > 0; m--) {
+            edges->rows[base + m - 1] = (uint32_t)i;
+            edges->cols[base + m - 1] = heap[0].index;
+            edges->scores[base + m - 1] = (float)heap[0].score;
+            heap[0] = heap[m - 1];
+            top_k_sift_down(heap, m - 1, 0);
+        }
+        edges->count += size;
+    }
+
+    free(heap);
+    return edges;
+}
+
+// 阈值以上的文档对
+SimilarityEdges* similarity_matrix_pairs_above(const SimilarityMatrix *matrix, double threshold) {
+    if (!matrix || matrix->size > UINT32_MAX) return NULL;
+
+    SimilarityEdges *edges = edges_create(64);
+    if (!edges) return NULL;
+
+    for (size_t i = 0; i < matrix->size; i++) {
+        const double *row = matrix->matrix[i];
+        for (size_t j = i + 1; j < matrix->size; j++) {
+            if (row[j] < threshold) continue;
+
+            if (!edges_reserve(edges, edges->count + 1)) {
+                similarity_edges_destroy(edges);
+                return NULL;
+            }
+            edges->rows[edges->count] = (uint32_t)i;
+            edges->cols[edges->count] = (uint32_t)j;
+            edges->scores[edges->count] = (float)row[j];
+            edges->count++;
+        }
+    }
+
+    return edges;
+}
+
+void similarity_edges_destroy(SimilarityEdges *edges) {
+    if (!edges) return;
+    sim_memory_release(MEM_PAIRS, sizeof(SimilarityEdges) + edges->capacity * EDGE_BYTES);
+    free(edges->rows);
+    free(edges->cols);
+    free(edges->scores);
+    free(edges);
+}
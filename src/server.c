@@ -0,0 +1,984 @@
+#include "server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include "byte_order.h"
+#include "file_manager.h"
+#include "hashtable.h"
+#include "matrix_engine.h"
+#include "matrix_file.h"
+#include "top_k.h"
+#include "vector_math.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define SERVER_DEFAULT_MAX_BATCH 64
+
+// 响应缓冲区：前 5 字节预留给长度与状态
+typedef struct ByteBuffer {
+    uint8_t *data;
+    size_t len;
+    size_t capacity;
+    bool failed;
+} ByteBuffer;
+
+typedef struct CorpusEntry {
+    char *name;
+    SparseVector *vector;
+} CorpusEntry;
+
+// 等待评分线程处理的查询，存放在连接线程的栈上
+typedef struct PendingQuery {
+    SparseVector *vector;
+    size_t k;
+    ByteBuffer *response;
+    bool done;
+    struct PendingQuery *next;
+} PendingQuery;
+
+struct SimServer {
+    char *socket_path;
+    StopWords *stop_words;
+    size_t max_batch;
+    int listen_fd;
+    int stop_pipe[2];           // 写入一个字节即通知所有线程停止
+
+    // 语料：查询与矩阵持读锁，增删持写锁
+    pthread_rwlock_t corpus_lock;
+    CorpusEntry *entries;
+    size_t count;
+    size_t capacity;
+    HashTable *names;           // 名称 -> 下标
+
+    // 查询队列与连接计数
+    pthread_mutex_t queue_lock;
+    pthread_cond_t queue_ready;
+    pthread_cond_t batch_done;
+    pthread_cond_t connections_done;
+    PendingQuery *head;
+    PendingQuery *tail;
+    PendingQuery **batch;       // 评分线程的批次缓冲区，max_batch 个
+    bool stopping;
+    size_t connections;
+    uint64_t queries;
+    uint64_t batches;
+    size_t largest_batch;
+};
+
+typedef struct Connection {
+    SimServer *server;
+    int fd;
+} Connection;
+
+// ---- 响应缓冲区 ----
+
+static bool buffer_reserve(ByteBuffer *buf, size_t extra) {
+    if (buf->failed) return false;
+    if (buf->len + extra <= buf->capacity) return true;
+
+    size_t new_capacity = buf->capacity ? buf->capacity : 256;
+    while (new_capacity < buf->len + extra) new_capacity *= 2;
+    uint8_t *data = (uint8_t*)realloc(buf->data, new_capacity);
+    if (!data) {
+        buf->failed = true;
+        return false;
+    }
+    buf->data = data;
+    buf->capacity = new_capacity;
+    return true;
+}
+
+static void buffer_put_bytes(ByteBuffer *buf, const void *bytes, size_t len) {
+    if (!buffer_reserve(buf, len)) return;
+    if (len > 0) memcpy(buf->data + buf->len, bytes, len);
+    buf->len += len;
+}
+
+static void buffer_put_u16(ByteBuffer *buf, uint16_t v) {
+    if (!buffer_reserve(buf, 2)) return;
+    put_u16(buf->data + buf->len, v);
+    buf->len += 2;
+}
+
+static void buffer_put_u32(ByteBuffer *buf, uint32_t v) {
+    if (!buffer_reserve(buf, 4)) return;
+    put_u32(buf->data + buf->len, v);
+    buf->len += 4;
+}
+
+static void buffer_put_u64(ByteBuffer *buf, uint64_t v) {
+    if (!buffer_reserve(buf, 8)) return;
+    put_u64(buf->data + buf->len, v);
+    buf->len += 8;
+}
+
+static void buffer_put_f64(ByteBuffer *buf, double v) {
+    if (!buffer_reserve(buf, 8)) return;
+    put_f64(buf->data + buf->len, v);
+    buf->len += 8;
+}
+
+static void buffer_put_name(ByteBuffer *buf, const char *name) {
+    size_t len = strlen(name);
+    if (len > UINT16_MAX) len = UINT16_MAX;
+    buffer_put_u16(buf, (uint16_t)len);
+    buffer_put_bytes(buf, name, len);
+}
+
+// 清空负载，开始一个新响应
+static void response_begin(ByteBuffer *buf) {
+    buf->len = 0;
+    buf->failed = false;
+    if (buffer_reserve(buf, 5)) buf->len = 5;
+}
+
+// 填写帧头；缓冲区分配失败或超出 u32 帧长度时退化为无负载的错误响应
+static void response_finish(ByteBuffer *buf, ServerStatus status) {
+    if (buf->failed || buf->len - 4 > UINT32_MAX) {
+        buf->failed = false;
+        buf->len = 0;
+        if (!buffer_reserve(buf, 5)) return;
+        buf->len = 5;
+        status = SERVER_STATUS_ERROR;
+    }
+    put_u32(buf->data, (uint32_t)(buf->len - 4));
+    buf->data[4] = (uint8_t)status;
+}
+
+static void response_error(ByteBuffer *buf, ServerStatus status, const char *message) {
+    response_begin(buf);
+    buffer_put_bytes(buf, message, strlen(message));
+    response_finish(buf, status);
+}
+
+// ---- 语料 ----
+
+// 分词并生成稀疏向量（不持有任何锁）
+static SparseVector* text_vector(const char *text, size_t len, StopWords *stop_words) {
+    Document *doc = document_create_from_buffer("request", text, len);
+    if (!doc) return NULL;
+
+    SparseVector *vector = NULL;
+    if (document_process(doc, stop_words)) {
+        vector = document_vector(doc);
+        doc->vector = NULL;
+    }
+    document_destroy(doc);
+    return vector;
+}
+
+// 调用方持写锁；vector 的所有权转移给语料，返回文档下标
+static bool corpus_put(SimServer *server, const char *name, SparseVector *vector, size_t *index) {
+    int existing = hash_table_get(server->names, name);
+    if (existing >= 0) {
+        sparse_vector_destroy(server->entries[existing].vector);
+        server->entries[existing].vector = vector;
+        *index = (size_t)existing;
+        return true;
+    }
+
+    if (server->count >= (size_t)INT32_MAX) return false;
+    if (server->count >= server->capacity) {
+        size_t new_capacity = server->capacity ? server->capacity * 2 : 64;
+        CorpusEntry *entries = (CorpusEntry*)realloc(server->entries,
+                                                     new_capacity * sizeof(CorpusEntry));
+        if (!entries) return false;
+        server->entries = entries;
+        server->capacity = new_capacity;
+    }
+
+    char *copy = strdup(name);
+    if (!copy || !hash_table_insert(server->names, name, (int)server->count)) {
+        free(copy);
+        return false;
+    }
+    server->entries[server->count].name = copy;
+    server->entries[server->count].vector = vector;
+    *index = server->count++;
+    return true;
+}
+
+// 调用方持写锁；最后一个文档移入空位
+static bool corpus_remove(SimServer *server, const char *name) {
+    int found = hash_table_get(server->names, name);
+    if (found < 0) return false;
+
+    size_t index = (size_t)found;
+    hash_table_remove(server->names, name);
+    free(server->entries[index].name);
+    sparse_vector_destroy(server->entries[index].vector);
+
+    size_t last = --server->count;
+    if (index != last) {
+        server->entries[index] = server->entries[last];
+        hash_table_remove(server->names, server->entries[index].name);
+        hash_table_insert(server->names, server->entries[index].name, (int)index);
+    }
+    return true;
+}
+
+static bool preload_visitor(Document *doc, const char *name, void *userdata) {
+    SimServer *server = (SimServer*)userdata;
+    SparseVector *vector = document_vector(doc);
+    if (!vector) return false;
+
+    size_t index;
+    if (!corpus_put(server, name, vector, &index)) return false;
+    doc->vector = NULL;
+    return false;
+}
+
+// ---- 批量评分 ----
+
+// 一批查询的词项表：词项 -> 倒排链 (查询编号, 权重)
+typedef struct TermMap {
+    uint64_t *keys;
+    size_t *heads;              // SIZE_MAX 表示空槽
+    unsigned shift;
+    uint32_t *post_query;
+    double *post_value;
+    size_t *post_next;
+} TermMap;
+
+static size_t term_slot(const TermMap *map, uint64_t key) {
+    return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> map->shift);
+}
+
+static void term_map_destroy(TermMap *map) {
+    free(map->keys);
+    free(map->heads);
+    free(map->post_query);
+    free(map->post_value);
+    free(map->post_next);
+    memset(map, 0, sizeof(*map));
+}
+
+static bool term_map_build(TermMap *map, PendingQuery **batch, size_t count) {
+    memset(map, 0, sizeof(*map));
+
+    size_t postings = 0;
+    for (size_t q = 0; q < count; q++) {
+        if (batch[q]->vector) postings += batch[q]->vector->size;
+    }
+
+    unsigned bits = 4;
+    while (((size_t)1 << bits) < postings * 2) bits++;
+    size_t slots = (size_t)1 << bits;
+    map->shift = 64 - bits;
+    map->keys = (uint64_t*)malloc(slots * sizeof(uint64_t));
+    map->heads = (size_t*)malloc(slots * sizeof(size_t));
+    map->post_query = (uint32_t*)malloc((postings + 1) * sizeof(uint32_t));
+    map->post_value = (double*)malloc((postings + 1) * sizeof(double));
+    map->post_next = (size_t*)malloc((postings + 1) * sizeof(size_t));
+    if (!map->keys || !map->heads || !map->post_query || !map->post_value || !map->post_next) {
+        term_map_destroy(map);
+        return false;
+    }
+    for (size_t s = 0; s < slots; s++) map->heads[s] = SIZE_MAX;
+
+    size_t p = 0;
+    for (size_t q = 0; q < count; q++) {
+        const SparseVector *vec = batch[q]->vector;
+        if (!vec || vec->norm == 0) continue;
+        for (size_t t = 0; t < vec->size; t++) {
+            size_t slot = term_slot(map, vec->keys[t]);
+            while (map->heads[slot] != SIZE_MAX && map->keys[slot] != vec->keys[t]) {
+                slot = (slot + 1) & (slots - 1);
+            }
+            map->keys[slot] = vec->keys[t];
+            map->post_query[p] = (uint32_t)q;
+            map->post_value[p] = vec->values[t];
+            map->post_next[p] = map->heads[slot];
+            map->heads[slot] = p++;
+        }
+    }
+    return true;
+}
+
+static size_t term_map_find(const TermMap *map, uint64_t key) {
+    size_t mask = ((size_t)1 << (64 - map->shift)) - 1;
+    size_t slot = term_slot(map, key);
+    while (map->heads[slot] != SIZE_MAX) {
+        if (map->keys[slot] == key) return map->heads[slot];
+        slot = (slot + 1) & mask;
+    }
+    return SIZE_MAX;
+}
+
+// 对语料做一次扫描，同时为整批查询累加点积。每个文档的词项按升序访问，
+// 累加顺序与 sparse_vector_dot 的归并一致，因此分数与 sparse_vector_cosine 逐位相同
+static void score_batch(SimServer *server, PendingQuery **batch, size_t count) {
+    pthread_rwlock_rdlock(&server->corpus_lock);
+
+    size_t n = server->count;
+    size_t heap_total = 0;
+    for (size_t q = 0; q < count; q++) {
+        if (batch[q]->k > n) batch[q]->k = n;
+        heap_total += batch[q]->k;
+    }
+
+    TermMap map;
+    bool ok = term_map_build(&map, batch, count);
+    double *dots = (double*)malloc(count * sizeof(double));
+    uint32_t *touched = (uint32_t*)malloc(count * sizeof(uint32_t));
+    bool *seen = (bool*)calloc(count, sizeof(bool));
+    size_t *heap_sizes = (size_t*)calloc(count, sizeof(size_t));
+    Candidate *heaps = (Candidate*)malloc((heap_total + 1) * sizeof(Candidate));
+    Candidate **heap_of = (Candidate**)malloc(count * sizeof(Candidate*));
+    ok = ok && dots && touched && seen && heap_sizes && heaps && heap_of;
+
+    if (ok) {
+        size_t offset = 0;
+        for (size_t q = 0; q < count; q++) {
+            heap_of[q] = heaps + offset;
+            offset += batch[q]->k;
+        }
+
+        for (size_t d = 0; d < n; d++) {
+            const SparseVector *doc = server->entries[d].vector;
+            if (!doc || doc->norm == 0) continue;
+
+            size_t touched_count = 0;
+            for (size_t t = 0; t < doc->size; t++) {
+                for (size_t p = term_map_find(&map, doc->keys[t]); p != SIZE_MAX; p = map.post_next[p]) {
+                    uint32_t q = map.post_query[p];
+                    if (!seen[q]) {
+                        seen[q] = true;
+                        touched[touched_count++] = q;
+                        dots[q] = 0.0;
+                    }
+                    dots[q] += map.post_value[p] * doc->values[t];
+                }
+            }
+
+            for (size_t i = 0; i < touched_count; i++) {
+                uint32_t q = touched[i];
+                seen[q] = false;
+                if (batch[q]->k == 0) continue;
+                Candidate c = {dots[q] / (batch[q]->vector->norm * doc->norm), (uint32_t)d};
+                top_k_push(heap_of[q], &heap_sizes[q], batch[q]->k, c);
+            }
+        }
+
+        // 名称在读锁内复制进响应
+        for (size_t q = 0; q < count; q++) {
+            ByteBuffer *buf = batch[q]->response;
+            Candidate *heap = heap_of[q];
+            qsort(heap, heap_sizes[q], sizeof(Candidate), candidate_compare);
+
+            response_begin(buf);
+            buffer_put_u32(buf, (uint32_t)heap_sizes[q]);
+            for (size_t i = 0; i < heap_sizes[q]; i++) {
+                buffer_put_u32(buf, heap[i].index);
+                buffer_put_f64(buf, heap[i].score);
+                buffer_put_name(buf, server->entries[heap[i].index].name);
+            }
+            response_finish(buf, SERVER_STATUS_OK);
+        }
+    } else {
+        for (size_t q = 0; q < count; q++) {
+            response_error(batch[q]->response, SERVER_STATUS_ERROR, "无法分配内存");
+        }
+    }
+
+    pthread_rwlock_unlock(&server->corpus_lock);
+
+    term_map_destroy(&map);
+    free(dots);
+    free(touched);
+    free(seen);
+    free(heap_sizes);
+    free(heaps);
+    free(heap_of);
+}
+
+// 评分线程：取走队列中已积压的查询（最多 max_batch 个）一起评分。
+// 不额外等待凑批，扫描期间到达的查询自然合并进下一批
+static void* scorer_main(void *arg) {
+    SimServer *server = (SimServer*)arg;
+    PendingQuery **batch = server->batch;
+
+    pthread_mutex_lock(&server->queue_lock);
+    for (;;) {
+        while (!server->head && !server->stopping) {
+            pthread_cond_wait(&server->queue_ready, &server->queue_lock);
+        }
+        if (!server->head) break;
+
+        size_t count = 0;
+        while (server->head && count < server->max_batch) {
+            batch[count++] = server->head;
+            server->head = server->head->next;
+        }
+        if (!server->head) server->tail = NULL;
+        pthread_mutex_unlock(&server->queue_lock);
+
+        score_batch(server, batch, count);
+
+        pthread_mutex_lock(&server->queue_lock);
+        for (size_t i = 0; i < count; i++) {
+            batch[i]->done = true;
+        }
+        server->queries += count;
+        server->batches++;
+        if (count > server->largest_batch) server->largest_batch = count;
+        pthread_cond_broadcast(&server->batch_done);
+    }
+    pthread_mutex_unlock(&server->queue_lock);
+    return NULL;
+}
+
+// ---- 请求处理 ----
+
+static void handle_add(SimServer *server, const uint8_t *payload, size_t len, ByteBuffer *out) {
+    if (len < 2 || get_u16(payload) == 0 || (size_t)get_u16(payload) + 2 > len) {
+        response_error(out, SERVER_STATUS_BAD_REQUEST, "ADD 请求格式错误");
+        return;
+    }
+    size_t name_len = get_u16(payload);
+    const char *text = (const char*)payload + 2 + name_len;
+    size_t text_len = len - 2 - name_len;
+    if (memchr(payload + 2, '\0', name_len)) {
+        response_error(out, SERVER_STATUS_BAD_REQUEST, "文档名包含空字符");
+        return;
+    }
+    if (text_len == 0) {
+        response_error(out, SERVER_STATUS_BAD_REQUEST, "文档为空");
+        return;
+    }
+
+    char *name = (char*)malloc(name_len + 1);
+    SparseVector *vector = name ? text_vector(text, text_len, server->stop_words) : NULL;
+    if (!vector) {
+        free(name);
+        response_error(out, SERVER_STATUS_ERROR, "无法处理文档");
+        return;
+    }
+    memcpy(name, payload + 2, name_len);
+    name[name_len] = '\0';
+
+    pthread_rwlock_wrlock(&server->corpus_lock);
+    size_t index;
+    bool ok = corpus_put(server, name, vector, &index);
+    size_t count = server->count;
+    pthread_rwlock_unlock(&server->corpus_lock);
+    free(name);
+
+    if (!ok) {
+        sparse_vector_destroy(vector);
+        response_error(out, SERVER_STATUS_ERROR, "无法添加文档");
+        return;
+    }
+    response_begin(out);
+    buffer_put_u32(out, (uint32_t)index);
+    buffer_put_u32(out, (uint32_t)count);
+    response_finish(out, SERVER_STATUS_OK);
+}
+
+static void handle_remove(SimServer *server, const uint8_t *payload, size_t len, ByteBuffer *out) {
+    if (len < 2 || (size_t)get_u16(payload) + 2 != len) {
+        response_error(out, SERVER_STATUS_BAD_REQUEST, "REMOVE 请求格式错误");
+        return;
+    }
+    size_t name_len = get_u16(payload);
+    char *name = (char*)malloc(name_len + 1);
+    if (!name) {
+        response_error(out, SERVER_STATUS_ERROR, "无法分配内存");
+        return;
+    }
+    memcpy(name, payload + 2, name_len);
+    name[name_len] = '\0';
+
+    pthread_rwlock_wrlock(&server->corpus_lock);
+    bool removed = strlen(name) == name_len && corpus_remove(server, name);
+    size_t count = server->count;
+    pthread_rwlock_unlock(&server->corpus_lock);
+    free(name);
+
+    if (!removed) {
+        response_error(out, SERVER_STATUS_NOT_FOUND, "文档不存在");
+        return;
+    }
+    response_begin(out);
+    buffer_put_u32(out, (uint32_t)count);
+    response_finish(out, SERVER_STATUS_OK);
+}
+
+static void handle_query(SimServer *server, const uint8_t *payload, size_t len, ByteBuffer *out) {
+    if (len < 4) {
+        response_error(out, SERVER_STATUS_BAD_REQUEST, "QUERY 请求格式错误");
+        return;
+    }
+
+    PendingQuery query;
+    memset(&query, 0, sizeof(query));
+    query.k = get_u32(payload);
+    query.response = out;
+
+    // 没有有效词项的查询不进入队列
+    if (len == 4 || query.k == 0 ||
+        !(query.vector = text_vector((const char*)payload + 4, len - 4, server->stop_words)) ||
+        query.vector->size == 0) {
+        sparse_vector_destroy(query.vector);
+        response_begin(out);
+        buffer_put_u32(out, 0);
+        response_finish(out, SERVER_STATUS_OK);
+        return;
+    }
+
+    pthread_mutex_lock(&server->queue_lock);
+    if (server->tail) server->tail->next = &query;
+    else server->head = &query;
+    server->tail = &query;
+    pthread_cond_signal(&server->queue_ready);
+    while (!query.done) {
+        pthread_cond_wait(&server->batch_done, &server->queue_lock);
+    }
+    pthread_mutex_unlock(&server->queue_lock);
+
+    sparse_vector_destroy(query.vector);
+}
+
+// 复制稀疏向量，供锁外计算使用
+static SparseVector* vector_copy(const SparseVector *vec) {
+    SparseVector *copy = sparse_vector_alloc(vec->size);
+    if (!copy) return NULL;
+    memcpy(copy->keys, vec->keys, vec->size * sizeof(uint64_t));
+    memcpy(copy->values, vec->values, vec->size * sizeof(double));
+    copy->norm = vec->norm;
+    return copy;
+}
+
+// MATRIX 响应的负载字节数：u32 n、n 个名称与编码后的单元格
+static uint64_t matrix_payload_bytes(const SimServer *server, MatrixDType dtype, MatrixLayout layout) {
+    uint64_t cell_size = dtype == MATRIX_DTYPE_F64 ? 8 : dtype == MATRIX_DTYPE_F32 ? 4
+                       : dtype == MATRIX_DTYPE_F16 ? 2 : 1;
+    uint64_t n = server->count;
+    uint64_t cells = layout == MATRIX_LAYOUT_UPPER ? n * (n + 1) / 2 : n * n;
+    uint64_t bytes = 4 + cells * cell_size;
+    for (size_t i = 0; i < server->count; i++) {
+        size_t name = strlen(server->entries[i].name);
+        bytes += 2 + (name > UINT16_MAX ? UINT16_MAX : name);
+    }
+    return bytes;
+}
+
+static void handle_matrix(SimServer *server, const uint8_t *payload, size_t len, ByteBuffer *out) {
+    if (len != 2 || payload[0] < MATRIX_DTYPE_F32 || payload[0] > MATRIX_DTYPE_F16 ||
+        payload[1] > MATRIX_LAYOUT_UPPER) {
+        response_error(out, SERVER_STATUS_BAD_REQUEST, "MATRIX 请求格式错误");
+        return;
+    }
+
+    // 读锁内只复制名字与向量，O(n^2) 的计算在锁外多线程进行，不阻塞 ADD/REMOVE
+    pthread_rwlock_rdlock(&server->corpus_lock);
+    // 帧长度字段为 u32（含状态字节），放不下的矩阵在计算前拒绝
+    if (matrix_payload_bytes(server, (MatrixDType)payload[0], (MatrixLayout)payload[1]) > UINT32_MAX - 1) {
+        pthread_rwlock_unlock(&server->corpus_lock);
+        response_error(out, SERVER_STATUS_ERROR, "相似度矩阵超出单帧上限 4 GB，请使用更紧凑的格式");
+        return;
+    }
+    size_t n = server->count;
+    const char **names = (const char**)calloc(n + 1, sizeof(char*));
+    SparseVector **vectors = (SparseVector**)calloc(n + 1, sizeof(SparseVector*));
+    bool copied = names && vectors;
+    for (size_t i = 0; copied && i < n; i++) {
+        names[i] = strdup(server->entries[i].name);
+        vectors[i] = vector_copy(server->entries[i].vector);
+        copied = names[i] && vectors[i];
+    }
+    pthread_rwlock_unlock(&server->corpus_lock);
+
+    SimilarityMatrix *matrix = copied && n > 0
+        ? similarity_matrix_create_from_vectors(names, vectors, n, 0) : NULL;
+    for (size_t i = 0; i < n && names && vectors; i++) {
+        free((char*)names[i]);
+        sparse_vector_destroy(vectors[i]);
+    }
+    free(names);
+    free(vectors);
+
+    if (n == 0) {
+        response_begin(out);
+        buffer_put_u32(out, 0);
+        response_finish(out, SERVER_STATUS_OK);
+        return;
+    }
+
+    size_t bytes = 0;
+    void *cells = matrix ? similarity_matrix_encode(matrix, (MatrixDType)payload[0],
+                                                    (MatrixLayout)payload[1], &bytes) : NULL;
+    if (!cells) {
+        similarity_matrix_destroy(matrix);
+        response_error(out, SERVER_STATUS_ERROR, "无法计算相似度矩阵");
+        return;
+    }
+
+    response_begin(out);
+    buffer_put_u32(out, (uint32_t)n);
+    for (size_t i = 0; i < n; i++) buffer_put_name(out, matrix->filenames[i]);
+    buffer_put_bytes(out, cells, bytes);
+    response_finish(out, SERVER_STATUS_OK);
+
+    similarity_buffer_free(cells);
+    similarity_matrix_destroy(matrix);
+}
+
+static void handle_stats(SimServer *server, ByteBuffer *out) {
+    ServerStats stats;
+    sim_server_get_stats(server, &stats);
+    response_begin(out);
+    buffer_put_u32(out, (uint32_t)stats.documents);
+    buffer_put_u64(out, stats.queries);
+    buffer_put_u64(out, stats.batches);
+    buffer_put_u32(out, (uint32_t)stats.largest_batch);
+    response_finish(out, SERVER_STATUS_OK);
+}
+
+static void handle_request(SimServer *server, const uint8_t *frame, size_t len, ByteBuffer *out) {
+    const uint8_t *payload = frame + 1;
+    size_t payload_len = len - 1;
+
+    switch (frame[0]) {
+        case SERVER_OP_ADD: handle_add(server, payload, payload_len, out); return;
+        case SERVER_OP_QUERY: handle_query(server, payload, payload_len, out); return;
+        case SERVER_OP_MATRIX: handle_matrix(server, payload, payload_len, out); return;
+        case SERVER_OP_REMOVE: handle_remove(server, payload, payload_len, out); return;
+        case SERVER_OP_STATS: handle_stats(server, out); return;
+        default: break;
+    }
+
+    response_error(out, SERVER_STATUS_BAD_REQUEST, "未知操作码");
+}
+
+// ---- 连接 ----
+
+// 读满 len 字节；连接关闭、出错或服务停止时返回 false
+static bool read_full(SimServer *server, int fd, uint8_t *buf, size_t len) {
+    struct pollfd fds[2] = {{fd, POLLIN, 0}, {server->stop_pipe[0], POLLIN, 0}};
+
+    while (len > 0) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (fds[1].revents) return false;
+
+        ssize_t got = recv(fd, buf, len, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        buf += got;
+        len -= (size_t)got;
+    }
+    return true;
+}
+
+static bool write_full(int fd, const uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t sent = send(fd, buf, len, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        buf += sent;
+        len -= (size_t)sent;
+    }
+    return true;
+}
+
+static void* connection_main(void *arg) {
+    Connection *conn = (Connection*)arg;
+    SimServer *server = conn->server;
+    ByteBuffer response = {0};
+    uint8_t header[4];
+
+    while (read_full(server, conn->fd, header, sizeof(header))) {
+        uint32_t len = get_u32(header);
+        if (len == 0 || len > SERVER_MAX_FRAME) {
+            response_error(&response, SERVER_STATUS_BAD_REQUEST, "帧长度无效");
+            write_full(conn->fd, response.data, response.len);
+            break;
+        }
+
+        uint8_t *frame = (uint8_t*)malloc(len);
+        if (!frame || !read_full(server, conn->fd, frame, len)) {
+            free(frame);
+            break;
+        }
+
+        handle_request(server, frame, len, &response);
+        free(frame);
+        if (response.len == 0 || !write_full(conn->fd, response.data, response.len)) break;
+
+        // 大响应（矩阵）发送后不保留缓冲区
+        if (response.capacity > (1u << 20)) {
+            free(response.data);
+            memset(&response, 0, sizeof(response));
+        }
+    }
+
+    free(response.data);
+    close(conn->fd);
+    free(conn);
+
+    pthread_mutex_lock(&server->queue_lock);
+    if (--server->connections == 0) pthread_cond_broadcast(&server->connections_done);
+    pthread_mutex_unlock(&server->queue_lock);
+    return NULL;
+}
+
+// ---- 生命周期 ----
+
+SimServer* sim_server_create(const ServerOptions *options, StopWords *stop_words) {
+    if (!options || !options->socket_path) return NULL;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(options->socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "错误: 套接字路径过长: %s\n", options->socket_path);
+        return NULL;
+    }
+    strcpy(addr.sun_path, options->socket_path);
+
+    SimServer *server = (SimServer*)calloc(1, sizeof(SimServer));
+    if (!server) return NULL;
+    server->listen_fd = -1;
+    server->stop_pipe[0] = server->stop_pipe[1] = -1;
+    server->stop_words = stop_words;
+    server->max_batch = options->max_batch ? options->max_batch : SERVER_DEFAULT_MAX_BATCH;
+    server->socket_path = strdup(options->socket_path);
+    server->names = hash_table_create(1024);
+    server->batch = (PendingQuery**)malloc(server->max_batch * sizeof(PendingQuery*));
+    pthread_rwlock_init(&server->corpus_lock, NULL);
+    pthread_mutex_init(&server->queue_lock, NULL);
+    pthread_cond_init(&server->queue_ready, NULL);
+    pthread_cond_init(&server->batch_done, NULL);
+    pthread_cond_init(&server->connections_done, NULL);
+
+    if (!server->socket_path || !server->names || !server->batch || pipe(server->stop_pipe) != 0) {
+        fprintf(stderr, "错误: 无法初始化服务\n");
+        sim_server_destroy(server);
+        return NULL;
+    }
+
+    if (options->preload_dir) {
+        for_each_document_in_dir(options->preload_dir, stop_words, preload_visitor, server);
+        printf("已加载 %zu 个文档\n", server->count);
+    }
+
+    // 只替换残留的套接字文件，不覆盖普通文件
+    struct stat st;
+    if (lstat(server->socket_path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "错误: %s 已存在且不是套接字\n", server->socket_path);
+            sim_server_destroy(server);
+            return NULL;
+        }
+        unlink(server->socket_path);
+    }
+
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server->listen_fd < 0 ||
+        bind(server->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(server->listen_fd, 64) != 0) {
+        fprintf(stderr, "错误: 无法监听套接字 %s: %s\n", server->socket_path, strerror(errno));
+        if (server->listen_fd >= 0) {
+            close(server->listen_fd);
+            server->listen_fd = -1;
+        }
+        sim_server_destroy(server);
+        return NULL;
+    }
+
+    return server;
+}
+
+int sim_server_run(SimServer *server) {
+    if (!server || server->listen_fd < 0) return 1;
+
+    pthread_t scorer;
+    if (pthread_create(&scorer, NULL, scorer_main, server) != 0) {
+        fprintf(stderr, "错误: 无法创建评分线程\n");
+        return 1;
+    }
+
+    int status = 0;
+    struct pollfd fds[2] = {{server->listen_fd, POLLIN, 0}, {server->stop_pipe[0], POLLIN, 0}};
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "错误: 等待连接失败\n");
+            status = 1;
+            break;
+        }
+        if (fds[1].revents) break;
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) continue;
+
+        Connection *conn = (Connection*)malloc(sizeof(Connection));
+        pthread_t thread;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+        pthread_mutex_lock(&server->queue_lock);
+        server->connections++;
+        pthread_mutex_unlock(&server->queue_lock);
+
+        if (conn) {
+            conn->server = server;
+            conn->fd = fd;
+        }
+        if (!conn || pthread_create(&thread, &attr, connection_main, conn) != 0) {
+            free(conn);
+            close(fd);
+            pthread_mutex_lock(&server->queue_lock);
+            server->connections--;
+            pthread_mutex_unlock(&server->queue_lock);
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    // 连接线程看到停止信号后退出；评分线程处理完剩余查询后退出
+    sim_server_stop(server);
+    pthread_mutex_lock(&server->queue_lock);
+    while (server->connections > 0) {
+        pthread_cond_wait(&server->connections_done, &server->queue_lock);
+    }
+    server->stopping = true;
+    pthread_cond_signal(&server->queue_ready);
+    pthread_mutex_unlock(&server->queue_lock);
+    pthread_join(scorer, NULL);
+
+    return status;
+}
+
+void sim_server_stop(SimServer *server) {
+    if (!server || server->stop_pipe[1] < 0) return;
+    if (write(server->stop_pipe[1], "", 1) < 0) {
+        // 管道已满说明停止请求已经发出
+    }
+}
+
+void sim_server_destroy(SimServer *server) {
+    if (!server) return;
+
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+        unlink(server->socket_path);
+    }
+    if (server->stop_pipe[0] >= 0) close(server->stop_pipe[0]);
+    if (server->stop_pipe[1] >= 0) close(server->stop_pipe[1]);
+
+    for (size_t i = 0; i < server->count; i++) {
+        free(server->entries[i].name);
+        sparse_vector_destroy(server->entries[i].vector);
+    }
+    free(server->entries);
+    if (server->names) hash_table_destroy(server->names);
+    free(server->socket_path);
+    free(server->batch);
+
+    pthread_rwlock_destroy(&server->corpus_lock);
+    pthread_mutex_destroy(&server->queue_lock);
+    pthread_cond_destroy(&server->queue_ready);
+    pthread_cond_destroy(&server->batch_done);
+    pthread_cond_destroy(&server->connections_done);
+    free(server);
+}
+
+void sim_server_get_stats(SimServer *server, ServerStats *stats) {
+    if (!server || !stats) return;
+
+    pthread_rwlock_rdlock(&server->corpus_lock);
+    stats->documents = server->count;
+    pthread_rwlock_unlock(&server->corpus_lock);
+
+    pthread_mutex_lock(&server->queue_lock);
+    stats->queries = server->queries;
+    stats->batches = server->batches;
+    stats->largest_batch = server->largest_batch;
+    pthread_mutex_unlock(&server->queue_lock);
+}
+
+static SimServer *active_server = NULL;
+
+static void serve_signal_handler(int sig) {
+    (void)sig;
+    sim_server_stop(active_server);
+}
+
+int serve_socket(const ServerOptions *options, StopWords *stop_words) {
+    SimServer *server = sim_server_create(options, stop_words);
+    if (!server) return 1;
+
+    printf("正在监听 %s，按 Ctrl+C 退出...\n", options->socket_path);
+    fflush(stdout);
+
+    active_server = server;
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, serve_signal_handler);
+    signal(SIGTERM, serve_signal_handler);
+
+    int status = sim_server_run(server);
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    active_server = NULL;
+
+    ServerStats stats;
+    sim_server_get_stats(server, &stats);
+    printf("服务已退出：%zu 个文档，%llu 次查询，%llu 个批次\n", stats.documents,
+           (unsigned long long)stats.queries, (unsigned long long)stats.batches);
+    sim_server_destroy(server);
+    return status;
+}
+
+#else
+
+SimServer* sim_server_create(const ServerOptions *options, StopWords *stop_words) {
+    (void)options;
+    (void)stop_words;
+    fprintf(stderr, "错误: 服务模式仅支持 POSIX 平台\n");
+    return NULL;
+}
+
+int sim_server_run(SimServer *server) {
+    (void)server;
+    return 1;
+}
+
+void sim_server_stop(SimServer *server) {
+    (void)server;
+}
+
+void sim_server_destroy(SimServer *server) {
+    (void)server;
+}
+
+void sim_server_get_stats(SimServer *server, ServerStats *stats) {
+    (void)server;
+    if (stats) memset(stats, 0, sizeof(*stats));
+}
+
+int serve_socket(const ServerOptions *options, StopWords *stop_words) {
+    (void)options;
+    (void)stop_words;
+    fprintf(stderr, "错误: 服务模式仅支持 POSIX 平台\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,194 @@
+#include "shingle.h"
+#include "sim_memory.h"
+#include "sim_stats.h"
+#include "sim_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define SHINGLE_INITIAL_CAPACITY 256
+#define SHINGLE_BASE 0x100000001B3ULL       // 多项式的底，奇数，模 2^64 下可逆
+#define CJK_UNIT_SEED 0x9E3779B97F4A7C15ULL  // 区分单字与同码点的单词哈希
+
+// 收集中的 shingle 哈希
+typedef struct ShingleBuffer {
+    uint64_t *hashes;
+    size_t count;
+    size_t capacity;
+} ShingleBuffer;
+
+// 窗口状态：最近 width 个词的哈希与它们的多项式和
+typedef struct ShingleWindow {
+    const ShingleOptions *options;
+    uint64_t units[SHINGLE_MAX_WIDTH];
+    uint64_t top_power;     // SHINGLE_BASE^(width-1)，移出最旧的词时使用
+    uint64_t hash;
+    size_t seen;            // 已进入窗口的词数
+    uint64_t min_hash;      // 所有 shingle 中最小的哈希，抽样全部落空时保留它
+    bool emitted;
+    ShingleBuffer *out;
+    bool ok;
+} ShingleWindow;
+
+void shingle_options_init(ShingleOptions *options) {
+    if (!options) return;
+    options->width = 0;
+    options->sample_mod = 1;
+}
+
+bool shingle_options_active(const ShingleOptions *options) {
+    return options && options->width > 0;
+}
+
+// 64 位终结混合，使多项式和的低位也均匀，mod p 抽样才近似 1/p
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 31;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 29;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 32;
+    return x;
+}
+
+static bool buffer_push(ShingleBuffer *buffer, uint64_t hash) {
+    if (buffer->count >= buffer->capacity) {
+        size_t new_capacity = buffer->capacity ? buffer->capacity * 2 : SHINGLE_INITIAL_CAPACITY;
+        uint64_t *grown = (uint64_t*)sim_memory_realloc(MEM_VECTOR, buffer->hashes,
+                                                        buffer->capacity * sizeof(uint64_t),
+                                                        new_capacity * sizeof(uint64_t));
+        if (!grown) return false;
+        buffer->hashes = grown;
+        buffer->capacity = new_capacity;
+    }
+    buffer->hashes[buffer->count++] = hash;
+    return true;
+}
+
+static void window_emit(ShingleWindow *w) {
+    uint64_t hash = mix64(w->hash);
+    uint64_t mod = w->options->sample_mod;
+    if (!w->emitted || hash < w->min_hash) w->min_hash = hash;
+    w->emitted = true;
+    if (mod > 1 && hash % mod != 0) return;
+    if (!buffer_push(w->out, hash)) w->ok = false;
+}
+
+// 词进入窗口：窗口已满时先减去最旧的词，再整体乘底加上新词
+static void window_push(ShingleWindow *w, uint64_t unit) {
+    size_t width = w->options->width;
+    size_t slot = w->seen % width;
+    if (w->seen >= width) {
+        w->hash -= w->units[slot] * w->top_power;
+    }
+    w->hash = w->hash * SHINGLE_BASE + unit;
+    w->units[slot] = unit;
+    w->seen++;
+    if (w->seen >= width) window_emit(w);
+}
+
+// 单词的哈希：逐字节小写后 FNV-1a，直接读正文，不复制
+static uint64_t word_unit(const char *start, size_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)start[i];
+        if (c >= 'A' && c <= 'Z') c = (unsigned char)(c - 'A' + 'a');
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return mix64(hash);
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// 排序去重，值为出现次数
+static SparseVector* buffer_to_vector(ShingleBuffer *buffer) {
+    // 没有 shingle 时缓冲区未分配，不能传给 qsort
+    if (buffer->count > 0) {
+        qsort(buffer->hashes, buffer->count, sizeof(uint64_t), compare_u64);
+    }
+    size_t distinct = 0;
+    for (size_t i = 0; i < buffer->count; i++) {
+        if (i == 0 || buffer->hashes[i] != buffer->hashes[i - 1]) distinct++;
+    }
+
+    SparseVector *vec = sparse_vector_alloc(distinct);
+    if (!vec) return NULL;
+    vec->size = 0;
+    for (size_t i = 0; i < buffer->count; i++) {
+        if (vec->size > 0 && vec->keys[vec->size - 1] == buffer->hashes[i]) {
+            vec->values[vec->size - 1] += 1.0;
+        } else {
+            vec->keys[vec->size] = buffer->hashes[i];
+            vec->values[vec->size] = 1.0;
+            vec->size++;
+        }
+    }
+    double sum = 0.0;
+    for (size_t i = 0; i < vec->size; i++) {
+        sum += vec->values[i] * vec->values[i];
+    }
+    vec->norm = sqrt(sum);
+    return vec;
+}
+
+SparseVector* shingle_vector(const char *text, const ShingleOptions *options) {
+    if (!text || !options || options->width < 1 || options->width > SHINGLE_MAX_WIDTH) {
+        fprintf(stderr, "错误: shingle 宽度必须在 1 到 %d 之间\n", SHINGLE_MAX_WIDTH);
+        return NULL;
+    }
+
+    ShingleBuffer buffer = {0};
+    ShingleWindow w;
+    memset(&w, 0, sizeof(w));
+    w.options = options;
+    w.out = &buffer;
+    w.ok = true;
+    w.top_power = 1;
+    for (size_t i = 1; i < options->width; i++) w.top_power *= SHINGLE_BASE;
+
+    STATS_TIMER_START(timer);
+    TRACE_BEGIN(span);
+    Token token;
+    while (w.ok && next_token(&text, &token)) {
+        if (token.kind == TOKEN_WORD) {
+            window_push(&w, word_unit(token.start, token.length));
+            continue;
+        }
+        // 中日韩文字每个字是一个词
+        const char *p = token.start;
+        const char *end = token.start + token.length;
+        while (p < end && w.ok) {
+            uint32_t cp;
+            p += utf8_decode(p, &cp);
+            window_push(&w, mix64(cp ^ CJK_UNIT_SEED));
+        }
+    }
+    // 不足一个窗口的短文本整体作为一个 shingle
+    if (w.ok && w.seen > 0 && w.seen < options->width) window_emit(&w);
+    // 短文档可能没有哈希落在 mod p 上，与 winnowing 一样保留最小的一个，免得成为空向量
+    if (w.ok && buffer.count == 0 && w.emitted && !buffer_push(&buffer, w.min_hash)) w.ok = false;
+
+    SparseVector *vec = w.ok ? buffer_to_vector(&buffer) : NULL;
+    sim_memory_free(MEM_VECTOR, buffer.hashes, buffer.capacity * sizeof(uint64_t));
+    TRACE_END(span, "shingle", w.seen);
+    STATS_TIMER_LAP(timer, STAT_PHASE_VECTORIZE);
+    if (vec) STATS_COUNT(STAT_VECTORS, 1);
+    return vec;
+}
+
+bool document_shingle(Document *doc, const ShingleOptions *options) {
+    if (!doc || !doc->content) {
+        fprintf(stderr, "错误: 文档正文已释放，无法生成 shingle: %s\n", doc ? doc->filename : "");
+        return false;
+    }
+    SparseVector *vec = shingle_vector(doc->content, options);
+    if (!vec) return false;
+    sparse_vector_destroy(doc->vector);
+    doc->vector = vec;
+    return true;
+}
@@ -0,0 +1,251 @@
+#include "sim_context.h"
+#include "arena.h"
+#include "matrix_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <dirent.h>
+
+#define SIM_ERROR_MAX 256
+
+struct SimContext {
+    SimConfig config;
+    StopWords *stop_words;
+    DocumentStore *store;       // 私有仓库或共享仓库
+    bool owns_store;
+    Arena *arena;               // 单次调用内的临时数据，调用开始时重置
+    JobControl *job;            // 进度与取消，调用方持有，可为 NULL
+    char error[SIM_ERROR_MAX];
+};
+
+static void set_error(SimContext *ctx, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(ctx->error, sizeof(ctx->error), format, args);
+    va_end(args);
+}
+
+SimConfig sim_config_default(void) {
+    SimConfig config;
+    config.threads = 1;
+    config.store_budget = 0;
+    config.pair_cache_entries = 0;
+    config.shared_store = NULL;
+    config.weighting = WEIGHT_RAW;
+    config.cjk_ngram = 0;
+    return config;
+}
+
+SimContext* sim_context_create(const SimConfig *config) {
+    SimContext *ctx = (SimContext*)calloc(1, sizeof(SimContext));
+    if (!ctx) return NULL;
+
+    ctx->config = config ? *config : sim_config_default();
+    if (ctx->config.threads == 0) {
+        ctx->config.threads = matrix_engine_default_threads();
+    }
+
+    ctx->stop_words = stop_words_create();
+    ctx->arena = arena_create(0);
+    if (!ctx->stop_words || !ctx->arena ||
+        (ctx->config.cjk_ngram > 0 && !stop_words_set_cjk_ngram(ctx->stop_words, ctx->config.cjk_ngram))) {
+        sim_context_destroy(ctx);
+        return NULL;
+    }
+
+    if (ctx->config.shared_store) {
+        ctx->store = ctx->config.shared_store;
+    } else if (ctx->config.store_budget > 0) {
+        ctx->store = doc_store_create(ctx->stop_words, ctx->config.store_budget,
+                                      ctx->config.pair_cache_entries);
+        ctx->owns_store = true;
+        if (!ctx->store) {
+            sim_context_destroy(ctx);
+            return NULL;
+        }
+    }
+
+    return ctx;
+}
+
+void sim_context_destroy(SimContext *ctx) {
+    if (!ctx) return;
+    if (ctx->owns_store) {
+        doc_store_destroy(ctx->store);
+    }
+    stop_words_destroy(ctx->stop_words);
+    arena_destroy(ctx->arena);
+    free(ctx);
+}
+
+bool sim_context_add_stop_word(SimContext *ctx, const char *word) {
+    if (!ctx || !word) return false;
+
+    // 与文件加载一致，统一转为小写
+    size_t len = strlen(word);
+    char *lower = arena_strndup(ctx->arena, word, len);
+    if (!lower || !stop_words_add(ctx->stop_words, str_to_lower(lower))) {
+        set_error(ctx, "无法添加停用词: %s", word);
+        return false;
+    }
+    if (ctx->owns_store) {
+        // 私有仓库中已处理的向量按旧停用词生成，需要丢弃
+        doc_store_clear(ctx->store);
+    }
+    return true;
+}
+
+bool sim_context_load_stop_words(SimContext *ctx, const char *path) {
+    if (!ctx || !path) return false;
+
+    if (!stop_words_load_from_file(ctx->stop_words, path)) {
+        set_error(ctx, "无法打开停用词文件 %s", path);
+        return false;
+    }
+    if (ctx->owns_store) {
+        doc_store_clear(ctx->store);
+    }
+    return true;
+}
+
+void sim_context_set_job(SimContext *ctx, JobControl *job) {
+    if (ctx) ctx->job = job;
+}
+
+// 调用失败时区分取消与其他错误
+static void set_failure(SimContext *ctx, const char *message) {
+    if (job_control_cancelled(ctx->job)) {
+        set_error(ctx, "任务已取消");
+    } else {
+        set_error(ctx, "%s", message);
+    }
+}
+
+// 按配置的线程数计算矩阵；有任务控制时总是经由引擎，以便报告进度
+static SimilarityMatrix* compute_matrix(SimContext *ctx, DocumentCollection *col) {
+    if (col->count == 0) {
+        set_failure(ctx, "没有可处理的文档");
+        return NULL;
+    }
+    if (ctx->config.weighting != WEIGHT_RAW &&
+        !collection_set_weighting(col, ctx->config.weighting)) {
+        set_error(ctx, "无法计算词项权重");
+        return NULL;
+    }
+    SimilarityMatrix *matrix = ctx->config.threads > 1 || ctx->job
+        ? similarity_matrix_create_parallel_job(col, ctx->config.threads, NULL, NULL, ctx->job)
+        : similarity_matrix_create(col);
+    if (!matrix) {
+        set_failure(ctx, "无法分配相似度矩阵");
+    }
+    return matrix;
+}
+
+SimilarityMatrix* sim_context_matrix_from_buffers(SimContext *ctx, const char **names,
+                                                  const char **buffers, const size_t *lengths,
+                                                  size_t count) {
+    if (!ctx) return NULL;
+    if (!names || !buffers || !lengths) {
+        set_error(ctx, "参数无效");
+        return NULL;
+    }
+    sim_context_clear_error(ctx);
+
+    // 仓库缓存的向量与文档对分数只取决于单个文档，加权时不能复用
+    if (ctx->store && ctx->config.weighting == WEIGHT_RAW) {
+        SimilarityMatrix *matrix = doc_store_matrix_job(ctx->store, names, buffers, lengths, count,
+                                                        ctx->job);
+        if (!matrix) set_failure(ctx, "文档仓库计算失败");
+        return matrix;
+    }
+
+    DocumentCollection *col = collection_create(count);
+    if (!col) {
+        set_error(ctx, "无法分配文档集合");
+        return NULL;
+    }
+
+    // 文本只在分词期间需要，复制到内存池中，处理完即与文档解除关联
+    arena_reset(ctx->arena);
+    for (size_t i = 0; i < count; i++) {
+        if (!job_control_report(ctx->job, JOB_STAGE_LOAD, i, count)) {
+            collection_destroy(col);
+            set_failure(ctx, "");
+            return NULL;
+        }
+        if (!buffers[i] || lengths[i] == 0) continue;
+
+        Document *doc = document_create(names[i]);
+        char *content = arena_strndup(ctx->arena, buffers[i], lengths[i]);
+        if (!doc || !content) {
+            document_destroy(doc);
+            collection_destroy(col);
+            set_error(ctx, "内存不足: %s", names[i]);
+            return NULL;
+        }
+
+        doc->content = content;
+        bool processed = document_process(doc, ctx->stop_words);
+        doc->content = NULL;
+        if (!processed || !collection_add_document(col, doc)) {
+            document_destroy(doc);
+            collection_destroy(col);
+            set_error(ctx, "无法处理文档: %s", names[i]);
+            return NULL;
+        }
+        job_control_add_bytes(ctx->job, lengths[i]);
+    }
+    arena_reset(ctx->arena);
+
+    SimilarityMatrix *matrix = compute_matrix(ctx, col);
+    collection_destroy(col);
+    return matrix;
+}
+
+// 静默收集目录中的文档
+static bool collect_quietly(Document *doc, const char *name, void *userdata) {
+    (void)name;
+    return collection_add_document((DocumentCollection*)userdata, doc);
+}
+
+SimilarityMatrix* sim_context_matrix_from_dir(SimContext *ctx, const char *dir_path) {
+    if (!ctx) return NULL;
+    if (!dir_path) {
+        set_error(ctx, "参数无效");
+        return NULL;
+    }
+    sim_context_clear_error(ctx);
+
+    // 先行检查，使错误进入上下文而不是只打印到 stderr
+    DIR *dir = opendir(dir_path);
+    if (!dir) {
+        set_error(ctx, "无法打开目录 %s", dir_path);
+        return NULL;
+    }
+    closedir(dir);
+
+    DocumentCollection *col = collection_create(0);
+    if (!col) {
+        set_error(ctx, "无法分配文档集合");
+        return NULL;
+    }
+    for_each_document_in_dir_job(dir_path, ctx->stop_words, collect_quietly, col, ctx->job);
+    if (job_control_cancelled(ctx->job)) {
+        collection_destroy(col);
+        set_failure(ctx, "");
+        return NULL;
+    }
+
+    SimilarityMatrix *matrix = compute_matrix(ctx, col);
+    collection_destroy(col);
+    return matrix;
+}
+
+const char* sim_context_last_error(const SimContext *ctx) {
+    return ctx ? ctx->error : "";
+}
+
+void sim_context_clear_error(SimContext *ctx) {
+    if (ctx) ctx->error[0] = '\0';
+}
@@ -0,0 +1,126 @@
+#include "sim_memory.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static size_t mem_current[MEM_TAG_COUNT];
+static size_t mem_peak[MEM_TAG_COUNT];
+static size_t mem_total = 0;
+static size_t mem_peak_total = 0;
+static size_t mem_budget = 0;
+static uint64_t mem_rejected = 0;
+static int mem_exceeded = 0;
+
+static const char *tag_names[MEM_TAG_COUNT] = {
+    "hashtable", "document", "vector", "matrix", "pairs", "ui"
+};
+
+// 只在超过已记录的峰值时才写入
+static void raise_peak(size_t *peak, size_t value) {
+    size_t seen = __atomic_load_n(peak, __ATOMIC_RELAXED);
+    while (value > seen &&
+           !__atomic_compare_exchange_n(peak, &seen, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+bool sim_memory_reserve(MemoryTag tag, size_t bytes) {
+    if (tag >= MEM_TAG_COUNT) tag = MEM_UI;
+
+    size_t total = __atomic_add_fetch(&mem_total, bytes, __ATOMIC_RELAXED);
+    size_t budget = __atomic_load_n(&mem_budget, __ATOMIC_RELAXED);
+    if (budget > 0 && total > budget) {
+        __atomic_sub_fetch(&mem_total, bytes, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&mem_rejected, 1, __ATOMIC_RELAXED);
+        // 只报告第一次，之后的失败由调用方按内存不足处理
+        if (__atomic_exchange_n(&mem_exceeded, 1, __ATOMIC_RELAXED) == 0) {
+            fprintf(stderr, "错误: 超出内存预算 %zu MB（%s 申请 %zu 字节时已用 %zu 字节）\n",
+                    budget / (1024 * 1024), tag_names[tag], bytes, total - bytes);
+        }
+        return false;
+    }
+    raise_peak(&mem_peak_total, total);
+    raise_peak(&mem_peak[tag], __atomic_add_fetch(&mem_current[tag], bytes, __ATOMIC_RELAXED));
+    return true;
+}
+
+void sim_memory_release(MemoryTag tag, size_t bytes) {
+    if (tag >= MEM_TAG_COUNT) tag = MEM_UI;
+    __atomic_sub_fetch(&mem_current[tag], bytes, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&mem_total, bytes, __ATOMIC_RELAXED);
+}
+
+void* sim_memory_alloc(MemoryTag tag, size_t bytes) {
+    if (!sim_memory_reserve(tag, bytes)) return NULL;
+    void *ptr = malloc(bytes);
+    if (!ptr) sim_memory_release(tag, bytes);
+    return ptr;
+}
+
+void* sim_memory_calloc(MemoryTag tag, size_t count, size_t size) {
+    if (size > 0 && count > SIZE_MAX / size) return NULL;
+    if (!sim_memory_reserve(tag, count * size)) return NULL;
+    void *ptr = calloc(count, size);
+    if (!ptr) sim_memory_release(tag, count * size);
+    return ptr;
+}
+
+void* sim_memory_realloc(MemoryTag tag, void *ptr, size_t old_bytes, size_t new_bytes) {
+    if (new_bytes > old_bytes) {
+        if (!sim_memory_reserve(tag, new_bytes - old_bytes)) return NULL;
+    }
+    void *grown = realloc(ptr, new_bytes);
+    if (!grown) {
+        if (new_bytes > old_bytes) sim_memory_release(tag, new_bytes - old_bytes);
+        return NULL;
+    }
+    if (new_bytes < old_bytes) sim_memory_release(tag, old_bytes - new_bytes);
+    return grown;
+}
+
+char* sim_memory_strdup(MemoryTag tag, const char *str) {
+    if (!str) return NULL;
+    size_t len = strlen(str) + 1;
+    char *copy = (char*)sim_memory_alloc(tag, len);
+    if (copy) memcpy(copy, str, len);
+    return copy;
+}
+
+void sim_memory_free(MemoryTag tag, void *ptr, size_t bytes) {
+    if (!ptr) return;
+    free(ptr);
+    sim_memory_release(tag, bytes);
+}
+
+void sim_memory_set_budget(size_t bytes) {
+    __atomic_store_n(&mem_budget, bytes, __ATOMIC_RELAXED);
+    __atomic_store_n(&mem_exceeded, 0, __ATOMIC_RELAXED);
+}
+
+bool sim_memory_budget_exceeded(void) {
+    return __atomic_load_n(&mem_exceeded, __ATOMIC_RELAXED) != 0;
+}
+
+void sim_memory_get(MemoryStats *stats) {
+    if (!stats) return;
+    for (int i = 0; i < MEM_TAG_COUNT; i++) {
+        stats->current[i] = __atomic_load_n(&mem_current[i], __ATOMIC_RELAXED);
+        stats->peak[i] = __atomic_load_n(&mem_peak[i], __ATOMIC_RELAXED);
+    }
+    stats->current_total = __atomic_load_n(&mem_total, __ATOMIC_RELAXED);
+    stats->peak_total = __atomic_load_n(&mem_peak_total, __ATOMIC_RELAXED);
+    stats->budget = __atomic_load_n(&mem_budget, __ATOMIC_RELAXED);
+    stats->rejected = __atomic_load_n(&mem_rejected, __ATOMIC_RELAXED);
+}
+
+void sim_memory_reset_peak(void) {
+    for (int i = 0; i < MEM_TAG_COUNT; i++) {
+        __atomic_store_n(&mem_peak[i], __atomic_load_n(&mem_current[i], __ATOMIC_RELAXED),
+                         __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&mem_peak_total, __atomic_load_n(&mem_total, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    __atomic_store_n(&mem_rejected, 0, __ATOMIC_RELAXED);
+}
+
+const char* memory_tag_name(MemoryTag tag) {
+    return tag < MEM_TAG_COUNT ? tag_names[tag] : "unknown";
+}
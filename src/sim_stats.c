@@ -0,0 +1,230 @@
+#include "sim_stats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+// 每个线程一块计数区，只有所属线程写入，读取方用原子加载避免撕裂。
+// 线程退出时计数并入 retired，计数区留给之后的新线程复用，
+// 因此每连接一个线程的服务长期运行时计数区数量也不会增长
+typedef struct StatsBlock {
+    uint64_t phase_ns[STAT_PHASE_COUNT];
+    uint64_t counters[STAT_COUNTER_COUNT];
+    bool in_use;
+    struct StatsBlock *next;
+} StatsBlock;
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t stats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t stats_key;
+static StatsBlock *stats_blocks = NULL;
+static StatsBlock stats_retired;
+// 热路径只读线程局部指针；pthread 键仅用于线程退出时回收
+static __thread StatsBlock *stats_current = NULL;
+
+static const char *phase_names[STAT_PHASE_COUNT] = {
+    "scan", "read", "tokenize", "stop_words", "hash_insert", "vectorize", "score", "output"
+};
+
+static const char *counter_names[STAT_COUNTER_COUNT] = {
+    "files", "bytes_read", "tokens", "stop_words", "hash_inserts", "hash_probes",
+    "hash_resizes", "allocations", "vectors", "pairs", "output_bytes"
+};
+
+static uint64_t load_u64(const uint64_t *p) {
+    return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+
+static void store_u64(uint64_t *p, uint64_t value) {
+    __atomic_store_n(p, value, __ATOMIC_RELAXED);
+}
+
+// 线程退出：并入 retired 并归还计数区
+static void retire_block(void *ptr) {
+    StatsBlock *block = (StatsBlock*)ptr;
+    pthread_mutex_lock(&stats_lock);
+    for (int i = 0; i < STAT_PHASE_COUNT; i++) {
+        stats_retired.phase_ns[i] += load_u64(&block->phase_ns[i]);
+        store_u64(&block->phase_ns[i], 0);
+    }
+    for (int i = 0; i < STAT_COUNTER_COUNT; i++) {
+        stats_retired.counters[i] += load_u64(&block->counters[i]);
+        store_u64(&block->counters[i], 0);
+    }
+    block->in_use = false;
+    pthread_mutex_unlock(&stats_lock);
+    stats_current = NULL;
+}
+
+static void create_key(void) {
+    pthread_key_create(&stats_key, retire_block);
+}
+
+static StatsBlock* thread_block(void) {
+    if (stats_current) return stats_current;
+    pthread_once(&stats_once, create_key);
+
+    StatsBlock *block;
+    pthread_mutex_lock(&stats_lock);
+    for (block = stats_blocks; block && block->in_use; block = block->next) {
+    }
+    if (!block) {
+        block = (StatsBlock*)calloc(1, sizeof(StatsBlock));
+        if (block) {
+            block->next = stats_blocks;
+            stats_blocks = block;
+        }
+    }
+    if (block) block->in_use = true;
+    pthread_mutex_unlock(&stats_lock);
+
+    if (block) pthread_setspecific(stats_key, block);
+    stats_current = block;
+    return block;
+}
+
+uint64_t similarity_stats_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void similarity_stats_add(StatCounter counter, uint64_t n) {
+    StatsBlock *block = thread_block();
+    if (!block || counter >= STAT_COUNTER_COUNT) return;
+    store_u64(&block->counters[counter], load_u64(&block->counters[counter]) + n);
+}
+
+void similarity_stats_add_time(StatPhase phase, uint64_t ns) {
+    StatsBlock *block = thread_block();
+    if (!block || phase >= STAT_PHASE_COUNT) return;
+    store_u64(&block->phase_ns[phase], load_u64(&block->phase_ns[phase]) + ns);
+}
+
+bool similarity_stats_enabled(void) {
+#ifdef SIM_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void similarity_stats_get(SimilarityStats *stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    stats->enabled = similarity_stats_enabled();
+
+    pthread_mutex_lock(&stats_lock);
+    memcpy(stats->phase_ns, stats_retired.phase_ns, sizeof(stats->phase_ns));
+    memcpy(stats->counters, stats_retired.counters, sizeof(stats->counters));
+    for (StatsBlock *block = stats_blocks; block; block = block->next) {
+        for (int i = 0; i < STAT_PHASE_COUNT; i++) {
+            stats->phase_ns[i] += load_u64(&block->phase_ns[i]);
+        }
+        for (int i = 0; i < STAT_COUNTER_COUNT; i++) {
+            stats->counters[i] += load_u64(&block->counters[i]);
+        }
+    }
+    pthread_mutex_unlock(&stats_lock);
+    sim_memory_get(&stats->memory);
+}
+
+void similarity_stats_reset(void) {
+    pthread_mutex_lock(&stats_lock);
+    memset(&stats_retired, 0, sizeof(stats_retired));
+    for (StatsBlock *block = stats_blocks; block; block = block->next) {
+        for (int i = 0; i < STAT_PHASE_COUNT; i++) store_u64(&block->phase_ns[i], 0);
+        for (int i = 0; i < STAT_COUNTER_COUNT; i++) store_u64(&block->counters[i], 0);
+    }
+    pthread_mutex_unlock(&stats_lock);
+    sim_memory_reset_peak();
+}
+
+const char* stat_phase_name(StatPhase phase) {
+    return phase < STAT_PHASE_COUNT ? phase_names[phase] : "unknown";
+}
+
+const char* stat_counter_name(StatCounter counter) {
+    return counter < STAT_COUNTER_COUNT ? counter_names[counter] : "unknown";
+}
+
+// 数量除以阶段耗时得到每秒速率；耗时为 0 时速率为 0
+static double per_second(uint64_t count, uint64_t ns) {
+    return ns > 0 ? (double)count * 1e9 / (double)ns : 0.0;
+}
+
+static void print_memory_json(const MemoryStats *memory, FILE *out) {
+    fprintf(out, "\"memory\": {\"current_bytes\": {");
+    for (int i = 0; i < MEM_TAG_COUNT; i++) {
+        fprintf(out, "%s\"%s\": %zu", i ? ", " : "", memory_tag_name((MemoryTag)i), memory->current[i]);
+    }
+    fprintf(out, "}, \"peak_bytes\": {");
+    for (int i = 0; i < MEM_TAG_COUNT; i++) {
+        fprintf(out, "%s\"%s\": %zu", i ? ", " : "", memory_tag_name((MemoryTag)i), memory->peak[i]);
+    }
+    fprintf(out, "}, \"current_total\": %zu, \"peak_total\": %zu, \"budget\": %zu, \"rejected\": %llu}",
+            memory->current_total, memory->peak_total, memory->budget,
+            (unsigned long long)memory->rejected);
+}
+
+static void print_memory_table(const MemoryStats *memory, FILE *out) {
+    fprintf(out, "  %-14s %12s %12s\n", "内存", "当前(KB)", "峰值(KB)");
+    for (int i = 0; i < MEM_TAG_COUNT; i++) {
+        fprintf(out, "  %-14s %12.1f %12.1f\n", memory_tag_name((MemoryTag)i),
+                memory->current[i] / 1024.0, memory->peak[i] / 1024.0);
+    }
+    fprintf(out, "  %-14s %12.1f %12.1f\n", "total", memory->current_total / 1024.0,
+            memory->peak_total / 1024.0);
+    if (memory->budget > 0) {
+        fprintf(out, "  内存预算 %.1f MB，被拒绝的分配 %llu 次\n", memory->budget / (1024.0 * 1024.0),
+                (unsigned long long)memory->rejected);
+    }
+}
+
+void similarity_stats_print(const SimilarityStats *stats, FILE *out, bool json) {
+    if (!stats || !out) return;
+
+    uint64_t total_ns = 0;
+    for (int i = 0; i < STAT_PHASE_COUNT; i++) total_ns += stats->phase_ns[i];
+    uint64_t text_ns = stats->phase_ns[STAT_PHASE_TOKENIZE] + stats->phase_ns[STAT_PHASE_STOP_WORDS] +
+                       stats->phase_ns[STAT_PHASE_HASH_INSERT];
+    double tokens_per_sec = per_second(stats->counters[STAT_TOKENS], text_ns);
+    double bytes_per_sec = per_second(stats->counters[STAT_BYTES_READ], stats->phase_ns[STAT_PHASE_READ]);
+    double pairs_per_sec = per_second(stats->counters[STAT_PAIRS], stats->phase_ns[STAT_PHASE_SCORE]);
+
+    if (json) {
+        fprintf(out, "{\"enabled\": %s, \"phases_ms\": {", stats->enabled ? "true" : "false");
+        for (int i = 0; i < STAT_PHASE_COUNT; i++) {
+            fprintf(out, "%s\"%s\": %.3f", i ? ", " : "", phase_names[i], stats->phase_ns[i] / 1e6);
+        }
+        fprintf(out, "}, \"counters\": {");
+        for (int i = 0; i < STAT_COUNTER_COUNT; i++) {
+            fprintf(out, "%s\"%s\": %llu", i ? ", " : "", counter_names[i],
+                    (unsigned long long)stats->counters[i]);
+        }
+        fprintf(out, "}, \"rates\": {\"tokens_per_sec\": %.1f, \"bytes_per_sec\": %.1f, "
+                "\"pairs_per_sec\": %.1f}, ", tokens_per_sec, bytes_per_sec, pairs_per_sec);
+        print_memory_json(&stats->memory, out);
+        fprintf(out, "}\n");
+        return;
+    }
+
+    if (!stats->enabled) {
+        fprintf(out, "运行统计未启用：请使用 make stats（-DSIM_STATS）重新编译\n");
+        print_memory_table(&stats->memory, out);
+        return;
+    }
+    fprintf(out, "\n运行统计（多线程阶段为各线程耗时之和）:\n");
+    fprintf(out, "  %-14s %12s %7s\n", "阶段", "耗时(ms)", "占比");
+    for (int i = 0; i < STAT_PHASE_COUNT; i++) {
+        fprintf(out, "  %-14s %12.3f %6.1f%%\n", phase_names[i], stats->phase_ns[i] / 1e6,
+                total_ns ? stats->phase_ns[i] * 100.0 / total_ns : 0.0);
+    }
+    fprintf(out, "  %-14s %12s\n", "计数器", "数值");
+    for (int i = 0; i < STAT_COUNTER_COUNT; i++) {
+        fprintf(out, "  %-14s %12llu\n", counter_names[i], (unsigned long long)stats->counters[i]);
+    }
+    fprintf(out, "  词/秒 %.0f，字节/秒 %.0f，文档对/秒 %.0f\n",
+            tokens_per_sec, bytes_per_sec, pairs_per_sec);
+    print_memory_table(&stats->memory, out);
+}
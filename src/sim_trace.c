@@ -0,0 +1,167 @@
+#include "sim_trace.h"
+#include "sim_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+typedef struct TraceEvent {
+    const char *name;
+    uint64_t begin;
+    uint64_t end;
+    uint64_t arg;
+} TraceEvent;
+
+// 单写者环形缓冲区：只有所属线程写入事件并推进 head
+typedef struct TraceRing {
+    TraceEvent *events;
+    size_t capacity;
+    uint64_t head;              // 累计写入的事件数
+    unsigned tid;
+    bool in_use;
+    struct TraceRing *next;
+} TraceRing;
+
+static int trace_on = 0;
+static uint64_t trace_origin = 0;
+static size_t trace_capacity = SIM_TRACE_DEFAULT_EVENTS;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+static pthread_key_t trace_key;
+static TraceRing *trace_rings = NULL;
+static unsigned trace_next_tid = 1;
+static __thread TraceRing *trace_current = NULL;
+
+// 线程退出：事件保留到导出，缓冲区交给之后的新线程
+static void release_ring(void *ptr) {
+    TraceRing *ring = (TraceRing*)ptr;
+    pthread_mutex_lock(&trace_lock);
+    ring->in_use = false;
+    pthread_mutex_unlock(&trace_lock);
+    trace_current = NULL;
+}
+
+static void create_key(void) {
+    pthread_key_create(&trace_key, release_ring);
+}
+
+static TraceRing* thread_ring(void) {
+    if (trace_current) return trace_current;
+    pthread_once(&trace_once, create_key);
+
+    TraceRing *ring;
+    pthread_mutex_lock(&trace_lock);
+    for (ring = trace_rings; ring && ring->in_use; ring = ring->next) {
+    }
+    if (!ring) {
+        ring = (TraceRing*)calloc(1, sizeof(TraceRing));
+        if (ring) {
+            ring->events = (TraceEvent*)malloc(trace_capacity * sizeof(TraceEvent));
+            if (!ring->events) {
+                free(ring);
+                ring = NULL;
+            }
+        }
+        if (ring) {
+            ring->capacity = trace_capacity;
+            ring->tid = trace_next_tid++;
+            ring->next = trace_rings;
+            trace_rings = ring;
+        }
+    }
+    if (ring) ring->in_use = true;
+    pthread_mutex_unlock(&trace_lock);
+
+    if (ring) pthread_setspecific(trace_key, ring);
+    trace_current = ring;
+    return ring;
+}
+
+void sim_trace_start(size_t events_per_thread) {
+    pthread_mutex_lock(&trace_lock);
+    trace_capacity = events_per_thread > 0 ? events_per_thread : SIM_TRACE_DEFAULT_EVENTS;
+    for (TraceRing *ring = trace_rings; ring; ring = ring->next) {
+        __atomic_store_n(&ring->head, 0, __ATOMIC_RELAXED);
+    }
+    trace_origin = similarity_stats_now();
+    pthread_mutex_unlock(&trace_lock);
+    __atomic_store_n(&trace_on, 1, __ATOMIC_RELEASE);
+}
+
+bool sim_trace_enabled(void) {
+    return __atomic_load_n(&trace_on, __ATOMIC_ACQUIRE) != 0;
+}
+
+uint64_t sim_trace_begin(void) {
+    return sim_trace_enabled() ? similarity_stats_now() : 0;
+}
+
+void sim_trace_end(const char *name, uint64_t begin, uint64_t arg) {
+    if (!begin || !sim_trace_enabled()) return;
+    TraceRing *ring = thread_ring();
+    if (!ring) return;
+
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    TraceEvent *event = &ring->events[head % ring->capacity];
+    event->name = name;
+    event->begin = begin;
+    event->end = similarity_stats_now();
+    event->arg = arg;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+size_t sim_trace_event_count(void) {
+    size_t count = 0;
+    pthread_mutex_lock(&trace_lock);
+    for (TraceRing *ring = trace_rings; ring; ring = ring->next) {
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        count += head < ring->capacity ? (size_t)head : ring->capacity;
+    }
+    pthread_mutex_unlock(&trace_lock);
+    return count;
+}
+
+// 纳秒转为相对起点的微秒
+static double trace_us(uint64_t ns) {
+    return ns > trace_origin ? (double)(ns - trace_origin) / 1000.0 : 0.0;
+}
+
+bool sim_trace_stop(const char *path) {
+    __atomic_store_n(&trace_on, 0, __ATOMIC_RELEASE);
+    if (!path) return true;
+
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "错误: 无法写入追踪文件 %s\n", path);
+        return false;
+    }
+
+    pthread_mutex_lock(&trace_lock);
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first = true;
+    for (TraceRing *ring = trace_rings; ring; ring = ring->next) {
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        if (head == 0) continue;
+
+        fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, "
+                "\"args\": {\"name\": \"thread %u\"}}", first ? "" : ",\n", ring->tid, ring->tid);
+        first = false;
+
+        // 缓冲区写满后只保留最近 capacity 个事件
+        uint64_t start = head > ring->capacity ? head - ring->capacity : 0;
+        for (uint64_t i = start; i < head; i++) {
+            const TraceEvent *event = &ring->events[i % ring->capacity];
+            fprintf(file, ",\n{\"name\": \"%s\", \"cat\": \"similarity\", \"ph\": \"X\", \"pid\": 1, "
+                    "\"tid\": %u, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"n\": %llu}}",
+                    event->name, ring->tid, trace_us(event->begin),
+                    (double)(event->end - event->begin) / 1000.0, (unsigned long long)event->arg);
+        }
+    }
+    fprintf(file, "\n]}\n");
+    pthread_mutex_unlock(&trace_lock);
+
+    if (fclose(file) != 0) {
+        fprintf(stderr, "错误: 写入追踪文件失败 %s\n", path);
+        return false;
+    }
+    return true;
+}
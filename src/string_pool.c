@@ -0,0 +1,163 @@
+#include "string_pool.h"
+#include "arena.h"
+#include "sim_memory.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define POOL_FIRST_BLOCK 4096
+#define POOL_MAX_BLOCK (64 * 1024)
+#define POOL_INITIAL_SLOTS 64
+#define POOL_CHUNK 4096
+
+// slots 为开放寻址的索引，保存 编号 + 1（0 表示空槽），负载不超过一半。
+// 字符串首尾相接地存放在从内存池取出的块中，不做对齐填充
+struct StringPool {
+    Arena *arena;
+    char *chunk;
+    size_t chunk_left;
+    const char **strings;
+    uint32_t *slots;
+    size_t count;
+    size_t capacity;
+    size_t slot_count;
+};
+
+// FNV-1a
+static uint32_t pool_hash(const char *str) {
+    uint32_t hash = 2166136261u;
+    while (*str) {
+        hash ^= (unsigned char)*str++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+StringPool* string_pool_create(void) {
+    StringPool *pool = (StringPool*)sim_memory_calloc(MEM_DOCUMENT, 1, sizeof(StringPool));
+    if (!pool) return NULL;
+
+    pool->arena = arena_create_growing(POOL_FIRST_BLOCK, POOL_MAX_BLOCK, MEM_DOCUMENT);
+    pool->slot_count = POOL_INITIAL_SLOTS;
+    pool->slots = (uint32_t*)sim_memory_calloc(MEM_DOCUMENT, pool->slot_count, sizeof(uint32_t));
+    if (!pool->arena || !pool->slots) {
+        string_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void string_pool_destroy(StringPool *pool) {
+    if (!pool) return;
+    arena_destroy(pool->arena);
+    sim_memory_free(MEM_DOCUMENT, pool->strings, pool->capacity * sizeof(char*));
+    sim_memory_free(MEM_DOCUMENT, pool->slots, pool->slot_count * sizeof(uint32_t));
+    sim_memory_free(MEM_DOCUMENT, pool, sizeof(StringPool));
+}
+
+// 返回字符串所在的槽，或应插入的空槽
+static size_t pool_probe(const StringPool *pool, const char *str, uint32_t hash) {
+    size_t mask = pool->slot_count - 1;
+    size_t slot = hash & mask;
+    while (pool->slots[slot] != 0 &&
+           strcmp(pool->strings[pool->slots[slot] - 1], str) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static bool pool_grow_slots(StringPool *pool) {
+    size_t new_count = pool->slot_count * 2;
+    uint32_t *new_slots = (uint32_t*)sim_memory_calloc(MEM_DOCUMENT, new_count, sizeof(uint32_t));
+    if (!new_slots) return false;
+
+    uint32_t *old_slots = pool->slots;
+    size_t old_count = pool->slot_count;
+    pool->slots = new_slots;
+    pool->slot_count = new_count;
+    for (size_t i = 0; i < old_count; i++) {
+        if (old_slots[i] == 0) continue;
+        size_t slot = pool_hash(pool->strings[old_slots[i] - 1]) & (new_count - 1);
+        while (new_slots[slot] != 0) slot = (slot + 1) & (new_count - 1);
+        new_slots[slot] = old_slots[i];
+    }
+    sim_memory_free(MEM_DOCUMENT, old_slots, old_count * sizeof(uint32_t));
+    return true;
+}
+
+// 较长的字符串单独分配，其余追加到当前块
+static char* pool_copy(StringPool *pool, const char *str) {
+    size_t len = strlen(str) + 1;
+    if (len > POOL_CHUNK / 4) {
+        return arena_strndup(pool->arena, str, len - 1);
+    }
+    if (len > pool->chunk_left) {
+        pool->chunk = (char*)arena_alloc(pool->arena, POOL_CHUNK);
+        if (!pool->chunk) {
+            pool->chunk_left = 0;
+            return NULL;
+        }
+        pool->chunk_left = POOL_CHUNK;
+    }
+    char *copy = pool->chunk;
+    memcpy(copy, str, len);
+    pool->chunk += len;
+    pool->chunk_left -= len;
+    return copy;
+}
+
+uint32_t string_pool_intern(StringPool *pool, const char *str) {
+    if (!pool || !str) return STRING_POOL_INVALID;
+
+    uint32_t hash = pool_hash(str);
+    size_t slot = pool_probe(pool, str, hash);
+    if (pool->slots[slot] != 0) return pool->slots[slot] - 1;
+
+    if (pool->count >= STRING_POOL_INVALID - 1) return STRING_POOL_INVALID;
+    if (pool->count >= pool->capacity) {
+        size_t new_capacity = pool->capacity ? pool->capacity * 2 : POOL_INITIAL_SLOTS;
+        const char **new_strings = (const char**)sim_memory_realloc(MEM_DOCUMENT, (void*)pool->strings,
+                                                                   pool->capacity * sizeof(char*),
+                                                                   new_capacity * sizeof(char*));
+        if (!new_strings) return STRING_POOL_INVALID;
+        pool->strings = new_strings;
+        pool->capacity = new_capacity;
+    }
+
+    char *copy = pool_copy(pool, str);
+    if (!copy) return STRING_POOL_INVALID;
+
+    uint32_t id = (uint32_t)pool->count;
+    pool->strings[pool->count++] = copy;
+    pool->slots[slot] = id + 1;
+
+    if (pool->count * 2 > pool->slot_count && !pool_grow_slots(pool)) {
+        // 索引扩容失败时撤销插入，保持负载上限
+        pool->slots[pool_probe(pool, str, hash)] = 0;
+        pool->count--;
+        return STRING_POOL_INVALID;
+    }
+    return id;
+}
+
+bool string_pool_find(const StringPool *pool, const char *str, uint32_t *id) {
+    if (!pool || !str) return false;
+    size_t slot = pool_probe(pool, str, pool_hash(str));
+    if (pool->slots[slot] == 0) return false;
+    if (id) *id = pool->slots[slot] - 1;
+    return true;
+}
+
+const char* string_pool_get(const StringPool *pool, uint32_t id) {
+    if (!pool || id >= pool->count) return NULL;
+    return pool->strings[id];
+}
+
+size_t string_pool_count(const StringPool *pool) {
+    return pool ? pool->count : 0;
+}
+
+size_t string_pool_bytes(const StringPool *pool) {
+    if (!pool) return 0;
+    return sizeof(StringPool) + arena_bytes_used(pool->arena) +
+           pool->capacity * sizeof(char*) + pool->slot_count * sizeof(uint32_t);
+}
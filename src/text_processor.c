@@ -1,7 +1,12 @@
 #include "text_processor.h"
+#include "vector_math.h"
+#include "sim_stats.h"
+#include "sim_trace.h"
+#include "sim_memory.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <ctype.h>
 
 // 常见停用词
@@ -21,7 +26,7 @@ static const char *default_stop_words[] = {
 
 // 创建文档
 Document* document_create(const char *filename) {
-    Document *doc = (Document*)malloc(sizeof(Document));
+    Document *doc = (Document*)sim_memory_alloc(MEM_DOCUMENT, sizeof(Document));
     if (!doc) return NULL;
     
     if (filename) {
@@ -31,9 +36,15 @@ Document* document_create(const char *filename) {
         doc->filename[0] = '\0';
     }
     
-    doc->word_freq = hash_table_create(101);
+    doc->word_freq = hash_table_create_pooled(101);
     doc->content = NULL;
+    doc->content_size = 0;
     doc->word_count = 0;
+    doc->vector = NULL;
+    if (!doc->word_freq) {
+        sim_memory_free(MEM_DOCUMENT, doc, sizeof(Document));
+        return NULL;
+    }
     
     return doc;
 }
@@ -46,17 +57,17 @@ void document_destroy(Document *doc) {
         hash_table_destroy(doc->word_freq);
     }
     
-    if (doc->content) {
-        free(doc->content);
-    }
-    
-    free(doc);
+    document_release_content(doc);
+    sparse_vector_destroy(doc->vector);
+    sim_memory_free(MEM_DOCUMENT, doc, sizeof(Document));
 }
 
 // 从文件加载文档
 bool document_load_from_file(Document *doc, const char *filename) {
     if (!doc || !filename) return false;
     
+    STATS_TIMER_START(timer);
+    TRACE_BEGIN(span);
     FILE *file = fopen(filename, "rb");
     if (!file) {
         fprintf(stderr, "错误: 无法打开文件 %s\n", filename);
@@ -91,7 +102,7 @@ bool document_load_from_file(Document *doc, const char *filename) {
     }
     
     // 分配内存
-    char *content = (char*)malloc(file_size + 1);
+    char *content = (char*)sim_memory_alloc(MEM_DOCUMENT, file_size + 1);
     if (!content) {
         fprintf(stderr, "错误: 无法分配内存用于文件内容\n");
         fclose(file);
@@ -102,48 +113,289 @@ bool document_load_from_file(Document *doc, const char *filename) {
     size_t bytes_read = fread(content, 1, file_size, file);
     content[bytes_read] = '\0';
     fclose(file);
+    STATS_TIMER_LAP(timer, STAT_PHASE_READ);
+    STATS_COUNT(STAT_FILES, 1);
+    STATS_COUNT(STAT_BYTES_READ, bytes_read);
+    TRACE_END(span, "file_load", bytes_read);
     
     if (bytes_read != (size_t)file_size) {
         fprintf(stderr, "警告: 读取的字节数与文件大小不匹配\n");
     }
     
-    if (doc->content) {
-        free(doc->content);
+    document_release_content(doc);
+    doc->content = content;
+    doc->content_size = (size_t)file_size + 1;
+    strncpy(doc->filename, filename, sizeof(doc->filename) - 1);
+    
+    return true;
+}
+
+// 从内存缓冲区加载文档内容（复制一份，调用方保留缓冲区所有权）
+bool document_load_from_buffer(Document *doc, const char *data, size_t len) {
+    if (!doc || !data) return false;
+    
+    if (len == 0) {
+        fprintf(stderr, "警告: 文档为空: %s\n", doc->filename);
+        return false;
+    }
+    
+    // 与文件加载相同的大小限制（100MB）
+    const size_t MAX_BUFFER_SIZE = 100UL * 1024 * 1024;
+    if (len > MAX_BUFFER_SIZE) {
+        fprintf(stderr, "错误: 文档太大 (%zu bytes)，超过限制 (%zu bytes)\n", 
+                len, MAX_BUFFER_SIZE);
+        return false;
     }
     
+    char *content = (char*)sim_memory_alloc(MEM_DOCUMENT, len + 1);
+    if (!content) {
+        fprintf(stderr, "错误: 无法分配内存用于文件内容\n");
+        return false;
+    }
+    memcpy(content, data, len);
+    content[len] = '\0';
+    
+    document_release_content(doc);
     doc->content = content;
-    strncpy(doc->filename, filename, sizeof(doc->filename) - 1);
+    doc->content_size = len + 1;
+    return true;
+}
+
+// 释放正文；处理完成后正文不再需要，可先行释放以降低内存占用
+void document_release_content(Document *doc) {
+    if (!doc || !doc->content) return;
+    sim_memory_free(MEM_DOCUMENT, doc->content, doc->content_size);
+    doc->content = NULL;
+    doc->content_size = 0;
+}
+
+// 用内存中的文本创建文档（尚未处理）
+Document* document_create_from_buffer(const char *name, const char *data, size_t len) {
+    Document *doc = document_create(name);
+    if (!doc) return NULL;
     
+    if (!document_load_from_buffer(doc, data, len)) {
+        document_destroy(doc);
+        return NULL;
+    }
+    
+    return doc;
+}
+
+#define WORD_BUFFER 256
+#define NGRAM_INITIAL_SLOTS 64
+#define CJK_BITS 21
+
+// 中日韩片段计数表：开放寻址，键为打包的码点（码点非零，0 表示空槽），负载不超过一半
+typedef struct NgramCounter {
+    uint64_t *keys;
+    uint32_t *counts;
+    size_t capacity;
+    size_t size;
+    int shift;                  // 64 - log2(capacity)
+} NgramCounter;
+
+static void ngram_counter_free(NgramCounter *counter) {
+    sim_memory_free(MEM_HASHTABLE, counter->keys, counter->capacity * sizeof(uint64_t));
+    sim_memory_free(MEM_HASHTABLE, counter->counts, counter->capacity * sizeof(uint32_t));
+    counter->keys = NULL;
+    counter->counts = NULL;
+    counter->capacity = 0;
+    counter->size = 0;
+}
+
+static size_t ngram_slot(const NgramCounter *counter, uint64_t key) {
+    size_t mask = counter->capacity - 1;
+    size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> counter->shift);
+    while (counter->keys[slot] != 0 && counter->keys[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static bool ngram_counter_grow(NgramCounter *counter) {
+    NgramCounter grown;
+    grown.capacity = counter->capacity ? counter->capacity * 2 : NGRAM_INITIAL_SLOTS;
+    grown.size = counter->size;
+    grown.shift = 64;
+    for (size_t c = grown.capacity; c > 1; c >>= 1) grown.shift--;
+    grown.keys = (uint64_t*)sim_memory_calloc(MEM_HASHTABLE, grown.capacity, sizeof(uint64_t));
+    grown.counts = (uint32_t*)sim_memory_calloc(MEM_HASHTABLE, grown.capacity, sizeof(uint32_t));
+    if (!grown.keys || !grown.counts) {
+        ngram_counter_free(&grown);
+        return false;
+    }
+    for (size_t i = 0; i < counter->capacity; i++) {
+        if (counter->keys[i] == 0) continue;
+        size_t slot = ngram_slot(&grown, counter->keys[i]);
+        grown.keys[slot] = counter->keys[i];
+        grown.counts[slot] = counter->counts[i];
+    }
+    ngram_counter_free(counter);
+    *counter = grown;
+    return true;
+}
+
+static bool ngram_counter_add(NgramCounter *counter, uint64_t key) {
+    if ((counter->size + 1) * 2 > counter->capacity && !ngram_counter_grow(counter)) {
+        return false;
+    }
+    size_t slot = ngram_slot(counter, key);
+    if (counter->keys[slot] == 0) {
+        counter->keys[slot] = key;
+        counter->size++;
+    }
+    counter->counts[slot]++;
     return true;
 }
 
+// 把一段中日韩文字切成重叠的 n 字片段计数；返回片段数，内存不足返回 0
+static size_t count_cjk_ngrams(NgramCounter *counter, const Token *token, size_t n) {
+    uint64_t mask = (n * CJK_BITS >= 64) ? UINT64_MAX : ((uint64_t)1 << (n * CJK_BITS)) - 1;
+    uint64_t key = 0;
+    size_t chars = 0;
+    size_t grams = 0;
+    const char *p = token->start;
+    const char *end = token->start + token->length;
+    while (p < end) {
+        uint32_t cp;
+        p += utf8_decode(p, &cp);
+        key = ((key << CJK_BITS) | cp) & mask;
+        if (++chars >= n) {
+            if (!ngram_counter_add(counter, key)) return 0;
+            grams++;
+        }
+    }
+    // 比 n 短的整段作为一个片段
+    if (chars < n) {
+        if (!ngram_counter_add(counter, key)) return 0;
+        grams++;
+    }
+    return grams;
+}
+
+static size_t utf8_encode(uint32_t cp, char *out) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    } else if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    } else if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// 把打包的码点还原为 UTF-8 字符串
+static void ngram_to_utf8(uint64_t key, char *out) {
+    uint32_t cps[CJK_NGRAM_MAX];
+    size_t n = 0;
+    for (; key != 0 && n < CJK_NGRAM_MAX; key >>= CJK_BITS) {
+        cps[n++] = (uint32_t)(key & ((1u << CJK_BITS) - 1));
+    }
+    while (n > 0) {
+        out += utf8_encode(cps[--n], out);
+    }
+    *out = '\0';
+}
+
+// 每个不同的片段写入词频表一次
+static void flush_cjk_ngrams(Document *doc, const NgramCounter *counter, StopWords *stop_words) {
+    char gram[CJK_NGRAM_MAX * 4 + 1];
+    for (size_t i = 0; i < counter->capacity; i++) {
+        if (counter->keys[i] == 0) continue;
+        ngram_to_utf8(counter->keys[i], gram);
+        if (stop_words && is_stop_word(stop_words, gram)) {
+            STATS_COUNT(STAT_STOP_WORDS, counter->counts[i]);
+            continue;
+        }
+        hash_table_insert(doc->word_freq, gram, (int)counter->counts[i]);
+        doc->word_count += counter->counts[i];
+    }
+}
+
 // 处理文档内容
 bool document_process(Document *doc, StopWords *stop_words) {
     if (!doc || !doc->content) return false;
     
-    char *text = doc->content;
-    char *word;
+    const char *text = doc->content;
+    Token token;
+    char buffer[WORD_BUFFER];
+    NgramCounter grams = {0};
+    size_t ngram = stop_words_cjk_ngram(stop_words);
+    bool ok = true;
     
     doc->word_count = 0;
     
-    while ((word = get_next_word(&text)) != NULL) {
+    // 词频即将变化，丢弃缓存向量
+    sparse_vector_destroy(doc->vector);
+    doc->vector = NULL;
+    
+    // 统计构建中整篇文档只计时一次：逐词取时的开销与被测的工作相当，
+    // 分词、停用词过滤与词频插入一并计入 tokenize，词数等计数仍逐词累加
+    STATS_TIMER_START(timer);
+    TRACE_BEGIN(span);
+    while (next_token(&text, &token)) {
+        if (token.kind == TOKEN_CJK) {
+            size_t counted = count_cjk_ngrams(&grams, &token, ngram);
+            if (counted == 0) {
+                ok = false;
+                break;
+            }
+            STATS_COUNT(STAT_TOKENS, counted);
+            continue;
+        }
+        
+        // 常见长度的单词复制到栈上，过长的才分配
+        char *word = buffer;
+        if (token.length >= sizeof(buffer)) {
+            word = (char*)malloc(token.length + 1);
+            if (!word) {
+                ok = false;
+                break;
+            }
+            STATS_COUNT(STAT_ALLOCATIONS, 1);
+        }
+        memcpy(word, token.start, token.length);
+        word[token.length] = '\0';
+        
         // 转换为小写
         str_to_lower(word);
+        STATS_COUNT(STAT_TOKENS, 1);
         
         // 检查是否是停用词
         if (stop_words && is_stop_word(stop_words, word)) {
-            free(word);
-            continue;
+            STATS_COUNT(STAT_STOP_WORDS, 1);
+        } else {
+            // 插入到哈希表
+            hash_table_insert(doc->word_freq, word, 1);
+            doc->word_count++;
         }
         
-        // 插入到哈希表
-        hash_table_insert(doc->word_freq, word, 1);
-        doc->word_count++;
-        
-        free(word);
+        if (word != buffer) free(word);
     }
+    STATS_TIMER_LAP(timer, STAT_PHASE_TOKENIZE);
     
-    return true;
+    if (ok && grams.size > 0) {
+        flush_cjk_ngrams(doc, &grams, stop_words);
+        STATS_TIMER_LAP(timer, STAT_PHASE_HASH_INSERT);
+    }
+    ngram_counter_free(&grams);
+    TRACE_END(span, "tokenize", doc->word_count);
+    
+    if (!ok) {
+        fprintf(stderr, "错误: 无法分配内存用于分词: %s\n", doc->filename);
+    }
+    return ok;
 }
 
 // 打印文档统计信息
@@ -156,15 +408,16 @@ void document_print_stats(Document *doc) {
 
 // 创建停用词表
 StopWords* stop_words_create() {
-    StopWords *sw = (StopWords*)malloc(sizeof(StopWords));
+    StopWords *sw = (StopWords*)sim_memory_alloc(MEM_DOCUMENT, sizeof(StopWords));
     if (!sw) return NULL;
     
     sw->capacity = 100;
     sw->size = 0;
-    sw->words = (char**)malloc(sw->capacity * sizeof(char*));
+    sw->cjk_ngram = CJK_NGRAM_DEFAULT;
+    sw->words = (char**)sim_memory_alloc(MEM_DOCUMENT, sw->capacity * sizeof(char*));
     
     if (!sw->words) {
-        free(sw);
+        sim_memory_free(MEM_DOCUMENT, sw, sizeof(StopWords));
         return NULL;
     }
     
@@ -177,6 +430,20 @@ StopWords* stop_words_create() {
     return sw;
 }
 
+bool stop_words_set_cjk_ngram(StopWords *sw, size_t n) {
+    if (!sw) return false;
+    if (n < 1 || n > CJK_NGRAM_MAX) {
+        fprintf(stderr, "错误: 中文切分长度必须在 1 到 %d 之间\n", CJK_NGRAM_MAX);
+        return false;
+    }
+    sw->cjk_ngram = n;
+    return true;
+}
+
+size_t stop_words_cjk_ngram(const StopWords *sw) {
+    return sw ? sw->cjk_ngram : CJK_NGRAM_DEFAULT;
+}
+
 // 从文件加载停用词
 bool stop_words_load_from_file(StopWords *sw, const char *filename) {
     FILE *file = fopen(filename, "r");
@@ -210,7 +477,8 @@ bool stop_words_add(StopWords *sw, const char *word) {
         }
         
         size_t new_capacity = sw->capacity * 2;
-        char **new_words = realloc(sw->words, new_capacity * sizeof(char*));
+        char **new_words = sim_memory_realloc(MEM_DOCUMENT, sw->words, sw->capacity * sizeof(char*),
+                                              new_capacity * sizeof(char*));
         if (!new_words) {
             fprintf(stderr, "错误: 无法扩容停用词表\n");
             return false;
@@ -219,7 +487,7 @@ bool stop_words_add(StopWords *sw, const char *word) {
         sw->capacity = new_capacity;
     }
     
-    sw->words[sw->size] = strdup(word);
+    sw->words[sw->size] = sim_memory_strdup(MEM_DOCUMENT, word);
     if (!sw->words[sw->size]) {
         fprintf(stderr, "错误: 无法复制停用词\n");
         return false;
@@ -247,61 +515,156 @@ void stop_words_destroy(StopWords *sw) {
     if (!sw) return;
     
     for (size_t i = 0; i < sw->size; i++) {
-        free(sw->words[i]);
+        sim_memory_free(MEM_DOCUMENT, sw->words[i], strlen(sw->words[i]) + 1);
     }
     
-    free(sw->words);
-    free(sw);
+    sim_memory_free(MEM_DOCUMENT, sw->words, sw->capacity * sizeof(char*));
+    sim_memory_free(MEM_DOCUMENT, sw, sizeof(StopWords));
 }
 
-// 转换为小写
+// 转换为小写（只转换 ASCII 字母，多字节字符的字节保持不变）
 char* str_to_lower(char *str) {
     if (!str) return str;
     
     for (char *p = str; *p; p++) {
-        *p = tolower(*p);
+        *p = tolower((unsigned char)*p);
     }
     
     return str;
 }
 
-// 检查字符是否是单词字符
+// 检查字节是否可能属于单词：英文字母、撇号，以及多字节字符的字节。
+// 分词本身按解码后的码点由 char_class 判断
 bool is_word_char(char c) {
-    // 允许英文字母、撇号，以及非ASCII字符（通常是UTF-8多字节字符的一部分）
-    // 注意：这只是一个简单的启发式方法，对于中文分词并不完美，
-    // 但至少可以保留中文字符而不是将其全部丢弃。
     return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '\'' || (unsigned char)c >= 0x80;
 }
 
-// 获取下一个单词
-char* get_next_word(char **text_ptr) {
-    if (!text_ptr || !*text_ptr) return NULL;
+// UTF-8 解码状态机（Bjoern Hoehrmann）：前 256 项把字节映射到字节类别，
+// 其后是以 状态 * 12 + 类别 为下标的转移表；状态 0 为接受，12 为拒绝
+#define UTF8_ACCEPT 0
+#define UTF8_REJECT 12
+
+static const uint8_t utf8_dfa[] = {
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+    7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,
+    8,8,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
+    10,3,3,3,3,3,3,3,3,3,3,3,3,4,3,3,11,6,6,6,5,8,8,8,8,8,8,8,8,8,8,8,
+    0,12,24,36,60,96,84,12,12,12,48,72, 12,12,12,12,12,12,12,12,12,12,12,12,
+    12,0,12,12,12,12,12,0,12,0,12,12, 12,24,12,12,12,12,12,24,12,24,12,12,
+    12,12,12,12,12,12,12,24,12,12,12,12, 12,24,12,12,12,12,12,12,12,24,12,12,
+    12,12,12,12,12,12,12,36,12,36,12,12, 12,36,12,12,12,12,12,36,12,36,12,12,
+    12,36,12,12,12,12,12,12,12,12,12,12
+};
+
+size_t utf8_decode(const char *s, uint32_t *cp) {
+    const unsigned char *p = (const unsigned char*)s;
+    if (*p < 0x80) {
+        *cp = *p;
+        return *p ? 1 : 0;
+    }
     
-    char *start = *text_ptr;
+    uint32_t state = UTF8_ACCEPT;
+    uint32_t code = 0;
+    size_t i = 0;
+    do {
+        uint32_t type = utf8_dfa[p[i]];
+        code = state != UTF8_ACCEPT ? (p[i] & 0x3Fu) | (code << 6) : (0xFFu >> type) & p[i];
+        state = utf8_dfa[256 + state + type];
+        i++;
+    } while (state != UTF8_ACCEPT && state != UTF8_REJECT);
+    
+    if (state == UTF8_REJECT) {
+        *cp = UTF8_INVALID;
+        return 1;
+    }
+    *cp = code;
+    return i;
+}
+
+CharClass char_class(uint32_t cp) {
+    if (cp < 0x80) {
+        return ((cp | 0x20) >= 'a' && (cp | 0x20) <= 'z') || cp == '\'' ? CHAR_WORD : CHAR_SEPARATOR;
+    }
+    if (cp == UTF8_INVALID) return CHAR_SEPARATOR;
+    
+    // 中日韩：谚文字母、部首、假名、注音、统一汉字及扩展、谚文音节、兼容汉字、半角片假名
+    if ((cp >= 0x1100 && cp <= 0x11FF) || (cp >= 0x2E80 && cp <= 0x2FDF) ||
+        (cp >= 0x3040 && cp <= 0x31FF) || (cp >= 0x3400 && cp <= 0x4DBF) ||
+        (cp >= 0x4E00 && cp <= 0x9FFF) || (cp >= 0xA960 && cp <= 0xA97F) ||
+        (cp >= 0xAC00 && cp <= 0xD7AF) || (cp >= 0xF900 && cp <= 0xFAFF) ||
+        (cp >= 0xFF66 && cp <= 0xFFDC) || (cp >= 0x20000 && cp <= 0x3FFFF)) {
+        return CHAR_CJK;
+    }
     
-    // 跳过非单词字符
-    while (*start && !is_word_char(*start)) {
-        start++;
+    // 拉丁补充中的符号、通用标点与各类符号、中日韩标点、竖排与小型标点、
+    // 字节序标记、全角标点、特殊字符、表情符号
+    if (cp <= 0xBF || cp == 0xD7 || cp == 0xF7 ||
+        (cp >= 0x2000 && cp <= 0x2BFF) || (cp >= 0x3000 && cp <= 0x303F) ||
+        (cp >= 0xFE10 && cp <= 0xFE6F) || cp == 0xFEFF ||
+        (cp >= 0xFF00 && cp <= 0xFF65) || (cp >= 0xFFF0 && cp <= 0xFFFF) ||
+        (cp >= 0x1F000 && cp <= 0x1FAFF)) {
+        return CHAR_SEPARATOR;
     }
     
-    if (!*start) {
-        *text_ptr = start;
-        return NULL;
+    return CHAR_WORD;
+}
+
+bool next_token(const char **text_ptr, Token *token) {
+    if (!text_ptr || !*text_ptr || !token) return false;
+    
+    const char *p = *text_ptr;
+    uint32_t cp;
+    size_t len;
+    CharClass kind;
+    
+    // 跳过分隔字符
+    for (;;) {
+        len = utf8_decode(p, &cp);
+        if (len == 0) {
+            *text_ptr = p;
+            return false;
+        }
+        kind = char_class(cp);
+        if (kind != CHAR_SEPARATOR) break;
+        p += len;
     }
     
-    char *end = start;
-    while (*end && is_word_char(*end)) {
-        end++;
+    // 同一类文字连成一个片段
+    const char *start = p;
+    do {
+        p += len;
+        len = utf8_decode(p, &cp);
+    } while (len > 0 && char_class(cp) == kind);
+    
+    token->start = start;
+    token->length = (size_t)(p - start);
+    token->kind = kind == CHAR_CJK ? TOKEN_CJK : TOKEN_WORD;
+    *text_ptr = p;
+    return true;
+}
+
+// 获取下一个单词
+char* get_next_word(char **text_ptr) {
+    if (!text_ptr || !*text_ptr) return NULL;
+    
+    const char *text = *text_ptr;
+    Token token;
+    if (!next_token(&text, &token)) {
+        *text_ptr += text - *text_ptr;
+        return NULL;
     }
     
     // 分配内存存储单词
-    size_t length = end - start;
-    char *word = (char*)malloc(length + 1);
+    char *word = (char*)malloc(token.length + 1);
     if (!word) return NULL;
     
-    strncpy(word, start, length);
-    word[length] = '\0';
+    memcpy(word, token.start, token.length);
+    word[token.length] = '\0';
     
-    *text_ptr = end;
+    *text_ptr += text - *text_ptr;
     return word;
-}
\ No newline at end of file
+}
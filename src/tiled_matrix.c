@@ -0,0 +1,433 @@
+#include "tiled_matrix.h"
+#include "csv_writer.h"
+#include "sim_stats.h"
+#include "sim_trace.h"
+#include "sim_memory.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define tile_seek(file, offset) _fseeki64((file), (long long)(offset), SEEK_SET)
+#else
+#define tile_seek(file, offset) fseeko((file), (off_t)(offset), SEEK_SET)
+#endif
+
+#define TILE_MAGIC "TSTM"
+#define TILE_HEADER_SIZE 32
+#define NO_TILE ((size_t)-1)
+
+// 文件布局: 32 字节头部 (magic, 行数, 每块最多行数, 块数) + 各行块的上三角条带。
+// 行块 t 覆盖第 s_t..s_{t+1} 行，只存列 s_t..N-1；条带内再按列块 u >= t 分成
+// rows_t × cols_u 的子块，子块内行主序。左下半部分不落盘，读回时由子块 (t', t) 转置补全，
+// 每个子块都是一段连续数据，补全一个行块只需每个较早的块一次定位。
+struct TiledMatrix {
+    FILE *file;
+    char *path;
+    char **filenames;
+    size_t size;
+    size_t tile_rows;           // 最大的块行数
+    size_t tile_count;
+    size_t *tile_start;         // tile_count + 1 项，最后一项为 size
+    uint64_t *strip_offset;     // 各行块条带在文件中的偏移
+    float *cache;               // 当前行块的完整行，tile_rows × size
+    float *column;              // 读回子块时的一行缓冲
+    size_t cached_tile;
+};
+
+static bool write_header(TiledMatrix *tm) {
+    uint8_t header[TILE_HEADER_SIZE] = {0};
+    uint64_t size = tm->size;
+    uint64_t tile_rows = tm->tile_rows;
+    uint64_t tile_count = tm->tile_count;
+    memcpy(header, TILE_MAGIC, 4);
+    memcpy(header + 8, &size, sizeof(size));
+    memcpy(header + 16, &tile_rows, sizeof(tile_rows));
+    memcpy(header + 24, &tile_count, sizeof(tile_count));
+    return tile_seek(tm->file, 0) == 0 && fwrite(header, 1, sizeof(header), tm->file) == sizeof(header);
+}
+
+static size_t tile_rows_of(const TiledMatrix *tm, size_t t) {
+    return tm->tile_start[t + 1] - tm->tile_start[t];
+}
+
+// 子块 (t, u) 在条带 t 中的起始位置（单元格数）
+static uint64_t block_cells(const TiledMatrix *tm, size_t t, size_t u) {
+    return (uint64_t)tile_rows_of(tm, t) * (tm->tile_start[u] - tm->tile_start[t]);
+}
+
+// 行所在的行块
+static size_t tile_of(const TiledMatrix *tm, size_t row) {
+    size_t lo = 0, hi = tm->tile_count;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (tm->tile_start[mid] <= row) lo = mid;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// 在内存预算内尽量多地放入行：块缓冲 + 常驻的行向量 + 一个流式列向量 + 一行子块读回缓冲。
+// 读回时的行块缓存与计算时的块缓冲同样大小，不会另外超出预算
+static size_t plan_tile(VectorStore *store, size_t start, size_t memory_budget, size_t max_column_bytes) {
+    size_t n = vector_store_count(store);
+    size_t row_bytes = n * sizeof(float);
+    size_t used = max_column_bytes + row_bytes;
+    size_t rows = 0;
+
+    while (start + rows < n) {
+        size_t extra = row_bytes + vector_store_vector_bytes(store, start + rows);
+        if (rows > 0 && used + extra > memory_budget) break;
+        used += extra;
+        rows++;
+    }
+
+    return rows;
+}
+
+// 预先划分全部行块，后面的块同时是前面条带的列块
+static bool plan_tiles(TiledMatrix *tm, VectorStore *store, size_t memory_budget, size_t max_column_bytes) {
+    size_t n = tm->size;
+    tm->tile_start = (size_t*)malloc((n + 1) * sizeof(size_t));
+    tm->strip_offset = (uint64_t*)malloc(n * sizeof(uint64_t));
+    if (!tm->tile_start || !tm->strip_offset) return false;
+
+    uint64_t offset = TILE_HEADER_SIZE;
+    for (size_t start = 0; start < n; ) {
+        size_t rows = plan_tile(store, start, memory_budget, max_column_bytes);
+        tm->tile_start[tm->tile_count] = start;
+        tm->strip_offset[tm->tile_count] = offset;
+        tm->tile_count++;
+        if (rows > tm->tile_rows) tm->tile_rows = rows;
+        offset += (uint64_t)rows * (n - start) * sizeof(float);
+        start += rows;
+    }
+    tm->tile_start[tm->tile_count] = n;
+    return true;
+}
+
+// 外存模式计算相似度矩阵
+TiledMatrix* similarity_matrix_create_tiled(VectorStore *store, size_t memory_budget,
+                                            const char *path, JobControl *job) {
+    size_t n = vector_store_count(store);
+    if (n == 0 || !path) return NULL;
+
+    TiledMatrix *tm = (TiledMatrix*)calloc(1, sizeof(TiledMatrix));
+    if (!tm) return NULL;
+
+    tm->size = n;
+    tm->cached_tile = NO_TILE;
+    tm->path = strdup(path);
+    tm->filenames = (char**)calloc(n, sizeof(char*));
+    tm->file = fopen(path, "w+b");
+    if (!tm->path || !tm->filenames || !tm->file) {
+        fprintf(stderr, "错误: 无法创建分块矩阵文件 %s\n", path);
+        tiled_matrix_destroy(tm);
+        return NULL;
+    }
+
+    size_t max_column_bytes = 0;
+    for (size_t i = 0; i < n; i++) {
+        tm->filenames[i] = strdup(vector_store_name(store, i));
+        if (!tm->filenames[i]) {
+            tiled_matrix_destroy(tm);
+            return NULL;
+        }
+        size_t bytes = vector_store_vector_bytes(store, i);
+        if (bytes > max_column_bytes) max_column_bytes = bytes;
+    }
+
+    if (!plan_tiles(tm, store, memory_budget, max_column_bytes)) {
+        tiled_matrix_destroy(tm);
+        return NULL;
+    }
+    if ((tm->tile_rows + 1) * n * sizeof(float) > memory_budget) {
+        fprintf(stderr, "警告: 内存预算过小，每块只能容纳 %zu 行\n", tm->tile_rows);
+    }
+    if (!write_header(tm)) {
+        tiled_matrix_destroy(tm);
+        return NULL;
+    }
+
+    // 进度按块报告：已完成行块覆盖的上三角文档对数
+    size_t total_pairs = n * (n - 1) / 2;
+    bool ok = true;
+    for (size_t t = 0; ok && t < tm->tile_count; t++) {
+        size_t start = tm->tile_start[t];
+        size_t end = tm->tile_start[t + 1];
+        size_t rows = end - start;
+        size_t width = n - start;
+        size_t pairs_done = start * n - start * (start + 1) / 2;
+        if (!job_control_report(job, JOB_STAGE_MATRIX, pairs_done, total_pairs)) {
+            ok = false;
+            break;
+        }
+
+        TRACE_BEGIN(span);
+        float *tile = (float*)sim_memory_alloc(MEM_MATRIX, rows * width * sizeof(float));
+        SparseVector **resident = (SparseVector**)sim_memory_calloc(MEM_MATRIX, rows, sizeof(SparseVector*));
+        if (!tile || !resident) {
+            fprintf(stderr, "错误: 无法分配分块缓冲区\n");
+            ok = false;
+        }
+
+        // 载入本块的行向量
+        for (size_t r = 0; ok && r < rows; r++) {
+            resident[r] = vector_store_load(store, start + r);
+            if (!resident[r]) ok = false;
+        }
+
+        // 对角子块 (t, t)，完整存储以便读回时整块复制
+        STATS_TIMER_START(timer);
+        for (size_t r = 0; ok && r < rows; r++) {
+            tile[r * rows + r] = 1.0f;
+            for (size_t c = r + 1; c < rows; c++) {
+                float similarity = (float)sparse_vector_cosine(resident[r], resident[c]);
+                tile[r * rows + c] = similarity;
+                tile[c * rows + r] = similarity;
+            }
+        }
+
+        // 右侧列向量逐个从仓库流入，写入所属列块的子块
+        size_t u = t;
+        for (size_t j = end; ok && j < n; j++) {
+            while (j >= tm->tile_start[u + 1]) u++;
+            SparseVector *column = vector_store_load(store, j);
+            if (!column) {
+                ok = false;
+                break;
+            }
+            size_t cols = tile_rows_of(tm, u);
+            float *block = tile + block_cells(tm, t, u) + (j - tm->tile_start[u]);
+            for (size_t r = 0; r < rows; r++) {
+                block[r * cols] = (float)sparse_vector_cosine(resident[r], column);
+            }
+            sparse_vector_destroy(column);
+        }
+        // 计时包含右侧列向量的载入
+        STATS_TIMER_LAP(timer, STAT_PHASE_SCORE);
+        STATS_COUNT(STAT_PAIRS, rows * (rows - 1) / 2 + rows * (n - end));
+
+        // 写出完成的条带，各条带依次追加，文件只被顺序写入
+        if (ok && (tile_seek(tm->file, tm->strip_offset[t]) != 0 ||
+                   fwrite(tile, sizeof(float), rows * width, tm->file) != rows * width)) {
+            fprintf(stderr, "错误: 写入分块矩阵失败 %s\n", path);
+            ok = false;
+        }
+
+        if (resident) {
+            for (size_t r = 0; r < rows; r++) {
+                sparse_vector_destroy(resident[r]);
+            }
+        }
+        sim_memory_free(MEM_MATRIX, resident, rows * sizeof(SparseVector*));
+        sim_memory_free(MEM_MATRIX, tile, rows * width * sizeof(float));
+
+        TRACE_END(span, "matrix_tile", start);
+    }
+
+    if (!ok || fflush(tm->file) != 0) {
+        tiled_matrix_destroy(tm);
+        return NULL;
+    }
+    job_control_report(job, JOB_STAGE_MATRIX, total_pairs, total_pairs);
+
+    printf("外存矩阵计算完成: %zu 个文档, %zu 个分块 (每块最多 %zu 行)\n",
+           n, tm->tile_count, tm->tile_rows);
+    return tm;
+}
+
+// 销毁分块矩阵并删除其文件
+void tiled_matrix_destroy(TiledMatrix *tm) {
+    if (!tm) return;
+
+    if (tm->file) {
+        fclose(tm->file);
+        remove(tm->path);
+    }
+    if (tm->filenames) {
+        for (size_t i = 0; i < tm->size; i++) {
+            free(tm->filenames[i]);
+        }
+    }
+    sim_memory_free(MEM_MATRIX, tm->cache, tm->tile_rows * tm->size * sizeof(float));
+    sim_memory_free(MEM_MATRIX, tm->column, tm->tile_rows * sizeof(float));
+    free(tm->tile_start);
+    free(tm->strip_offset);
+    free(tm->filenames);
+    free(tm->path);
+    free(tm);
+}
+
+size_t tiled_matrix_size(const TiledMatrix *tm) {
+    return tm ? tm->size : 0;
+}
+
+size_t tiled_matrix_tile_rows(const TiledMatrix *tm) {
+    return tm ? tm->tile_rows : 0;
+}
+
+const char* tiled_matrix_filename(const TiledMatrix *tm, size_t index) {
+    if (!tm || index >= tm->size) return NULL;
+    return tm->filenames[index];
+}
+
+// 把行块 t 的完整行读入缓存：左侧各列块由较早条带中的子块 (t', t) 转置得到，
+// 其余部分是条带 t 本身，按子块顺序连续读入
+static bool load_tile(TiledMatrix *tm, size_t t) {
+    size_t n = tm->size;
+    if (!tm->cache) tm->cache = (float*)sim_memory_alloc(MEM_MATRIX, tm->tile_rows * n * sizeof(float));
+    if (!tm->column) tm->column = (float*)sim_memory_alloc(MEM_MATRIX, tm->tile_rows * sizeof(float));
+    if (!tm->cache || !tm->column) return false;
+    tm->cached_tile = NO_TILE;
+
+    size_t rows = tile_rows_of(tm, t);
+    for (size_t e = 0; e < t; e++) {
+        size_t earlier = tm->tile_start[e];
+        uint64_t offset = tm->strip_offset[e] + block_cells(tm, e, t) * sizeof(float);
+        if (tile_seek(tm->file, offset) != 0) return false;
+        for (size_t k = 0; k < tile_rows_of(tm, e); k++) {
+            if (fread(tm->column, sizeof(float), rows, tm->file) != rows) return false;
+            for (size_t r = 0; r < rows; r++) {
+                tm->cache[r * n + earlier + k] = tm->column[r];
+            }
+        }
+    }
+
+    if (tile_seek(tm->file, tm->strip_offset[t]) != 0) return false;
+    for (size_t u = t; u < tm->tile_count; u++) {
+        size_t cols = tile_rows_of(tm, u);
+        for (size_t r = 0; r < rows; r++) {
+            if (fread(tm->cache + r * n + tm->tile_start[u], sizeof(float), cols, tm->file) != cols) {
+                return false;
+            }
+        }
+    }
+    tm->cached_tile = t;
+    return true;
+}
+
+// 读取一整行；按行号顺序读取时每个行块只读回一次
+bool tiled_matrix_read_row(TiledMatrix *tm, size_t row, float *out) {
+    if (!tm || !out || row >= tm->size) return false;
+
+    size_t t = tile_of(tm, row);
+    if (tm->cached_tile != t && !load_tile(tm, t)) return false;
+    memcpy(out, tm->cache + (row - tm->tile_start[t]) * tm->size, tm->size * sizeof(float));
+    return true;
+}
+
+// 流式导出CSV，格式与 similarity_matrix_save_csv 相同
+bool tiled_matrix_save_csv(TiledMatrix *tm, const char *filename) {
+    if (!tm || !filename) return false;
+
+    float *row = (float*)malloc(tm->size * sizeof(float));
+    if (!row) return false;
+
+    CsvWriter *writer = csv_writer_open(filename);
+    if (!writer) {
+        free(row);
+        return false;
+    }
+
+    bool ok = csv_writer_write_header(writer, tm->filenames, tm->size);
+    for (size_t i = 0; ok && i < tm->size; i++) {
+        ok = tiled_matrix_read_row(tm, i, row) &&
+             csv_writer_write_row_f32(writer, tm->filenames[i], row, tm->size);
+    }
+
+    if (!csv_writer_close(writer)) ok = false;
+    free(row);
+
+    if (ok) {
+        printf("相似度矩阵已保存到 %s\n", filename);
+    }
+    return ok;
+}
+
+// 小顶堆，按相似度维护当前前N个
+static void pair_heap_sift_down(SimilarityPair *heap, size_t size, size_t i) {
+    for (;;) {
+        size_t smallest = i;
+        size_t l = 2 * i + 1, r = 2 * i + 2;
+        if (l < size && heap[l].similarity < heap[smallest].similarity) smallest = l;
+        if (r < size && heap[r].similarity < heap[smallest].similarity) smallest = r;
+        if (smallest == i) return;
+        SimilarityPair tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+static void fill_pair(SimilarityPair *pair, const char *doc1, const char *doc2, double similarity) {
+    strncpy(pair->doc1, doc1, sizeof(pair->doc1) - 1);
+    pair->doc1[sizeof(pair->doc1) - 1] = '\0';
+    strncpy(pair->doc2, doc2, sizeof(pair->doc2) - 1);
+    pair->doc2[sizeof(pair->doc2) - 1] = '\0';
+    pair->similarity = similarity;
+}
+
+// 流式查找前N个最相似对，内存占用只与 N 有关
+SimilarityPair* tiled_matrix_top_similarities(TiledMatrix *tm, size_t top_n, size_t *result_count) {
+    if (!tm || tm->size < 2 || top_n == 0 || !result_count) return NULL;
+
+    float *row = (float*)malloc(tm->size * sizeof(float));
+    SimilarityPair *heap = (SimilarityPair*)malloc(top_n * sizeof(SimilarityPair));
+    if (!row || !heap) {
+        free(row);
+        free(heap);
+        return NULL;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < tm->size; i++) {
+        if (!tiled_matrix_read_row(tm, i, row)) {
+            free(row);
+            free(heap);
+            return NULL;
+        }
+        for (size_t j = i + 1; j < tm->size; j++) {
+            double similarity = row[j];
+            if (count < top_n) {
+                fill_pair(&heap[count++], tm->filenames[i], tm->filenames[j], similarity);
+                if (count == top_n) {
+                    for (size_t k = top_n / 2 + 1; k-- > 0; ) {
+                        pair_heap_sift_down(heap, count, k);
+                    }
+                }
+            } else if (similarity > heap[0].similarity) {
+                fill_pair(&heap[0], tm->filenames[i], tm->filenames[j], similarity);
+                pair_heap_sift_down(heap, count, 0);
+            }
+        }
+    }
+
+    free(row);
+    sort_similarity_pairs(heap, count);
+    *result_count = count;
+    return heap;
+}
+
+// 流式筛选相似度不低于阈值的文档对，返回对数
+size_t tiled_matrix_filter_pairs(TiledMatrix *tm, double threshold,
+                                 PairVisitor visitor, void *userdata) {
+    if (!tm || !visitor) return 0;
+
+    float *row = (float*)malloc(tm->size * sizeof(float));
+    if (!row) return 0;
+
+    size_t count = 0;
+    for (size_t i = 0; i < tm->size; i++) {
+        if (!tiled_matrix_read_row(tm, i, row)) break;
+        for (size_t j = i + 1; j < tm->size; j++) {
+            if (row[j] >= threshold) {
+                visitor(tm->filenames[i], tm->filenames[j], row[j], userdata);
+                count++;
+            }
+        }
+    }
+
+    free(row);
+    return count;
+}
@@ -1,7 +1,9 @@
 #include "ui.h"
+#include "shingle.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <ctype.h>
 
 #ifdef _WIN32
@@ -10,6 +12,9 @@
     #define CLEAR_COMMAND "clear"
 #endif
 
+#define UI_SHINGLE_WIDTH 4
+#define UI_MINHASH_SIZE 128
+
 // 清屏
 void clear_screen() {
     system(CLEAR_COMMAND);
@@ -33,8 +38,10 @@ void print_menu() {
     printf("  5. 筛选相似度对\n");
     printf("  6. 显示热力图\n");
     printf("  7. 显示统计信息\n");
+    printf("  8. 添加单个文档\n");
+    printf("  9. 移除文档\n");
     printf("  0. 退出\n");
-    printf("请选择操作 (0-7): ");
+    printf("请选择操作 (0-9): ");
 }
 
 // 获取菜单选择
@@ -43,7 +50,7 @@ MenuOption get_menu_choice() {
     fgets(input, sizeof(input), stdin);
     
     int choice = atoi(input);
-    if (choice < 0 || choice > 7) {
+    if (choice < 0 || choice > 9) {
         return MENU_EXIT;
     }
     
@@ -82,7 +89,7 @@ void process_menu_choice(MenuOption choice, DocumentCollection **col_ptr,
             break;
             
         case MENU_COMPARE_TWO:
-            compare_two_documents();
+            compare_two_documents(*stop_words_ptr);
             break;
             
         case MENU_GENERATE_MATRIX:
@@ -153,6 +160,18 @@ void process_menu_choice(MenuOption choice, DocumentCollection **col_ptr,
             }
             break;
             
+        case MENU_ADD_DOCUMENT:
+            add_document_to_collection(col_ptr, *matrix_ptr, *stop_words_ptr);
+            break;
+            
+        case MENU_REMOVE_DOCUMENT:
+            if (*col_ptr && (*col_ptr)->count > 0) {
+                remove_document_from_collection(*col_ptr, *matrix_ptr);
+            } else {
+                printf("请先加载文档目录！\n");
+            }
+            break;
+            
         default:
             printf("无效的选择！\n");
             break;
@@ -165,7 +184,7 @@ void process_menu_choice(MenuOption choice, DocumentCollection **col_ptr,
 }
 
 // 比较两个文档
-void compare_two_documents() {
+void compare_two_documents(StopWords *stop_words) {
     char file1[256], file2[256];
     
     printf("请输入第一个文档路径: ");
@@ -176,9 +195,6 @@ void compare_two_documents() {
     fgets(file2, sizeof(file2), stdin);
     file2[strcspn(file2, "\n")] = '\0';
     
-    // 创建停用词表
-    StopWords *stop_words = stop_words_create();
-    
     // 加载并处理文档
     Document *doc1 = document_create("文档1");
     Document *doc2 = document_create("文档2");
@@ -193,9 +209,23 @@ void compare_two_documents() {
         double cosine_sim = document_cosine_similarity(doc1, doc2);
         double jaccard_sim = jaccard_similarity(doc1->word_freq, doc2->word_freq);
         
+        // 词序：4 词 shingle 的集合相似度及其 MinHash 估计
+        ShingleOptions shingles;
+        shingle_options_init(&shingles);
+        shingles.width = UI_SHINGLE_WIDTH;
+        SparseVector *sh1 = shingle_vector(doc1->content, &shingles);
+        SparseVector *sh2 = shingle_vector(doc2->content, &shingles);
+        uint64_t sig1[UI_MINHASH_SIZE], sig2[UI_MINHASH_SIZE];
+        minhash_signature(sh1, sig1, UI_MINHASH_SIZE);
+        minhash_signature(sh2, sig2, UI_MINHASH_SIZE);
+        
         printf("\n比较结果:\n");
         printf("  余弦相似度: %.4f\n", cosine_sim);
         printf("  Jaccard相似度: %.4f\n", jaccard_sim);
+        printf("  %d词shingle Jaccard: %.4f (MinHash估计 %.4f)\n", UI_SHINGLE_WIDTH,
+               sparse_vector_jaccard(sh1, sh2), minhash_similarity(sig1, sig2, UI_MINHASH_SIZE));
+        sparse_vector_destroy(sh1);
+        sparse_vector_destroy(sh2);
         printf("  文档1单词数: %zu\n", doc1->word_count);
         printf("  文档2单词数: %zu\n", doc2->word_count);
         printf("  文档1唯一单词数: %zu\n", doc1->word_freq->unique_words);
@@ -220,11 +250,71 @@ void compare_two_documents() {
     }
     
     // 清理
-    stop_words_destroy(stop_words);
     document_destroy(doc1);
     document_destroy(doc2);
 }
 
+// 向已加载集合添加单个文档，若已生成矩阵则只计算新行
+void add_document_to_collection(DocumentCollection **col_ptr, SimilarityMatrix *matrix,
+                                StopWords *stop_words) {
+    char path[256];
+    printf("请输入文档路径: ");
+    fgets(path, sizeof(path), stdin);
+    path[strcspn(path, "\n")] = '\0';
+    
+    Document *doc = document_create(path);
+    if (!doc || !document_load_from_file(doc, path) || !document_process(doc, stop_words)) {
+        printf("无法加载文档！\n");
+        document_destroy(doc);
+        return;
+    }
+    
+    if (!*col_ptr) {
+        *col_ptr = collection_create(0);
+        if (!*col_ptr) {
+            document_destroy(doc);
+            return;
+        }
+    }
+    
+    bool added = matrix ? similarity_matrix_add_document(matrix, *col_ptr, doc)
+                        : collection_add_document(*col_ptr, doc);
+    if (!added) {
+        printf("添加文档失败！\n");
+        document_destroy(doc);
+        return;
+    }
+    
+    printf("已添加文档: %s (集合共 %zu 个文档)\n", doc->filename, (*col_ptr)->count);
+    if (matrix) {
+        printf("相似度矩阵已增量更新 (%zux%zu)\n", matrix->size, matrix->size);
+    }
+}
+
+// 从集合中移除文档，若已生成矩阵则同步删除对应行列
+void remove_document_from_collection(DocumentCollection *col, SimilarityMatrix *matrix) {
+    printf("当前文档:\n");
+    for (size_t i = 0; i < col->count; i++) {
+        printf("  %zu. %s\n", i + 1, col->documents[i]->filename);
+    }
+    
+    char input[10];
+    printf("请输入要移除的文档编号: ");
+    fgets(input, sizeof(input), stdin);
+    
+    size_t index = (size_t)atoi(input);
+    if (index == 0 || index > col->count) {
+        printf("无效的编号！\n");
+        return;
+    }
+    
+    bool removed = matrix ? similarity_matrix_remove_document(matrix, col, index - 1)
+                          : collection_remove_document(col, index - 1);
+    if (removed) {
+        printf("已移除文档 (集合剩余 %zu 个文档)\n", col->count);
+    }
+}
+
 // 显示统计信息
 void show_statistics(DocumentCollection *col) {
     if (!col || col->count == 0) {
@@ -1,4 +1,7 @@
 #include "vector_math.h"
+#include "sim_stats.h"
+#include "sim_trace.h"
+#include "sim_memory.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,15 +11,15 @@
 
 // 创建向量
 Vector* vector_create(size_t capacity) {
-    Vector *vec = (Vector*)malloc(sizeof(Vector));
+    Vector *vec = (Vector*)sim_memory_alloc(MEM_VECTOR, sizeof(Vector));
     if (!vec) return NULL;
     
     vec->capacity = capacity > 0 ? capacity : VECTOR_INITIAL_CAPACITY;
     vec->size = 0;
-    vec->data = (double*)calloc(vec->capacity, sizeof(double));
+    vec->data = (double*)sim_memory_calloc(MEM_VECTOR, vec->capacity, sizeof(double));
     
     if (!vec->data) {
-        free(vec);
+        sim_memory_free(MEM_VECTOR, vec, sizeof(Vector));
         return NULL;
     }
     
@@ -27,11 +30,8 @@ Vector* vector_create(size_t capacity) {
 void vector_destroy(Vector *vec) {
     if (!vec) return;
     
-    if (vec->data) {
-        free(vec->data);
-    }
-    
-    free(vec);
+    sim_memory_free(MEM_VECTOR, vec->data, vec->capacity * sizeof(double));
+    sim_memory_free(MEM_VECTOR, vec, sizeof(Vector));
 }
 
 // 向向量添加元素
@@ -39,10 +39,11 @@ bool vector_add(Vector *vec, double value) {
     if (!vec) return false;
     
     if (vec->size >= vec->capacity) {
-        vec->capacity *= 2;
-        double *new_data = realloc(vec->data, vec->capacity * sizeof(double));
+        double *new_data = sim_memory_realloc(MEM_VECTOR, vec->data, vec->capacity * sizeof(double),
+                                              vec->capacity * 2 * sizeof(double));
         if (!new_data) return false;
         vec->data = new_data;
+        vec->capacity *= 2;
     }
     
     vec->data[vec->size++] = value;
@@ -174,7 +175,7 @@ double document_cosine_similarity(Document *doc1, Document *doc2) {
     }
     
     // 获取两个哈希表的所有键
-    HashTable *combined = hash_table_create(101);
+    HashTable *combined = hash_table_create_pooled(101);
     
     // 收集所有单词
     for (size_t i = 0; i < doc1->word_freq->capacity; i++) {
@@ -233,9 +234,10 @@ double document_cosine_similarity(Document *doc1, Document *doc2) {
 char** build_vocabulary(Document **docs, size_t doc_count, size_t *vocab_size) {
     if (!docs || doc_count == 0) return NULL;
 
-    HashTable *temp_ht = hash_table_create(1000);
+    HashTable *temp_ht = hash_table_create_pooled(1000);
     if (!temp_ht) return NULL;
 
+    TRACE_BEGIN(span);
     // 收集所有唯一单词
     for (size_t i = 0; i < doc_count; i++) {
         if (!docs[i] || !docs[i]->word_freq) continue;
@@ -253,6 +255,7 @@ char** build_vocabulary(Document **docs, size_t doc_count, size_t *vocab_size) {
     }
 
     *vocab_size = temp_ht->unique_words;
+    TRACE_END(span, "vocab", *vocab_size);
     if (*vocab_size == 0) {
         hash_table_destroy(temp_ht);
         return NULL;
@@ -286,10 +289,11 @@ void document_to_vector(Document *doc, Vector *vec, char **vocab, size_t vocab_s
     
     // 预分配空间以避免多次realloc
     if (vec->capacity < vocab_size) {
-        vec->capacity = vocab_size;
-        double *new_data = realloc(vec->data, vec->capacity * sizeof(double));
+        double *new_data = sim_memory_realloc(MEM_VECTOR, vec->data, vec->capacity * sizeof(double),
+                                              vocab_size * sizeof(double));
         if (new_data) {
             vec->data = new_data;
+            vec->capacity = vocab_size;
         } else {
             return; // 内存分配失败
         }
@@ -303,4 +307,234 @@ void document_to_vector(Document *doc, Vector *vec, char **vocab, size_t vocab_s
         // 直接操作数据数组比调用vector_add更高效且安全（因为我们已经处理了容量）
         vec->data[vec->size++] = val;
     }
-}
\ No newline at end of file
+}
+
+// 词项的64位哈希 (FNV-1a)
+uint64_t term_hash64(const char *term) {
+    uint64_t hash = 14695981039346656037ULL;
+    
+    while (*term) {
+        hash ^= (unsigned char)*term++;
+        hash *= 1099511628211ULL;
+    }
+    
+    return hash;
+}
+
+typedef struct SparseEntry {
+    uint64_t key;
+    double value;
+} SparseEntry;
+
+static int compare_sparse_entry(const void *a, const void *b) {
+    uint64_t ka = ((const SparseEntry*)a)->key;
+    uint64_t kb = ((const SparseEntry*)b)->key;
+    return ka < kb ? -1 : (ka > kb ? 1 : 0);
+}
+
+// size 个分量的向量占用的字节数（空向量也分配一个分量）
+static size_t sparse_vector_bytes(size_t size) {
+    return sizeof(SparseVector) + (size ? size : 1) * (sizeof(uint64_t) + sizeof(double));
+}
+
+// 分配 size 个分量的稀疏向量，分量未初始化
+SparseVector* sparse_vector_alloc(size_t size) {
+    if (!sim_memory_reserve(MEM_VECTOR, sparse_vector_bytes(size))) return NULL;
+    
+    SparseVector *vec = (SparseVector*)malloc(sizeof(SparseVector));
+    if (!vec) {
+        sim_memory_release(MEM_VECTOR, sparse_vector_bytes(size));
+        return NULL;
+    }
+    vec->keys = (uint64_t*)malloc((size ? size : 1) * sizeof(uint64_t));
+    vec->values = (double*)malloc((size ? size : 1) * sizeof(double));
+    vec->size = size;
+    vec->norm = 0.0;
+    
+    if (!vec->keys || !vec->values) {
+        sparse_vector_destroy(vec);
+        return NULL;
+    }
+    return vec;
+}
+
+// 由词频哈希表构建稀疏向量
+SparseVector* sparse_vector_from_table(HashTable *ht) {
+    if (!ht) return NULL;
+    
+    size_t count = ht->size;
+    SparseVector *vec = sparse_vector_alloc(count);
+    SparseEntry *entries = (SparseEntry*)malloc((count ? count : 1) * sizeof(SparseEntry));
+    
+    if (!vec || !entries) {
+        free(entries);
+        sparse_vector_destroy(vec);
+        return NULL;
+    }
+    
+    size_t n = 0;
+    for (size_t i = 0; i < ht->capacity; i++) {
+        for (Entry *entry = ht->buckets[i]; entry; entry = entry->next) {
+            entries[n].key = term_hash64(entry->key);
+            entries[n].value = (double)entry->value;
+            n++;
+        }
+    }
+    
+    qsort(entries, n, sizeof(SparseEntry), compare_sparse_entry);
+    
+    // 合并哈希相同的分量并计算模长
+    double sum = 0.0;
+    vec->size = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (vec->size > 0 && vec->keys[vec->size - 1] == entries[i].key) {
+            vec->values[vec->size - 1] += entries[i].value;
+        } else {
+            vec->keys[vec->size] = entries[i].key;
+            vec->values[vec->size] = entries[i].value;
+            vec->size++;
+        }
+    }
+    for (size_t i = 0; i < vec->size; i++) {
+        sum += vec->values[i] * vec->values[i];
+    }
+    vec->norm = sqrt(sum);
+    // 哈希相同的分量合并后多出的空间只在记账中归还，数组保持原大小
+    if (vec->size < count && vec->size > 0) {
+        sim_memory_release(MEM_VECTOR, sparse_vector_bytes(count) - sparse_vector_bytes(vec->size));
+    }
+    
+    free(entries);
+    return vec;
+}
+
+// 销毁稀疏向量
+void sparse_vector_destroy(SparseVector *vec) {
+    if (!vec) return;
+    
+    sim_memory_release(MEM_VECTOR, sparse_vector_bytes(vec->size));
+    free(vec->keys);
+    free(vec->values);
+    free(vec);
+}
+
+// 稀疏向量点积（有序归并）
+double sparse_vector_dot(const SparseVector *a, const SparseVector *b) {
+    if (!a || !b) return 0.0;
+    
+    double result = 0.0;
+    size_t i = 0, j = 0;
+    while (i < a->size && j < b->size) {
+        if (a->keys[i] < b->keys[j]) {
+            i++;
+        } else if (a->keys[i] > b->keys[j]) {
+            j++;
+        } else {
+            result += a->values[i] * b->values[j];
+            i++;
+            j++;
+        }
+    }
+    
+    return result;
+}
+
+// 稀疏向量余弦相似度
+double sparse_vector_cosine(const SparseVector *a, const SparseVector *b) {
+    if (!a || !b) return -1.0;
+    
+    if (a->norm == 0 || b->norm == 0) {
+        return 0.0;
+    }
+    
+    return sparse_vector_dot(a, b) / (a->norm * b->norm);
+}
+
+// 键集合的 Jaccard 相似度（有序归并）
+double sparse_vector_jaccard(const SparseVector *a, const SparseVector *b) {
+    if (!a || !b) return 0.0;
+    
+    size_t intersection = 0;
+    size_t i = 0, j = 0;
+    while (i < a->size && j < b->size) {
+        if (a->keys[i] < b->keys[j]) {
+            i++;
+        } else if (a->keys[i] > b->keys[j]) {
+            j++;
+        } else {
+            intersection++;
+            i++;
+            j++;
+        }
+    }
+    
+    size_t union_size = a->size + b->size - intersection;
+    if (union_size == 0) return 0.0;
+    return (double)intersection / union_size;
+}
+
+// 第 i 个置换：键与按序号生成的种子异或后混合
+static uint64_t minhash_permute(uint64_t key, uint64_t seed) {
+    key ^= seed;
+    key ^= key >> 31;
+    key *= 0xBF58476D1CE4E5B9ULL;
+    key ^= key >> 29;
+    key *= 0x94D049BB133111EBULL;
+    key ^= key >> 32;
+    return key;
+}
+
+// 计算 k 个分量的 MinHash 签名；空向量的签名全为 UINT64_MAX
+void minhash_signature(const SparseVector *vec, uint64_t *signature, size_t k) {
+    if (!signature) return;
+    
+    for (size_t h = 0; h < k; h++) {
+        uint64_t seed = (h + 1) * 0x9E3779B97F4A7C15ULL;
+        uint64_t min = UINT64_MAX;
+        for (size_t i = 0; vec && i < vec->size; i++) {
+            uint64_t value = minhash_permute(vec->keys[i], seed);
+            if (value < min) min = value;
+        }
+        signature[h] = min;
+    }
+}
+
+// 签名相同位置的比例；与 sparse_vector_jaccard 一致，空集合之间为 0
+double minhash_similarity(const uint64_t *a, const uint64_t *b, size_t k) {
+    if (!a || !b || k == 0) return 0.0;
+    
+    size_t equal = 0;
+    for (size_t h = 0; h < k; h++) {
+        if (a[h] == b[h] && a[h] != UINT64_MAX) equal++;
+    }
+    return (double)equal / k;
+}
+
+// 获取文档的缓存向量（首次调用时生成）
+SparseVector* document_vector(Document *doc) {
+    if (!doc || !doc->word_freq) return NULL;
+    
+    if (!doc->vector) {
+        STATS_TIMER_START(timer);
+        TRACE_BEGIN(span);
+        doc->vector = sparse_vector_from_table(doc->word_freq);
+        TRACE_END(span, "vectorize", doc->word_freq->size);
+        STATS_TIMER_LAP(timer, STAT_PHASE_VECTORIZE);
+        STATS_COUNT(STAT_VECTORS, 1);
+        STATS_COUNT(STAT_ALLOCATIONS, 4);
+    }
+    
+    return doc->vector;
+}
+
+// 基于缓存向量的文档余弦相似度，结果与 document_cosine_similarity 一致
+double document_vector_similarity(Document *doc1, Document *doc2) {
+    SparseVector *vec1 = document_vector(doc1);
+    SparseVector *vec2 = document_vector(doc2);
+    
+    if (!vec1 || !vec2) {
+        return -1.0;
+    }
+    
+    return sparse_vector_cosine(vec1, vec2);
+}
@@ -0,0 +1,179 @@
+#include "vector_store.h"
+#include "file_manager.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define store_seek(file, offset) _fseeki64((file), (long long)(offset), SEEK_SET)
+#else
+#define store_seek(file, offset) fseeko((file), (off_t)(offset), SEEK_SET)
+#endif
+
+#define STORE_INITIAL_CAPACITY 256
+
+// 每条记录: u32 分量数, f64 模长, u64 键[n], f64 值[n]（本机字节序，仅作临时溢出文件）
+struct VectorStore {
+    FILE *file;
+    char *path;
+    char **names;
+    uint64_t *offsets;
+    uint32_t *sizes;
+    size_t count;
+    size_t capacity;
+    uint64_t write_pos;
+    bool writing;
+};
+
+// 创建仓库文件（已存在则覆盖）
+VectorStore* vector_store_create(const char *path) {
+    if (!path) return NULL;
+
+    VectorStore *store = (VectorStore*)calloc(1, sizeof(VectorStore));
+    if (!store) return NULL;
+
+    store->path = strdup(path);
+    store->file = fopen(path, "w+b");
+    if (!store->path || !store->file) {
+        fprintf(stderr, "错误: 无法创建向量仓库 %s\n", path);
+        if (store->file) fclose(store->file);
+        free(store->path);
+        free(store);
+        return NULL;
+    }
+
+    return store;
+}
+
+// 关闭并删除仓库文件
+void vector_store_destroy(VectorStore *store) {
+    if (!store) return;
+
+    fclose(store->file);
+    remove(store->path);
+
+    for (size_t i = 0; i < store->count; i++) {
+        free(store->names[i]);
+    }
+    free(store->names);
+    free(store->offsets);
+    free(store->sizes);
+    free(store->path);
+    free(store);
+}
+
+// 追加一个向量
+bool vector_store_append(VectorStore *store, const char *name, const SparseVector *vec) {
+    if (!store || !name || !vec) return false;
+
+    if (store->count >= store->capacity) {
+        size_t new_capacity = store->capacity ? store->capacity * 2 : STORE_INITIAL_CAPACITY;
+        char **new_names = realloc(store->names, new_capacity * sizeof(char*));
+        if (!new_names) return false;
+        store->names = new_names;
+        uint64_t *new_offsets = realloc(store->offsets, new_capacity * sizeof(uint64_t));
+        if (!new_offsets) return false;
+        store->offsets = new_offsets;
+        uint32_t *new_sizes = realloc(store->sizes, new_capacity * sizeof(uint32_t));
+        if (!new_sizes) return false;
+        store->sizes = new_sizes;
+        store->capacity = new_capacity;
+    }
+
+    char *copy = strdup(name);
+    if (!copy) return false;
+
+    if (!store->writing) {
+        // 读写切换前必须重新定位
+        if (store_seek(store->file, store->write_pos) != 0) {
+            free(copy);
+            return false;
+        }
+        store->writing = true;
+    }
+
+    uint32_t size = (uint32_t)vec->size;
+    if (fwrite(&size, sizeof(size), 1, store->file) != 1 ||
+        fwrite(&vec->norm, sizeof(double), 1, store->file) != 1 ||
+        fwrite(vec->keys, sizeof(uint64_t), size, store->file) != size ||
+        fwrite(vec->values, sizeof(double), size, store->file) != size) {
+        fprintf(stderr, "错误: 写入向量仓库失败 %s\n", store->path);
+        free(copy);
+        return false;
+    }
+
+    store->names[store->count] = copy;
+    store->offsets[store->count] = store->write_pos;
+    store->sizes[store->count] = size;
+    store->count++;
+    store->write_pos += sizeof(uint32_t) + sizeof(double) +
+                        (uint64_t)size * (sizeof(uint64_t) + sizeof(double));
+    return true;
+}
+
+// 目录遍历回调：向量化后写入仓库，文档本身立即释放
+static bool store_document(Document *doc, const char *name, void *userdata) {
+    VectorStore *store = (VectorStore*)userdata;
+    SparseVector *vec = document_vector(doc);
+
+    // 与内存模式一致，使用文档路径作为矩阵中的文件名
+    if (vec && vector_store_append(store, doc->filename, vec)) {
+        printf("已加载文档: %s\n", name);
+    }
+
+    return false;
+}
+
+// 从目录构建向量仓库，内存中不保留任何文档
+VectorStore* vector_store_build_from_dir(const char *dir_path, StopWords *stop_words,
+                                         const char *path, JobControl *job) {
+    VectorStore *store = vector_store_create(path);
+    if (!store) return NULL;
+
+    for_each_document_in_dir_job(dir_path, stop_words, store_document, store, job);
+    if (job_control_cancelled(job)) {
+        vector_store_destroy(store);
+        return NULL;
+    }
+    return store;
+}
+
+size_t vector_store_count(const VectorStore *store) {
+    return store ? store->count : 0;
+}
+
+const char* vector_store_name(const VectorStore *store, size_t index) {
+    if (!store || index >= store->count) return NULL;
+    return store->names[index];
+}
+
+// 向量读回内存后的大致占用
+size_t vector_store_vector_bytes(const VectorStore *store, size_t index) {
+    if (!store || index >= store->count) return 0;
+    return sizeof(SparseVector) + store->sizes[index] * (sizeof(uint64_t) + sizeof(double));
+}
+
+// 从磁盘读回一个向量，调用方负责销毁
+SparseVector* vector_store_load(VectorStore *store, size_t index) {
+    if (!store || index >= store->count) return NULL;
+
+    if (fflush(store->file) != 0 || store_seek(store->file, store->offsets[index]) != 0) {
+        return NULL;
+    }
+    store->writing = false;
+
+    uint32_t size = store->sizes[index];
+    SparseVector *vec = sparse_vector_alloc(size);
+    if (!vec) return NULL;
+
+    uint32_t stored_size;
+    if (fread(&stored_size, sizeof(stored_size), 1, store->file) != 1 || stored_size != size ||
+        fread(&vec->norm, sizeof(double), 1, store->file) != 1 ||
+        fread(vec->keys, sizeof(uint64_t), size, store->file) != size ||
+        fread(vec->values, sizeof(double), size, store->file) != size) {
+        fprintf(stderr, "错误: 读取向量仓库失败 %s\n", store->path);
+        sparse_vector_destroy(vec);
+        return NULL;
+    }
+
+    return vec;
+}
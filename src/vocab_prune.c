@@ -0,0 +1,212 @@
+#include "vocab_prune.h"
+#include "matrix_engine.h"
+#include "vector_math.h"
+#include "sim_memory.h"
+#include "sim_trace.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct TermWeight {
+    const char *term;
+    int value;
+} TermWeight;
+
+typedef struct PruneWorker {
+    DocumentCollection *col;
+    HashTable *vocab;       // 保留的词项；NULL 表示不做全局过滤
+    size_t top_terms;
+    size_t begin;
+    size_t end;
+    size_t terms_after;
+    bool ok;
+} PruneWorker;
+
+void prune_options_init(PruneOptions *options) {
+    if (options) memset(options, 0, sizeof(*options));
+}
+
+bool prune_options_active(const PruneOptions *options) {
+    return options && (options->min_df > 1 || options->max_df > 0 ||
+                       options->max_vocab > 0 || options->top_terms > 0);
+}
+
+// 权重从高到低，相同时按词项排序，使结果与哈希表内部顺序无关
+static int compare_weight_desc(const void *a, const void *b) {
+    const TermWeight *wa = (const TermWeight*)a;
+    const TermWeight *wb = (const TermWeight*)b;
+    if (wa->value != wb->value) return wa->value > wb->value ? -1 : 1;
+    return strcmp(wa->term, wb->term);
+}
+
+static bool reserve_scratch(TermWeight **scratch, size_t *capacity, size_t needed) {
+    if (needed <= *capacity) return true;
+    TermWeight *grown = (TermWeight*)sim_memory_realloc(MEM_VECTOR, *scratch, *capacity * sizeof(TermWeight),
+                                                        needed * sizeof(TermWeight));
+    if (!grown) return false;
+    *scratch = grown;
+    *capacity = needed;
+    return true;
+}
+
+// 裁剪一个文档的词频表：保留的词项排在 scratch 前部，其余从表中删除
+static bool prune_document(Document *doc, HashTable *vocab, size_t top_terms,
+                           TermWeight **scratch, size_t *capacity) {
+    HashTable *table = doc->word_freq;
+    if (!table || table->size == 0) return true;
+    if (!reserve_scratch(scratch, capacity, table->size)) return false;
+
+    TermWeight *terms = *scratch;
+    size_t n = table->size;
+    size_t kept = 0;
+    size_t dropped = 0;
+    for (size_t b = 0; b < table->capacity; b++) {
+        for (Entry *entry = table->buckets[b]; entry; entry = entry->next) {
+            bool keep = !vocab || hash_table_get(vocab, entry->key) != -1;
+            TermWeight *slot = keep ? &terms[kept++] : &terms[n - 1 - dropped++];
+            slot->term = entry->key;
+            slot->value = entry->value;
+        }
+    }
+
+    if (top_terms > 0 && kept > top_terms) {
+        qsort(terms, kept, sizeof(TermWeight), compare_weight_desc);
+        kept = top_terms;
+    }
+    if (kept == n) return true;
+
+    // 非内存池的表删除时释放键，每个键只在删除自己的条目时用到
+    for (size_t i = kept; i < n; i++) {
+        hash_table_remove(table, terms[i].term);
+    }
+    sparse_vector_destroy(doc->vector);
+    doc->vector = NULL;
+    return true;
+}
+
+static void* prune_worker(void *arg) {
+    PruneWorker *worker = (PruneWorker*)arg;
+    TermWeight *scratch = NULL;
+    size_t capacity = 0;
+
+    TRACE_BEGIN(span);
+    for (size_t i = worker->begin; i < worker->end && worker->ok; i++) {
+        Document *doc = worker->col->documents[i];
+        worker->ok = prune_document(doc, worker->vocab, worker->top_terms, &scratch, &capacity);
+        if (doc->word_freq) worker->terms_after += doc->word_freq->size;
+    }
+    TRACE_END(span, "prune", worker->end - worker->begin);
+
+    sim_memory_free(MEM_VECTOR, scratch, capacity * sizeof(TermWeight));
+    return NULL;
+}
+
+// 统计文档频率并按全局规则删去词项，返回保留的词表；内存不足时返回 NULL
+static HashTable* build_pruned_vocab(DocumentCollection *col, const PruneOptions *options,
+                                     PruneStats *stats) {
+    HashTable *vocab = hash_table_create_pooled(1024);
+    if (!vocab) return NULL;
+
+    for (size_t i = 0; i < col->count; i++) {
+        HashTable *table = col->documents[i]->word_freq;
+        if (!table) continue;
+        stats->terms_before += table->size;
+        for (size_t b = 0; b < table->capacity; b++) {
+            for (Entry *entry = table->buckets[b]; entry; entry = entry->next) {
+                if (!hash_table_insert(vocab, entry->key, 1)) {
+                    hash_table_destroy(vocab);
+                    return NULL;
+                }
+            }
+        }
+    }
+    stats->vocab_before = vocab->size;
+
+    size_t n = vocab->size;
+    size_t bytes = (n > 0 ? n : 1) * sizeof(TermWeight);
+    TermWeight *terms = (TermWeight*)sim_memory_alloc(MEM_VECTOR, bytes);
+    if (!terms) {
+        hash_table_destroy(vocab);
+        return NULL;
+    }
+
+    // 不满足文档频率范围的排在后部
+    size_t kept = 0;
+    size_t dropped = 0;
+    double max_count = options->max_df > 0 ? options->max_df * (double)col->count : (double)col->count;
+    for (size_t b = 0; b < vocab->capacity; b++) {
+        for (Entry *entry = vocab->buckets[b]; entry; entry = entry->next) {
+            bool keep = (size_t)entry->value >= options->min_df && (double)entry->value <= max_count;
+            TermWeight *slot = keep ? &terms[kept++] : &terms[n - 1 - dropped++];
+            slot->term = entry->key;
+            slot->value = entry->value;
+        }
+    }
+    if (options->max_vocab > 0 && kept > options->max_vocab) {
+        qsort(terms, kept, sizeof(TermWeight), compare_weight_desc);
+        kept = options->max_vocab;
+    }
+
+    // 内存池中的键在删除后仍然有效，直到词表销毁
+    for (size_t i = kept; i < n; i++) {
+        hash_table_remove(vocab, terms[i].term);
+    }
+    sim_memory_free(MEM_VECTOR, terms, bytes);
+    stats->vocab_after = vocab->size;
+    return vocab;
+}
+
+bool collection_prune(DocumentCollection *col, const PruneOptions *options, PruneStats *stats) {
+    if (!col || !options) return false;
+    // 裁剪会丢弃缓存向量，之后按原始词频重建，加权与 shingle 特征都会丢失
+    if (col->weights || shingle_options_active(&col->shingles)) {
+        fprintf(stderr, "错误: 集合已启用加权或 shingle 特征，须先裁剪词表\n");
+        return false;
+    }
+
+    PruneStats local;
+    memset(&local, 0, sizeof(local));
+    HashTable *vocab = build_pruned_vocab(col, options, &local);
+    if (!vocab) return false;
+
+    bool global = options->min_df > 1 || options->max_df > 0 || options->max_vocab > 0;
+    size_t threads = options->threads ? options->threads : matrix_engine_default_threads();
+    if (threads > col->count) threads = col->count;
+    if (threads == 0) threads = 1;
+
+    PruneWorker *workers = (PruneWorker*)calloc(threads, sizeof(PruneWorker));
+    pthread_t *ids = (pthread_t*)malloc(threads * sizeof(pthread_t));
+    bool ok = workers && ids;
+    size_t started = 0;
+
+    // 文档按连续区间分给各线程；全局词表只读，可以共享
+    for (size_t t = 0; ok && t < threads; t++) {
+        workers[t].col = col;
+        workers[t].vocab = global ? vocab : NULL;
+        workers[t].top_terms = options->top_terms;
+        workers[t].begin = col->count * t / threads;
+        workers[t].end = col->count * (t + 1) / threads;
+        workers[t].ok = true;
+    }
+    for (; ok && started < threads; started++) {
+        if (pthread_create(&ids[started], NULL, prune_worker, &workers[started]) != 0) break;
+    }
+    for (size_t t = 0; t < started; t++) {
+        pthread_join(ids[t], NULL);
+    }
+    // 无法创建的线程的区间在当前线程完成
+    for (size_t t = started; ok && t < threads; t++) {
+        prune_worker(&workers[t]);
+    }
+    for (size_t t = 0; ok && t < threads; t++) {
+        ok = workers[t].ok;
+        local.terms_after += workers[t].terms_after;
+    }
+
+    free(workers);
+    free(ids);
+    hash_table_destroy(vocab);
+    if (stats) *stats = local;
+    return ok;
+}
@@ -0,0 +1,256 @@
+#include "watcher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+#define WATCH_EVENT_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE)
+
+static volatile sig_atomic_t watch_stop_requested = 0;
+
+static void watch_signal_handler(int sig) {
+    (void)sig;
+    watch_stop_requested = 1;
+}
+
+// 一批待处理的文件名（去重）
+typedef struct PendingSet {
+    char **names;
+    size_t count;
+    size_t capacity;
+    bool rescan;    // 事件队列溢出，需要全量重新加载
+} PendingSet;
+
+static void pending_add(PendingSet *set, const char *name) {
+    for (size_t i = 0; i < set->count; i++) {
+        if (strcmp(set->names[i], name) == 0) return;
+    }
+
+    if (set->count >= set->capacity) {
+        size_t new_capacity = set->capacity ? set->capacity * 2 : 16;
+        char **new_names = realloc(set->names, new_capacity * sizeof(char*));
+        if (!new_names) {
+            set->rescan = true;
+            return;
+        }
+        set->names = new_names;
+        set->capacity = new_capacity;
+    }
+
+    set->names[set->count] = strdup(name);
+    if (set->names[set->count]) {
+        set->count++;
+    } else {
+        set->rescan = true;
+    }
+}
+
+static void pending_clear(PendingSet *set) {
+    for (size_t i = 0; i < set->count; i++) {
+        free(set->names[i]);
+    }
+    set->count = 0;
+    set->rescan = false;
+}
+
+static bool is_txt_file(const char *name) {
+    const char *dot = strrchr(name, '.');
+    return dot && strcmp(dot, ".txt") == 0;
+}
+
+// 读取当前可用的全部 inotify 事件
+static void drain_events(int fd, PendingSet *set) {
+    uint64_t buffer[1024];
+
+    for (;;) {
+        ssize_t len = read(fd, buffer, sizeof(buffer));
+        if (len <= 0) return;
+
+        const char *p = (const char*)buffer;
+        const char *end = p + len;
+        while (p < end) {
+            const struct inotify_event *event = (const struct inotify_event*)p;
+            if (event->mask & IN_Q_OVERFLOW) {
+                set->rescan = true;
+            } else if (event->len > 0 && is_txt_file(event->name)) {
+                pending_add(set, event->name);
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+// 重新处理单个文件：新建、修改或删除
+static void apply_change(const char *dir_path, const char *name, DocumentCollection *col,
+                         SimilarityMatrix **matrix_ptr, StopWords *stop_words) {
+    char filepath[512];
+    snprintf(filepath, sizeof(filepath), "%s/%s", dir_path, name);
+
+    size_t index;
+    bool known = collection_find_document(col, filepath, &index);
+
+    Document *doc = NULL;
+    struct stat path_stat;
+    if (stat(filepath, &path_stat) == 0 && S_ISREG(path_stat.st_mode)) {
+        doc = document_create(name);
+        if (doc && !(document_load_from_file(doc, filepath) &&
+                     document_process(doc, stop_words))) {
+            document_destroy(doc);
+            doc = NULL;
+        }
+    }
+
+    if (!doc) {
+        if (known) {
+            similarity_matrix_remove_document(*matrix_ptr, col, index);
+            printf("已移除文档: %s\n", name);
+        }
+        return;
+    }
+
+    bool ok;
+    if (known) {
+        ok = similarity_matrix_update_document(*matrix_ptr, col, index, doc);
+    } else if (*matrix_ptr) {
+        ok = similarity_matrix_add_document(*matrix_ptr, col, doc);
+    } else {
+        ok = collection_add_document(col, doc);
+        if (ok) *matrix_ptr = similarity_matrix_create(col);
+    }
+
+    if (ok) {
+        printf("%s文档: %s\n", known ? "已更新" : "已添加", name);
+    } else {
+        fprintf(stderr, "错误: 无法更新文档 %s\n", name);
+        document_destroy(doc);
+    }
+}
+
+// 全量加载目录
+static bool reload_all(const WatchOptions *options, StopWords *stop_words,
+                       DocumentCollection **col_ptr, SimilarityMatrix **matrix_ptr) {
+    similarity_matrix_destroy(*matrix_ptr);
+    collection_destroy(*col_ptr);
+    *matrix_ptr = NULL;
+
+    *col_ptr = load_documents_from_dir(options->dir_path, stop_words);
+    if (!*col_ptr) return false;
+
+    if ((*col_ptr)->count > 0) {
+        *matrix_ptr = similarity_matrix_create(*col_ptr);
+    }
+    return true;
+}
+
+// 原子地重写所有输出文件
+static void write_outputs(const WatchOptions *options, SimilarityMatrix *matrix) {
+    if (!matrix) return;
+
+    // 二进制矩阵同样先写临时文件再替换
+    if (options->binary) {
+        similarity_matrix_save_binary(matrix, options->output_file, options->binary);
+    } else {
+        similarity_matrix_save_csv_atomic(matrix, options->output_file);
+    }
+    if (options->report_file) {
+        save_top_pairs_report(matrix, options->top_n, options->report_file);
+    }
+}
+
+int watch_directory(const WatchOptions *options, StopWords *stop_words) {
+    if (!options || !options->dir_path || !options->output_file) return 1;
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "错误: 无法初始化 inotify\n");
+        return 1;
+    }
+
+    if (inotify_add_watch(fd, options->dir_path, WATCH_EVENT_MASK) < 0) {
+        fprintf(stderr, "错误: 无法监视目录 %s\n", options->dir_path);
+        close(fd);
+        return 1;
+    }
+
+    // 先注册监视再全量加载，避免遗漏加载期间的变更
+    DocumentCollection *col = NULL;
+    SimilarityMatrix *matrix = NULL;
+    if (!reload_all(options, stop_words, &col, &matrix)) {
+        close(fd);
+        return 1;
+    }
+    write_outputs(options, matrix);
+    printf("正在监视目录 %s (%zu 个文档)，按 Ctrl+C 退出...\n",
+           options->dir_path, col->count);
+
+    watch_stop_requested = 0;
+    signal(SIGINT, watch_signal_handler);
+    signal(SIGTERM, watch_signal_handler);
+
+    PendingSet pending = {0};
+    struct pollfd pfd = {fd, POLLIN, 0};
+
+    while (!watch_stop_requested) {
+        // 等待第一个事件
+        int ready = poll(&pfd, 1, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "错误: 等待文件事件失败\n");
+            break;
+        }
+        drain_events(fd, &pending);
+
+        // 去抖：直到静默 debounce_ms 才处理这一批
+        while (!watch_stop_requested && poll(&pfd, 1, options->debounce_ms) > 0) {
+            drain_events(fd, &pending);
+        }
+        if (watch_stop_requested) break;
+        if (pending.count == 0 && !pending.rescan) continue;
+
+        clock_t start = clock();
+        if (pending.rescan) {
+            printf("事件队列溢出，重新加载整个目录...\n");
+            if (!reload_all(options, stop_words, &col, &matrix)) break;
+        } else {
+            for (size_t i = 0; i < pending.count; i++) {
+                apply_change(options->dir_path, pending.names[i], col, &matrix, stop_words);
+            }
+        }
+        write_outputs(options, matrix);
+
+        printf("已处理 %zu 个变更，当前 %zu 个文档，耗时 %.1f ms\n",
+               pending.count, col->count,
+               (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+        pending_clear(&pending);
+    }
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    pending_clear(&pending);
+    free(pending.names);
+    similarity_matrix_destroy(matrix);
+    collection_destroy(col);
+    close(fd);
+
+    printf("监视模式已退出\n");
+    return 0;
+}
+
+#else
+
+int watch_directory(const WatchOptions *options, StopWords *stop_words) {
+    (void)options;
+    (void)stop_words;
+    fprintf(stderr, "错误: 当前平台不支持监视模式 (需要 inotify)\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,211 @@
+#include "weighting.h"
+#include "sim_memory.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define DF_INITIAL_CAPACITY 1024
+#define BM25_K1 1.2
+#define BM25_B 0.75
+
+struct TermWeights {
+    WeightScheme scheme;
+    HashTable *df;          // 词项 -> 文档频率，降到 0 的词项被删除
+    size_t doc_count;
+    size_t total_length;    // 各文档词频之和的总和，用于 BM25 的平均文档长度
+};
+
+static const char *scheme_names[] = {"raw", "log", "tfidf", "bm25"};
+
+TermWeights* term_weights_create(WeightScheme scheme) {
+    if (scheme < WEIGHT_RAW || scheme > WEIGHT_BM25) return NULL;
+
+    TermWeights *tw = (TermWeights*)sim_memory_calloc(MEM_VECTOR, 1, sizeof(TermWeights));
+    if (!tw) return NULL;
+    tw->scheme = scheme;
+    tw->df = hash_table_create(DF_INITIAL_CAPACITY);
+    if (!tw->df) {
+        sim_memory_free(MEM_VECTOR, tw, sizeof(TermWeights));
+        return NULL;
+    }
+    return tw;
+}
+
+void term_weights_destroy(TermWeights *tw) {
+    if (!tw) return;
+    hash_table_destroy(tw->df);
+    sim_memory_free(MEM_VECTOR, tw, sizeof(TermWeights));
+}
+
+WeightScheme term_weights_scheme(const TermWeights *tw) {
+    return tw ? tw->scheme : WEIGHT_RAW;
+}
+
+// 文档长度：词频之和（词表裁剪后的词项才计入）
+static size_t document_length(const Document *doc) {
+    size_t length = 0;
+    HashTable *table = doc->word_freq;
+    for (size_t b = 0; b < table->capacity; b++) {
+        for (Entry *entry = table->buckets[b]; entry; entry = entry->next) {
+            length += (size_t)entry->value;
+        }
+    }
+    return length;
+}
+
+// 撤销文档的前 limit 个词项的文档频率
+static void df_remove(TermWeights *tw, const Document *doc, size_t limit) {
+    HashTable *table = doc->word_freq;
+    size_t n = 0;
+    for (size_t b = 0; b < table->capacity && n < limit; b++) {
+        for (Entry *entry = table->buckets[b]; entry && n < limit; entry = entry->next, n++) {
+            // 插入负值即累减
+            hash_table_insert(tw->df, entry->key, -1);
+            if (hash_table_get(tw->df, entry->key) <= 0) {
+                hash_table_remove(tw->df, entry->key);
+            }
+        }
+    }
+}
+
+bool term_weights_add_document(TermWeights *tw, const Document *doc) {
+    if (!tw || !doc || !doc->word_freq) return false;
+
+    HashTable *table = doc->word_freq;
+    size_t n = 0;
+    for (size_t b = 0; b < table->capacity; b++) {
+        for (Entry *entry = table->buckets[b]; entry; entry = entry->next) {
+            if (!hash_table_insert(tw->df, entry->key, 1)) {
+                df_remove(tw, doc, n);
+                return false;
+            }
+            n++;
+        }
+    }
+    tw->doc_count++;
+    tw->total_length += document_length(doc);
+    return true;
+}
+
+void term_weights_remove_document(TermWeights *tw, const Document *doc) {
+    if (!tw || !doc || !doc->word_freq || tw->doc_count == 0) return;
+
+    df_remove(tw, doc, doc->word_freq->size);
+    tw->doc_count--;
+    size_t length = document_length(doc);
+    tw->total_length = tw->total_length > length ? tw->total_length - length : 0;
+}
+
+size_t term_weights_doc_count(const TermWeights *tw) {
+    return tw ? tw->doc_count : 0;
+}
+
+size_t term_weights_df(const TermWeights *tw, const char *term) {
+    if (!tw || !term) return 0;
+    int df = hash_table_get(tw->df, term);
+    return df > 0 ? (size_t)df : 0;
+}
+
+static double idf_for(const TermWeights *tw, size_t df) {
+    double n = (double)tw->doc_count;
+    switch (tw->scheme) {
+    case WEIGHT_TFIDF:
+        return log((n + 1.0) / ((double)df + 1.0)) + 1.0;
+    case WEIGHT_BM25:
+        return log(1.0 + (n - (double)df + 0.5) / ((double)df + 0.5));
+    default:
+        return 1.0;
+    }
+}
+
+double term_weights_idf(const TermWeights *tw, const char *term) {
+    if (!tw || !term) return 0.0;
+    return idf_for(tw, term_weights_df(tw, term));
+}
+
+// 二分查找分量位置
+static size_t find_key(const SparseVector *vec, uint64_t key) {
+    size_t lo = 0, hi = vec->size;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (vec->keys[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+SparseVector* term_weights_vector(const TermWeights *tw, const Document *doc) {
+    if (!tw || !doc || !doc->word_freq) return NULL;
+
+    // 先按词频建好有序的键，再把各分量替换为权重；
+    // 64 位哈希相同的词项共用一个分量，权重相加
+    SparseVector *vec = sparse_vector_from_table(doc->word_freq);
+    if (!vec) return NULL;
+    for (size_t i = 0; i < vec->size; i++) {
+        vec->values[i] = 0.0;
+    }
+
+    double length_ratio = 1.0;
+    if (tw->scheme == WEIGHT_BM25 && tw->total_length > 0) {
+        double average = (double)tw->total_length / (double)tw->doc_count;
+        length_ratio = (double)document_length(doc) / average;
+    }
+
+    HashTable *table = doc->word_freq;
+    for (size_t b = 0; b < table->capacity; b++) {
+        for (Entry *entry = table->buckets[b]; entry; entry = entry->next) {
+            double tf = (double)entry->value;
+            double weight;
+            switch (tw->scheme) {
+            case WEIGHT_LOG_TF:
+                weight = 1.0 + log(tf);
+                break;
+            case WEIGHT_TFIDF:
+                weight = tf * term_weights_idf(tw, entry->key);
+                break;
+            case WEIGHT_BM25:
+                weight = term_weights_idf(tw, entry->key) * tf * (BM25_K1 + 1.0) /
+                         (tf + BM25_K1 * (1.0 - BM25_B + BM25_B * length_ratio));
+                break;
+            default:
+                weight = tf;
+                break;
+            }
+            vec->values[find_key(vec, term_hash64(entry->key))] += weight;
+        }
+    }
+
+    // 预先归一化，相似度计算只剩点积
+    double sum = 0.0;
+    for (size_t i = 0; i < vec->size; i++) {
+        sum += vec->values[i] * vec->values[i];
+    }
+    double norm = sqrt(sum);
+    if (norm > 0) {
+        for (size_t i = 0; i < vec->size; i++) {
+            vec->values[i] /= norm;
+        }
+        vec->norm = 1.0;
+    } else {
+        vec->norm = 0.0;
+    }
+    return vec;
+}
+
+bool weight_scheme_parse(const char *name, WeightScheme *scheme) {
+    if (!name) return false;
+    for (int i = WEIGHT_RAW; i <= WEIGHT_BM25; i++) {
+        if (strcmp(name, scheme_names[i]) == 0) {
+            if (scheme) *scheme = (WeightScheme)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* weight_scheme_name(WeightScheme scheme) {
+    return scheme >= WEIGHT_RAW && scheme <= WEIGHT_BM25 ? scheme_names[scheme] : "unknown";
+}
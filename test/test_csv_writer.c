@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "csv_writer.h"
+#include "matrix_engine.h"
+#include "test_fixtures.h"
+
+#define DOC_COUNT 41
+#define CSV_PATH "build/test_csv_writer.csv"
+#define REF_PATH "build/test_csv_reference.csv"
+
+static DocumentCollection* make_collection() {
+    TestCorpus corpus = test_corpus_create(DOC_COUNT, 5, 10, 3, 14);
+    DocumentCollection *col = test_collection_create(&corpus);
+    test_corpus_destroy(&corpus);
+    return col;
+}
+
+static void check_cell(double value) {
+    char expected[CSV_CELL_MAX], actual[CSV_CELL_MAX];
+    snprintf(expected, sizeof(expected), "%.4f", value);
+    size_t len = csv_format_cell(actual, value);
+    actual[len] = '\0';
+    if (strcmp(expected, actual) != 0) {
+        printf("不一致: %.17g -> %s / %s\n", value, expected, actual);
+    }
+    assert(strcmp(expected, actual) == 0);
+}
+
+void test_format_cell() {
+    printf("测试定点格式化...\n");
+
+    // 边界值与恰好落在进位点上的二进制小数
+    double special[] = {
+        0.0, -0.0, 1.0, -1.0, 0.5, 0.00005, 0.00015, 0.99995, 0.999949999,
+        0.03125, 0.09375, 1.0 / 3, 2.0 / 3, -0.00001, 9999.99995, 12345.6789,
+        1e300, -1e300, INFINITY, -INFINITY, NAN
+    };
+    for (size_t i = 0; i < sizeof(special) / sizeof(special[0]); i++) {
+        check_cell(special[i]);
+    }
+
+    // k / 2^m 形式的值在第 5 位小数上可能恰为 5
+    for (int k = 0; k <= 4096; k++) {
+        check_cell(k / 4096.0);
+        check_cell(-k / 4096.0);
+    }
+
+    srand(3);
+    for (int i = 0; i < 200000; i++) {
+        double value = (double)rand() / RAND_MAX;
+        check_cell(value);
+        check_cell(value * 100 - 50);
+        check_cell((double)(float)value);
+    }
+
+    printf("定点格式化测试通过！\n");
+}
+
+// 与原 fprintf 实现逐字节比较
+static void write_reference(SimilarityMatrix *matrix, const char *path) {
+    FILE *file = fopen(path, "w");
+    assert(file != NULL);
+    fprintf(file, "Filename");
+    for (size_t i = 0; i < matrix->size; i++) {
+        fprintf(file, ",%s", matrix->filenames[i]);
+    }
+    fprintf(file, "\n");
+    for (size_t i = 0; i < matrix->size; i++) {
+        fprintf(file, "%s", matrix->filenames[i]);
+        for (size_t j = 0; j < matrix->size; j++) {
+            fprintf(file, ",%.4f", matrix->matrix[i][j]);
+        }
+        fprintf(file, "\n");
+    }
+    fclose(file);
+}
+
+static bool files_equal(const char *path1, const char *path2) {
+    FILE *f1 = fopen(path1, "rb");
+    FILE *f2 = fopen(path2, "rb");
+    assert(f1 && f2);
+
+    bool equal = true;
+    int c1, c2;
+    do {
+        c1 = fgetc(f1);
+        c2 = fgetc(f2);
+        if (c1 != c2) equal = false;
+    } while (equal && c1 != EOF);
+
+    fclose(f1);
+    fclose(f2);
+    return equal;
+}
+
+void test_csv_identical() {
+    printf("测试CSV输出逐字节一致...\n");
+
+    DocumentCollection *col = make_collection();
+    SimilarityMatrix *matrix = similarity_matrix_create(col);
+    write_reference(matrix, REF_PATH);
+
+    assert(similarity_matrix_save_csv(matrix, CSV_PATH));
+    assert(files_equal(REF_PATH, CSV_PATH));
+
+    // 流式写出：多线程计算的同时按行输出
+    SimilarityMatrix *streamed = similarity_matrix_create_streaming_csv(col, 4, CSV_PATH, NULL);
+    assert(streamed != NULL);
+    assert(files_equal(REF_PATH, CSV_PATH));
+
+    similarity_matrix_destroy(streamed);
+    similarity_matrix_destroy(matrix);
+    collection_destroy(col);
+    remove(CSV_PATH);
+    remove(REF_PATH);
+    printf("CSV一致性测试通过！\n");
+}
+
+typedef struct RowLog {
+    size_t next;
+    SimilarityMatrix *expected;
+    size_t stop_after;
+} RowLog;
+
+static bool check_row(size_t row, const double *values, size_t count, void *userdata) {
+    RowLog *log = (RowLog*)userdata;
+    assert(row == log->next);
+    assert(count == log->expected->size);
+    assert(memcmp(values, log->expected->matrix[row], count * sizeof(double)) == 0);
+    log->next++;
+    return log->next < log->stop_after;
+}
+
+void test_parallel_engine() {
+    printf("测试多线程矩阵引擎...\n");
+
+    DocumentCollection *col = make_collection();
+    SimilarityMatrix *serial = similarity_matrix_create(col);
+
+    size_t thread_counts[] = {1, 3, 8, 100};
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        RowLog log = {0, serial, DOC_COUNT + 1};
+        SimilarityMatrix *parallel = similarity_matrix_create_parallel(col, thread_counts[t],
+                                                                       check_row, &log);
+        assert(parallel != NULL);
+        assert(log.next == DOC_COUNT);
+        for (size_t i = 0; i < DOC_COUNT; i++) {
+            assert(memcmp(parallel->matrix[i], serial->matrix[i], DOC_COUNT * sizeof(double)) == 0);
+        }
+        similarity_matrix_destroy(parallel);
+    }
+
+    // 回调返回 false 时中止
+    RowLog log = {0, serial, 5};
+    assert(similarity_matrix_create_parallel(col, 2, check_row, &log) == NULL);
+    assert(log.next == 5);
+
+    similarity_matrix_destroy(serial);
+    collection_destroy(col);
+    printf("多线程矩阵引擎测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("CSV写出与并行引擎测试套件\n");
+    printf("========================================\n\n");
+
+    test_format_cell();
+    test_csv_identical();
+    test_parallel_engine();
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
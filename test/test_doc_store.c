@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "doc_store.h"
+#include "test_fixtures.h"
+
+#define DOC_COUNT 12
+
+static TestCorpus corpus;
+
+static void assert_same_matrix(SimilarityMatrix *a, SimilarityMatrix *b) {
+    assert(a && b);
+    assert(a->size == b->size);
+    for (size_t i = 0; i < a->size; i++) {
+        assert(strcmp(a->filenames[i], b->filenames[i]) == 0);
+        assert(memcmp(a->matrix[i], b->matrix[i], a->size * sizeof(double)) == 0);
+    }
+}
+
+void test_store_matches_direct() {
+    printf("测试文档仓库结果与直接计算一致...\n");
+
+    StopWords *sw = stop_words_create();
+    DocumentStore *store = doc_store_create(sw, 1 << 20, 1024);
+    assert(store != NULL);
+
+    SimilarityMatrix *expected = similarity_matrix_from_buffers(corpus.names, corpus.buffers,
+                                                                corpus.lengths, DOC_COUNT, sw);
+    SimilarityMatrix *first = doc_store_matrix(store, corpus.names, corpus.buffers, corpus.lengths, DOC_COUNT);
+    assert_same_matrix(expected, first);
+
+    DocStoreStats stats;
+    doc_store_get_stats(store, &stats);
+    assert(stats.documents == DOC_COUNT);
+    assert(stats.doc_misses == DOC_COUNT);
+    assert(stats.doc_hits == 0);
+    assert(stats.pair_hits == 0);
+
+    // 重复提交：不再分词，所有文档对命中缓存
+    SimilarityMatrix *second = doc_store_matrix(store, corpus.names, corpus.buffers, corpus.lengths, DOC_COUNT);
+    assert_same_matrix(expected, second);
+    doc_store_get_stats(store, &stats);
+    assert(stats.doc_hits == DOC_COUNT);
+    assert(stats.pair_hits == DOC_COUNT * (DOC_COUNT - 1) / 2);
+
+    // 子集与新增文档混合提交，只处理新内容
+    const char *mixed_names[] = {"new.txt", "doc03.txt", "empty.txt", "renamed.txt"};
+    const char *mixed_buffers[] = {"omega omega alpha", corpus.buffers[3], "", corpus.buffers[5]};
+    const size_t mixed_lengths[] = {17, corpus.lengths[3], 0, corpus.lengths[5]};
+    SimilarityMatrix *mixed = doc_store_matrix(store, mixed_names, mixed_buffers, mixed_lengths, 4);
+    SimilarityMatrix *mixed_expected = similarity_matrix_from_buffers(mixed_names, mixed_buffers,
+                                                                      mixed_lengths, 4, sw);
+    assert_same_matrix(mixed_expected, mixed);
+    assert(mixed->size == 3);
+    doc_store_get_stats(store, &stats);
+    assert(stats.documents == DOC_COUNT + 1);
+    assert(stats.doc_misses == DOC_COUNT + 1);
+
+    similarity_matrix_destroy(mixed_expected);
+    similarity_matrix_destroy(mixed);
+    similarity_matrix_destroy(second);
+    similarity_matrix_destroy(first);
+    similarity_matrix_destroy(expected);
+    doc_store_destroy(store);
+    stop_words_destroy(sw);
+    printf("文档仓库一致性测试通过！\n");
+}
+
+void test_store_dedup() {
+    printf("测试内容哈希去重...\n");
+
+    DocumentStore *store = doc_store_create(NULL, 1 << 20, 0);
+    const char *dup_names[] = {"a.txt", "b.txt", "c.txt"};
+    const char *dup_buffers[] = {"same words here", "same words here", "other words"};
+    const size_t dup_lengths[] = {15, 15, 11};
+
+    SimilarityMatrix *matrix = doc_store_matrix(store, dup_names, dup_buffers, dup_lengths, 3);
+    assert(matrix != NULL && matrix->size == 3);
+    assert(strcmp(matrix->filenames[1], "b.txt") == 0);
+
+    DocStoreStats stats;
+    doc_store_get_stats(store, &stats);
+    assert(stats.documents == 2);
+    assert(stats.doc_hits == 1);
+
+    similarity_matrix_destroy(matrix);
+    doc_store_destroy(store);
+    printf("内容哈希去重测试通过！\n");
+}
+
+void test_store_eviction() {
+    printf("测试LRU淘汰...\n");
+
+    StopWords *sw = stop_words_create();
+    // 预算极小：每次调用结束后只保留本次用到的文档
+    DocumentStore *store = doc_store_create(sw, 1, 16);
+    SimilarityMatrix *expected = similarity_matrix_from_buffers(corpus.names, corpus.buffers,
+                                                                corpus.lengths, DOC_COUNT, sw);
+
+    SimilarityMatrix *first = doc_store_matrix(store, corpus.names, corpus.buffers, corpus.lengths, 6);
+    SimilarityMatrix *second = doc_store_matrix(store, corpus.names + 6, corpus.buffers + 6, corpus.lengths + 6, 6);
+    DocStoreStats stats;
+    doc_store_get_stats(store, &stats);
+    assert(stats.evictions == 6);
+    assert(stats.documents == 6);
+
+    // 被淘汰后重新提交，结果不变
+    SimilarityMatrix *all = doc_store_matrix(store, corpus.names, corpus.buffers, corpus.lengths, DOC_COUNT);
+    assert_same_matrix(expected, all);
+
+    doc_store_clear(store);
+    doc_store_get_stats(store, &stats);
+    assert(stats.documents == 0 && stats.bytes == 0);
+
+    similarity_matrix_destroy(all);
+    similarity_matrix_destroy(second);
+    similarity_matrix_destroy(first);
+    similarity_matrix_destroy(expected);
+    doc_store_destroy(store);
+    stop_words_destroy(sw);
+    printf("LRU淘汰测试通过！\n");
+}
+
+void test_store_ngram() {
+    printf("测试切分长度参与缓存键...\n");
+
+    // 文本相似度 / 相似文本度：双字片段一半相同，单字完全相同
+    const char *cn_names[] = {"a.txt", "b.txt"};
+    const char *cn_buffers[] = {"\xE6\x96\x87\xE6\x9C\xAC\xE7\x9B\xB8\xE4\xBC\xBC\xE5\xBA\xA6",
+                                "\xE7\x9B\xB8\xE4\xBC\xBC\xE6\x96\x87\xE6\x9C\xAC\xE5\xBA\xA6"};
+    const size_t cn_lengths[] = {15, 15};
+
+    StopWords *sw = stop_words_create();
+    DocumentStore *store = doc_store_create(sw, 1 << 20, 16);
+    SimilarityMatrix *bigram = doc_store_matrix(store, cn_names, cn_buffers, cn_lengths, 2);
+    assert(fabs(bigram->matrix[0][1] - 0.5) < 1e-9);
+
+    // 改变切分长度后不能命中按旧长度处理的向量或文档对
+    assert(stop_words_set_cjk_ngram(sw, 1));
+    SimilarityMatrix *unigram = doc_store_matrix(store, cn_names, cn_buffers, cn_lengths, 2);
+    assert(fabs(unigram->matrix[0][1] - 1.0) < 1e-9);
+    DocStoreStats stats;
+    doc_store_get_stats(store, &stats);
+    assert(stats.doc_misses == 4 && stats.doc_hits == 0 && stats.pair_hits == 0);
+
+    similarity_matrix_destroy(bigram);
+    similarity_matrix_destroy(unigram);
+    doc_store_destroy(store);
+    stop_words_destroy(sw);
+    printf("切分长度缓存键测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("常驻文档仓库测试套件\n");
+    printf("========================================\n\n");
+
+    corpus = test_corpus_create(DOC_COUNT, 9, 10, 3, 12);
+    test_store_matches_direct();
+    test_store_dedup();
+    test_store_eviction();
+    test_store_ngram();
+
+    test_corpus_destroy(&corpus);
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
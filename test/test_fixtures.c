@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "test_fixtures.h"
+
+const char *const test_words[TEST_WORD_COUNT] = {
+    "alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta", "iota", "kappa",
+    "lambda", "omicron", "sigma", "omega", "rho", "tau"
+};
+
+TestCorpus test_corpus_create(size_t count, unsigned seed, size_t vocab, int min_words, int max_words) {
+    assert(vocab > 0 && vocab <= TEST_WORD_COUNT && min_words <= max_words);
+
+    TestCorpus corpus;
+    corpus.count = count;
+    corpus.names = (const char**)malloc((count ? count : 1) * sizeof(char*));
+    corpus.buffers = (const char**)malloc((count ? count : 1) * sizeof(char*));
+    corpus.lengths = (size_t*)malloc((count ? count : 1) * sizeof(size_t));
+    assert(corpus.names && corpus.buffers && corpus.lengths);
+
+    srand(seed);
+    for (size_t d = 0; d < count; d++) {
+        char *name = (char*)malloc(32);
+        // 最长的词 7 个字节，加一个空格
+        char *text = (char*)malloc((size_t)max_words * 8 + 1);
+        assert(name && text);
+        snprintf(name, 32, "doc%02zu.txt", d);
+        text[0] = '\0';
+        int words = min_words + rand() % (max_words - min_words + 1);
+        for (int w = 0; w < words; w++) {
+            strcat(text, test_words[(size_t)rand() % vocab]);
+            strcat(text, " ");
+        }
+        corpus.names[d] = name;
+        corpus.buffers[d] = text;
+        corpus.lengths[d] = strlen(text);
+    }
+    return corpus;
+}
+
+void test_corpus_destroy(TestCorpus *corpus) {
+    for (size_t d = 0; d < corpus->count; d++) {
+        free((char*)corpus->names[d]);
+        free((char*)corpus->buffers[d]);
+    }
+    free(corpus->names);
+    free(corpus->buffers);
+    free(corpus->lengths);
+    corpus->count = 0;
+}
+
+DocumentCollection* test_collection_create(const TestCorpus *corpus) {
+    DocumentCollection *col = collection_create(corpus->count);
+    assert(col != NULL);
+    for (size_t d = 0; d < corpus->count; d++) {
+        Document *doc = document_create(corpus->names[d]);
+        doc->content = strdup(corpus->buffers[d]);
+        assert(document_process(doc, NULL));
+        collection_add_document(col, doc);
+    }
+    return col;
+}
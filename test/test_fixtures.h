@@ -0,0 +1,26 @@
+#ifndef TEST_FIXTURES_H
+#define TEST_FIXTURES_H
+
+#include "file_manager.h"
+
+// 测试共用的随机语料：每篇文档由固定词表前 vocab 个词随机组成，
+// 种子相同则内容相同；文件名为 doc00.txt、doc01.txt ...
+#define TEST_WORD_COUNT 16
+
+extern const char *const test_words[TEST_WORD_COUNT];
+
+typedef struct TestCorpus {
+    const char **names;
+    const char **buffers;
+    size_t *lengths;
+    size_t count;
+} TestCorpus;
+
+// 每篇 min_words ~ max_words 个词；之后的 rand() 序列接着生成语料时的状态
+TestCorpus test_corpus_create(size_t count, unsigned seed, size_t vocab, int min_words, int max_words);
+void test_corpus_destroy(TestCorpus *corpus);
+
+// 由语料建立已分词（不去停用词）的文档集合
+DocumentCollection* test_collection_create(const TestCorpus *corpus);
+
+#endif
@@ -1,7 +1,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <string.h>
 #include "hashtable.h"
+#include "sim_memory.h"
 
 void test_hash_table_basic() {
     printf("测试基本哈希表操作...\n");
@@ -58,6 +60,45 @@ void test_hash_table_resize() {
     printf("扩容测试通过！\n");
 }
 
+void test_hash_table_pooled() {
+    printf("测试内存池哈希表...\n");
+    
+    MemoryStats before, during, after;
+    sim_memory_get(&before);
+    
+    HashTable *table = hash_table_create_pooled(5);
+    assert(table != NULL && table->pool != NULL);
+    
+    // 扩容后条目与键仍然有效
+    for (int i = 0; i < 1000; i++) {
+        char key[20];
+        sprintf(key, "key%d", i);
+        assert(hash_table_insert(table, key, i));
+    }
+    assert(hash_table_insert(table, "key7", 1));
+    for (int i = 0; i < 1000; i++) {
+        char key[20];
+        sprintf(key, "key%d", i);
+        assert(hash_table_get(table, key) == (i == 7 ? 8 : i));
+    }
+    assert(table->unique_words == 1000);
+    
+    // 删除只解除链接
+    assert(hash_table_remove(table, "key3"));
+    assert(hash_table_get(table, "key3") == -1);
+    assert(table->size == 999);
+    
+    // 内存池按块计入哈希表的内存
+    sim_memory_get(&during);
+    assert(during.current[MEM_HASHTABLE] > before.current[MEM_HASHTABLE] + 1000 * sizeof(Entry));
+    
+    hash_table_destroy(table);
+    sim_memory_get(&after);
+    assert(after.current[MEM_HASHTABLE] == before.current[MEM_HASHTABLE]);
+    
+    printf("内存池哈希表测试通过！\n");
+}
+
 void test_hash_function() {
     printf("测试哈希函数...\n");
     
@@ -101,6 +142,9 @@ int main() {
     test_hash_table_resize();
     printf("\n");
     
+    test_hash_table_pooled();
+    printf("\n");
+    
     printf("所有测试通过！\n");
     return 0;
 }
\ No newline at end of file
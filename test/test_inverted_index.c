@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <sys/stat.h>
+#include "inverted_index.h"
+#include "vector_math.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#define make_dir(path) _mkdir(path)
+#else
+#define make_dir(path) mkdir(path, 0755)
+#endif
+
+#define TEST_DIR "build/test_index_docs"
+#define TEST_INDEX "build/test_index.tsix"
+#define DOC_COUNT 300
+#define EPSILON 0.000001
+
+static const char *vocab[] = {
+    "apple", "banana", "cherry", "delta", "echo", "fox", "grape", "hotel",
+    "india", "juliet", "kilo", "lima", "mango", "november", "oscar", "papa",
+    "quebec", "romeo", "sierra", "tango", "uniform", "victor", "whiskey", "yankee"
+};
+
+// 生成测试语料：词频服从偏斜分布，保证倒排表跨越多个块
+static void write_corpus() {
+    make_dir("build");
+    make_dir(TEST_DIR);
+
+    srand(42);
+    size_t vocab_size = sizeof(vocab) / sizeof(vocab[0]);
+    for (int d = 0; d < DOC_COUNT; d++) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s/doc%03d.txt", TEST_DIR, d);
+        FILE *file = fopen(path, "w");
+        assert(file != NULL);
+
+        int words = 5 + rand() % 40;
+        for (int w = 0; w < words; w++) {
+            size_t a = (size_t)rand() % vocab_size;
+            size_t b = (size_t)rand() % vocab_size;
+            fprintf(file, "%s ", vocab[a < b ? a : b]);
+        }
+        fclose(file);
+    }
+}
+
+static Document* load_doc(int d) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/doc%03d.txt", TEST_DIR, d);
+    Document *doc = document_create(path);
+    assert(document_load_from_file(doc, path));
+    assert(document_process(doc, NULL));
+    return doc;
+}
+
+void test_index_build_and_open() {
+    printf("测试索引构建与打开...\n");
+
+    assert(inverted_index_build(TEST_DIR, NULL, TEST_INDEX));
+
+    InvertedIndex *idx = inverted_index_open(TEST_INDEX);
+    assert(idx != NULL);
+    assert(inverted_index_doc_count(idx) == DOC_COUNT);
+    assert(inverted_index_term_count(idx) == sizeof(vocab) / sizeof(vocab[0]));
+    assert(inverted_index_doc_name(idx, DOC_COUNT) == NULL);
+
+    inverted_index_close(idx);
+    assert(inverted_index_open("build/nonexistent.tsix") == NULL);
+    printf("索引构建测试通过！\n");
+}
+
+void test_index_query_matches_brute_force() {
+    printf("测试 WAND 查询与暴力计算一致...\n");
+
+    InvertedIndex *idx = inverted_index_open(TEST_INDEX);
+    assert(idx != NULL);
+
+    Document *docs[DOC_COUNT];
+    for (int d = 0; d < DOC_COUNT; d++) {
+        docs[d] = load_doc(d);
+    }
+
+    const size_t top_k = 5;
+    IndexHit hits[5];
+    for (int q = 0; q < DOC_COUNT; q += 37) {
+        size_t count = inverted_index_query(idx, docs[q], top_k, hits);
+        assert(count == top_k);
+
+        // 自身一定排在第一
+        assert(fabs(hits[0].score - 1.0) < EPSILON);
+
+        // 每个命中分数与直接计算的余弦相似度一致
+        for (size_t i = 0; i < count; i++) {
+            const char *name = inverted_index_doc_name(idx, hits[i].doc_id);
+            int d = atoi(name + 3);
+            double expected = document_cosine_similarity(docs[q], docs[d]);
+            assert(fabs(hits[i].score - expected) < EPSILON);
+            if (i > 0) assert(hits[i - 1].score >= hits[i].score);
+        }
+
+        // 没有被遗漏的更高分文档
+        size_t better = 0;
+        for (int d = 0; d < DOC_COUNT; d++) {
+            if (document_cosine_similarity(docs[q], docs[d]) > hits[count - 1].score + EPSILON) {
+                better++;
+            }
+        }
+        assert(better < top_k);
+    }
+
+    for (int d = 0; d < DOC_COUNT; d++) {
+        document_destroy(docs[d]);
+    }
+    inverted_index_close(idx);
+    printf("WAND 查询测试通过！\n");
+}
+
+void test_index_query_unknown_terms() {
+    printf("测试查询未收录词项...\n");
+
+    InvertedIndex *idx = inverted_index_open(TEST_INDEX);
+    assert(idx != NULL);
+
+    Document *query = document_create("query.txt");
+    query->content = strdup("zebra zulu");
+    assert(document_process(query, NULL));
+
+    IndexHit hits[3];
+    assert(inverted_index_query(idx, query, 3, hits) == 0);
+
+    document_destroy(query);
+    inverted_index_close(idx);
+    printf("未收录词项测试通过！\n");
+}
+
+// 复制索引文件并在 offset 处写入 8 字节的 value
+static void write_corrupted(const char *path, size_t offset, uint64_t value) {
+    FILE *in = fopen(TEST_INDEX, "rb");
+    assert(in != NULL);
+    fseek(in, 0, SEEK_END);
+    size_t size = (size_t)ftell(in);
+    fseek(in, 0, SEEK_SET);
+    unsigned char *data = (unsigned char*)malloc(size);
+    assert(data && fread(data, 1, size, in) == size);
+    fclose(in);
+
+    for (int b = 0; b < 8; b++) data[offset + b] = (unsigned char)(value >> (8 * b));
+    FILE *out = fopen(path, "wb");
+    assert(out && fwrite(data, 1, size, out) == size);
+    fclose(out);
+    free(data);
+}
+
+void test_index_corrupted_offsets() {
+    printf("测试损坏的索引偏移...\n");
+
+    const char *path = "build/test_index_corrupt.tsix";
+    // 头部之后依次是文档表（16 字节/项）与词典（32 字节/项），字符串偏移在各项开头
+    size_t dict_offset = 64 + DOC_COUNT * 16;
+    write_corrupted(path, dict_offset, (uint64_t)1 << 40);
+    assert(inverted_index_open(path) == NULL);
+    write_corrupted(path, 64 + 16, UINT64_MAX);
+    assert(inverted_index_open(path) == NULL);
+    // 倒排表偏移越界
+    write_corrupted(path, dict_offset + 32 + 8, (uint64_t)1 << 40);
+    assert(inverted_index_open(path) == NULL);
+
+    remove(path);
+    printf("损坏偏移测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("倒排索引测试套件\n");
+    printf("========================================\n\n");
+
+    write_corpus();
+    test_index_build_and_open();
+    test_index_query_matches_brute_force();
+    test_index_query_unknown_terms();
+    test_index_corrupted_offsets();
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
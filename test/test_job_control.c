@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "job_control.h"
+#include "matrix_engine.h"
+#include "doc_store.h"
+#include "sim_context.h"
+#include "test_fixtures.h"
+
+#define DOC_COUNT 60
+
+static TestCorpus corpus;
+
+// 记录进度，在第 stop_after 次回调时取消
+typedef struct ProgressLog {
+    size_t calls;
+    size_t stop_after;
+    JobProgress last;
+    bool monotonic;
+} ProgressLog;
+
+static bool log_progress(const JobProgress *progress, void *userdata) {
+    ProgressLog *log = (ProgressLog*)userdata;
+    if (log->calls > 0 && progress->stage == log->last.stage && progress->done < log->last.done) {
+        log->monotonic = false;
+    }
+    log->last = *progress;
+    log->calls++;
+    return log->calls < log->stop_after;
+}
+
+void test_engine_progress() {
+    printf("测试矩阵引擎进度与取消...\n");
+
+    DocumentCollection *col = load_documents_from_buffers(corpus.names, corpus.buffers,
+                                                          corpus.lengths, DOC_COUNT, NULL);
+    SimilarityMatrix *serial = similarity_matrix_create(col);
+    size_t total = DOC_COUNT * (DOC_COUNT - 1) / 2;
+
+    size_t thread_counts[] = {1, 3};
+    for (size_t t = 0; t < 2; t++) {
+        ProgressLog log = {0, (size_t)-1, {JOB_STAGE_LOAD, 0, 0, 0}, true};
+        JobControl *job = job_control_create(log_progress, &log);
+        SimilarityMatrix *matrix = similarity_matrix_create_parallel_job(col, thread_counts[t],
+                                                                         NULL, NULL, job);
+        assert(matrix != NULL);
+        for (size_t i = 0; i < DOC_COUNT; i++) {
+            assert(memcmp(matrix->matrix[i], serial->matrix[i], DOC_COUNT * sizeof(double)) == 0);
+        }
+        assert(log.calls > 1 && log.monotonic);
+        assert(log.last.stage == JOB_STAGE_MATRIX);
+        assert(log.last.done == total && log.last.total == total);
+        similarity_matrix_destroy(matrix);
+        job_control_destroy(job);
+
+        // 回调返回 false 时取消
+        ProgressLog stop = {0, 3, {JOB_STAGE_LOAD, 0, 0, 0}, true};
+        job = job_control_create(log_progress, &stop);
+        assert(similarity_matrix_create_parallel_job(col, thread_counts[t], NULL, NULL, job) == NULL);
+        assert(job_control_cancelled(job));
+        assert(stop.calls == 3);
+        job_control_destroy(job);
+    }
+
+    // 直接由稀疏向量计算（服务端的快照路径）与按集合计算逐位一致
+    const char *vec_names[DOC_COUNT];
+    SparseVector *vectors[DOC_COUNT];
+    for (size_t i = 0; i < DOC_COUNT; i++) {
+        vec_names[i] = col->documents[i]->filename;
+        vectors[i] = document_vector(col->documents[i]);
+    }
+    SimilarityMatrix *from_vectors = similarity_matrix_create_from_vectors(vec_names, vectors, DOC_COUNT, 3);
+    assert(from_vectors && from_vectors->size == DOC_COUNT);
+    for (size_t i = 0; i < DOC_COUNT; i++) {
+        assert(strcmp(from_vectors->filenames[i], serial->filenames[i]) == 0);
+        assert(memcmp(from_vectors->matrix[i], serial->matrix[i], DOC_COUNT * sizeof(double)) == 0);
+    }
+    similarity_matrix_destroy(from_vectors);
+
+    // 事先取消的任务不做任何计算
+    JobControl *job = job_control_create(NULL, NULL);
+    job_control_cancel(job);
+    assert(similarity_matrix_create_parallel_job(col, 2, NULL, NULL, job) == NULL);
+    job_control_destroy(job);
+
+    similarity_matrix_destroy(serial);
+    collection_destroy(col);
+    printf("矩阵引擎进度与取消测试通过！\n");
+}
+
+void test_store_and_context_cancel() {
+    printf("测试文档仓库与上下文取消...\n");
+
+    StopWords *sw = stop_words_create();
+    DocumentStore *store = doc_store_create(sw, 1 << 20, 1024);
+    SimilarityMatrix *expected = similarity_matrix_from_buffers(corpus.names, corpus.buffers,
+                                                                corpus.lengths, DOC_COUNT, sw);
+
+    // 计算中途取消，仓库保持可用
+    ProgressLog stop = {0, DOC_COUNT + 5, {JOB_STAGE_LOAD, 0, 0, 0}, true};
+    JobControl *job = job_control_create(log_progress, &stop);
+    assert(doc_store_matrix_job(store, corpus.names, corpus.buffers, corpus.lengths, DOC_COUNT, job) == NULL);
+    assert(stop.last.stage == JOB_STAGE_MATRIX);
+    job_control_destroy(job);
+
+    ProgressLog log = {0, (size_t)-1, {JOB_STAGE_LOAD, 0, 0, 0}, true};
+    job = job_control_create(log_progress, &log);
+    SimilarityMatrix *matrix = doc_store_matrix_job(store, corpus.names, corpus.buffers,
+                                                    corpus.lengths, DOC_COUNT, job);
+    assert(matrix != NULL && matrix->size == DOC_COUNT);
+    for (size_t i = 0; i < DOC_COUNT; i++) {
+        assert(memcmp(matrix->matrix[i], expected->matrix[i], DOC_COUNT * sizeof(double)) == 0);
+    }
+    JobProgress progress;
+    job_control_get_progress(job, &progress);
+    assert(progress.stage == JOB_STAGE_MATRIX && progress.done == progress.total);
+    similarity_matrix_destroy(matrix);
+    job_control_destroy(job);
+
+    // 上下文：取消后返回 NULL 并给出原因
+    SimContext *ctx = sim_context_create(NULL);
+    job = job_control_create(NULL, NULL);
+    sim_context_set_job(ctx, job);
+    matrix = sim_context_matrix_from_buffers(ctx, corpus.names, corpus.buffers, corpus.lengths, DOC_COUNT);
+    assert(matrix != NULL);
+    job_control_get_progress(job, &progress);
+    size_t bytes = 0;
+    for (size_t i = 0; i < DOC_COUNT; i++) bytes += corpus.lengths[i];
+    assert(progress.bytes == bytes);
+    similarity_matrix_destroy(matrix);
+
+    job_control_cancel(job);
+    assert(sim_context_matrix_from_buffers(ctx, corpus.names, corpus.buffers, corpus.lengths, DOC_COUNT) == NULL);
+    assert(strcmp(sim_context_last_error(ctx), "任务已取消") == 0);
+    sim_context_set_job(ctx, NULL);
+    matrix = sim_context_matrix_from_buffers(ctx, corpus.names, corpus.buffers, corpus.lengths, DOC_COUNT);
+    assert(matrix != NULL);
+
+    similarity_matrix_destroy(matrix);
+    job_control_destroy(job);
+    sim_context_destroy(ctx);
+    similarity_matrix_destroy(expected);
+    doc_store_destroy(store);
+    stop_words_destroy(sw);
+    printf("文档仓库与上下文取消测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("进度与取消测试套件\n");
+    printf("========================================\n\n");
+
+    corpus = test_corpus_create(DOC_COUNT, 23, 10, 3, 14);
+    test_engine_progress();
+    test_store_and_context_cancel();
+
+    test_corpus_destroy(&corpus);
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include "job_queue.h"
+#include "test_fixtures.h"
+
+#define SMALL_COUNT 10
+#define LARGE_COUNT 800
+
+static uint64_t submit(JobQueue *queue, const TestCorpus *corpus) {
+    uint64_t id = 0;
+    assert(job_queue_submit(queue, corpus->names, corpus->buffers, corpus->lengths, corpus->count, &id));
+    assert(id > 0);
+    return id;
+}
+
+static JobState wait_finished(JobQueue *queue, uint64_t id) {
+    JobStatus status;
+    for (;;) {
+        assert(job_queue_status(queue, id, &status));
+        if (status.state >= JOB_STATE_DONE) return status.state;
+        usleep(1000);
+    }
+}
+
+void test_results() {
+    printf("测试任务结果与直接计算一致...\n");
+
+    TestCorpus corpus = test_corpus_create(SMALL_COUNT, 1, TEST_WORD_COUNT, 1, 12);
+    JobQueueConfig config = job_queue_default_config();
+    config.workers = 3;
+    JobQueue *queue = job_queue_create(&config);
+    assert(queue != NULL);
+
+    uint64_t id = submit(queue, &corpus);
+    assert(wait_finished(queue, id) == JOB_STATE_DONE);
+
+    JobStatus status;
+    assert(job_queue_status(queue, id, &status));
+    assert(status.documents == SMALL_COUNT);
+    assert(status.result_bytes > SMALL_COUNT * SMALL_COUNT * sizeof(double));
+    assert(status.progress.stage == JOB_STAGE_MATRIX);
+    assert(status.progress.done == status.progress.total);
+    assert(strcmp(job_state_name(status.state), "done") == 0);
+
+    SimilarityMatrix *expected = similarity_matrix_from_buffers(corpus.names, corpus.buffers,
+                                                                corpus.lengths, corpus.count, NULL);
+    SimilarityMatrix *result = job_queue_copy_result(queue, id);
+    assert(result && result->size == expected->size);
+    for (size_t i = 0; i < result->size; i++) {
+        assert(strcmp(result->filenames[i], expected->filenames[i]) == 0);
+        assert(memcmp(result->matrix[i], expected->matrix[i], result->size * sizeof(double)) == 0);
+    }
+    similarity_matrix_destroy(result);
+    similarity_matrix_destroy(expected);
+
+    // 没有有效文档的任务失败并给出原因
+    const char *empty_names[] = {"empty.txt"};
+    const char *empty_buffers[] = {""};
+    const size_t empty_lengths[] = {0};
+    uint64_t failed;
+    assert(job_queue_submit(queue, empty_names, empty_buffers, empty_lengths, 1, &failed));
+    assert(wait_finished(queue, failed) == JOB_STATE_FAILED);
+    assert(job_queue_status(queue, failed, &status));
+    assert(status.error[0] != '\0');
+    assert(job_queue_copy_result(queue, failed) == NULL);
+
+    // 删除后记录不再存在
+    assert(job_queue_remove(queue, id));
+    assert(!job_queue_status(queue, id, &status));
+    assert(!job_queue_remove(queue, id));
+
+    job_queue_destroy(queue);
+    test_corpus_destroy(&corpus);
+    printf("任务结果测试通过！\n");
+}
+
+void test_small_jobs_not_starved() {
+    printf("测试小任务不被大任务阻塞...\n");
+
+    TestCorpus small = test_corpus_create(SMALL_COUNT, 2, TEST_WORD_COUNT, 1, 8);
+    TestCorpus large = test_corpus_create(LARGE_COUNT, 3, TEST_WORD_COUNT, 1, 60);
+    JobQueueConfig config = job_queue_default_config();
+    config.workers = 2;
+    config.small_job_bytes = 4096;
+    JobQueue *queue = job_queue_create(&config);
+
+    uint64_t large_ids[3];
+    for (int i = 0; i < 3; i++) large_ids[i] = submit(queue, &large);
+    uint64_t small_id = submit(queue, &small);
+
+    JobStatus status;
+    assert(job_queue_status(queue, large_ids[2], &status));
+    assert(status.state == JOB_STATE_QUEUED);
+
+    // 小任务由专用线程处理，不必等待排在前面的大任务
+    assert(wait_finished(queue, small_id) == JOB_STATE_DONE);
+    assert(job_queue_status(queue, large_ids[2], &status));
+    assert(status.state == JOB_STATE_QUEUED || status.state == JOB_STATE_RUNNING);
+
+    for (int i = 0; i < 3; i++) {
+        assert(wait_finished(queue, large_ids[i]) == JOB_STATE_DONE);
+    }
+
+    job_queue_destroy(queue);
+    test_corpus_destroy(&small);
+    test_corpus_destroy(&large);
+    printf("调度测试通过！\n");
+}
+
+void test_limits_and_cancel() {
+    printf("测试队列上限、取消与结果预算...\n");
+
+    TestCorpus small = test_corpus_create(SMALL_COUNT, 4, TEST_WORD_COUNT, 1, 8);
+    TestCorpus large = test_corpus_create(LARGE_COUNT, 5, TEST_WORD_COUNT, 1, 60);
+    size_t small_bytes = 0;
+    for (size_t d = 0; d < small.count; d++) small_bytes += small.lengths[d];
+
+    // 输入超过排队字节上限时拒绝
+    JobQueueConfig config = job_queue_default_config();
+    config.workers = 2;
+    config.max_pending_bytes = small_bytes - 1;
+    JobQueue *queue = job_queue_create(&config);
+    uint64_t id = 0;
+    assert(!job_queue_submit(queue, small.names, small.buffers, small.lengths, small.count, &id));
+    assert(!job_queue_submit(queue, small.names, small.buffers, small.lengths, 0, &id));
+    job_queue_destroy(queue);
+
+    // 运行中与排队中的任务都可以取消
+    config = job_queue_default_config();
+    config.workers = 2;
+    queue = job_queue_create(&config);
+    uint64_t running = submit(queue, &large);
+    uint64_t queued = submit(queue, &large);
+    assert(job_queue_cancel(queue, queued));
+    assert(job_queue_cancel(queue, running));
+    assert(wait_finished(queue, queued) == JOB_STATE_CANCELLED);
+    assert(wait_finished(queue, running) == JOB_STATE_CANCELLED);
+    assert(job_queue_copy_result(queue, running) == NULL);
+    job_queue_destroy(queue);
+
+    // 结果预算只够保留一个结果：较早完成的结果被释放
+    config = job_queue_default_config();
+    config.workers = 2;
+    config.result_budget = SMALL_COUNT * SMALL_COUNT * sizeof(double) + 1024;
+    config.max_finished = 2;
+    queue = job_queue_create(&config);
+    uint64_t first = submit(queue, &small);
+    assert(wait_finished(queue, first) == JOB_STATE_DONE);
+    uint64_t second = submit(queue, &small);
+    assert(wait_finished(queue, second) == JOB_STATE_DONE);
+    assert(wait_finished(queue, first) == JOB_STATE_EXPIRED);
+    assert(job_queue_copy_result(queue, first) == NULL);
+    SimilarityMatrix *result = job_queue_copy_result(queue, second);
+    assert(result != NULL);
+    similarity_matrix_destroy(result);
+
+    // 记录数上限：最早结束的记录被删除
+    uint64_t third = submit(queue, &small);
+    assert(wait_finished(queue, third) == JOB_STATE_DONE);
+    JobStatus status;
+    assert(!job_queue_status(queue, first, &status));
+    assert(job_queue_status(queue, second, &status));
+
+    // 销毁时仍有任务在运行
+    submit(queue, &large);
+    job_queue_destroy(queue);
+
+    test_corpus_destroy(&small);
+    test_corpus_destroy(&large);
+    printf("队列上限与取消测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("后台任务队列测试套件\n");
+    printf("========================================\n\n");
+
+    test_results();
+    test_small_jobs_not_starved();
+    test_limits_and_cancel();
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
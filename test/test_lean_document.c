@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "lean_document.h"
+#include "string_pool.h"
+#include "sim_memory.h"
+
+#define DOC_COUNT 200
+#define DOC_WORDS 400
+#define VOCAB_SIZE 4000
+
+static size_t current_total(void) {
+    MemoryStats stats;
+    sim_memory_get(&stats);
+    return stats.current_total;
+}
+
+// 生成确定性的测试语料：小编号的词出现得更频繁
+static char* make_text(unsigned *seed) {
+    char *text = (char*)malloc(DOC_WORDS * 12);
+    char *p = text;
+    for (int w = 0; w < DOC_WORDS; w++) {
+        *seed = *seed * 1103515245u + 12345u;
+        unsigned x = (*seed >> 8) % VOCAB_SIZE;
+        unsigned idx = x * x / VOCAB_SIZE;
+        p += sprintf(p, "lex%c%c%c ", 'a' + idx % 26, 'a' + idx / 26 % 26, 'a' + idx / 676 % 26);
+    }
+    return text;
+}
+
+void test_string_pool() {
+    printf("测试字符串驻留池...\n");
+
+    StringPool *pool = string_pool_create();
+    assert(pool != NULL);
+    assert(string_pool_intern(pool, "alpha") == 0);
+    assert(string_pool_intern(pool, "beta") == 1);
+    assert(string_pool_intern(pool, "alpha") == 0);
+    assert(string_pool_count(pool) == 2);
+
+    // 超过初始索引容量后编号与内容保持不变
+    char word[32];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(word, sizeof(word), "word%d", i);
+        assert(string_pool_intern(pool, word) == (uint32_t)(i + 2));
+    }
+    uint32_t id = 0;
+    assert(string_pool_find(pool, "word500", &id) && id == 502);
+    assert(!string_pool_find(pool, "missing", NULL));
+    assert(strcmp(string_pool_get(pool, 1), "beta") == 0);
+    assert(string_pool_get(pool, 5000) == NULL);
+    assert(string_pool_bytes(pool) > 1000 * 6);
+
+    string_pool_destroy(pool);
+    printf("字符串驻留池测试通过！\n");
+}
+
+void test_matches_document_vectors() {
+    printf("测试精简文档与普通文档的相似度一致...\n");
+
+    const char *names[] = {"a.txt", "b.txt", "c.txt", "d.txt"};
+    const char *texts[] = {
+        "the quick brown fox jumps over the lazy dog fox fox",
+        "quick brown cats sleep over the lazy dog",
+        "completely different words here",
+        "the and of"
+    };
+    size_t lengths[4];
+    for (int i = 0; i < 4; i++) lengths[i] = strlen(texts[i]);
+
+    StopWords *sw = stop_words_create();
+    DocumentCollection *col = load_documents_from_buffers(names, texts, lengths, 4, sw);
+    assert(col && col->count == 4);
+
+    for (int e = 0; e < 2; e++) {
+        LeanCollection *lean = lean_collection_create(e == 0 ? LEAN_PAIRS : LEAN_VARINT);
+        for (size_t i = 0; i < col->count; i++) {
+            assert(lean_collection_add(lean, col->documents[i]));
+        }
+        assert(lean_collection_count(lean) == 4);
+        assert(strcmp(lean_collection_name(lean, 1), "b.txt") == 0);
+        assert(lean_collection_term_count(lean, 3) == 0);
+
+        // 解码出的词项有序，词频与哈希表一致
+        size_t n = lean_collection_term_count(lean, 0);
+        LeanTerm *terms = (LeanTerm*)malloc(n * sizeof(LeanTerm));
+        assert(lean_collection_terms(lean, 0, terms) == n);
+        for (size_t k = 0; k < n; k++) {
+            if (k > 0) assert(terms[k - 1].term < terms[k].term);
+            const char *word = lean_collection_term(lean, terms[k].term);
+            assert((int)terms[k].count == hash_table_get(col->documents[0]->word_freq, word));
+        }
+        free(terms);
+
+        for (size_t i = 0; i < 4; i++) {
+            for (size_t j = 0; j < 4; j++) {
+                double expected = document_vector_similarity(col->documents[i], col->documents[j]);
+                assert(fabs(lean_collection_cosine(lean, i, j) - expected) < 1e-12);
+            }
+        }
+        assert(lean_collection_cosine(lean, 0, 9) == -1.0);
+        lean_collection_destroy(lean);
+    }
+
+    collection_destroy(col);
+    stop_words_destroy(sw);
+    printf("相似度一致性测试通过！\n");
+}
+
+void test_resident_size() {
+    printf("测试常驻内存...\n");
+
+    assert(current_total() == 0);
+
+    char *names[DOC_COUNT];
+    char *texts[DOC_COUNT];
+    size_t lengths[DOC_COUNT];
+    unsigned seed = 42;
+    for (int i = 0; i < DOC_COUNT; i++) {
+        names[i] = (char*)malloc(32);
+        snprintf(names[i], 32, "doc%03d.txt", i);
+        texts[i] = make_text(&seed);
+        lengths[i] = strlen(texts[i]);
+    }
+
+    // 普通集合：正文、哈希表与缓存向量都常驻
+    StopWords *sw = stop_words_create();
+    size_t base = current_total();
+    DocumentCollection *col = load_documents_from_buffers((const char**)names, (const char**)texts,
+                                                          lengths, DOC_COUNT, sw);
+    assert(col && col->count == DOC_COUNT);
+    SimilarityMatrix *expected = similarity_matrix_create(col);
+    assert(expected != NULL);
+    similarity_matrix_destroy(expected);
+    expected = NULL;
+    size_t full = current_total() - base;
+
+    LeanCollection *pairs = lean_collection_create(LEAN_PAIRS);
+    LeanCollection *varint = lean_collection_create(LEAN_VARINT);
+    for (size_t i = 0; i < col->count; i++) {
+        assert(lean_collection_add(pairs, col->documents[i]));
+        assert(lean_collection_add(varint, col->documents[i]));
+    }
+
+    size_t lean_pairs = lean_collection_bytes(pairs);
+    size_t lean_varint = lean_collection_bytes(varint);
+    printf("  每文档常驻: 普通 %zu 字节, 定长 %zu 字节, varint %zu 字节\n",
+           full / DOC_COUNT, lean_pairs / DOC_COUNT, lean_varint / DOC_COUNT);
+    assert(lean_pairs * 4 < full);
+    assert(lean_varint * 10 < full);
+    assert(lean_varint < lean_pairs);
+
+    // 矩阵结果相同
+    SimilarityMatrix *reference = similarity_matrix_create(col);
+    SimilarityMatrix *m1 = lean_collection_similarity_matrix(pairs, NULL);
+    SimilarityMatrix *m2 = lean_collection_similarity_matrix(varint, NULL);
+    assert(reference && m1 && m2 && m1->size == DOC_COUNT);
+    for (size_t i = 0; i < DOC_COUNT; i++) {
+        assert(strcmp(m2->filenames[i], reference->filenames[i]) == 0);
+        for (size_t j = 0; j < DOC_COUNT; j++) {
+            assert(fabs(m1->matrix[i][j] - reference->matrix[i][j]) < 1e-12);
+            assert(m1->matrix[i][j] == m2->matrix[i][j]);
+        }
+    }
+    similarity_matrix_destroy(reference);
+    similarity_matrix_destroy(m1);
+    similarity_matrix_destroy(m2);
+
+    collection_destroy(col);
+    lean_collection_destroy(pairs);
+    lean_collection_destroy(varint);
+    stop_words_destroy(sw);
+    assert(current_total() == 0);
+
+    for (int i = 0; i < DOC_COUNT; i++) {
+        free(names[i]);
+        free(texts[i]);
+    }
+    printf("常驻内存测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("精简文档测试套件\n");
+    printf("========================================\n\n");
+
+    test_string_pool();
+    test_matches_document_vectors();
+    test_resident_size();
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
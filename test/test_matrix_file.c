@@ -0,0 +1,237 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "matrix_file.h"
+#include "byte_order.h"
+#include "test_fixtures.h"
+
+#define DOC_COUNT 23
+#define MATRIX_PATH "build/test_matrix.simx"
+#define EPSILON 0.00001
+
+static DocumentCollection* make_collection() {
+    TestCorpus corpus = test_corpus_create(DOC_COUNT, 11, 10, 3, 14);
+    DocumentCollection *col = test_collection_create(&corpus);
+    test_corpus_destroy(&corpus);
+    return col;
+}
+
+// 按给定选项写出后读回，与内存矩阵逐项比较
+static void check_roundtrip(SimilarityMatrix *matrix, MatrixDType dtype, MatrixLayout layout,
+                            MatrixCompression compression, double tolerance) {
+    MatrixFileOptions options = matrix_file_default_options();
+    options.dtype = dtype;
+    options.layout = layout;
+    options.compression = compression;
+    options.tile_rows = 4;
+    assert(similarity_matrix_save_binary(matrix, MATRIX_PATH, &options));
+
+    MatrixFile *mf = matrix_file_open(MATRIX_PATH);
+    assert(mf != NULL);
+    assert(matrix_file_size(mf) == DOC_COUNT);
+    assert(matrix_file_dtype(mf) == (int)dtype);
+    assert(matrix_file_layout(mf) == (int)layout);
+    assert(matrix_file_compression(mf) == (int)compression);
+
+    float row[DOC_COUNT];
+    for (size_t i = 0; i < DOC_COUNT; i++) {
+        assert(strcmp(matrix_file_name(mf, i), matrix->filenames[i]) == 0);
+        assert(matrix_file_read_row(mf, i, row));
+        for (size_t j = 0; j < DOC_COUNT; j++) {
+            // read_row 输出 float，至少有单精度误差
+            assert(fabs(row[j] - matrix->matrix[i][j]) <= tolerance + EPSILON);
+            assert(fabs(matrix_file_get(mf, i, j) - matrix->matrix[i][j]) <= tolerance);
+        }
+    }
+    assert(matrix_file_name(mf, DOC_COUNT) == NULL);
+
+    // 逆序读取：上三角压缩文件的行游标需要回到行首
+    for (size_t i = DOC_COUNT; i-- > 0;) {
+        assert(matrix_file_read_row(mf, i, row));
+        for (size_t j = 0; j < DOC_COUNT; j++) {
+            assert(fabs(row[j] - matrix->matrix[i][j]) <= tolerance + EPSILON);
+        }
+    }
+
+    matrix_file_close(mf);
+}
+
+void test_binary_roundtrip() {
+    printf("测试二进制矩阵读写...\n");
+
+    DocumentCollection *col = make_collection();
+    SimilarityMatrix *matrix = similarity_matrix_create(col);
+
+    check_roundtrip(matrix, MATRIX_DTYPE_F64, MATRIX_LAYOUT_FULL, MATRIX_COMPRESS_NONE, 0);
+    check_roundtrip(matrix, MATRIX_DTYPE_F32, MATRIX_LAYOUT_FULL, MATRIX_COMPRESS_NONE, EPSILON);
+    check_roundtrip(matrix, MATRIX_DTYPE_F32, MATRIX_LAYOUT_UPPER, MATRIX_COMPRESS_NONE, EPSILON);
+    check_roundtrip(matrix, MATRIX_DTYPE_U8, MATRIX_LAYOUT_UPPER, MATRIX_COMPRESS_NONE, 0.5 / 255 + EPSILON);
+    check_roundtrip(matrix, MATRIX_DTYPE_U8, MATRIX_LAYOUT_UPPER, MATRIX_COMPRESS_RLE, 0.5 / 255 + EPSILON);
+    check_roundtrip(matrix, MATRIX_DTYPE_F32, MATRIX_LAYOUT_FULL, MATRIX_COMPRESS_RLE, EPSILON);
+    // 半精度在 [0.5, 1] 内的舍入误差不超过 2^-11
+    check_roundtrip(matrix, MATRIX_DTYPE_F16, MATRIX_LAYOUT_UPPER, MATRIX_COMPRESS_NONE, 1.0 / 2048);
+    check_roundtrip(matrix, MATRIX_DTYPE_F16, MATRIX_LAYOUT_FULL, MATRIX_COMPRESS_RLE, 1.0 / 2048);
+
+    similarity_matrix_destroy(matrix);
+    collection_destroy(col);
+    printf("二进制矩阵读写测试通过！\n");
+}
+
+void test_zero_copy_rows() {
+    printf("测试零拷贝行访问...\n");
+
+    DocumentCollection *col = make_collection();
+    SimilarityMatrix *matrix = similarity_matrix_create(col);
+
+    MatrixFileOptions options = matrix_file_default_options();
+    options.layout = MATRIX_LAYOUT_UPPER;
+    assert(similarity_matrix_save_binary(matrix, MATRIX_PATH, &options));
+
+    MatrixFile *mf = matrix_file_open(MATRIX_PATH);
+    assert(mf != NULL);
+    for (size_t i = 0; i < DOC_COUNT; i++) {
+        size_t count = 0;
+        const float *cells = (const float*)matrix_file_row_data(mf, i, &count);
+        assert(cells != NULL);
+        assert(count == DOC_COUNT - i);
+        // 数据区 64 字节对齐，行指针可直接当作 float 数组
+        assert(((size_t)cells - (size_t)matrix_file_row_data(mf, 0, NULL)) % sizeof(float) == 0);
+        for (size_t k = 0; k < count; k++) {
+            assert(cells[k] == (float)matrix->matrix[i][i + k]);
+        }
+    }
+    assert(matrix_file_row_data(mf, DOC_COUNT, NULL) == NULL);
+    matrix_file_close(mf);
+
+    // 压缩文件不提供零拷贝访问
+    options.compression = MATRIX_COMPRESS_RLE;
+    assert(similarity_matrix_save_binary(matrix, MATRIX_PATH, &options));
+    mf = matrix_file_open(MATRIX_PATH);
+    assert(mf != NULL);
+    assert(matrix_file_row_data(mf, 0, NULL) == NULL);
+    matrix_file_close(mf);
+
+    similarity_matrix_destroy(matrix);
+    collection_destroy(col);
+    printf("零拷贝行访问测试通过！\n");
+}
+
+void test_encode_buffer() {
+    printf("测试内存编码...\n");
+
+    const char *names[] = {"a", "b", "c"};
+    SimilarityMatrix *matrix = similarity_matrix_alloc_named(names, 3);
+    double values[3][3] = {{1.0, 0.5, 1.0 / 3}, {0.5, 1.0, 0.0}, {1.0 / 3, 0.0, 1.0}};
+    for (size_t i = 0; i < 3; i++) {
+        memcpy(matrix->matrix[i], values[i], sizeof(values[i]));
+    }
+
+    // 半精度位模式：1.0 = 0x3C00, 0.5 = 0x3800, 1/3 = 0x3555（最近偶数舍入）
+    size_t bytes = 0;
+    uint8_t *cells = (uint8_t*)similarity_matrix_encode(matrix, MATRIX_DTYPE_F16, MATRIX_LAYOUT_UPPER, &bytes);
+    assert(cells != NULL && bytes == 6 * 2);
+    const uint16_t expected_f16[] = {0x3C00, 0x3800, 0x3555, 0x3C00, 0x0000, 0x3C00};
+    for (size_t k = 0; k < 6; k++) {
+        assert(get_u16(cells + 2 * k) == expected_f16[k]);
+    }
+    similarity_buffer_free(cells);
+
+    cells = (uint8_t*)similarity_matrix_encode(matrix, MATRIX_DTYPE_U8, MATRIX_LAYOUT_FULL, &bytes);
+    assert(cells != NULL && bytes == 9);
+    const uint8_t expected_u8[] = {255, 128, 85, 128, 255, 0, 85, 0, 255};
+    assert(memcmp(cells, expected_u8, 9) == 0);
+    similarity_buffer_free(cells);
+
+    assert(similarity_matrix_encode(matrix, (MatrixDType)99, MATRIX_LAYOUT_FULL, &bytes) == NULL);
+    similarity_matrix_destroy(matrix);
+    printf("内存编码测试通过！\n");
+}
+
+void test_rejects_invalid_file() {
+    printf("测试拒绝无效文件...\n");
+
+    FILE *file = fopen(MATRIX_PATH, "wb");
+    assert(file != NULL);
+    char junk[128];
+    memset(junk, 'x', sizeof(junk));
+    fwrite(junk, 1, sizeof(junk), file);
+    fclose(file);
+
+    assert(matrix_file_open(MATRIX_PATH) == NULL);
+    assert(matrix_file_open("build/no_such_matrix.simx") == NULL);
+
+    // 压缩文件：行块偏移超出数据区时拒绝打开，行程数据损坏时读行失败
+    DocumentCollection *col = make_collection();
+    SimilarityMatrix *matrix = similarity_matrix_create(col);
+    MatrixFileOptions options = matrix_file_default_options();
+    options.layout = MATRIX_LAYOUT_UPPER;
+    options.compression = MATRIX_COMPRESS_RLE;
+    options.tile_rows = 4;
+    assert(similarity_matrix_save_binary(matrix, MATRIX_PATH, &options));
+
+    file = fopen(MATRIX_PATH, "rb");
+    fseek(file, 0, SEEK_END);
+    size_t size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *bytes = (uint8_t*)malloc(size);
+    assert(fread(bytes, 1, size, file) == size);
+    fclose(file);
+    uint64_t data_offset = get_u64(bytes + 32);
+    uint64_t index_offset = get_u64(bytes + 48);
+
+    uint8_t *patched = (uint8_t*)malloc(size);
+    memcpy(patched, bytes, size);
+    put_u64(patched + index_offset + 8, UINT64_MAX / 2);
+    file = fopen(MATRIX_PATH, "wb");
+    fwrite(patched, 1, size, file);
+    fclose(file);
+    assert(matrix_file_open(MATRIX_PATH) == NULL);
+
+    // 每块行数大于矩阵行数时拒绝打开，块缓存的大小不会由文件随意指定
+    memcpy(patched, bytes, size);
+    put_u32(patched + 12, UINT32_MAX);
+    file = fopen(MATRIX_PATH, "wb");
+    fwrite(patched, 1, size, file);
+    fclose(file);
+    assert(matrix_file_open(MATRIX_PATH) == NULL);
+
+    // 第一个行块的数据全部置零：行程长度为 0
+    memcpy(patched, bytes, size);
+    memset(patched + data_offset, 0, (size_t)get_u64(bytes + index_offset + 8));
+    file = fopen(MATRIX_PATH, "wb");
+    fwrite(patched, 1, size, file);
+    fclose(file);
+    MatrixFile *mf = matrix_file_open(MATRIX_PATH);
+    assert(mf != NULL);
+    float row[DOC_COUNT];
+    assert(!matrix_file_read_row(mf, 0, row));
+    assert(!matrix_file_read_row(mf, DOC_COUNT - 1, row));
+    matrix_file_close(mf);
+
+    free(bytes);
+    free(patched);
+    similarity_matrix_destroy(matrix);
+    collection_destroy(col);
+    remove(MATRIX_PATH);
+
+    printf("无效文件测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("二进制矩阵文件测试套件\n");
+    printf("========================================\n\n");
+
+    test_binary_roundtrip();
+    test_zero_copy_rows();
+    test_encode_buffer();
+    test_rejects_invalid_file();
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
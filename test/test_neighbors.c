@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "neighbors.h"
+#include "test_fixtures.h"
+
+#define DOC_COUNT 37
+
+static SimilarityMatrix* make_matrix() {
+    // 词表很小，产生大量分数相同的文档对
+    TestCorpus corpus = test_corpus_create(DOC_COUNT, 29, 5, 2, 7);
+    DocumentCollection *col = test_collection_create(&corpus);
+    test_corpus_destroy(&corpus);
+
+    SimilarityMatrix *matrix = similarity_matrix_create(col);
+    collection_destroy(col);
+    return matrix;
+}
+
+// 暴力参照：同一行中 (score, col) 排在 (best_score, best_col) 之后的最佳候选
+static void check_top_k(SimilarityMatrix *matrix, size_t k, double min_score) {
+    SimilarityEdges *edges = similarity_matrix_top_k(matrix, k, min_score);
+    assert(edges != NULL);
+
+    size_t pos = 0;
+    for (size_t i = 0; i < DOC_COUNT; i++) {
+        double last_score = 2.0;
+        size_t last_col = 0;
+        bool first = true;
+        for (size_t r = 0; r < k; r++) {
+            // 找出排名紧随上一个之后的列
+            size_t best = DOC_COUNT;
+            for (size_t j = 0; j < DOC_COUNT; j++) {
+                double s = matrix->matrix[i][j];
+                if (j == i || s < min_score) continue;
+                bool after_last = first || s < last_score || (s == last_score && j > last_col);
+                if (!after_last) continue;
+                if (best == DOC_COUNT || s > matrix->matrix[i][best]) best = j;
+            }
+            if (best == DOC_COUNT) break;
+
+            assert(pos < edges->count);
+            assert(edges->rows[pos] == i);
+            assert(edges->cols[pos] == best);
+            assert(edges->scores[pos] == (float)matrix->matrix[i][best]);
+            last_score = matrix->matrix[i][best];
+            last_col = best;
+            first = false;
+            pos++;
+        }
+    }
+    assert(pos == edges->count);
+    similarity_edges_destroy(edges);
+}
+
+void test_top_k() {
+    printf("测试每行Top-K邻居...\n");
+
+    SimilarityMatrix *matrix = make_matrix();
+    check_top_k(matrix, 1, 0.0);
+    check_top_k(matrix, 5, 0.0);
+    check_top_k(matrix, 5, 0.6);
+    check_top_k(matrix, DOC_COUNT - 1, 0.0);
+
+    // k 超过文档数时截断为 n - 1
+    SimilarityEdges *edges = similarity_matrix_top_k(matrix, 1000, -1.0);
+    assert(edges->count == DOC_COUNT * (DOC_COUNT - 1));
+    similarity_edges_destroy(edges);
+
+    edges = similarity_matrix_top_k(matrix, 0, 0.0);
+    assert(edges != NULL && edges->count == 0);
+    similarity_edges_destroy(edges);
+
+    similarity_matrix_destroy(matrix);
+    printf("Top-K邻居测试通过！\n");
+}
+
+void test_pairs_above() {
+    printf("测试阈值筛选...\n");
+
+    SimilarityMatrix *matrix = make_matrix();
+    double thresholds[] = {0.0, 0.5, 0.9, 1.01};
+    for (size_t t = 0; t < 4; t++) {
+        SimilarityEdges *edges = similarity_matrix_pairs_above(matrix, thresholds[t]);
+        assert(edges != NULL);
+
+        size_t pos = 0;
+        for (size_t i = 0; i < DOC_COUNT; i++) {
+            for (size_t j = i + 1; j < DOC_COUNT; j++) {
+                if (matrix->matrix[i][j] < thresholds[t]) continue;
+                assert(edges->rows[pos] == i && edges->cols[pos] == j);
+                assert(edges->scores[pos] == (float)matrix->matrix[i][j]);
+                pos++;
+            }
+        }
+        assert(pos == edges->count);
+        similarity_edges_destroy(edges);
+    }
+
+    similarity_matrix_destroy(matrix);
+    printf("阈值筛选测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("稀疏结果测试套件\n");
+    printf("========================================\n\n");
+
+    test_top_k();
+    test_pairs_above();
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
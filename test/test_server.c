@@ -0,0 +1,381 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "server.h"
+#include "byte_order.h"
+#include "file_manager.h"
+#include "matrix_file.h"
+#include "test_fixtures.h"
+
+#define DOC_COUNT 30
+#define QUERY_COUNT 12
+#define CLIENT_THREADS 8
+#define SOCKET_PATH "build/test_server.sock"
+
+static TestCorpus corpus;
+static char queries[QUERY_COUNT][128];
+static StopWords *stop_words;
+
+static void make_texts() {
+    corpus = test_corpus_create(DOC_COUNT, 11, 14, 3, 14);
+    for (int q = 0; q < QUERY_COUNT; q++) {
+        queries[q][0] = '\0';
+        int count = 1 + rand() % 5;
+        for (int w = 0; w < count; w++) {
+            strcat(queries[q], test_words[rand() % 14]);
+            strcat(queries[q], " ");
+        }
+    }
+}
+
+// ---- 客户端 ----
+
+static int client_connect() {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, SOCKET_PATH);
+    assert(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    return fd;
+}
+
+static void write_all(int fd, const uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t sent = write(fd, buf, len);
+        assert(sent > 0);
+        buf += sent;
+        len -= (size_t)sent;
+    }
+}
+
+static void read_all(int fd, uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t got = read(fd, buf, len);
+        assert(got > 0);
+        buf += got;
+        len -= (size_t)got;
+    }
+}
+
+// 发送一个请求并读取响应，返回状态；*reply 需调用方释放
+static int request(int fd, uint8_t op, const uint8_t *payload, size_t len,
+                   uint8_t **reply, size_t *reply_len) {
+    uint8_t header[5];
+    put_u32(header, (uint32_t)(len + 1));
+    header[4] = op;
+    write_all(fd, header, 5);
+    if (len > 0) write_all(fd, payload, len);
+
+    read_all(fd, header, 5);
+    *reply_len = get_u32(header) - 1;
+    *reply = (uint8_t*)malloc(*reply_len + 1);
+    read_all(fd, *reply, *reply_len);
+    return header[4];
+}
+
+static void add_document(int fd, const char *name, const char *text, uint32_t expected_index) {
+    size_t name_len = strlen(name), text_len = strlen(text);
+    uint8_t *payload = (uint8_t*)malloc(2 + name_len + text_len);
+    put_u16(payload, (uint16_t)name_len);
+    memcpy(payload + 2, name, name_len);
+    memcpy(payload + 2 + name_len, text, text_len);
+
+    uint8_t *reply;
+    size_t reply_len;
+    assert(request(fd, SERVER_OP_ADD, payload, 2 + name_len + text_len, &reply, &reply_len) == SERVER_STATUS_OK);
+    assert(reply_len == 8);
+    assert(get_u32(reply) == expected_index);
+    free(reply);
+    free(payload);
+}
+
+typedef struct Hit {
+    uint32_t index;
+    double score;
+    char name[32];
+} Hit;
+
+static size_t query_top_k(int fd, const char *text, uint32_t k, Hit *hits) {
+    size_t len = strlen(text);
+    uint8_t *payload = (uint8_t*)malloc(4 + len);
+    put_u32(payload, k);
+    memcpy(payload + 4, text, len);
+
+    uint8_t *reply;
+    size_t reply_len;
+    assert(request(fd, SERVER_OP_QUERY, payload, 4 + len, &reply, &reply_len) == SERVER_STATUS_OK);
+    size_t count = get_u32(reply);
+    const uint8_t *p = reply + 4;
+    for (size_t i = 0; i < count; i++) {
+        hits[i].index = get_u32(p);
+        hits[i].score = get_f64(p + 4);
+        size_t name_len = get_u16(p + 12);
+        assert(name_len < sizeof(hits[i].name));
+        memcpy(hits[i].name, p + 14, name_len);
+        hits[i].name[name_len] = '\0';
+        p += 14 + name_len;
+    }
+    assert((size_t)(p - reply) == reply_len);
+    free(reply);
+    free(payload);
+    return count;
+}
+
+// ---- 参考实现 ----
+
+static SparseVector* reference_vector(const char *text) {
+    Document *doc = document_create_from_buffer("ref", text, strlen(text));
+    assert(doc && document_process(doc, stop_words));
+    SparseVector *vec = document_vector(doc);
+    doc->vector = NULL;
+    document_destroy(doc);
+    return vec;
+}
+
+static SparseVector *doc_vectors[DOC_COUNT];
+
+// 与两两计算的余弦相似度逐位一致，排序规则为分数降序、下标升序
+static size_t reference_top_k(const char *text, size_t k, Hit *hits) {
+    SparseVector *query = reference_vector(text);
+    size_t count = 0;
+    for (size_t d = 0; d < DOC_COUNT; d++) {
+        double score = sparse_vector_cosine(query, doc_vectors[d]);
+        if (score <= 0) continue;
+        size_t pos = count++;
+        while (pos > 0 && (hits[pos - 1].score < score)) {
+            hits[pos] = hits[pos - 1];
+            pos--;
+        }
+        hits[pos].index = (uint32_t)d;
+        hits[pos].score = score;
+        strcpy(hits[pos].name, corpus.names[d]);
+    }
+    sparse_vector_destroy(query);
+    return count < k ? count : k;
+}
+
+static void check_query(int fd, const char *text, uint32_t k) {
+    Hit actual[DOC_COUNT], expected[DOC_COUNT];
+    size_t count = query_top_k(fd, text, k, actual);
+    assert(count == reference_top_k(text, k, expected));
+    for (size_t i = 0; i < count; i++) {
+        assert(actual[i].index == expected[i].index);
+        assert(memcmp(&actual[i].score, &expected[i].score, sizeof(double)) == 0);
+        assert(strcmp(actual[i].name, expected[i].name) == 0);
+    }
+}
+
+// ---- 测试 ----
+
+static void* run_server(void *arg) {
+    assert(sim_server_run((SimServer*)arg) == 0);
+    return NULL;
+}
+
+void test_add_query_matrix(int fd) {
+    printf("测试添加、查询与矩阵请求...\n");
+
+    // 先用错误内容添加，再同名替换
+    add_document(fd, corpus.names[0], "placeholder words", 0);
+    for (uint32_t d = 0; d < DOC_COUNT; d++) {
+        add_document(fd, corpus.names[d], corpus.buffers[d], d);
+        doc_vectors[d] = reference_vector(corpus.buffers[d]);
+    }
+
+    for (int q = 0; q < QUERY_COUNT; q++) {
+        check_query(fd, queries[q], 5);
+        check_query(fd, queries[q], DOC_COUNT * 2);
+    }
+    Hit hits[DOC_COUNT];
+    assert(query_top_k(fd, "the and of", 5, hits) == 0);
+    assert(query_top_k(fd, "alpha", 0, hits) == 0);
+
+    // 矩阵与直接计算逐位一致
+    SimilarityMatrix *expected = similarity_matrix_from_buffers(corpus.names, corpus.buffers,
+                                                                corpus.lengths, DOC_COUNT,
+                                                                stop_words);
+    uint8_t spec[2] = {MATRIX_DTYPE_F64, MATRIX_LAYOUT_FULL};
+    uint8_t *reply;
+    size_t reply_len;
+    assert(request(fd, SERVER_OP_MATRIX, spec, 2, &reply, &reply_len) == SERVER_STATUS_OK);
+    assert(get_u32(reply) == DOC_COUNT);
+    const uint8_t *p = reply + 4;
+    for (int d = 0; d < DOC_COUNT; d++) {
+        size_t name_len = get_u16(p);
+        assert(name_len == strlen(corpus.names[d]));
+        assert(memcmp(p + 2, corpus.names[d], name_len) == 0);
+        p += 2 + name_len;
+    }
+    assert((size_t)(reply + reply_len - p) == DOC_COUNT * DOC_COUNT * sizeof(double));
+    for (size_t i = 0; i < DOC_COUNT; i++) {
+        for (size_t j = 0; j < DOC_COUNT; j++) {
+            double value = get_f64(p + (i * DOC_COUNT + j) * sizeof(double));
+            assert(memcmp(&value, &expected->matrix[i][j], sizeof(double)) == 0);
+        }
+    }
+    free(reply);
+
+    // 量化的上三角布局
+    spec[0] = MATRIX_DTYPE_U8;
+    spec[1] = MATRIX_LAYOUT_UPPER;
+    assert(request(fd, SERVER_OP_MATRIX, spec, 2, &reply, &reply_len) == SERVER_STATUS_OK);
+    size_t bytes;
+    void *cells = similarity_matrix_encode(expected, MATRIX_DTYPE_U8, MATRIX_LAYOUT_UPPER, &bytes);
+    assert(bytes == DOC_COUNT * (DOC_COUNT + 1) / 2);
+    assert(memcmp(reply + reply_len - bytes, cells, bytes) == 0);
+    similarity_buffer_free(cells);
+    free(reply);
+
+    similarity_matrix_destroy(expected);
+    printf("添加、查询与矩阵请求测试通过！\n");
+}
+
+static void* client_main(void *arg) {
+    int seed = (int)(size_t)arg;
+    int fd = client_connect();
+    for (int i = 0; i < 25; i++) {
+        check_query(fd, queries[(seed + i) % QUERY_COUNT], 1 + (seed + i) % 7);
+    }
+    close(fd);
+    return NULL;
+}
+
+void test_concurrent_queries(SimServer *server) {
+    printf("测试并发查询合并...\n");
+
+    ServerStats before, after;
+    sim_server_get_stats(server, &before);
+
+    pthread_t threads[CLIENT_THREADS];
+    for (size_t t = 0; t < CLIENT_THREADS; t++) {
+        assert(pthread_create(&threads[t], NULL, client_main, (void*)t) == 0);
+    }
+    for (size_t t = 0; t < CLIENT_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    sim_server_get_stats(server, &after);
+    assert(after.queries - before.queries == CLIENT_THREADS * 25);
+    assert(after.batches - before.batches <= after.queries - before.queries);
+    assert(after.largest_batch >= 1 && after.largest_batch <= CLIENT_THREADS);
+    printf("  %llu 次查询，%llu 次扫描，最大批次 %zu\n",
+           (unsigned long long)(after.queries - before.queries),
+           (unsigned long long)(after.batches - before.batches), after.largest_batch);
+    printf("并发查询测试通过！\n");
+}
+
+void test_remove_and_errors(int fd) {
+    printf("测试删除与错误请求...\n");
+
+    uint8_t *reply;
+    size_t reply_len;
+    uint8_t payload[64];
+
+    // 删除第一个文档，最后一个文档移入其位置
+    size_t name_len = strlen(corpus.names[0]);
+    put_u16(payload, (uint16_t)name_len);
+    memcpy(payload + 2, corpus.names[0], name_len);
+    assert(request(fd, SERVER_OP_REMOVE, payload, 2 + name_len, &reply, &reply_len) == SERVER_STATUS_OK);
+    assert(get_u32(reply) == DOC_COUNT - 1);
+    free(reply);
+    assert(request(fd, SERVER_OP_REMOVE, payload, 2 + name_len, &reply, &reply_len) == SERVER_STATUS_NOT_FOUND);
+    free(reply);
+
+    Hit hits[DOC_COUNT];
+    size_t count = query_top_k(fd, corpus.buffers[DOC_COUNT - 1], DOC_COUNT, hits);
+    bool found_last = false;
+    for (size_t i = 0; i < count; i++) {
+        assert(strcmp(hits[i].name, corpus.names[0]) != 0);
+        if (strcmp(hits[i].name, corpus.names[DOC_COUNT - 1]) == 0) {
+            assert(hits[i].index == 0);
+            found_last = true;
+        }
+    }
+    assert(found_last);
+
+    // 格式错误的请求不会断开连接
+    assert(request(fd, 99, NULL, 0, &reply, &reply_len) == SERVER_STATUS_BAD_REQUEST);
+    free(reply);
+    uint8_t bad_spec[2] = {9, 0};
+    assert(request(fd, SERVER_OP_MATRIX, bad_spec, 2, &reply, &reply_len) == SERVER_STATUS_BAD_REQUEST);
+    free(reply);
+    put_u16(payload, 40);
+    assert(request(fd, SERVER_OP_ADD, payload, 6, &reply, &reply_len) == SERVER_STATUS_BAD_REQUEST);
+    free(reply);
+
+    assert(request(fd, SERVER_OP_STATS, NULL, 0, &reply, &reply_len) == SERVER_STATUS_OK);
+    assert(reply_len == 24 && get_u32(reply) == DOC_COUNT - 1);
+    free(reply);
+
+    printf("删除与错误请求测试通过！\n");
+}
+
+void test_oversized_matrix(int fd) {
+    printf("测试超出帧长度的矩阵...\n");
+
+    // f64 全矩阵超过 4 GB 的文档数；计算前即拒绝，连接保持同步
+    const uint32_t base = DOC_COUNT - 1;
+    const uint32_t extra = 23200;
+    char name[32];
+    for (uint32_t i = 0; i < extra; i++) {
+        snprintf(name, sizeof(name), "big%05u.txt", i);
+        add_document(fd, name, "alpha beta", base + i);
+    }
+
+    uint8_t *reply;
+    size_t reply_len;
+    uint8_t spec[2] = {MATRIX_DTYPE_F64, MATRIX_LAYOUT_FULL};
+    assert(request(fd, SERVER_OP_MATRIX, spec, 2, &reply, &reply_len) == SERVER_STATUS_ERROR);
+    free(reply);
+
+    assert(request(fd, SERVER_OP_STATS, NULL, 0, &reply, &reply_len) == SERVER_STATUS_OK);
+    assert(reply_len == 24 && get_u32(reply) == base + extra);
+    free(reply);
+
+    printf("超大矩阵测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("常驻相似度服务测试套件\n");
+    printf("========================================\n\n");
+
+    make_texts();
+    stop_words = stop_words_create();
+
+    ServerOptions options = {SOCKET_PATH, NULL, 0};
+    SimServer *server = sim_server_create(&options, stop_words);
+    assert(server != NULL);
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, run_server, server) == 0);
+
+    int fd = client_connect();
+    test_add_query_matrix(fd);
+    test_concurrent_queries(server);
+    test_remove_and_errors(fd);
+    test_oversized_matrix(fd);
+
+    // 仍有空闲连接时停止服务
+    sim_server_stop(server);
+    pthread_join(thread, NULL);
+    close(fd);
+    sim_server_destroy(server);
+    assert(access(SOCKET_PATH, F_OK) != 0);
+
+    for (int d = 0; d < DOC_COUNT; d++) sparse_vector_destroy(doc_vectors[d]);
+    stop_words_destroy(stop_words);
+    test_corpus_destroy(&corpus);
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "shingle.h"
+#include "file_manager.h"
+#include "sim_memory.h"
+
+static size_t current_total(void) {
+    MemoryStats stats;
+    sim_memory_get(&stats);
+    return stats.current_total;
+}
+
+static ShingleOptions make_options(size_t width, uint64_t sample_mod) {
+    ShingleOptions options;
+    shingle_options_init(&options);
+    options.width = width;
+    options.sample_mod = sample_mod;
+    return options;
+}
+
+static bool has_key(const SparseVector *vec, uint64_t key) {
+    for (size_t i = 0; i < vec->size; i++) {
+        if (vec->keys[i] == key) return true;
+    }
+    return false;
+}
+
+// 生成确定性的长文本
+static char* make_text(unsigned seed, int words) {
+    char *text = (char*)malloc((size_t)words * 8 + 1);
+    char *p = text;
+    for (int w = 0; w < words; w++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned idx = (seed >> 8) % 500;
+        p += sprintf(p, "w%c%c%c ", 'a' + idx % 26, 'a' + idx / 26 % 26, 'a' + idx / 676 % 26);
+    }
+    return text;
+}
+
+void test_rolling_hash() {
+    printf("测试滚动哈希...\n");
+
+    ShingleOptions options = make_options(2, 1);
+    shingle_options_init(&options);
+    assert(!shingle_options_active(&options));
+    options.width = 2;
+    assert(shingle_options_active(&options));
+
+    // 三个 2 词 shingle，键有序且各出现一次
+    SparseVector *full = shingle_vector("one two three four", &options);
+    assert(full && full->size == 3);
+    for (size_t i = 1; i < full->size; i++) assert(full->keys[i - 1] < full->keys[i]);
+    assert(fabs(full->norm - sqrt(3.0)) < 1e-12);
+
+    // 滚动得到的哈希与从头计算相同，且不受大小写与标点影响
+    SparseVector *part = shingle_vector("TWO, three!", &options);
+    assert(part && part->size == 1);
+    assert(has_key(full, part->keys[0]));
+    sparse_vector_destroy(part);
+
+    // 词序不同则哈希不同
+    part = shingle_vector("three two", &options);
+    assert(part->size == 1 && !has_key(full, part->keys[0]));
+    sparse_vector_destroy(part);
+
+    // 重复的 shingle 计数
+    SparseVector *repeat = shingle_vector("a b a b a b", &options);
+    assert(repeat->size == 2);
+    sparse_vector_destroy(repeat);
+
+    // 不足一个窗口的文本整体作为一个 shingle，没有词时为空向量
+    options.width = 5;
+    SparseVector *shorter = shingle_vector("just three words", &options);
+    assert(shorter->size == 1 && shorter->values[0] == 1.0);
+    sparse_vector_destroy(shorter);
+    SparseVector *empty = shingle_vector("42 -- !!", &options);
+    assert(empty && empty->size == 0 && empty->norm == 0.0);
+    sparse_vector_destroy(empty);
+
+    // 中日韩文字按单字滑动：文本相似度 -> 文本相, 本相似, 相似度
+    options.width = 3;
+    SparseVector *cjk = shingle_vector("\xE6\x96\x87\xE6\x9C\xAC\xE7\x9B\xB8\xE4\xBC\xBC\xE5\xBA\xA6", &options);
+    assert(cjk->size == 3);
+    sparse_vector_destroy(cjk);
+
+    options.width = SHINGLE_MAX_WIDTH + 1;
+    assert(shingle_vector("a b", &options) == NULL);
+
+    sparse_vector_destroy(full);
+    printf("滚动哈希测试通过！\n");
+}
+
+void test_word_order() {
+    printf("测试词序敏感性...\n");
+
+    const char *original = "the committee approved the new budget after a long debate "
+                           "about school funding and road repairs in the northern district";
+    const char *copied = "Reporters noted that the committee approved the new budget after "
+                         "a long debate about school funding and road repairs.";
+    const char *shuffled = "district northern the in repairs road and funding school about "
+                           "debate long a after budget new the approved committee the";
+
+    ShingleOptions options = make_options(3, 1);
+    SparseVector *a = shingle_vector(original, &options);
+    SparseVector *b = shingle_vector(copied, &options);
+    SparseVector *c = shingle_vector(shuffled, &options);
+
+    // 词袋分不出打乱顺序的文本，shingle 可以
+    Document *d1 = document_create_from_buffer("a", original, strlen(original));
+    Document *d3 = document_create_from_buffer("c", shuffled, strlen(shuffled));
+    assert(document_process(d1, NULL) && document_process(d3, NULL));
+    assert(fabs(document_vector_similarity(d1, d3) - 1.0) < 1e-12);
+    assert(sparse_vector_cosine(a, c) == 0.0);
+    assert(sparse_vector_cosine(a, b) > 0.7);
+    assert(sparse_vector_jaccard(a, b) > 0.5);
+    document_destroy(d1);
+    document_destroy(d3);
+
+    sparse_vector_destroy(a);
+    sparse_vector_destroy(b);
+    sparse_vector_destroy(c);
+    printf("词序敏感性测试通过！\n");
+}
+
+void test_sampling() {
+    printf("测试 mod p 抽样...\n");
+
+    char *text = make_text(7, 20000);
+    ShingleOptions options = make_options(4, 1);
+    SparseVector *full = shingle_vector(text, &options);
+    options.sample_mod = 8;
+    SparseVector *sampled = shingle_vector(text, &options);
+    assert(full && sampled);
+
+    // 抽样结果是全集的子集，键都满足 mod p 为 0，规模约为 1/p
+    for (size_t i = 0; i < sampled->size; i++) {
+        assert(sampled->keys[i] % 8 == 0);
+        assert(has_key(full, sampled->keys[i]));
+    }
+    double ratio = (double)sampled->size / full->size;
+    printf("  全部 %zu 个, 抽样后 %zu 个\n", full->size, sampled->size);
+    assert(ratio > 0.1 && ratio < 0.15);
+
+    // 短文档一个也未选中时保留哈希最小的 shingle，不会成为空向量
+    options.sample_mod = (uint64_t)1 << 40;
+    SparseVector *few = shingle_vector("the quick brown fox jumps over the lazy dog", &options);
+    options.sample_mod = 1;
+    SparseVector *all = shingle_vector("the quick brown fox jumps over the lazy dog", &options);
+    assert(few && few->size == 1 && few->values[0] == 1.0);
+    assert(few->keys[0] == all->keys[0]);
+    sparse_vector_destroy(few);
+    sparse_vector_destroy(all);
+
+    sparse_vector_destroy(full);
+    sparse_vector_destroy(sampled);
+    free(text);
+    printf("抽样测试通过！\n");
+}
+
+void test_jaccard_minhash() {
+    printf("测试 Jaccard 与 MinHash...\n");
+
+    // 两段文本共享前半部分
+    char *x = make_text(11, 4000);
+    char *y = make_text(11, 2000);
+    char *tail = make_text(99, 2000);
+    y = (char*)realloc(y, strlen(y) + strlen(tail) + 1);
+    strcat(y, tail);
+
+    ShingleOptions options = make_options(4, 1);
+    SparseVector *a = shingle_vector(x, &options);
+    SparseVector *b = shingle_vector(y, &options);
+    double exact = sparse_vector_jaccard(a, b);
+    assert(exact > 0.2 && exact < 0.5);
+    assert(sparse_vector_jaccard(a, a) == 1.0);
+
+    enum { K = 256 };
+    uint64_t sa[K], sb[K];
+    minhash_signature(a, sa, K);
+    minhash_signature(b, sb, K);
+    double estimate = minhash_similarity(sa, sb, K);
+    printf("  精确 %.4f, MinHash 估计 %.4f\n", exact, estimate);
+    assert(fabs(estimate - exact) < 0.1);
+    assert(minhash_similarity(sa, sa, K) == 1.0);
+
+    // 空集合与任何集合的相似度为 0
+    SparseVector *empty = shingle_vector("", &options);
+    uint64_t se[K];
+    minhash_signature(empty, se, K);
+    assert(sparse_vector_jaccard(empty, empty) == 0.0);
+    assert(minhash_similarity(se, se, K) == 0.0);
+    assert(minhash_similarity(se, sa, K) == 0.0);
+
+    sparse_vector_destroy(a);
+    sparse_vector_destroy(b);
+    sparse_vector_destroy(empty);
+    free(x);
+    free(y);
+    free(tail);
+    printf("Jaccard 与 MinHash 测试通过！\n");
+}
+
+void test_collection_shingles() {
+    printf("测试集合的 shingle 特征...\n");
+
+    size_t base = current_total();
+    const char *names[] = {"a.txt", "b.txt", "c.txt"};
+    const char *texts[] = {
+        "alpha beta gamma delta epsilon zeta",
+        "gamma delta epsilon zeta eta theta",
+        "zeta epsilon delta gamma beta alpha"
+    };
+    size_t lengths[3];
+    for (int i = 0; i < 3; i++) lengths[i] = strlen(texts[i]);
+
+    DocumentCollection *col = load_documents_from_buffers(names, texts, lengths, 3, NULL);
+    assert(col && col->count == 3);
+
+    ShingleOptions options = make_options(3, 1);
+    assert(collection_set_shingles(col, &options));
+    assert(!collection_set_weighting(col, WEIGHT_TFIDF));
+
+    // 矩阵引擎使用 shingle 向量
+    SimilarityMatrix *matrix = similarity_matrix_create(col);
+    assert(matrix);
+    SparseVector *va = shingle_vector(texts[0], &options);
+    SparseVector *vb = shingle_vector(texts[1], &options);
+    assert(fabs(matrix->matrix[0][1] - sparse_vector_cosine(va, vb)) < 1e-12);
+    assert(fabs(matrix->matrix[0][1] - 0.5) < 1e-12);
+    assert(matrix->matrix[0][2] == 0.0);
+    sparse_vector_destroy(va);
+    sparse_vector_destroy(vb);
+
+    // 增量加入的文档同样使用 shingle 特征
+    const char *copy = "alpha beta gamma delta epsilon zeta";
+    Document *doc = document_create_from_buffer("d.txt", copy, strlen(copy));
+    assert(document_process(doc, NULL));
+    assert(similarity_matrix_add_document(matrix, col, doc));
+    assert(fabs(matrix->matrix[3][0] - 1.0) < 1e-12);
+    assert(matrix->matrix[3][2] == 0.0);
+    similarity_matrix_destroy(matrix);
+
+    // 宽度为 0 时恢复词频特征
+    ShingleOptions off;
+    shingle_options_init(&off);
+    assert(collection_set_shingles(col, &off));
+    assert(!shingle_options_active(&col->shingles));
+    assert(fabs(document_vector_similarity(col->documents[0], col->documents[2]) - 1.0) < 1e-12);
+
+    collection_destroy(col);
+    assert(current_total() == base);
+    printf("集合 shingle 特征测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("Shingle 特征测试套件\n");
+    printf("========================================\n\n");
+
+    test_rolling_hash();
+    test_word_order();
+    test_sampling();
+    test_jaccard_minhash();
+    test_collection_shingles();
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include "sim_context.h"
+#include "arena.h"
+#include "test_fixtures.h"
+
+#define DOC_COUNT 24
+#define THREAD_COUNT 4
+#define ROUNDS 20
+
+static TestCorpus corpus;
+
+static bool same_matrix(SimilarityMatrix *a, SimilarityMatrix *b) {
+    if (!a || !b || a->size != b->size) return false;
+    for (size_t i = 0; i < a->size; i++) {
+        if (strcmp(a->filenames[i], b->filenames[i]) != 0) return false;
+        if (memcmp(a->matrix[i], b->matrix[i], a->size * sizeof(double)) != 0) return false;
+    }
+    return true;
+}
+
+void test_arena() {
+    printf("测试内存池...\n");
+
+    Arena *arena = arena_create(256);
+    assert(arena != NULL);
+
+    char *small = arena_strndup(arena, "hello world", 5);
+    assert(strcmp(small, "hello") == 0);
+    assert(((size_t)small & 15) == 0);
+
+    // 大对象单独成块，不影响后续小对象
+    char *big = (char*)arena_alloc(arena, 4096);
+    memset(big, 'x', 4096);
+    double *values = (double*)arena_alloc(arena, 3 * sizeof(double));
+    assert(((size_t)values & 15) == 0);
+    values[2] = 1.5;
+    assert(strcmp(small, "hello") == 0);
+    assert(arena_bytes_used(arena) >= 4096 + 3 * sizeof(double));
+
+    for (int i = 0; i < 1000; i++) {
+        assert(arena_alloc(arena, 1 + i % 40) != NULL);
+    }
+    arena_reset(arena);
+    assert(arena_bytes_used(arena) == 0);
+    assert(arena_strndup(arena, "again", 5) != NULL);
+
+    arena_destroy(arena);
+    printf("内存池测试通过！\n");
+}
+
+void test_context_matches_direct() {
+    printf("测试上下文计算结果...\n");
+
+    StopWords *sw = stop_words_create();
+    SimilarityMatrix *expected = similarity_matrix_from_buffers(corpus.names, corpus.buffers,
+                                                                corpus.lengths, DOC_COUNT, sw);
+
+    SimContext *ctx = sim_context_create(NULL);
+    SimilarityMatrix *matrix = sim_context_matrix_from_buffers(ctx, corpus.names, corpus.buffers,
+                                                               corpus.lengths, DOC_COUNT);
+    assert(same_matrix(expected, matrix));
+    assert(sim_context_last_error(ctx)[0] == '\0');
+    similarity_matrix_destroy(matrix);
+
+    // 多线程与私有仓库配置结果相同
+    SimConfig config = sim_config_default();
+    config.threads = 3;
+    config.store_budget = 1 << 20;
+    config.pair_cache_entries = 256;
+    SimContext *threaded = sim_context_create(&config);
+    for (int round = 0; round < 2; round++) {
+        matrix = sim_context_matrix_from_buffers(threaded, corpus.names, corpus.buffers, corpus.lengths, DOC_COUNT);
+        assert(same_matrix(expected, matrix));
+        similarity_matrix_destroy(matrix);
+    }
+
+    // 停用词只影响所属上下文
+    assert(sim_context_add_stop_word(ctx, "ALPHA"));
+    matrix = sim_context_matrix_from_buffers(ctx, corpus.names, corpus.buffers, corpus.lengths, DOC_COUNT);
+    assert(!same_matrix(expected, matrix));
+    similarity_matrix_destroy(matrix);
+    matrix = sim_context_matrix_from_buffers(threaded, corpus.names, corpus.buffers, corpus.lengths, DOC_COUNT);
+    assert(same_matrix(expected, matrix));
+    similarity_matrix_destroy(matrix);
+
+    // 中文切分长度同样属于上下文：文本相似度 / 相似文本度
+    const char *cn_names[] = {"a.txt", "b.txt"};
+    const char *cn_buffers[] = {"\xE6\x96\x87\xE6\x9C\xAC\xE7\x9B\xB8\xE4\xBC\xBC\xE5\xBA\xA6",
+                                "\xE7\x9B\xB8\xE4\xBC\xBC\xE6\x96\x87\xE6\x9C\xAC\xE5\xBA\xA6"};
+    const size_t cn_lengths[] = {15, 15};
+    SimConfig unigram = sim_config_default();
+    unigram.cjk_ngram = 1;
+    SimContext *uni = sim_context_create(&unigram);
+    matrix = sim_context_matrix_from_buffers(uni, cn_names, cn_buffers, cn_lengths, 2);
+    assert(fabs(matrix->matrix[0][1] - 1.0) < 1e-9);
+    similarity_matrix_destroy(matrix);
+    matrix = sim_context_matrix_from_buffers(ctx, cn_names, cn_buffers, cn_lengths, 2);
+    assert(fabs(matrix->matrix[0][1] - 0.5) < 1e-9);
+    similarity_matrix_destroy(matrix);
+    sim_context_destroy(uni);
+    unigram.cjk_ngram = CJK_NGRAM_MAX + 1;
+    assert(sim_context_create(&unigram) == NULL);
+
+    // 错误记录在上下文中
+    assert(sim_context_matrix_from_dir(ctx, "no/such/dir") == NULL);
+    assert(strstr(sim_context_last_error(ctx), "no/such/dir") != NULL);
+    assert(!sim_context_load_stop_words(ctx, "no/such/file.txt"));
+    sim_context_clear_error(ctx);
+    assert(sim_context_last_error(ctx)[0] == '\0');
+
+    sim_context_destroy(threaded);
+    sim_context_destroy(ctx);
+    similarity_matrix_destroy(expected);
+    stop_words_destroy(sw);
+    printf("上下文计算结果测试通过！\n");
+}
+
+typedef struct Worker {
+    pthread_t thread;
+    SimConfig config;
+    SimilarityMatrix *expected;
+    int offset;
+    bool ok;
+} Worker;
+
+static void* run_worker(void *arg) {
+    Worker *worker = (Worker*)arg;
+    SimContext *ctx = sim_context_create(&worker->config);
+    worker->ok = ctx != NULL;
+
+    for (int round = 0; ctx && round < ROUNDS; round++) {
+        // 各线程提交不同的子集，交替命中和未命中仓库
+        size_t start = (size_t)(worker->offset + round) % (DOC_COUNT / 2);
+        size_t count = DOC_COUNT / 2;
+        SimilarityMatrix *matrix = sim_context_matrix_from_buffers(ctx, corpus.names + start, corpus.buffers + start,
+                                                                   corpus.lengths + start, count);
+        if (!matrix || matrix->size != count) {
+            worker->ok = false;
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                for (size_t j = 0; j < count; j++) {
+                    if (matrix->matrix[i][j] != worker->expected->matrix[start + i][start + j]) {
+                        worker->ok = false;
+                    }
+                }
+            }
+        }
+        similarity_matrix_destroy(matrix);
+    }
+
+    sim_context_destroy(ctx);
+    return NULL;
+}
+
+static void run_workers(DocumentStore *shared, SimilarityMatrix *expected) {
+    Worker workers[THREAD_COUNT];
+    for (int t = 0; t < THREAD_COUNT; t++) {
+        workers[t].config = sim_config_default();
+        workers[t].config.threads = 1 + t % 2;
+        workers[t].config.shared_store = shared;
+        workers[t].expected = expected;
+        workers[t].offset = t * 3;
+        assert(pthread_create(&workers[t].thread, NULL, run_worker, &workers[t]) == 0);
+    }
+    for (int t = 0; t < THREAD_COUNT; t++) {
+        pthread_join(workers[t].thread, NULL);
+        assert(workers[t].ok);
+    }
+}
+
+void test_concurrent_contexts() {
+    printf("测试多个上下文并发计算...\n");
+
+    StopWords *sw = stop_words_create();
+    SimilarityMatrix *expected = similarity_matrix_from_buffers(corpus.names, corpus.buffers,
+                                                                corpus.lengths, DOC_COUNT, sw);
+
+    // 互相独立的上下文
+    run_workers(NULL, expected);
+
+    // 共享同一个仓库，预算较小以便并发时发生淘汰
+    DocumentStore *store = doc_store_create(sw, 2048, 64);
+    run_workers(store, expected);
+
+    DocStoreStats stats;
+    doc_store_get_stats(store, &stats);
+    assert(stats.doc_hits > 0);
+    assert(stats.doc_hits + stats.doc_misses == (size_t)THREAD_COUNT * ROUNDS * (DOC_COUNT / 2));
+
+    doc_store_destroy(store);
+    similarity_matrix_destroy(expected);
+    stop_words_destroy(sw);
+    printf("并发计算测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("计算上下文测试套件\n");
+    printf("========================================\n\n");
+
+    corpus = test_corpus_create(DOC_COUNT, 17, 10, 3, 14);
+    test_arena();
+    test_context_matches_direct();
+    test_concurrent_contexts();
+
+    test_corpus_destroy(&corpus);
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
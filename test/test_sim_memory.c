@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "sim_memory.h"
+#include "sim_stats.h"
+#include "file_manager.h"
+#include "neighbors.h"
+
+static size_t current(MemoryTag tag) {
+    MemoryStats stats;
+    sim_memory_get(&stats);
+    return stats.current[tag];
+}
+
+static size_t current_total(void) {
+    MemoryStats stats;
+    sim_memory_get(&stats);
+    return stats.current_total;
+}
+
+void test_accounting() {
+    printf("测试分类记账...\n");
+
+    size_t base = current_total();
+    char *a = (char*)sim_memory_alloc(MEM_UI, 1000);
+    assert(a != NULL);
+    assert(current(MEM_UI) == 1000);
+
+    a = (char*)sim_memory_realloc(MEM_UI, a, 1000, 3000);
+    assert(a != NULL);
+    assert(current(MEM_UI) == 3000);
+    a = (char*)sim_memory_realloc(MEM_UI, a, 3000, 500);
+    assert(current(MEM_UI) == 500);
+
+    char *s = sim_memory_strdup(MEM_PAIRS, "hello");
+    assert(strcmp(s, "hello") == 0);
+    assert(current(MEM_PAIRS) == 6);
+
+    MemoryStats stats;
+    sim_memory_get(&stats);
+    assert(stats.peak[MEM_UI] >= 3000);
+    assert(stats.peak_total >= base + 3000);
+    assert(stats.current_total == base + 506);
+
+    sim_memory_free(MEM_UI, a, 500);
+    sim_memory_free(MEM_PAIRS, s, 6);
+    assert(current_total() == base);
+
+    // 峰值重置为当前值
+    sim_memory_reset_peak();
+    sim_memory_get(&stats);
+    assert(stats.peak[MEM_UI] == 0);
+    assert(stats.peak_total == base);
+    assert(strcmp(memory_tag_name(MEM_HASHTABLE), "hashtable") == 0);
+
+    printf("分类记账测试通过！\n");
+}
+
+void test_pipeline_balanced() {
+    printf("测试处理流程的分配与释放相抵...\n");
+
+    assert(current_total() == 0);
+
+    const char *names[] = {"a.txt", "b.txt", "c.txt"};
+    const char *texts[] = {
+        "the quick brown fox jumps over the lazy dog",
+        "the quick brown cat sleeps",
+        "completely different words here"
+    };
+    size_t lengths[3];
+    for (int i = 0; i < 3; i++) lengths[i] = strlen(texts[i]);
+
+    StopWords *sw = stop_words_create();
+    DocumentCollection *col = load_documents_from_buffers(names, texts, lengths, 3, sw);
+    assert(col && col->count == 3);
+    assert(current(MEM_HASHTABLE) > 0);
+    assert(current(MEM_DOCUMENT) > 0);
+
+    SimilarityMatrix *matrix = similarity_matrix_create(col);
+    assert(matrix != NULL);
+    assert(current(MEM_VECTOR) > 0);
+    assert(current(MEM_MATRIX) >= 9 * sizeof(double));
+
+    size_t count = 0;
+    SimilarityPair *pairs = find_top_similarities(matrix, 2, &count);
+    assert(pairs && count == 2);
+    free(pairs);
+    SimilarityEdges *edges = similarity_matrix_pairs_above(matrix, 0.0);
+    assert(edges && current(MEM_PAIRS) > 0);
+    similarity_edges_destroy(edges);
+
+    MemoryStats stats;
+    sim_memory_get(&stats);
+    // 临时的全部文档对缓冲区计入峰值
+    assert(stats.peak[MEM_PAIRS] >= 3 * sizeof(SimilarityPair));
+
+    // 增量更新：扩容与移除
+    Document *doc = document_create_from_buffer("d.txt", "quick brown fox", 15);
+    assert(document_process(doc, sw));
+    assert(similarity_matrix_add_document(matrix, col, doc));
+    assert(similarity_matrix_remove_document(matrix, col, 0));
+
+    similarity_matrix_destroy(matrix);
+    collection_destroy(col);
+    stop_words_destroy(sw);
+
+    sim_memory_get(&stats);
+    for (int i = 0; i < MEM_TAG_COUNT; i++) {
+        assert(stats.current[i] == 0);
+    }
+    assert(stats.current_total == 0);
+
+    printf("分配与释放相抵测试通过！\n");
+}
+
+void test_budget() {
+    printf("测试内存预算...\n");
+
+    sim_memory_set_budget(64 * 1024);
+    assert(!sim_memory_budget_exceeded());
+
+    // 超出预算的分配失败，不计入
+    void *big = sim_memory_alloc(MEM_MATRIX, 1024 * 1024);
+    assert(big == NULL);
+    assert(sim_memory_budget_exceeded());
+    assert(current(MEM_MATRIX) == 0);
+
+    // 哈希表在预算内正常工作，超出后插入失败而不是崩溃
+    HashTable *table = hash_table_create(16);
+    assert(table != NULL);
+    char word[32];
+    size_t inserted = 0;
+    for (int i = 0; i < 10000; i++) {
+        snprintf(word, sizeof(word), "word%05d", i);
+        if (hash_table_insert(table, word, 1)) inserted++;
+    }
+    assert(inserted > 0 && inserted < 10000);
+    assert(current_total() <= 64 * 1024);
+
+    MemoryStats stats;
+    sim_memory_get(&stats);
+    assert(stats.budget == 64 * 1024);
+    assert(stats.rejected > 1);
+    assert(stats.peak_total <= 64 * 1024);
+
+    hash_table_destroy(table);
+    assert(current_total() == 0);
+
+    // 统计接口同样报告内存
+    SimilarityStats all;
+    similarity_stats_get(&all);
+    assert(all.memory.budget == 64 * 1024);
+    assert(all.memory.rejected == stats.rejected);
+
+    sim_memory_set_budget(0);
+    assert(!sim_memory_budget_exceeded());
+    big = sim_memory_alloc(MEM_MATRIX, 1024 * 1024);
+    assert(big != NULL);
+    sim_memory_free(MEM_MATRIX, big, 1024 * 1024);
+
+    printf("内存预算测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("内存统计测试套件\n");
+    printf("========================================\n\n");
+
+    test_accounting();
+    test_pipeline_balanced();
+    test_budget();
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
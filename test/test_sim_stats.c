@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "sim_stats.h"
+#include "text_processor.h"
+#include "vector_math.h"
+
+#define THREADS 4
+#define ADDS_PER_THREAD 10000
+
+static void* add_counts(void *arg) {
+    (void)arg;
+    for (int i = 0; i < ADDS_PER_THREAD; i++) {
+        similarity_stats_add(STAT_PAIRS, 1);
+        similarity_stats_add_time(STAT_PHASE_SCORE, 2);
+    }
+    return NULL;
+}
+
+void test_thread_totals() {
+    printf("测试多线程计数汇总...\n");
+
+    similarity_stats_reset();
+    similarity_stats_add(STAT_PAIRS, 5);
+
+    // 线程退出后其计数仍计入总数
+    pthread_t threads[THREADS];
+    for (int t = 0; t < THREADS; t++) {
+        assert(pthread_create(&threads[t], NULL, add_counts, NULL) == 0);
+    }
+    for (int t = 0; t < THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    SimilarityStats stats;
+    similarity_stats_get(&stats);
+    assert(stats.counters[STAT_PAIRS] == 5 + THREADS * ADDS_PER_THREAD);
+    assert(stats.phase_ns[STAT_PHASE_SCORE] == 2ULL * THREADS * ADDS_PER_THREAD);
+
+    // 复用已退出线程的计数区
+    for (int t = 0; t < THREADS; t++) {
+        assert(pthread_create(&threads[t], NULL, add_counts, NULL) == 0);
+        pthread_join(threads[t], NULL);
+    }
+    similarity_stats_get(&stats);
+    assert(stats.counters[STAT_PAIRS] == 5 + 2 * THREADS * ADDS_PER_THREAD);
+
+    similarity_stats_reset();
+    similarity_stats_get(&stats);
+    for (int i = 0; i < STAT_COUNTER_COUNT; i++) assert(stats.counters[i] == 0);
+    for (int i = 0; i < STAT_PHASE_COUNT; i++) assert(stats.phase_ns[i] == 0);
+
+    printf("多线程计数测试通过！\n");
+}
+
+void test_instrumentation() {
+    printf("测试处理流程埋点...\n");
+
+    similarity_stats_reset();
+    const char *text = "the quick brown fox jumps over the lazy dog";
+    Document *doc = document_create_from_buffer("a.txt", text, strlen(text));
+    StopWords *sw = stop_words_create();
+    assert(document_process(doc, sw));
+    assert(document_vector(doc) != NULL);
+
+    SimilarityStats stats;
+    similarity_stats_get(&stats);
+    assert(stats.enabled == similarity_stats_enabled());
+    if (stats.enabled) {
+        assert(stats.counters[STAT_TOKENS] == 9);
+        assert(stats.counters[STAT_STOP_WORDS] == 2);
+        assert(stats.counters[STAT_HASH_INSERTS] == 7);
+        assert(stats.counters[STAT_VECTORS] == 1);
+    } else {
+        // 默认构建中埋点被编译掉
+        assert(stats.counters[STAT_TOKENS] == 0);
+        assert(stats.counters[STAT_VECTORS] == 0);
+    }
+
+    document_destroy(doc);
+    stop_words_destroy(sw);
+    printf("埋点测试通过！\n");
+}
+
+void test_print() {
+    printf("测试统计输出...\n");
+
+    similarity_stats_reset();
+    similarity_stats_add(STAT_TOKENS, 1000);
+    similarity_stats_add_time(STAT_PHASE_TOKENIZE, 1000000);
+
+    SimilarityStats stats;
+    similarity_stats_get(&stats);
+    FILE *out = tmpfile();
+    assert(out != NULL);
+    similarity_stats_print(&stats, out, true);
+    rewind(out);
+    char buffer[1024];
+    size_t n = fread(buffer, 1, sizeof(buffer) - 1, out);
+    buffer[n] = '\0';
+    fclose(out);
+
+    assert(strstr(buffer, "\"tokens\": 1000") != NULL);
+    assert(strstr(buffer, "\"tokenize\": 1.000") != NULL);
+    assert(strstr(buffer, "\"tokens_per_sec\": 1000000.0") != NULL);
+    assert(strcmp(stat_phase_name(STAT_PHASE_HASH_INSERT), "hash_insert") == 0);
+    assert(strcmp(stat_counter_name(STAT_HASH_PROBES), "hash_probes") == 0);
+
+    similarity_stats_reset();
+    printf("统计输出测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("运行统计测试套件\n");
+    printf("========================================\n\n");
+
+    test_thread_totals();
+    test_instrumentation();
+    test_print();
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
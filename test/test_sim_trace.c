@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "sim_trace.h"
+#include "text_processor.h"
+#include "vector_math.h"
+
+#define THREADS 4
+#define SPANS_PER_THREAD 100
+
+static const char *trace_path = "build/test_trace.json";
+static pthread_barrier_t barrier;
+
+static void* record_spans(void *arg) {
+    (void)arg;
+    // 先各自取得缓冲区再等待，保证所有线程同时持有缓冲区
+    TRACE_BEGIN(start);
+    TRACE_END(start, "thread_start", 0);
+    pthread_barrier_wait(&barrier);
+    for (int i = 0; i < SPANS_PER_THREAD; i++) {
+        TRACE_BEGIN(span);
+        TRACE_END(span, "test_span", i);
+    }
+    return NULL;
+}
+
+static char* read_file(const char *path) {
+    FILE *file = fopen(path, "rb");
+    assert(file != NULL);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *data = (char*)malloc((size_t)size + 1);
+    assert(fread(data, 1, (size_t)size, file) == (size_t)size);
+    data[size] = '\0';
+    fclose(file);
+    return data;
+}
+
+static size_t count_occurrences(const char *text, const char *needle) {
+    size_t count = 0;
+    for (const char *p = strstr(text, needle); p; p = strstr(p + 1, needle)) count++;
+    return count;
+}
+
+void test_disabled() {
+    printf("测试未开启时不记录...\n");
+
+    assert(!sim_trace_enabled());
+    TRACE_BEGIN(span);
+    assert(span == 0);
+    TRACE_END(span, "ignored", 0);
+    assert(sim_trace_event_count() == 0);
+
+    printf("未开启测试通过！\n");
+}
+
+void test_threads_and_export() {
+    printf("测试多线程记录与导出...\n");
+
+    sim_trace_start(0);
+    assert(sim_trace_enabled());
+
+    pthread_t threads[THREADS];
+    pthread_barrier_init(&barrier, NULL, THREADS);
+    for (int t = 0; t < THREADS; t++) {
+        assert(pthread_create(&threads[t], NULL, record_spans, NULL) == 0);
+    }
+    for (int t = 0; t < THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    pthread_barrier_destroy(&barrier);
+
+    // 处理流程中的埋点
+    const char *text = "alpha beta gamma";
+    Document *doc = document_create_from_buffer("a.txt", text, strlen(text));
+    assert(document_process(doc, NULL));
+    size_t vocab_size = 0;
+    char **vocab = build_vocabulary(&doc, 1, &vocab_size);
+    assert(vocab && vocab_size == 3);
+    for (size_t i = 0; i < vocab_size; i++) free(vocab[i]);
+    free(vocab);
+    document_destroy(doc);
+
+    assert(sim_trace_event_count() == THREADS * (SPANS_PER_THREAD + 1) + 2);
+    assert(sim_trace_stop(trace_path));
+    assert(!sim_trace_enabled());
+
+    char *json = read_file(trace_path);
+    assert(strncmp(json, "{\"displayTimeUnit\"", 18) == 0);
+    assert(count_occurrences(json, "\"name\": \"test_span\"") == THREADS * SPANS_PER_THREAD);
+    assert(count_occurrences(json, "\"name\": \"tokenize\"") == 1);
+    assert(count_occurrences(json, "\"name\": \"vocab\"") == 1);
+    assert(count_occurrences(json, "\"ph\": \"M\"") == THREADS);
+    assert(strstr(json, "\"args\": {\"n\": 3}") != NULL);
+    // 主线程复用了已退出线程的缓冲区，不会新增线程
+    assert(strstr(json, "\"tid\": 5") == NULL);
+    free(json);
+
+    // 停止后不再记录
+    TRACE_BEGIN(span);
+    assert(span == 0);
+
+    printf("多线程记录测试通过！\n");
+}
+
+void test_ring_overwrite() {
+    printf("测试环形缓冲区覆盖...\n");
+
+    // 重新开始时清空之前的事件；已分配的缓冲区保持原容量
+    sim_trace_start(0);
+    assert(sim_trace_event_count() == 0);
+    for (int i = 0; i < SIM_TRACE_DEFAULT_EVENTS + 10; i++) {
+        TRACE_BEGIN(span);
+        TRACE_END(span, "overwrite", i);
+    }
+    assert(sim_trace_event_count() == SIM_TRACE_DEFAULT_EVENTS);
+    assert(sim_trace_stop(trace_path));
+
+    char *json = read_file(trace_path);
+    assert(count_occurrences(json, "\"name\": \"overwrite\"") == SIM_TRACE_DEFAULT_EVENTS);
+    // 最早的 10 个事件被覆盖
+    assert(strstr(json, "\"args\": {\"n\": 9}}") == NULL);
+    assert(strstr(json, "\"args\": {\"n\": 10}}") != NULL);
+    free(json);
+    remove(trace_path);
+
+    printf("环形缓冲区测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("事件追踪测试套件\n");
+    printf("========================================\n\n");
+
+    test_disabled();
+    test_threads_and_export();
+    test_ring_overwrite();
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
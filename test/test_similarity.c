@@ -5,6 +5,7 @@
 #include <math.h>
 #include "text_processor.h"
 #include "vector_math.h"
+#include "file_manager.h"
 
 void test_document_processing() {
     printf("测试文档处理...\n");
@@ -94,6 +95,174 @@ void test_jaccard_similarity() {
     printf("Jaccard相似度测试通过！\n");
 }
 
+static Document* make_document(const char *name, const char *content) {
+    Document *doc = document_create(name);
+    doc->content = strdup(content);
+    assert(document_process(doc, NULL));
+    return doc;
+}
+
+static void assert_matrix_matches_full(SimilarityMatrix *matrix, DocumentCollection *col) {
+    assert(matrix->size == col->count);
+    size_t stride = similarity_matrix_stride(matrix);
+    for (size_t i = 0; i < col->count; i++) {
+        assert(strcmp(matrix->filenames[i], col->documents[i]->filename) == 0);
+        // 行指针始终指向连续缓冲区
+        assert(matrix->matrix[i] == similarity_matrix_data(matrix) + i * stride);
+        for (size_t j = 0; j < col->count; j++) {
+            double expected = i == j ? 1.0 :
+                document_cosine_similarity(col->documents[i], col->documents[j]);
+            assert(fabs(matrix->matrix[i][j] - expected) < 0.0001);
+        }
+    }
+}
+
+void test_incremental_matrix() {
+    printf("测试增量相似度矩阵...\n");
+    
+    const char *texts[] = {
+        "apple banana cherry apple",
+        "banana cherry date",
+        "apple apple apple fig",
+        "grape fig date banana",
+        "cherry cherry apple grape",
+        "kiwi lemon mango",
+        "banana kiwi apple lemon",
+        "date date fig fig grape",
+        "mango apple cherry",
+        "lemon lemon banana"
+    };
+    size_t text_count = sizeof(texts) / sizeof(texts[0]);
+    
+    DocumentCollection *col = collection_create(2);
+    collection_add_document(col, make_document("doc0", texts[0]));
+    collection_add_document(col, make_document("doc1", texts[1]));
+    
+    SimilarityMatrix *matrix = similarity_matrix_create(col);
+    assert(matrix != NULL);
+    
+    // 逐个添加，容量应按倍数增长
+    for (size_t i = 2; i < text_count; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "doc%zu", i);
+        assert(similarity_matrix_add_document(matrix, col, make_document(name, texts[i])));
+        assert(matrix->capacity >= matrix->size);
+        assert_matrix_matches_full(matrix, col);
+    }
+    assert(matrix->size == text_count);
+    
+    // 替换文档内容，只重算对应行列
+    assert(similarity_matrix_update_document(matrix, col, 3, make_document("doc3", "kiwi kiwi lemon")));
+    assert_matrix_matches_full(matrix, col);
+    
+    // 删除中间、开头和末尾的文档
+    assert(similarity_matrix_remove_document(matrix, col, 4));
+    assert_matrix_matches_full(matrix, col);
+    assert(similarity_matrix_remove_document(matrix, col, 0));
+    assert_matrix_matches_full(matrix, col);
+    assert(similarity_matrix_remove_document(matrix, col, matrix->size - 1));
+    assert_matrix_matches_full(matrix, col);
+    assert(!similarity_matrix_remove_document(matrix, col, matrix->size));
+    
+    // 删除到只剩一个后容量收缩
+    size_t capacity = matrix->capacity;
+    while (matrix->size > 1) {
+        assert(similarity_matrix_remove_document(matrix, col, 0));
+    }
+    assert(matrix->capacity < capacity);
+    assert_matrix_matches_full(matrix, col);
+    
+    // 再次添加
+    assert(similarity_matrix_add_document(matrix, col, make_document("again", texts[0])));
+    assert_matrix_matches_full(matrix, col);
+    
+    similarity_matrix_destroy(matrix);
+    collection_destroy(col);
+    printf("增量相似度矩阵测试通过！\n");
+}
+
+void test_contiguous_buffer() {
+    printf("测试连续矩阵缓冲区...\n");
+    
+    DocumentCollection *col = collection_create(4);
+    collection_add_document(col, make_document("a", "apple banana cherry"));
+    collection_add_document(col, make_document("b", "apple banana kiwi"));
+    collection_add_document(col, make_document("c", "kiwi lemon"));
+    SimilarityMatrix *matrix = similarity_matrix_create(col);
+    
+    size_t rows, cols;
+    similarity_matrix_shape(matrix, &rows, &cols);
+    assert(rows == 3 && cols == 3);
+    assert(similarity_matrix_stride(matrix) == 3);
+    
+    // 扩容后行距变大，形状不变
+    assert(similarity_matrix_add_document(matrix, col, make_document("d", "lemon mango")));
+    size_t stride = similarity_matrix_stride(matrix);
+    assert(stride >= 4);
+    similarity_matrix_shape(matrix, &rows, &cols);
+    assert(rows == 4 && cols == 4);
+    
+    float *packed = similarity_matrix_to_f32(matrix);
+    assert(packed != NULL);
+    for (size_t i = 0; i < 4; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            assert(packed[i * 4 + j] == (float)matrix->matrix[i][j]);
+        }
+    }
+    similarity_buffer_free(packed);
+    
+    double expected = matrix->matrix[2][3];
+    size_t size;
+    double *data = similarity_matrix_detach_data(matrix, &size, &stride);
+    assert(data != NULL);
+    assert(size == 4);
+    assert(data[2 * stride + 3] == expected);
+    assert(data[3 * stride + 3] == 1.0);
+    similarity_buffer_free(data);
+    
+    collection_destroy(col);
+    printf("连续矩阵缓冲区测试通过！\n");
+}
+
+void test_buffer_documents() {
+    printf("测试内存缓冲区文档...\n");
+    
+    // 缓冲区不要求以 '\0' 结尾，只取 len 字节
+    const char *raw = "apple banana cherry|apple banana kiwi|kiwi lemon";
+    const char *names[] = {"a.txt", "empty.txt", "b.txt", "c.txt"};
+    const char *buffers[] = {raw, raw, raw + 20, raw + 38};
+    const size_t lengths[] = {19, 0, 17, 10};
+    
+    Document *doc = document_create_from_buffer("a.txt", raw, 19);
+    assert(doc != NULL);
+    assert(strcmp(doc->content, "apple banana cherry") == 0);
+    assert(strcmp(doc->filename, "a.txt") == 0);
+    document_destroy(doc);
+    assert(document_create_from_buffer("empty.txt", raw, 0) == NULL);
+    
+    StopWords *sw = stop_words_create();
+    DocumentCollection *col = load_documents_from_buffers(names, buffers, lengths, 4, sw);
+    assert(col != NULL);
+    assert(col->count == 3);
+    assert(strcmp(col->documents[2]->content, "kiwi lemon") == 0);
+    
+    SimilarityMatrix *expected = similarity_matrix_create(col);
+    SimilarityMatrix *matrix = similarity_matrix_from_buffers(names, buffers, lengths, 4, sw);
+    assert(matrix != NULL);
+    assert(matrix->size == 3);
+    assert(strcmp(matrix->filenames[1], "b.txt") == 0);
+    for (size_t i = 0; i < matrix->size; i++) {
+        assert(memcmp(matrix->matrix[i], expected->matrix[i], matrix->size * sizeof(double)) == 0);
+    }
+    assert(fabs(matrix->matrix[0][1] - 2.0 / 3.0) < 0.0001);
+    
+    similarity_matrix_destroy(matrix);
+    similarity_matrix_destroy(expected);
+    collection_destroy(col);
+    stop_words_destroy(sw);
+    printf("内存缓冲区文档测试通过！\n");
+}
+
 int main() {
     printf("开始相似度测试...\n\n");
     
@@ -106,6 +275,15 @@ int main() {
     test_jaccard_similarity();
     printf("\n");
     
+    test_incremental_matrix();
+    printf("\n");
+    
+    test_contiguous_buffer();
+    printf("\n");
+    
+    test_buffer_documents();
+    printf("\n");
+    
     printf("所有相似度测试通过！\n");
     return 0;
 }
\ No newline at end of file
@@ -177,6 +177,136 @@ void test_empty_document() {
     printf("空文档测试通过！\n");
 }
 
+void test_utf8_decode() {
+    printf("测试 UTF-8 解码...\n");
+    
+    uint32_t cp;
+    assert(utf8_decode("a", &cp) == 1 && cp == 'a');
+    assert(utf8_decode("", &cp) == 0);
+    assert(utf8_decode("\xC3\xA9", &cp) == 2 && cp == 0xE9);            // é
+    assert(utf8_decode("\xE4\xB8\xAD", &cp) == 3 && cp == 0x4E2D);      // 中
+    assert(utf8_decode("\xF0\x9F\x98\x80", &cp) == 4 && cp == 0x1F600);
+    
+    // 非法序列只消耗一个字节：孤立的后续字节、过长编码、代理区、截断
+    assert(utf8_decode("\x80", &cp) == 1 && cp == UTF8_INVALID);
+    assert(utf8_decode("\xC0\xAF", &cp) == 1 && cp == UTF8_INVALID);
+    assert(utf8_decode("\xED\xA0\x80", &cp) == 1 && cp == UTF8_INVALID);
+    assert(utf8_decode("\xE4\xB8", &cp) == 1 && cp == UTF8_INVALID);
+    
+    assert(char_class('x') == CHAR_WORD);
+    assert(char_class('7') == CHAR_SEPARATOR);
+    assert(char_class(0xE9) == CHAR_WORD);
+    assert(char_class(0x4E2D) == CHAR_CJK);
+    assert(char_class(0x3042) == CHAR_CJK);        // あ
+    assert(char_class(0xD55C) == CHAR_CJK);        // 한
+    assert(char_class(0x3002) == CHAR_SEPARATOR);  // 。
+    assert(char_class(0xFF0C) == CHAR_SEPARATOR);  // ，
+    assert(char_class(0xFEFF) == CHAR_SEPARATOR);
+    
+    printf("UTF-8 解码测试通过！\n");
+}
+
+void test_token_stream() {
+    printf("测试中英混合分词...\n");
+    
+    const char *text = "caf\xC3\xA9\xE6\x96\x87\xE6\x9C\xAC\xEF\xBC\x8C don't 42";
+    const char *p = text;
+    Token token;
+    
+    assert(next_token(&p, &token) && token.kind == TOKEN_WORD);
+    assert(token.length == 5 && strncmp(token.start, "caf\xC3\xA9", 5) == 0);
+    assert(next_token(&p, &token) && token.kind == TOKEN_CJK);
+    assert(token.length == 6 && strncmp(token.start, "\xE6\x96\x87\xE6\x9C\xAC", 6) == 0);
+    assert(next_token(&p, &token) && token.kind == TOKEN_WORD);
+    assert(token.length == 5 && strncmp(token.start, "don't", 5) == 0);
+    assert(!next_token(&p, &token));
+    assert(*p == '\0');
+    
+    // get_next_word 同样在文字边界处切开
+    char copy[] = "abc\xE4\xB8\xAD";
+    char *cursor = copy;
+    char *word = get_next_word(&cursor);
+    assert(strcmp(word, "abc") == 0);
+    free(word);
+    word = get_next_word(&cursor);
+    assert(strcmp(word, "\xE4\xB8\xAD") == 0);
+    free(word);
+    assert(get_next_word(&cursor) == NULL);
+    
+    printf("中英混合分词测试通过！\n");
+}
+
+void test_cjk_ngrams() {
+    printf("测试中文 N 字切分...\n");
+    
+    // 文本相似度，文本。我
+    const char *text = "\xE6\x96\x87\xE6\x9C\xAC\xE7\x9B\xB8\xE4\xBC\xBC\xE5\xBA\xA6\xEF\xBC\x8C"
+                       "\xE6\x96\x87\xE6\x9C\xAC\xE3\x80\x82\xE6\x88\x91";
+    const char *wenben = "\xE6\x96\x87\xE6\x9C\xAC";
+    
+    assert(stop_words_cjk_ngram(NULL) == CJK_NGRAM_DEFAULT);
+    Document *doc = document_create_from_buffer("cn.txt", text, strlen(text));
+    assert(doc && document_process(doc, NULL));
+    // 文本 本相 相似 似度 | 文本 | 我（比 N 短的整段保留）
+    assert(doc->word_count == 6);
+    assert(doc->word_freq->size == 5);
+    assert(hash_table_get(doc->word_freq, wenben) == 2);
+    assert(hash_table_get(doc->word_freq, "\xE7\x9B\xB8\xE4\xBC\xBC") == 1);
+    assert(hash_table_get(doc->word_freq, "\xE6\x88\x91") == 1);
+    assert(hash_table_get(doc->word_freq, "\xEF\xBC\x8C") == -1);
+    
+    // 片段同样经过停用词过滤
+    document_destroy(doc);
+    StopWords *sw = stop_words_create();
+    assert(stop_words_add(sw, wenben));
+    doc = document_create_from_buffer("cn.txt", text, strlen(text));
+    assert(document_process(doc, sw));
+    assert(doc->word_count == 4);
+    assert(hash_table_get(doc->word_freq, wenben) == -1);
+    stop_words_destroy(sw);
+    document_destroy(doc);
+    
+    // 三字切分与单字切分：长度属于各自的停用词表，互不影响
+    StopWords *tri = stop_words_create();
+    StopWords *uni = stop_words_create();
+    assert(stop_words_cjk_ngram(tri) == CJK_NGRAM_DEFAULT);
+    assert(!stop_words_set_cjk_ngram(tri, 0) && !stop_words_set_cjk_ngram(tri, CJK_NGRAM_MAX + 1));
+    assert(stop_words_set_cjk_ngram(tri, 3) && stop_words_set_cjk_ngram(uni, 1));
+    doc = document_create_from_buffer("cn.txt", text, strlen(text));
+    assert(document_process(doc, tri));
+    assert(doc->word_count == 5);
+    assert(hash_table_get(doc->word_freq, "\xE6\x96\x87\xE6\x9C\xAC\xE7\x9B\xB8") == 1);
+    assert(hash_table_get(doc->word_freq, wenben) == 1);
+    document_destroy(doc);
+    
+    doc = document_create_from_buffer("cn.txt", text, strlen(text));
+    assert(document_process(doc, uni));
+    assert(doc->word_count == 8);
+    assert(hash_table_get(doc->word_freq, "\xE6\x96\x87") == 2);
+    document_destroy(doc);
+    stop_words_destroy(tri);
+    stop_words_destroy(uni);
+    
+    // 长段落：计数表多次扩容后片段数不变
+    char *long_text = (char*)malloc(3 * 5000 + 1);
+    char *q = long_text;
+    for (int i = 0; i < 5000; i++) {
+        uint32_t cp = 0x4E00 + (uint32_t)(i % 1000);
+        *q++ = (char)(0xE0 | (cp >> 12));
+        *q++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *q++ = (char)(0x80 | (cp & 0x3F));
+    }
+    *q = '\0';
+    doc = document_create_from_buffer("long.txt", long_text, strlen(long_text));
+    assert(document_process(doc, NULL));
+    assert(doc->word_count == 4999);
+    assert(doc->word_freq->size == 1000);
+    document_destroy(doc);
+    free(long_text);
+    
+    printf("中文 N 字切分测试通过！\n");
+}
+
 int main() {
     printf("========================================\n");
     printf("文本处理器测试套件\n");
@@ -190,6 +320,9 @@ int main() {
     test_document_processing();
     test_stop_words_file_loading();
     test_empty_document();
+    test_utf8_decode();
+    test_token_stream();
+    test_cjk_ngrams();
     
     printf("\n========================================\n");
     printf("所有测试通过！✓\n");
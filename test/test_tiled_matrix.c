@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "tiled_matrix.h"
+#include "test_fixtures.h"
+
+#define DOC_COUNT 37
+#define STORE_PATH "build/test_tiled.vectors"
+#define TILES_PATH "build/test_tiled.tiles"
+#define EPSILON 0.00001
+
+static DocumentCollection* make_collection() {
+    TestCorpus corpus = test_corpus_create(DOC_COUNT, 7, 10, 3, 14);
+    DocumentCollection *col = test_collection_create(&corpus);
+    test_corpus_destroy(&corpus);
+    return col;
+}
+
+static VectorStore* make_store(DocumentCollection *col) {
+    VectorStore *store = vector_store_create(STORE_PATH);
+    assert(store != NULL);
+    for (size_t i = 0; i < col->count; i++) {
+        assert(vector_store_append(store, col->documents[i]->filename,
+                                   document_vector(col->documents[i])));
+    }
+    return store;
+}
+
+void test_vector_store_roundtrip() {
+    printf("测试向量仓库读写...\n");
+
+    DocumentCollection *col = make_collection();
+    VectorStore *store = make_store(col);
+    assert(vector_store_count(store) == DOC_COUNT);
+
+    // 乱序读回
+    for (size_t k = 0; k < DOC_COUNT; k++) {
+        size_t i = (k * 7) % DOC_COUNT;
+        SparseVector *vec = vector_store_load(store, i);
+        SparseVector *expected = document_vector(col->documents[i]);
+        assert(vec != NULL);
+        assert(vec->size == expected->size);
+        assert(vec->norm == expected->norm);
+        assert(memcmp(vec->keys, expected->keys, vec->size * sizeof(uint64_t)) == 0);
+        assert(strcmp(vector_store_name(store, i), col->documents[i]->filename) == 0);
+        sparse_vector_destroy(vec);
+    }
+    assert(vector_store_load(store, DOC_COUNT) == NULL);
+
+    vector_store_destroy(store);
+    collection_destroy(col);
+    printf("向量仓库测试通过！\n");
+}
+
+void test_tiled_matches_in_memory() {
+    printf("测试分块矩阵与内存矩阵一致...\n");
+
+    DocumentCollection *col = make_collection();
+    SimilarityMatrix *matrix = similarity_matrix_create(col);
+    VectorStore *store = make_store(col);
+
+    // 预算只够容纳几行，强制产生多个分块
+    size_t budget = 5 * DOC_COUNT * sizeof(float) + 4096;
+    TiledMatrix *tm = similarity_matrix_create_tiled(store, budget, TILES_PATH, NULL);
+    assert(tm != NULL);
+    assert(tiled_matrix_size(tm) == DOC_COUNT);
+    assert(tiled_matrix_tile_rows(tm) < DOC_COUNT);
+
+    float row[DOC_COUNT];
+    for (size_t i = 0; i < DOC_COUNT; i++) {
+        assert(tiled_matrix_read_row(tm, i, row));
+        for (size_t j = 0; j < DOC_COUNT; j++) {
+            assert(fabs(row[j] - matrix->matrix[i][j]) < EPSILON);
+        }
+    }
+
+    // 乱序读取同样正确，跨块时重新补全
+    for (size_t k = 0; k < DOC_COUNT; k++) {
+        size_t i = (k * 11) % DOC_COUNT;
+        assert(tiled_matrix_read_row(tm, i, row));
+        for (size_t j = 0; j < DOC_COUNT; j++) {
+            assert(fabs(row[j] - matrix->matrix[i][j]) < EPSILON);
+        }
+    }
+    assert(!tiled_matrix_read_row(tm, DOC_COUNT, row));
+
+    // 只落盘上三角条带：约为全矩阵的 (N + 每块行数) / 2N
+    FILE *file = fopen(TILES_PATH, "rb");
+    assert(file != NULL);
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fclose(file);
+    size_t full = DOC_COUNT * DOC_COUNT * sizeof(float);
+    assert((size_t)file_size < full * (DOC_COUNT + tiled_matrix_tile_rows(tm)) / (2 * DOC_COUNT) + 64);
+
+    // 流式 Top-K 与内存版本一致
+    size_t count1, count2;
+    SimilarityPair *pairs1 = find_top_similarities(matrix, 5, &count1);
+    SimilarityPair *pairs2 = tiled_matrix_top_similarities(tm, 5, &count2);
+    assert(count1 == count2);
+    for (size_t i = 0; i < count1; i++) {
+        assert(fabs(pairs1[i].similarity - pairs2[i].similarity) < EPSILON);
+    }
+    free(pairs1);
+    free(pairs2);
+
+    vector_store_destroy(store);
+    tiled_matrix_destroy(tm);
+    similarity_matrix_destroy(matrix);
+    collection_destroy(col);
+    printf("分块矩阵测试通过！\n");
+}
+
+static void count_pair(const char *doc1, const char *doc2, double similarity, void *userdata) {
+    (void)doc1;
+    (void)doc2;
+    assert(similarity >= 0.5);
+    (*(size_t*)userdata)++;
+}
+
+void test_tiled_filter() {
+    printf("测试分块矩阵阈值筛选...\n");
+
+    DocumentCollection *col = make_collection();
+    SimilarityMatrix *matrix = similarity_matrix_create(col);
+    VectorStore *store = make_store(col);
+    TiledMatrix *tm = similarity_matrix_create_tiled(store, 1, TILES_PATH, NULL);
+    assert(tm != NULL);
+    assert(tiled_matrix_tile_rows(tm) == 1);
+
+    size_t expected = 0;
+    for (size_t i = 0; i < DOC_COUNT; i++) {
+        for (size_t j = i + 1; j < DOC_COUNT; j++) {
+            if ((float)matrix->matrix[i][j] >= 0.5) expected++;
+        }
+    }
+
+    size_t visited = 0;
+    assert(tiled_matrix_filter_pairs(tm, 0.5, count_pair, &visited) == expected);
+    assert(visited == expected);
+
+    vector_store_destroy(store);
+    tiled_matrix_destroy(tm);
+    similarity_matrix_destroy(matrix);
+    collection_destroy(col);
+    printf("阈值筛选测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("外存分块矩阵测试套件\n");
+    printf("========================================\n\n");
+
+    test_vector_store_roundtrip();
+    test_tiled_matches_in_memory();
+    test_tiled_filter();
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
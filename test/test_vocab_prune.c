@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "vocab_prune.h"
+#include "vector_math.h"
+#include "matrix_engine.h"
+#include "sim_memory.h"
+
+static const char *names[] = {"a.txt", "b.txt", "c.txt", "d.txt"};
+static const char *texts[] = {
+    "apple banana cherry common common",
+    "apple banana date common",
+    "apple egg common fig",
+    "grape common"
+};
+
+// 文档频率: common 4, apple 3, banana 2, 其余 1
+static DocumentCollection* load(StopWords *sw) {
+    size_t lengths[4];
+    for (int i = 0; i < 4; i++) lengths[i] = strlen(texts[i]);
+    DocumentCollection *col = load_documents_from_buffers(names, texts, lengths, 4, sw);
+    assert(col && col->count == 4);
+    return col;
+}
+
+static bool has(DocumentCollection *col, size_t doc, const char *term) {
+    return hash_table_get(col->documents[doc]->word_freq, term) != -1;
+}
+
+void test_document_frequency() {
+    printf("测试按文档频率裁剪...\n");
+
+    StopWords *sw = stop_words_create();
+    DocumentCollection *col = load(sw);
+    // 裁剪前已缓存的向量需要失效
+    assert(document_vector(col->documents[0])->size == 4);
+
+    PruneOptions options;
+    prune_options_init(&options);
+    assert(!prune_options_active(&options));
+    options.min_df = 2;
+    options.max_df = 0.9;
+    options.threads = 2;
+    assert(prune_options_active(&options));
+
+    PruneStats stats;
+    assert(collection_prune(col, &options, &stats));
+    assert(stats.vocab_before == 8 && stats.vocab_after == 2);
+    assert(stats.terms_before == 14 && stats.terms_after == 5);
+
+    assert(has(col, 0, "apple") && has(col, 0, "banana"));
+    assert(!has(col, 0, "common") && !has(col, 0, "cherry"));
+    assert(hash_table_get(col->documents[0]->word_freq, "apple") == 1);
+    assert(col->documents[3]->word_freq->size == 0);
+    assert(document_vector(col->documents[0])->size == 2);
+
+    // 全局词表与向量化都在裁剪后的空间上
+    size_t vocab_size = 0;
+    char **vocab = build_vocabulary(col->documents, col->count, &vocab_size);
+    assert(vocab && vocab_size == 2);
+    for (size_t i = 0; i < vocab_size; i++) free(vocab[i]);
+    free(vocab);
+
+    collection_destroy(col);
+
+    // 词表规模上限按文档频率保留
+    col = load(sw);
+    prune_options_init(&options);
+    options.max_vocab = 2;
+    assert(collection_prune(col, &options, &stats));
+    assert(stats.vocab_after == 2);
+    assert(has(col, 0, "common") && has(col, 0, "apple") && !has(col, 0, "banana"));
+    assert(has(col, 3, "common") && !has(col, 3, "grape"));
+    collection_destroy(col);
+
+    stop_words_destroy(sw);
+    printf("文档频率裁剪测试通过！\n");
+}
+
+void test_top_terms() {
+    printf("测试每文档词项上限...\n");
+
+    StopWords *sw = stop_words_create();
+    DocumentCollection *col = load(sw);
+
+    PruneOptions options;
+    prune_options_init(&options);
+    options.top_terms = 1;
+    PruneStats stats;
+    assert(collection_prune(col, &options, &stats));
+    assert(stats.vocab_after == stats.vocab_before);
+    assert(stats.terms_after == 4);
+
+    // 词频最高者优先，相同时按词项排序
+    assert(has(col, 0, "common"));
+    assert(has(col, 1, "apple"));
+    assert(has(col, 2, "apple"));
+    assert(has(col, 3, "common"));
+
+    collection_destroy(col);
+    stop_words_destroy(sw);
+    printf("每文档词项上限测试通过！\n");
+}
+
+void test_threads_match() {
+    printf("测试多线程裁剪结果一致...\n");
+
+    // 较大的集合，每个文档的词频各不相同
+    enum { N = 40 };
+    char *big_names[N];
+    char *big_texts[N];
+    size_t lengths[N];
+    for (int i = 0; i < N; i++) {
+        big_names[i] = (char*)malloc(16);
+        big_texts[i] = (char*)malloc(4096);
+        snprintf(big_names[i], 16, "d%02d.txt", i);
+        char *p = big_texts[i];
+        for (int w = 0; w < 120; w++) {
+            int id = (i * 7 + w * w) % 97;
+            p += sprintf(p, "term%c%c ", 'a' + id % 26, 'a' + id / 26);
+        }
+        lengths[i] = strlen(big_texts[i]);
+    }
+
+    StopWords *sw = stop_words_create();
+    SimilarityMatrix *results[2];
+    for (int r = 0; r < 2; r++) {
+        DocumentCollection *col = load_documents_from_buffers((const char**)big_names,
+                                                              (const char**)big_texts, lengths, N, sw);
+        PruneOptions options;
+        prune_options_init(&options);
+        options.min_df = 3;
+        options.max_df = 0.8;
+        options.top_terms = 10;
+        options.threads = r == 0 ? 1 : 4;
+        assert(collection_prune(col, &options, NULL));
+        for (size_t i = 0; i < col->count; i++) {
+            assert(col->documents[i]->word_freq->size <= 10);
+        }
+        results[r] = similarity_matrix_create_parallel(col, 2, NULL, NULL);
+        assert(results[r] != NULL);
+        collection_destroy(col);
+    }
+    for (size_t i = 0; i < N; i++) {
+        for (size_t j = 0; j < N; j++) {
+            assert(results[0]->matrix[i][j] == results[1]->matrix[i][j]);
+        }
+    }
+    similarity_matrix_destroy(results[0]);
+    similarity_matrix_destroy(results[1]);
+    stop_words_destroy(sw);
+
+    for (int i = 0; i < N; i++) {
+        free(big_names[i]);
+        free(big_texts[i]);
+    }
+
+    MemoryStats memory;
+    sim_memory_get(&memory);
+    assert(memory.current_total == 0);
+    printf("多线程一致性测试通过！\n");
+}
+
+void test_prune_order() {
+    printf("测试裁剪与加权、shingle 的调用顺序...\n");
+
+    StopWords *sw = stop_words_create();
+    PruneOptions options;
+    prune_options_init(&options);
+    options.min_df = 2;
+
+    // 加权之后再裁剪会丢掉加权向量，必须拒绝且不改动集合
+    DocumentCollection *col = load(sw);
+    assert(collection_set_weighting(col, WEIGHT_TFIDF));
+    SparseVector *weighted = col->documents[0]->vector;
+    assert(!collection_prune(col, &options, NULL));
+    assert(col->weights && col->documents[0]->vector == weighted);
+    assert(has(col, 0, "cherry"));
+    collection_destroy(col);
+
+    col = load(sw);
+    ShingleOptions shingles;
+    shingle_options_init(&shingles);
+    shingles.width = 2;
+    assert(collection_set_shingles(col, &shingles));
+    assert(!collection_prune(col, &options, NULL));
+    assert(shingle_options_active(&col->shingles) && col->documents[0]->vector != NULL);
+    collection_destroy(col);
+
+    // 先裁剪再加权：加权向量只包含保留的词项
+    col = load(sw);
+    assert(collection_prune(col, &options, NULL));
+    assert(collection_set_weighting(col, WEIGHT_TFIDF));
+    assert(col->documents[0]->vector->size == col->documents[0]->word_freq->size);
+    collection_destroy(col);
+
+    stop_words_destroy(sw);
+    printf("调用顺序测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("词表裁剪测试套件\n");
+    printf("========================================\n\n");
+
+    test_document_frequency();
+    test_top_terms();
+    test_threads_match();
+    test_prune_order();
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "weighting.h"
+#include "file_manager.h"
+#include "matrix_engine.h"
+#include "sim_memory.h"
+
+#define EPSILON 1e-12
+
+static const char *names[] = {"a.txt", "b.txt", "c.txt", "d.txt"};
+static const char *texts[] = {
+    "apple banana cherry common common",
+    "apple banana date common",
+    "apple egg common fig fig fig",
+    "grape common"
+};
+
+static DocumentCollection* load(StopWords *sw, size_t count) {
+    size_t lengths[4];
+    for (size_t i = 0; i < count; i++) lengths[i] = strlen(texts[i]);
+    DocumentCollection *col = load_documents_from_buffers(names, texts, lengths, count, sw);
+    assert(col && col->count == count);
+    return col;
+}
+
+static Document* make_doc(const char *name, const char *text, StopWords *sw) {
+    Document *doc = document_create_from_buffer(name, text, strlen(text));
+    assert(doc && document_process(doc, sw));
+    return doc;
+}
+
+void test_idf() {
+    printf("测试文档频率与 IDF...\n");
+
+    StopWords *sw = stop_words_create();
+    DocumentCollection *col = load(sw, 4);
+
+    TermWeights *tw = term_weights_create(WEIGHT_TFIDF);
+    for (size_t i = 0; i < col->count; i++) {
+        assert(term_weights_add_document(tw, col->documents[i]));
+    }
+    assert(term_weights_doc_count(tw) == 4);
+    assert(term_weights_df(tw, "common") == 4);
+    assert(term_weights_df(tw, "apple") == 3);
+    assert(term_weights_df(tw, "grape") == 1);
+    assert(term_weights_df(tw, "missing") == 0);
+    assert(fabs(term_weights_idf(tw, "common") - 1.0) < EPSILON);
+    assert(fabs(term_weights_idf(tw, "grape") - (log(5.0 / 2.0) + 1.0)) < EPSILON);
+
+    // 加权向量已归一化：自身点积为 1
+    SparseVector *vec = term_weights_vector(tw, col->documents[2]);
+    assert(vec && vec->norm == 1.0 && vec->size == 4);
+    assert(fabs(sparse_vector_dot(vec, vec) - 1.0) < EPSILON);
+    sparse_vector_destroy(vec);
+    term_weights_destroy(tw);
+
+    // BM25：出现在所有文档中的词权重最低
+    tw = term_weights_create(WEIGHT_BM25);
+    for (size_t i = 0; i < col->count; i++) {
+        term_weights_add_document(tw, col->documents[i]);
+    }
+    assert(term_weights_idf(tw, "common") < term_weights_idf(tw, "apple"));
+    assert(term_weights_idf(tw, "apple") < term_weights_idf(tw, "grape"));
+    assert(term_weights_idf(tw, "common") > 0);
+    term_weights_destroy(tw);
+
+    WeightScheme scheme;
+    assert(weight_scheme_parse("bm25", &scheme) && scheme == WEIGHT_BM25);
+    assert(!weight_scheme_parse("okapi", &scheme));
+    assert(strcmp(weight_scheme_name(WEIGHT_LOG_TF), "log") == 0);
+
+    collection_destroy(col);
+    stop_words_destroy(sw);
+    printf("文档频率与 IDF 测试通过！\n");
+}
+
+void test_collection_weighting() {
+    printf("测试集合加权...\n");
+
+    StopWords *sw = stop_words_create();
+    DocumentCollection *col = load(sw, 4);
+    SimilarityMatrix *plain = similarity_matrix_create(col);
+    assert(plain != NULL);
+
+    // 原始词频归一化后与未加权的余弦一致
+    assert(collection_set_weighting(col, WEIGHT_RAW));
+    SimilarityMatrix *raw = similarity_matrix_create_parallel(col, 2, NULL, NULL);
+    for (size_t i = 0; i < 4; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            assert(fabs(raw->matrix[i][j] - plain->matrix[i][j]) < EPSILON);
+        }
+    }
+
+    // TF-IDF 降低只共享常见词的文档对，分数就是加权向量的点积
+    assert(collection_set_weighting(col, WEIGHT_TFIDF));
+    assert(term_weights_scheme(col->weights) == WEIGHT_TFIDF);
+    SimilarityMatrix *tfidf = similarity_matrix_create(col);
+    assert(tfidf->matrix[0][3] < plain->matrix[0][3]);
+    double dot = sparse_vector_dot(col->documents[0]->vector, col->documents[1]->vector);
+    assert(fabs(tfidf->matrix[0][1] - dot) < EPSILON);
+
+    similarity_matrix_destroy(plain);
+    similarity_matrix_destroy(raw);
+    similarity_matrix_destroy(tfidf);
+    collection_destroy(col);
+    stop_words_destroy(sw);
+    printf("集合加权测试通过！\n");
+}
+
+void test_incremental() {
+    printf("测试增量维护 IDF...\n");
+
+    StopWords *sw = stop_words_create();
+    DocumentCollection *col = load(sw, 3);
+    assert(collection_set_weighting(col, WEIGHT_BM25));
+    SimilarityMatrix *matrix = similarity_matrix_create(col);
+
+    // 加入文档：统计增量更新，新文档按更新后的统计加权
+    Document *doc = make_doc("d.txt", texts[3], sw);
+    assert(similarity_matrix_add_document(matrix, col, doc));
+    assert(term_weights_doc_count(col->weights) == 4);
+    assert(term_weights_df(col->weights, "common") == 4);
+    assert(term_weights_df(col->weights, "grape") == 1);
+
+    // 与从头统计的结果相同
+    DocumentCollection *full = load(sw, 4);
+    assert(collection_set_weighting(full, WEIGHT_BM25));
+    assert(fabs(term_weights_idf(col->weights, "apple") - term_weights_idf(full->weights, "apple")) < EPSILON);
+    assert(fabs(sparse_vector_dot(doc->vector, full->documents[3]->vector) - 1.0) < EPSILON);
+    assert(fabs(matrix->matrix[3][0] -
+                sparse_vector_dot(doc->vector, col->documents[0]->vector)) < EPSILON);
+
+    // 替换与移除
+    Document *update = make_doc("d.txt", "grape melon", sw);
+    assert(similarity_matrix_update_document(matrix, col, 3, update));
+    assert(term_weights_df(col->weights, "common") == 3);
+    assert(term_weights_df(col->weights, "melon") == 1);
+    assert(term_weights_doc_count(col->weights) == 4);
+
+    assert(similarity_matrix_remove_document(matrix, col, 3));
+    assert(similarity_matrix_remove_document(matrix, col, 0));
+    assert(term_weights_doc_count(col->weights) == 2);
+    assert(term_weights_df(col->weights, "grape") == 0);
+    assert(term_weights_df(col->weights, "banana") == 1);
+    assert(term_weights_df(col->weights, "cherry") == 0);
+
+    similarity_matrix_destroy(matrix);
+    collection_destroy(col);
+    collection_destroy(full);
+    stop_words_destroy(sw);
+
+    MemoryStats stats;
+    sim_memory_get(&stats);
+    assert(stats.current_total == 0);
+    printf("增量维护测试通过！\n");
+}
+
+int main() {
+    printf("========================================\n");
+    printf("词项加权测试套件\n");
+    printf("========================================\n\n");
+
+    test_idf();
+    test_collection_weighting();
+    test_incremental();
+
+    printf("\n========================================\n");
+    printf("所有测试通过！✓\n");
+    printf("========================================\n");
+
+    return 0;
+}
@@ -1,63 +1,152 @@
-from flask import Flask, render_template, request, jsonify
-import os
-import tempfile
-import shutil
-from core_bridge import SimilarityEngine
+from flask import Flask, Response, render_template, request, jsonify
+from core_bridge import SimilarityEngine, CANCELLED_ERROR
 
 app = Flask(__name__)
 engine = SimilarityEngine()
 
-UPLOAD_FOLDER = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'uploads')
-if not os.path.exists(UPLOAD_FOLDER):
-    os.makedirs(UPLOAD_FOLDER)
+# Clients give up long before this; work still running afterwards is abandoned
+ANALYZE_TIMEOUT_SECONDS = 120
+
+DEFAULT_TOP_K = 10
+DEFAULT_THRESHOLD = 0.5
 
 @app.route('/')
 def index():
     return render_template('index.html')
 
+import time
 import traceback
 
+def uploaded_documents():
+    """(name, bytes) pairs of the uploaded .txt files; contents go straight to C, no temp files."""
+    documents = []
+    for file in request.files.getlist('files[]'):
+        if file.filename == '':
+            continue
+        if file.filename.endswith('.txt'):
+            documents.append((file.filename, file.read()))
+    return documents
+
+def server_timing(timings):
+    """Server-Timing header value (durations in milliseconds), read by test_load.py."""
+    return ", ".join(f"{name};dur={seconds * 1000:.3f}" for name, seconds in timings.items())
+
 @app.route('/analyze', methods=['POST'])
 def analyze():
     try:
+        # Multipart parsing is lazy: the upload is read on first access to request.files
+        start = time.perf_counter()
         if 'files[]' not in request.files:
             return jsonify({'error': 'No files uploaded'}), 400
         
-        files = request.files.getlist('files[]')
+        documents = uploaded_documents()
+        if not documents:
+            return jsonify({'error': 'No valid text files uploaded'}), 400
+        timings = {'upload': time.perf_counter() - start}
+            
+        # Result mode: dense (default) | topk | threshold | binary
+        mode = request.values.get('mode', 'dense')
+        # Term weighting: raw (default) | log | tfidf | bm25
+        weighting = request.values.get('weighting', 'raw')
+        try:
+            if mode == 'topk':
+                result = engine.process_documents_top_k(
+                    documents, int(request.values.get('k', DEFAULT_TOP_K)),
+                    float(request.values.get('min_score', 0.0)), timeout=ANALYZE_TIMEOUT_SECONDS,
+                    weighting=weighting)
+            elif mode == 'threshold':
+                result = engine.process_documents_pairs(
+                    documents, float(request.values.get('threshold', DEFAULT_THRESHOLD)),
+                    timeout=ANALYZE_TIMEOUT_SECONDS, weighting=weighting)
+            elif mode == 'binary':
+                result = engine.process_documents_quantized(
+                    documents, request.values.get('dtype', 'u8'), request.values.get('layout', 'full'),
+                    timeout=ANALYZE_TIMEOUT_SECONDS, weighting=weighting)
+            elif mode == 'dense':
+                result = engine.process_documents(documents, timeout=ANALYZE_TIMEOUT_SECONDS,
+                                                  weighting=weighting)
+            else:
+                return jsonify({'error': f'Unknown mode: {mode}'}), 400
+        except ValueError as e:
+            return jsonify({'error': str(e)}), 400
         
-        # Create a unique temporary directory for this request
-        session_id = os.urandom(8).hex()
-        session_dir = os.path.join(UPLOAD_FOLDER, session_id)
-        os.makedirs(session_dir)
+        if not result:
+            if engine.last_error == CANCELLED_ERROR:
+                return jsonify({'error': 'Analysis timed out'}), 503
+            return jsonify({'error': 'Analysis failed'}), 500
         
-        try:
-            saved_files = []
-            for file in files:
-                if file.filename == '':
-                    continue
-                if file.filename.endswith('.txt'):
-                    filepath = os.path.join(session_dir, file.filename)
-                    file.save(filepath)
-                    saved_files.append(file.filename)
-            
-            if not saved_files:
-                return jsonify({'error': 'No valid text files uploaded'}), 400
-                
-            # Call C engine
-            result = engine.process_directory(session_dir)
-            
-            if not result:
-                return jsonify({'error': 'Analysis failed'}), 500
-                
-            return jsonify(result)
-            
-        finally:
-            # Cleanup
-            if os.path.exists(session_dir):
-                shutil.rmtree(session_dir)
+        timings.update(engine.last_timings)
+        start = time.perf_counter()
+        if mode == 'binary':
+            # Layout: see core_bridge.encode_quantized_payload
+            response = Response(result, mimetype='application/octet-stream')
+        else:
+            response = jsonify(result)
+        timings['json'] = time.perf_counter() - start
+        response.headers['Server-Timing'] = server_timing(timings)
+        return response
     except Exception as e:
         traceback.print_exc()
         return jsonify({'error': str(e)}), 500
 
+# Background jobs: submit returns at once, clients poll the status and fetch the result
+@app.route('/jobs', methods=['POST'])
+def submit_job():
+    if 'files[]' not in request.files:
+        return jsonify({'error': 'No files uploaded'}), 400
+    documents = uploaded_documents()
+    if not documents:
+        return jsonify({'error': 'No valid text files uploaded'}), 400
+    
+    job_id = engine.submit_job(documents)
+    if job_id is None:
+        return jsonify({'error': 'Job queue is full, retry later'}), 429
+    response = jsonify(engine.job_status(job_id) or {'id': job_id})
+    response.headers['Location'] = f'/jobs/{job_id}'
+    return response, 202
+
+@app.route('/jobs/<int:job_id>', methods=['GET'])
+def job_status(job_id):
+    status = engine.job_status(job_id)
+    if status is None:
+        return jsonify({'error': 'Unknown job'}), 404
+    return jsonify(status)
+
+@app.route('/jobs/<int:job_id>', methods=['DELETE'])
+def delete_job(job_id):
+    if not engine.remove_job(job_id):
+        return jsonify({'error': 'Unknown job'}), 404
+    return '', 204
+
+@app.route('/jobs/<int:job_id>/result', methods=['GET'])
+def job_result(job_id):
+    status = engine.job_status(job_id)
+    if status is None:
+        return jsonify({'error': 'Unknown job'}), 404
+    if status['state'] in ('queued', 'running'):
+        return jsonify(status), 409
+    if status['state'] != 'done':
+        # failed, cancelled, or expired under the result memory budget
+        return jsonify(status), 410
+    
+    # Same result modes as /analyze
+    mode = request.args.get('mode', 'dense')
+    try:
+        result = engine.job_result(
+            job_id, mode,
+            k=int(request.args.get('k', DEFAULT_TOP_K)),
+            min_score=float(request.args.get('min_score', 0.0)),
+            threshold=float(request.args.get('threshold', DEFAULT_THRESHOLD)),
+            dtype=request.args.get('dtype', 'u8'),
+            layout=request.args.get('layout', 'full'))
+    except ValueError as e:
+        return jsonify({'error': str(e)}), 400
+    if result is None:
+        # Evicted between the status check and the copy
+        return jsonify(engine.job_status(job_id) or {'error': 'Unknown job'}), 410
+    if mode == 'binary':
+        return Response(result, mimetype='application/octet-stream')
+    return jsonify(result)
+
 if __name__ == '__main__':
     app.run(host='0.0.0.0', debug=True, port=5000)
@@ -2,6 +2,10 @@ import ctypes
 import os
 import sys
 import platform
+import json
+import struct
+import threading
+import time
 
 # Define structures
 class HashTable(ctypes.Structure):
@@ -12,7 +16,9 @@ class Document(ctypes.Structure):
         ("filename", ctypes.c_char * 256),
         ("word_freq", ctypes.POINTER(HashTable)),
         ("content", ctypes.c_char_p),
-        ("word_count", ctypes.c_size_t)
+        ("word_count", ctypes.c_size_t),
+        ("vector", ctypes.c_void_p),
+        ("content_size", ctypes.c_size_t)
     ]
 
 class DocumentCollection(ctypes.Structure):
@@ -26,14 +32,90 @@ class SimilarityMatrix(ctypes.Structure):
     _fields_ = [
         ("matrix", ctypes.POINTER(ctypes.POINTER(ctypes.c_double))),
         ("filenames", ctypes.POINTER(ctypes.c_char_p)),
-        ("size", ctypes.c_size_t)
+        ("size", ctypes.c_size_t),
+        ("capacity", ctypes.c_size_t),
+        ("data", ctypes.POINTER(ctypes.c_double))
+    ]
+
+class DocStoreStats(ctypes.Structure):
+    _fields_ = [
+        ("documents", ctypes.c_size_t),
+        ("bytes", ctypes.c_size_t),
+        ("doc_hits", ctypes.c_size_t),
+        ("doc_misses", ctypes.c_size_t),
+        ("evictions", ctypes.c_size_t),
+        ("pair_hits", ctypes.c_size_t),
+        ("pair_misses", ctypes.c_size_t)
+    ]
+
+class SimConfig(ctypes.Structure):
+    _fields_ = [
+        ("threads", ctypes.c_size_t),
+        ("store_budget", ctypes.c_size_t),
+        ("pair_cache_entries", ctypes.c_size_t),
+        ("shared_store", ctypes.c_void_p),
+        ("weighting", ctypes.c_int),
+        ("cjk_ngram", ctypes.c_size_t)
+    ]
+
+# WeightScheme codes (weighting.h)
+WEIGHTING_CODES = {"raw": 0, "log": 1, "tfidf": 2, "bm25": 3}
+
+class SimilarityEdges(ctypes.Structure):
+    _fields_ = [
+        ("count", ctypes.c_size_t),
+        ("rows", ctypes.POINTER(ctypes.c_uint32)),
+        ("cols", ctypes.POINTER(ctypes.c_uint32)),
+        ("scores", ctypes.POINTER(ctypes.c_float)),
+        ("capacity", ctypes.c_size_t)
+    ]
+
+class JobProgress(ctypes.Structure):
+    _fields_ = [
+        ("stage", ctypes.c_int),
+        ("done", ctypes.c_size_t),
+        ("total", ctypes.c_size_t),
+        ("bytes", ctypes.c_size_t)
+    ]
+
+JOB_STAGES = {0: "load", 1: "matrix"}
+# sim_context_last_error() text of a cancelled call
+CANCELLED_ERROR = "任务已取消"
+
+# bool (*JobProgressCallback)(const JobProgress *progress, void *userdata);
+JobProgressCallback = ctypes.CFUNCTYPE(ctypes.c_bool, ctypes.POINTER(JobProgress), ctypes.c_void_p)
+
+class JobQueueConfig(ctypes.Structure):
+    _fields_ = [
+        ("workers", ctypes.c_size_t),
+        ("threads_per_job", ctypes.c_size_t),
+        ("max_pending", ctypes.c_size_t),
+        ("max_pending_bytes", ctypes.c_size_t),
+        ("small_job_bytes", ctypes.c_size_t),
+        ("result_budget", ctypes.c_size_t),
+        ("max_finished", ctypes.c_size_t),
+        ("shared_store", ctypes.c_void_p)
     ]
 
+class JobStatus(ctypes.Structure):
+    _fields_ = [
+        ("state", ctypes.c_int),
+        ("progress", JobProgress),
+        ("documents", ctypes.c_size_t),
+        ("input_bytes", ctypes.c_size_t),
+        ("result_bytes", ctypes.c_size_t),
+        ("queue_position", ctypes.c_size_t),
+        ("error", ctypes.c_char * 128)
+    ]
+
+JOB_STATES = {0: "queued", 1: "running", 2: "done", 3: "failed", 4: "cancelled", 5: "expired"}
+
 class StopWords(ctypes.Structure):
     _fields_ = [
         ("words", ctypes.POINTER(ctypes.c_char_p)),
         ("size", ctypes.c_size_t),
-        ("capacity", ctypes.c_size_t)
+        ("capacity", ctypes.c_size_t),
+        ("cjk_ngram", ctypes.c_size_t)
     ]
 
 # Load Library
@@ -75,61 +157,748 @@ def load_lib():
     lib.similarity_matrix_create.restype = ctypes.POINTER(SimilarityMatrix)
     lib.similarity_matrix_create.argtypes = [ctypes.POINTER(DocumentCollection)]
     
+    # SimilarityMatrix* similarity_matrix_from_buffers(const char **names, const char **buffers,
+    #                                                  const size_t *lengths, size_t count, StopWords *sw);
+    lib.similarity_matrix_from_buffers.restype = ctypes.POINTER(SimilarityMatrix)
+    lib.similarity_matrix_from_buffers.argtypes = [
+        ctypes.POINTER(ctypes.c_char_p), ctypes.POINTER(ctypes.c_char_p),
+        ctypes.POINTER(ctypes.c_size_t), ctypes.c_size_t, ctypes.POINTER(StopWords)
+    ]
+    
     # void similarity_matrix_destroy(SimilarityMatrix *matrix);
     lib.similarity_matrix_destroy.argtypes = [ctypes.POINTER(SimilarityMatrix)]
     
+    # DocumentStore* doc_store_create(StopWords *sw, size_t memory_budget, size_t pair_cache_entries);
+    lib.doc_store_create.restype = ctypes.c_void_p
+    lib.doc_store_create.argtypes = [ctypes.POINTER(StopWords), ctypes.c_size_t, ctypes.c_size_t]
+    
+    # void doc_store_destroy(DocumentStore *store);
+    lib.doc_store_destroy.argtypes = [ctypes.c_void_p]
+    
+    # SimilarityMatrix* doc_store_matrix(DocumentStore *store, const char **names, const char **buffers,
+    #                                    const size_t *lengths, size_t count);
+    lib.doc_store_matrix.restype = ctypes.POINTER(SimilarityMatrix)
+    lib.doc_store_matrix.argtypes = [
+        ctypes.c_void_p, ctypes.POINTER(ctypes.c_char_p), ctypes.POINTER(ctypes.c_char_p),
+        ctypes.POINTER(ctypes.c_size_t), ctypes.c_size_t
+    ]
+    
+    # void doc_store_get_stats(DocumentStore *store, DocStoreStats *stats);
+    lib.doc_store_get_stats.argtypes = [ctypes.c_void_p, ctypes.POINTER(DocStoreStats)]
+    
+    # SimConfig sim_config_default(void);
+    lib.sim_config_default.restype = SimConfig
+    lib.sim_config_default.argtypes = []
+    
+    # SimContext* sim_context_create(const SimConfig *config);
+    lib.sim_context_create.restype = ctypes.c_void_p
+    lib.sim_context_create.argtypes = [ctypes.POINTER(SimConfig)]
+    
+    # void sim_context_destroy(SimContext *ctx);
+    lib.sim_context_destroy.argtypes = [ctypes.c_void_p]
+    
+    # SimilarityMatrix* sim_context_matrix_from_buffers(SimContext *ctx, const char **names,
+    #                                                   const char **buffers, const size_t *lengths, size_t count);
+    lib.sim_context_matrix_from_buffers.restype = ctypes.POINTER(SimilarityMatrix)
+    lib.sim_context_matrix_from_buffers.argtypes = [
+        ctypes.c_void_p, ctypes.POINTER(ctypes.c_char_p), ctypes.POINTER(ctypes.c_char_p),
+        ctypes.POINTER(ctypes.c_size_t), ctypes.c_size_t
+    ]
+    
+    # SimilarityMatrix* sim_context_matrix_from_dir(SimContext *ctx, const char *dir_path);
+    lib.sim_context_matrix_from_dir.restype = ctypes.POINTER(SimilarityMatrix)
+    lib.sim_context_matrix_from_dir.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+    
+    # void sim_context_set_job(SimContext *ctx, JobControl *job);
+    lib.sim_context_set_job.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
+    
+    # JobControl* job_control_create(JobProgressCallback on_progress, void *userdata);
+    lib.job_control_create.restype = ctypes.c_void_p
+    lib.job_control_create.argtypes = [JobProgressCallback, ctypes.c_void_p]
+    
+    # void job_control_destroy(JobControl *job);
+    lib.job_control_destroy.argtypes = [ctypes.c_void_p]
+    
+    # void job_control_cancel(JobControl *job);
+    lib.job_control_cancel.argtypes = [ctypes.c_void_p]
+    
+    # bool job_control_cancelled(JobControl *job);
+    lib.job_control_cancelled.restype = ctypes.c_bool
+    lib.job_control_cancelled.argtypes = [ctypes.c_void_p]
+    
+    # const char* sim_context_last_error(const SimContext *ctx);
+    lib.sim_context_last_error.restype = ctypes.c_char_p
+    lib.sim_context_last_error.argtypes = [ctypes.c_void_p]
+    
+    # double* similarity_matrix_detach_data(SimilarityMatrix *matrix, size_t *size, size_t *stride);
+    lib.similarity_matrix_detach_data.restype = ctypes.c_void_p
+    lib.similarity_matrix_detach_data.argtypes = [
+        ctypes.POINTER(SimilarityMatrix), ctypes.POINTER(ctypes.c_size_t), ctypes.POINTER(ctypes.c_size_t)
+    ]
+    
+    # void similarity_buffer_free(void *buffer);
+    lib.similarity_buffer_free.argtypes = [ctypes.c_void_p]
+    
+    # SimilarityEdges* similarity_matrix_top_k(const SimilarityMatrix *matrix, size_t k, double min_score);
+    lib.similarity_matrix_top_k.restype = ctypes.POINTER(SimilarityEdges)
+    lib.similarity_matrix_top_k.argtypes = [ctypes.POINTER(SimilarityMatrix), ctypes.c_size_t, ctypes.c_double]
+    
+    # SimilarityEdges* similarity_matrix_pairs_above(const SimilarityMatrix *matrix, double threshold);
+    lib.similarity_matrix_pairs_above.restype = ctypes.POINTER(SimilarityEdges)
+    lib.similarity_matrix_pairs_above.argtypes = [ctypes.POINTER(SimilarityMatrix), ctypes.c_double]
+    
+    # void similarity_edges_destroy(SimilarityEdges *edges);
+    lib.similarity_edges_destroy.argtypes = [ctypes.POINTER(SimilarityEdges)]
+    
+    # void* similarity_matrix_encode(const SimilarityMatrix *matrix, MatrixDType dtype,
+    #                                MatrixLayout layout, size_t *bytes);
+    lib.similarity_matrix_encode.restype = ctypes.c_void_p
+    lib.similarity_matrix_encode.argtypes = [
+        ctypes.POINTER(SimilarityMatrix), ctypes.c_int, ctypes.c_int, ctypes.POINTER(ctypes.c_size_t)
+    ]
+    
+    # MatrixFile* matrix_file_open(const char *path);
+    lib.matrix_file_open.restype = ctypes.c_void_p
+    lib.matrix_file_open.argtypes = [ctypes.c_char_p]
+    
+    # void matrix_file_close(MatrixFile *mf);
+    lib.matrix_file_close.argtypes = [ctypes.c_void_p]
+    
+    # size_t matrix_file_size(const MatrixFile *mf);
+    lib.matrix_file_size.restype = ctypes.c_size_t
+    lib.matrix_file_size.argtypes = [ctypes.c_void_p]
+    
+    for name in ("matrix_file_dtype", "matrix_file_layout", "matrix_file_compression"):
+        getattr(lib, name).restype = ctypes.c_int
+        getattr(lib, name).argtypes = [ctypes.c_void_p]
+    
+    # const char* matrix_file_name(const MatrixFile *mf, size_t index);
+    lib.matrix_file_name.restype = ctypes.c_char_p
+    lib.matrix_file_name.argtypes = [ctypes.c_void_p, ctypes.c_size_t]
+    
+    # const void* matrix_file_row_data(const MatrixFile *mf, size_t row, size_t *count);
+    lib.matrix_file_row_data.restype = ctypes.c_void_p
+    lib.matrix_file_row_data.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.POINTER(ctypes.c_size_t)]
+    
+    # bool matrix_file_read_row(MatrixFile *mf, size_t row, float *out);
+    lib.matrix_file_read_row.restype = ctypes.c_bool
+    lib.matrix_file_read_row.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.POINTER(ctypes.c_float)]
+    
+    # double matrix_file_get(MatrixFile *mf, size_t row, size_t col);
+    lib.matrix_file_get.restype = ctypes.c_double
+    lib.matrix_file_get.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.c_size_t]
+    
+    # JobQueueConfig job_queue_default_config(void);
+    lib.job_queue_default_config.restype = JobQueueConfig
+    lib.job_queue_default_config.argtypes = []
+    
+    # JobQueue* job_queue_create(const JobQueueConfig *config);
+    lib.job_queue_create.restype = ctypes.c_void_p
+    lib.job_queue_create.argtypes = [ctypes.POINTER(JobQueueConfig)]
+    
+    # void job_queue_destroy(JobQueue *queue);
+    lib.job_queue_destroy.argtypes = [ctypes.c_void_p]
+    
+    # bool job_queue_submit(JobQueue *queue, const char **names, const char **buffers,
+    #                       const size_t *lengths, size_t count, uint64_t *id);
+    lib.job_queue_submit.restype = ctypes.c_bool
+    lib.job_queue_submit.argtypes = [
+        ctypes.c_void_p, ctypes.POINTER(ctypes.c_char_p), ctypes.POINTER(ctypes.c_char_p),
+        ctypes.POINTER(ctypes.c_size_t), ctypes.c_size_t, ctypes.POINTER(ctypes.c_uint64)
+    ]
+    
+    # bool job_queue_status(JobQueue *queue, uint64_t id, JobStatus *status);
+    lib.job_queue_status.restype = ctypes.c_bool
+    lib.job_queue_status.argtypes = [ctypes.c_void_p, ctypes.c_uint64, ctypes.POINTER(JobStatus)]
+    
+    # SimilarityMatrix* job_queue_copy_result(JobQueue *queue, uint64_t id);
+    lib.job_queue_copy_result.restype = ctypes.POINTER(SimilarityMatrix)
+    lib.job_queue_copy_result.argtypes = [ctypes.c_void_p, ctypes.c_uint64]
+    
+    for name in ("job_queue_cancel", "job_queue_remove"):
+        getattr(lib, name).restype = ctypes.c_bool
+        getattr(lib, name).argtypes = [ctypes.c_void_p, ctypes.c_uint64]
+    
     return lib
 
+def decode_name(raw_name):
+    try:
+        # Try UTF-8 first
+        return raw_name.decode('utf-8')
+    except UnicodeDecodeError:
+        try:
+            # Fallback to GBK (common for Chinese Windows)
+            return raw_name.decode('gbk')
+        except UnicodeDecodeError:
+            # Fallback to system default or ignore errors
+            return raw_name.decode('mbcs', errors='replace') if os.name == 'nt' else raw_name.decode('utf-8', errors='replace')
+
+# Cell types of the binary matrix format (see include/matrix_file.h).
+# float16 cells are exposed as raw uint16 bits; struct format 'e' decodes them.
+MATRIX_DTYPES = {1: ctypes.c_float, 2: ctypes.c_double, 3: ctypes.c_uint8, 4: ctypes.c_uint16}
+MATRIX_DTYPE_CODES = {"f32": 1, "f64": 2, "u8": 3, "f16": 4}
+MATRIX_LAYOUT_FULL = 0
+MATRIX_LAYOUT_UPPER = 1
+
+class MatrixFileReader:
+    """Read-only view of a .simx file. The file is mmapped by the C library."""
+    
+    def __init__(self, path, lib=None):
+        self.lib = lib or load_lib()
+        self.handle = self.lib.matrix_file_open(path.encode('utf-8'))
+        if not self.handle:
+            raise ValueError(f"Invalid matrix file: {path}")
+        self.size = self.lib.matrix_file_size(self.handle)
+        self.dtype = self.lib.matrix_file_dtype(self.handle)
+        self.layout = self.lib.matrix_file_layout(self.handle)
+        self.filenames = [decode_name(self.lib.matrix_file_name(self.handle, i)) for i in range(self.size)]
+    
+    def close(self):
+        if self.handle:
+            self.lib.matrix_file_close(self.handle)
+            self.handle = None
+    
+    def __del__(self):
+        if hasattr(self, 'handle'):
+            self.close()
+    
+    def __enter__(self):
+        return self
+    
+    def __exit__(self, *exc):
+        self.close()
+    
+    def row_view(self, row):
+        """Zero-copy ctypes array over the stored cells of a row, or None if compressed.
+        For the upper-triangular layout the array starts at column `row`.
+        The view is only valid until close()."""
+        count = ctypes.c_size_t(0)
+        address = self.lib.matrix_file_row_data(self.handle, row, ctypes.byref(count))
+        if not address:
+            return None
+        return (MATRIX_DTYPES[self.dtype] * count.value).from_address(address)
+    
+    def read_row(self, row):
+        """Decoded full row (all n columns) as a list of floats."""
+        out = (ctypes.c_float * self.size)()
+        if not self.lib.matrix_file_read_row(self.handle, row, out):
+            raise IndexError(row)
+        return list(out)
+    
+    def get(self, row, col):
+        return self.lib.matrix_file_get(self.handle, row, col)
+
+class MatrixBuffer:
+    """Contiguous row-major float64 matrix detached from C (row i starts at i * stride).
+    The memory is owned by the C library and released by close().
+    
+    Every view is built on one ctypes array that refers back to this object, so a live
+    view keeps the buffer alive even after the MatrixBuffer itself is dropped.
+    close() raises BufferError while views are still alive, rather than leaving them dangling."""
+    
+    def __init__(self, lib, address, size, stride, filenames):
+        self.lib = lib
+        self.address = address
+        self.size = size
+        self.stride = stride
+        self.filenames = filenames
+        self._raw = None
+        if address and size:
+            self._raw = (ctypes.c_char * (size * stride * 8)).from_address(address)
+            self._raw._owner = self
+    
+    def exported(self):
+        """True while a memoryview, numpy array or slice of this buffer is still alive."""
+        # References held by self._raw and by the getrefcount argument
+        return self._raw is not None and sys.getrefcount(self._raw) > 2
+    
+    def _release(self):
+        if self.address:
+            self.lib.similarity_buffer_free(self.address)
+            self.address = None
+        self._raw = None
+    
+    def close(self):
+        if self.exported():
+            raise BufferError("MatrixBuffer still has exported views; drop them before close()")
+        self._release()
+    
+    def __del__(self):
+        # Reached only once no view refers to the buffer any more
+        if hasattr(self, 'address'):
+            self._release()
+    
+    def __enter__(self):
+        return self
+    
+    def __exit__(self, *exc):
+        self.close()
+    
+    def _source(self):
+        if self.size and not self.address:
+            raise ValueError("MatrixBuffer is closed")
+        return self._raw
+    
+    def memoryview(self):
+        """Zero-copy 2-D memoryview of shape (size, stride); columns >= size are padding."""
+        raw = self._source()
+        if raw is None:
+            return memoryview(b'').cast('d')
+        return memoryview(raw).cast('B').cast('d', [self.size, self.stride])
+    
+    def numpy(self):
+        """Zero-copy numpy view of shape (size, size); blocks close() while alive."""
+        import numpy
+        raw = self._source()
+        if raw is None:
+            return numpy.zeros((0, 0))
+        return numpy.frombuffer(raw, dtype=numpy.float64).reshape(self.size, self.stride)[:, :self.size]
+    
+    def tolist(self):
+        """Nested lists, one slice per row instead of one ctypes call per cell."""
+        raw = self._source()
+        if raw is None:
+            return []
+        flat = memoryview(raw).cast('B').cast('d')
+        return [flat[i * self.stride:i * self.stride + self.size].tolist() for i in range(self.size)]
+
+def encode_quantized_payload(header, cells):
+    """Binary response layout: uint32 little-endian header length | UTF-8 JSON header | cells.
+    Cells are little-endian, row-major; "u8" stores round(v * 255), "f16" IEEE half floats.
+    With layout "upper" row i holds columns i..n-1 only."""
+    header_bytes = json.dumps(header, ensure_ascii=False).encode('utf-8')
+    return struct.pack('<I', len(header_bytes)) + header_bytes + cells
+
+def decode_quantized_payload(payload):
+    """Inverse of encode_quantized_payload; returns (header, nested list of floats)."""
+    (length,) = struct.unpack_from('<I', payload)
+    header = json.loads(payload[4:4 + length].decode('utf-8'))
+    cells = memoryview(payload)[4 + length:]
+    if header["dtype"] == "f16":
+        values = struct.unpack('<%de' % (len(cells) // 2), cells)
+    else:
+        values = [c / 255.0 for c in cells]
+    n = header["size"]
+    rows, pos = [], 0
+    for i in range(n):
+        first = i if header["layout"] == "upper" else 0
+        rows.append(list(values[pos:pos + n - first]))
+        pos += n - first
+    return header, rows
+
+# Client for `similarity --serve`: length-prefixed frames over a Unix domain socket
+SERVICE_OPS = {"add": 1, "query": 2, "matrix": 3, "remove": 4, "stats": 5}
+SERVICE_STATUS_OK = 0
+SERVICE_STATUS_NOT_FOUND = 2
+SERVICE_CELL_FORMATS = {1: 'f', 2: 'd', 3: 'B', 4: 'e'}
+
+class ServiceError(RuntimeError):
+    def __init__(self, status, message):
+        super().__init__(message)
+        self.status = status
+
+class SimilarityServiceClient:
+    """One connection to a resident similarity service; not shared between threads."""
+    
+    def __init__(self, socket_path, timeout=None):
+        import socket
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.settimeout(timeout)
+        self.sock.connect(socket_path)
+    
+    def close(self):
+        self.sock.close()
+    
+    def __enter__(self):
+        return self
+    
+    def __exit__(self, *exc):
+        self.close()
+    
+    def _recv_exact(self, size):
+        chunks = []
+        while size > 0:
+            chunk = self.sock.recv(min(size, 1 << 20))
+            if not chunk:
+                raise ConnectionError("service closed the connection")
+            chunks.append(chunk)
+            size -= len(chunk)
+        return b"".join(chunks)
+    
+    def _request(self, op, payload=b""):
+        self.sock.sendall(struct.pack('<IB', len(payload) + 1, SERVICE_OPS[op]) + payload)
+        length, status = struct.unpack('<IB', self._recv_exact(5))
+        reply = self._recv_exact(length - 1)
+        if status != SERVICE_STATUS_OK:
+            raise ServiceError(status, reply.decode('utf-8', errors='replace'))
+        return reply
+    
+    @staticmethod
+    def _name(name):
+        raw = name.encode('utf-8')
+        return struct.pack('<H', len(raw)) + raw
+    
+    def add_document(self, name, text):
+        """Adds or replaces a document; returns (index, corpus size)."""
+        return struct.unpack('<II', self._request("add", self._name(name) + text.encode('utf-8')))
+    
+    def remove_document(self, name):
+        """Returns the new corpus size, or None if the name was unknown."""
+        try:
+            return struct.unpack('<I', self._request("remove", self._name(name)))[0]
+        except ServiceError as e:
+            if e.status == SERVICE_STATUS_NOT_FOUND:
+                return None
+            raise
+    
+    def query(self, text, k=10):
+        """Top-k corpus documents for text: list of {index, name, score}."""
+        reply = self._request("query", struct.pack('<I', k) + text.encode('utf-8'))
+        (count,) = struct.unpack_from('<I', reply)
+        results, pos = [], 4
+        for _ in range(count):
+            index, score, length = struct.unpack_from('<IdH', reply, pos)
+            pos += 14
+            results.append({"index": index, "name": decode_name(reply[pos:pos + length]),
+                            "score": score})
+            pos += length
+        return results
+    
+    def matrix(self, dtype="f32", layout="full"):
+        """Similarity matrix of the resident corpus: (names, rows); u8 cells are scaled back to [0, 1]."""
+        code = MATRIX_DTYPE_CODES[dtype]
+        upper = layout == "upper"
+        reply = self._request("matrix", struct.pack('<BB', code, MATRIX_LAYOUT_UPPER if upper else MATRIX_LAYOUT_FULL))
+        (n,) = struct.unpack_from('<I', reply)
+        names, pos = [], 4
+        for _ in range(n):
+            (length,) = struct.unpack_from('<H', reply, pos)
+            names.append(decode_name(reply[pos + 2:pos + 2 + length]))
+            pos += 2 + length
+        fmt = SERVICE_CELL_FORMATS[code]
+        cells = reply[pos:]
+        values = struct.unpack('<%d%s' % (len(cells) // struct.calcsize(fmt), fmt), cells)
+        if fmt == 'B':
+            values = [v / 255.0 for v in values]
+        rows, pos = [], 0
+        for i in range(n):
+            width = n - i if upper else n
+            rows.append(list(values[pos:pos + width]))
+            pos += width
+        return names, rows
+    
+    def stats(self):
+        documents, queries, batches, largest = struct.unpack('<IQQI', self._request("stats"))
+        return {"documents": documents, "queries": queries, "batches": batches,
+                "largest_batch": largest}
+
+# Resident document store: processed vectors kept across requests, plus a pair-score cache
+STORE_MEMORY_BUDGET = 256 * 1024 * 1024
+STORE_PAIR_CACHE_ENTRIES = 1 << 18
+
+class _Context:
+    """Owns one C SimContext; destroyed together with its thread's local storage."""
+    
+    def __init__(self, lib, store, weighting="raw"):
+        self.lib = lib
+        config = lib.sim_config_default()
+        config.shared_store = store
+        # Weighted requests bypass the store: weights depend on the whole upload
+        config.weighting = WEIGHTING_CODES[weighting]
+        self.handle = lib.sim_context_create(ctypes.byref(config))
+        if not self.handle:
+            raise MemoryError("sim_context_create failed")
+    
+    def last_error(self):
+        return decode_name(self.lib.sim_context_last_error(self.handle))
+    
+    def __del__(self):
+        if getattr(self, 'handle', None):
+            self.lib.sim_context_destroy(self.handle)
+            self.handle = None
+
 class SimilarityEngine:
+    """Shared by all request threads. Each thread computes through its own C context
+    (ctypes releases the GIL during the call), while all contexts share one document store."""
+    
     def __init__(self):
         self.lib = load_lib()
         self.stop_words = self.lib.stop_words_create()
+        self.store = self.lib.doc_store_create(self.stop_words, STORE_MEMORY_BUDGET, STORE_PAIR_CACHE_ENTRIES)
+        self._local = threading.local()
+        # Background jobs share the document store with synchronous requests
+        config = self.lib.job_queue_default_config()
+        config.shared_store = self.store
+        self.jobs = self.lib.job_queue_create(ctypes.byref(config))
         
     def __del__(self):
         if hasattr(self, 'lib') and hasattr(self, 'stop_words'):
+            # Contexts and job workers reference the store; drop them first
+            self._local = None
+            if getattr(self, 'jobs', None):
+                self.lib.job_queue_destroy(self.jobs)
+            if getattr(self, 'store', None):
+                self.lib.doc_store_destroy(self.store)
             self.lib.stop_words_destroy(self.stop_words)
+    
+    def _context(self, weighting="raw"):
+        if weighting not in WEIGHTING_CODES:
+            raise ValueError(f"Unsupported weighting: {weighting}")
+        contexts = getattr(self._local, 'contexts', None)
+        if contexts is None:
+            contexts = self._local.contexts = {}
+        context = contexts.get(weighting)
+        if context is None:
+            context = contexts[weighting] = _Context(self.lib, self.store, weighting)
+        return context
+    
+    @property
+    def last_error(self):
+        """Reason of the calling thread's most recent failure, or None."""
+        return getattr(self._local, 'last_error', None)
+    
+    @property
+    def last_timings(self):
+        """Seconds spent by the calling thread's most recent process_documents* call:
+        "analysis" (tokenizing and scoring in C) and "copy" (building the result from the C matrix)."""
+        return dict(getattr(self._local, 'timings', {}))
+    
+    def _timed(self, phase, compute):
+        start = time.perf_counter()
+        try:
+            return compute()
+        finally:
+            timings = getattr(self._local, 'timings', None)
+            if timings is not None:
+                timings[phase] = time.perf_counter() - start
+    
+    def _check(self, context, matrix):
+        self._local.last_error = None if matrix else (context.last_error() or None)
+        return matrix if matrix else None
+    
+    def store_stats(self):
+        """Counters of the resident document store (hits, misses, evictions, memory)."""
+        stats = DocStoreStats()
+        self.lib.doc_store_get_stats(self.store, ctypes.byref(stats))
+        return {name: getattr(stats, name) for name, _ in DocStoreStats._fields_}
             
-    def process_directory(self, dir_path):
-        dir_path_bytes = dir_path.encode('utf-8')
-        collection = self.lib.load_documents_from_dir(dir_path_bytes, self.stop_words)
+    def _matrix_buffer(self, matrix):
+        """Take the contiguous buffer out of a C matrix; the rest of the matrix is freed."""
+        filenames = [decode_name(matrix.contents.filenames[i]) for i in range(matrix.contents.size)]
+        size = ctypes.c_size_t(0)
+        stride = ctypes.c_size_t(0)
+        address = self.lib.similarity_matrix_detach_data(matrix, ctypes.byref(size), ctypes.byref(stride))
+        return MatrixBuffer(self.lib, address, size.value, stride.value, filenames)
+    
+    def _matrix_result(self, matrix):
+        """Copy a C matrix into a dict and free it."""
+        with self._matrix_buffer(matrix) as buffer:
+            return {
+                "filenames": buffer.filenames,
+                "matrix": buffer.tolist()
+            }
+    
+    def process_directory(self, dir_path, progress=None, timeout=None):
+        context = self._context()
+        matrix = self._run_job(context, lambda: self.lib.sim_context_matrix_from_dir(
+            context.handle, dir_path.encode('utf-8')), progress, timeout)
+        matrix = self._check(context, matrix)
+        return self._matrix_result(matrix) if matrix else None
+    
+    def _run_job(self, context, compute, progress=None, timeout=None):
+        """Run compute() with a C job control attached to the context.
+        progress(dict) is called from this thread; returning False cancels the work.
+        Work still running after `timeout` seconds is cancelled at the next tile."""
+        if progress is None and timeout is None:
+            return compute()
         
-        if not collection:
+        deadline = time.monotonic() + timeout if timeout is not None else None
+        
+        def on_progress(info, _userdata):
+            if deadline is not None and time.monotonic() > deadline:
+                return False
+            if progress is None:
+                return True
+            p = info.contents
+            return progress({"stage": JOB_STAGES.get(p.stage, p.stage), "done": p.done,
+                             "total": p.total, "bytes": p.bytes}) is not False
+        
+        callback = JobProgressCallback(on_progress)
+        job = self.lib.job_control_create(callback, None)
+        if not job:
+            raise MemoryError("job_control_create failed")
+        self.lib.sim_context_set_job(context.handle, job)
+        try:
+            return compute()
+        finally:
+            self.lib.sim_context_set_job(context.handle, None)
+            self.lib.job_control_destroy(job)
+    
+    def _matrix_from_documents(self, documents, progress=None, timeout=None, weighting="raw"):
+        count = len(documents)
+        if count == 0:
             return None
-            
-        matrix = self.lib.similarity_matrix_create(collection)
         
-        result = {
-            "filenames": [],
-            "matrix": []
-        }
+        names = (ctypes.c_char_p * count)(*[name.encode('utf-8') for name, _ in documents])
+        buffers = (ctypes.c_char_p * count)(*[data for _, data in documents])
+        lengths = (ctypes.c_size_t * count)(*[len(data) for _, data in documents])
         
-        if matrix:
-            size = matrix.contents.size
-            # Read filenames
-            for i in range(size):
-                raw_name = matrix.contents.filenames[i]
-                try:
-                    # Try UTF-8 first
-                    decoded_name = raw_name.decode('utf-8')
-                except UnicodeDecodeError:
-                    try:
-                        # Fallback to GBK (common for Chinese Windows)
-                        decoded_name = raw_name.decode('gbk')
-                    except UnicodeDecodeError:
-                        # Fallback to system default or ignore errors
-                        decoded_name = raw_name.decode('mbcs', errors='replace') if os.name == 'nt' else raw_name.decode('utf-8', errors='replace')
-                
-                result["filenames"].append(decoded_name)
-            
-            # Read matrix
-            for i in range(size):
-                row = []
-                row_ptr = matrix.contents.matrix[i]
-                for j in range(size):
-                    row.append(row_ptr[j])
-                result["matrix"].append(row)
-                
+        # Only content the store has not seen yet is tokenized and scored
+        context = self._context(weighting)
+        self._local.timings = {}
+        matrix = self._timed("analysis", lambda: self._run_job(
+            context, lambda: self.lib.sim_context_matrix_from_buffers(
+                context.handle, names, buffers, lengths, count), progress, timeout))
+        return self._check(context, matrix)
+    
+    def _filenames(self, matrix):
+        return [decode_name(matrix.contents.filenames[i]) for i in range(matrix.contents.size)]
+    
+    def _edges_result(self, matrix, edges_ptr, key, extra):
+        """Column arrays of a C edge list. Cost is proportional to the number of edges."""
+        try:
+            if not edges_ptr:
+                return None
+            edges = edges_ptr.contents
+            count = edges.count
+            result = {"filenames": self._filenames(matrix)}
+            result.update(extra)
+            result[key] = {
+                "row": edges.rows[:count],
+                "col": edges.cols[:count],
+                # Same precision as the CSV output
+                "score": [round(s, 4) for s in edges.scores[:count]]
+            }
+            return result
+        finally:
+            if edges_ptr:
+                self.lib.similarity_edges_destroy(edges_ptr)
             self.lib.similarity_matrix_destroy(matrix)
-            
-        self.lib.collection_destroy(collection)
+    
+    def _top_k_result(self, matrix, k, min_score=0.0):
+        if k < 0:
+            raise ValueError("k must be non-negative")
+        edges = self.lib.similarity_matrix_top_k(matrix, k, min_score)
+        return self._edges_result(matrix, edges, "neighbors", {"k": k, "min_score": min_score})
+    
+    def _pairs_result(self, matrix, threshold):
+        edges = self.lib.similarity_matrix_pairs_above(matrix, threshold)
+        return self._edges_result(matrix, edges, "pairs", {"threshold": threshold})
+    
+    def _quantized_result(self, matrix, dtype, layout):
+        try:
+            layout_code = MATRIX_LAYOUT_UPPER if layout == "upper" else MATRIX_LAYOUT_FULL
+            size = ctypes.c_size_t(0)
+            address = self.lib.similarity_matrix_encode(matrix, MATRIX_DTYPE_CODES[dtype], layout_code,
+                                                        ctypes.byref(size))
+            if not address:
+                return None
+            try:
+                cells = ctypes.string_at(address, size.value)
+            finally:
+                self.lib.similarity_buffer_free(address)
+            header = {"filenames": self._filenames(matrix), "size": matrix.contents.size,
+                      "dtype": dtype, "layout": "upper" if layout_code == MATRIX_LAYOUT_UPPER else "full"}
+            return encode_quantized_payload(header, cells)
+        finally:
+            self.lib.similarity_matrix_destroy(matrix)
+    
+    def process_documents_top_k(self, documents, k, min_score=0.0, progress=None, timeout=None, weighting="raw"):
+        """The k most similar documents of every document, computed in C.
+        Returns {"filenames", "k", "neighbors": {"row", "col", "score"}}; row i's entries are
+        sorted by descending score."""
+        if k < 0:
+            raise ValueError("k must be non-negative")
+        matrix = self._matrix_from_documents(documents, progress, timeout, weighting)
+        return self._timed("copy", lambda: self._top_k_result(matrix, k, min_score)) if matrix else None
+    
+    def process_documents_pairs(self, documents, threshold, progress=None, timeout=None, weighting="raw"):
+        """Document pairs (row < col) with similarity >= threshold, computed in C.
+        Returns {"filenames", "threshold", "pairs": {"row", "col", "score"}}."""
+        matrix = self._matrix_from_documents(documents, progress, timeout, weighting)
+        return self._timed("copy", lambda: self._pairs_result(matrix, threshold)) if matrix else None
+    
+    def process_documents_quantized(self, documents, dtype="u8", layout="full", progress=None, timeout=None, weighting="raw"):
+        """Dense matrix as a compact binary payload (see encode_quantized_payload)."""
+        if dtype not in ("u8", "f16"):
+            raise ValueError(f"Unsupported dtype: {dtype}")
+        matrix = self._matrix_from_documents(documents, progress, timeout, weighting)
+        return self._timed("copy", lambda: self._quantized_result(matrix, dtype, layout)) if matrix else None
+    
+    def process_documents(self, documents, progress=None, timeout=None, weighting="raw"):
+        """Analyze in-memory documents given as (name, bytes) pairs, without touching the disk.
+        The bytes objects are passed to C by pointer; the library copies them while processing.
+        Optional progress callback / timeout in seconds: see _run_job. Cancelled work returns None
+        with last_error set. weighting: "raw" (cosine of term counts), "log", "tfidf" or "bm25";
+        weights are computed in C from the uploaded documents."""
+        matrix = self._matrix_from_documents(documents, progress, timeout, weighting)
+        return self._timed("copy", lambda: self._matrix_result(matrix)) if matrix else None
+    
+    def process_documents_buffer(self, documents, progress=None, timeout=None, weighting="raw"):
+        """Like process_documents, but returns a MatrixBuffer for zero-copy access
+        (memoryview() / numpy()). Call close() when done."""
+        matrix = self._matrix_from_documents(documents, progress, timeout, weighting)
+        return self._timed("copy", lambda: self._matrix_buffer(matrix)) if matrix else None
+    
+    # Background jobs: the upload is copied into the C job queue and computed by its worker pool
+    
+    def submit_job(self, documents):
+        """Queue (name, bytes) documents for background analysis.
+        Returns the job id, or None when the queue is full."""
+        count = len(documents)
+        if count == 0:
+            raise ValueError("No documents")
+        names = (ctypes.c_char_p * count)(*[name.encode('utf-8') for name, _ in documents])
+        buffers = (ctypes.c_char_p * count)(*[data for _, data in documents])
+        lengths = (ctypes.c_size_t * count)(*[len(data) for _, data in documents])
+        job_id = ctypes.c_uint64(0)
+        if not self.lib.job_queue_submit(self.jobs, names, buffers, lengths, count, ctypes.byref(job_id)):
+            return None
+        return job_id.value
+    
+    def job_status(self, job_id):
+        """{"id", "state", "progress", "documents", ...} or None for an unknown job."""
+        status = JobStatus()
+        if not self.lib.job_queue_status(self.jobs, job_id, ctypes.byref(status)):
+            return None
+        p = status.progress
+        result = {
+            "id": job_id,
+            "state": JOB_STATES.get(status.state, status.state),
+            "progress": {"stage": JOB_STAGES.get(p.stage, p.stage), "done": p.done,
+                         "total": p.total, "bytes": p.bytes},
+            "documents": status.documents,
+            "input_bytes": status.input_bytes,
+            "result_bytes": status.result_bytes
+        }
+        if result["state"] == "queued":
+            result["queue_position"] = status.queue_position
+        if status.error:
+            result["error"] = decode_name(status.error)
         return result
+    
+    def job_result(self, job_id, mode="dense", k=10, min_score=0.0, threshold=0.5, dtype="u8", layout="full"):
+        """Result of a finished job in one of the /analyze modes; None if not available."""
+        if mode not in ("dense", "topk", "threshold", "binary"):
+            raise ValueError(f"Unknown mode: {mode}")
+        if mode == "binary" and dtype not in ("u8", "f16"):
+            raise ValueError(f"Unsupported dtype: {dtype}")
+        if mode == "topk" and k < 0:
+            raise ValueError("k must be non-negative")
+        matrix = self.lib.job_queue_copy_result(self.jobs, job_id)
+        if not matrix:
+            return None
+        if mode == "topk":
+            return self._top_k_result(matrix, k, min_score)
+        if mode == "threshold":
+            return self._pairs_result(matrix, threshold)
+        if mode == "binary":
+            return self._quantized_result(matrix, dtype, layout)
+        return self._matrix_result(matrix)
+    
+    def cancel_job(self, job_id):
+        return self.lib.job_queue_cancel(self.jobs, job_id)
+    
+    def remove_job(self, job_id):
+        """Cancel if needed and forget the job and its result."""
+        return self.lib.job_queue_remove(self.jobs, job_id)
@@ -1,12 +1,288 @@
-import sys
+"""Load generator for the /analyze endpoint.
+
+Starts the Flask app locally in a subprocess (or targets a running server with --url), sends
+concurrent multipart uploads of synthetic documents and reports latency percentiles, throughput
+and the server-side phase breakdown taken from the Server-Timing header of each response:
+upload (multipart parsing), analysis (C tokenizing and scoring), copy (building the result from
+the C matrix) and json (response encoding). "other" is the rest of the client-observed latency:
+HTTP, Flask routing and the network.
+
+    python test_load.py --concurrency 8 --requests 200 --docs 20 --doc-bytes 4096
+    python test_load.py --url http://127.0.0.1:5000 --mode topk --duration 30 --json load.json
+
+Documents are unique per request by default, so every request is tokenized and scored;
+--repeat sends the same upload each time to measure the document store's cache hits.
+"""
+import argparse
+import http.client
+import json
+import math
 import os
-sys.path.append(os.getcwd())
-try:
-    from core_bridge import SimilarityEngine
-    print("Import successful")
-    engine = SimilarityEngine()
-    print("Engine created")
-except Exception as e:
-    print(f"Error: {e}")
-    import traceback
-    traceback.print_exc()
+import random
+import socket
+import subprocess
+import sys
+import threading
+import time
+import urllib.parse
+import uuid
+
+PHASES = ("upload", "analysis", "copy", "json")
+SYLLABLES = ("ka", "to", "ri", "ne", "mo", "sa", "lu", "pe", "di", "ga",
+             "ro", "vi", "an", "el", "ost", "ur", "bre", "cla", "fin", "gor")
+
+
+def make_vocabulary(size):
+    """Distinct pseudo-words; rank r is the bijective base-N spelling of r + 1."""
+    words = []
+    for rank in range(size):
+        n, parts = rank + 1, []
+        while n > 0:
+            n -= 1
+            parts.append(SYLLABLES[n % len(SYLLABLES)])
+            n //= len(SYLLABLES)
+        words.append("".join(parts))
+    return words
+
+
+class Corpus:
+    """Documents whose word ranks follow a Zipf distribution (weight 1/r)."""
+
+    def __init__(self, vocabulary=20000, exponent=1.0):
+        self.words = make_vocabulary(vocabulary)
+        total, self.cum_weights = 0.0, []
+        for rank in range(vocabulary):
+            total += 1.0 / (rank + 1) ** exponent
+            self.cum_weights.append(total)
+
+    def document(self, rng, size):
+        words, length = [], 0
+        while length < size:
+            batch = rng.choices(self.words, cum_weights=self.cum_weights, k=64)
+            words.extend(batch)
+            length += sum(len(w) + 1 for w in batch)
+        return " ".join(words)[:size].encode("utf-8")
+
+
+def encode_multipart(documents, fields):
+    """multipart/form-data body with one files[] part per (name, bytes) document."""
+    boundary = uuid.uuid4().hex
+    parts = []
+    for name, value in fields.items():
+        parts.append(f'--{boundary}\r\nContent-Disposition: form-data; name="{name}"\r\n\r\n'
+                     f'{value}\r\n'.encode("utf-8"))
+    for name, data in documents:
+        parts.append(f'--{boundary}\r\nContent-Disposition: form-data; name="files[]"; '
+                     f'filename="{name}"\r\nContent-Type: text/plain\r\n\r\n'.encode("utf-8"))
+        parts.append(data)
+        parts.append(b"\r\n")
+    parts.append(f"--{boundary}--\r\n".encode("utf-8"))
+    return b"".join(parts), f"multipart/form-data; boundary={boundary}"
+
+
+def parse_server_timing(header):
+    """{"name": seconds} from a Server-Timing header such as "upload;dur=1.5, analysis;dur=20"."""
+    timings = {}
+    for entry in (header or "").split(","):
+        name, _, params = entry.strip().partition(";")
+        for param in params.split(";"):
+            key, _, value = param.strip().partition("=")
+            if key == "dur" and name:
+                try:
+                    timings[name] = float(value) / 1000.0
+                except ValueError:
+                    pass
+    return timings
+
+
+def percentile(sorted_values, p):
+    """Nearest-rank percentile of an ascending list."""
+    if not sorted_values:
+        return 0.0
+    index = math.ceil(p / 100.0 * len(sorted_values)) - 1
+    return sorted_values[max(0, min(len(sorted_values) - 1, index))]
+
+
+def summarize(values):
+    values = sorted(values)
+    if not values:
+        return {"mean": 0.0, "p50": 0.0, "p95": 0.0, "p99": 0.0, "max": 0.0}
+    return {"mean": sum(values) / len(values), "p50": percentile(values, 50),
+            "p95": percentile(values, 95), "p99": percentile(values, 99), "max": values[-1]}
+
+
+class LoadRunner:
+    def __init__(self, url, payloads, concurrency, requests, duration):
+        parsed = urllib.parse.urlsplit(url)
+        self.host = parsed.hostname
+        self.port = parsed.port or 80
+        self.path = (parsed.path.rstrip("/") or "") + "/analyze"
+        self.payloads = payloads
+        self.concurrency = concurrency
+        self.requests = requests
+        self.duration = duration
+        self.lock = threading.Lock()
+        self.issued = 0
+        self.samples = []
+        self.errors = {}
+
+    def _next_index(self, deadline):
+        with self.lock:
+            if self.requests and self.issued >= self.requests:
+                return None
+            if deadline and time.perf_counter() >= deadline:
+                return None
+            index = self.issued
+            self.issued += 1
+            return index
+
+    def _worker(self, deadline):
+        conn = http.client.HTTPConnection(self.host, self.port, timeout=300)
+        while True:
+            index = self._next_index(deadline)
+            if index is None:
+                break
+            body, content_type = self.payloads[index % len(self.payloads)]
+            start = time.perf_counter()
+            try:
+                conn.request("POST", self.path, body=body, headers={"Content-Type": content_type})
+                response = conn.getresponse()
+                data = response.read()
+                status, timing = response.status, response.getheader("Server-Timing")
+            except (OSError, http.client.HTTPException) as e:
+                conn.close()
+                conn = http.client.HTTPConnection(self.host, self.port, timeout=300)
+                status, data, timing = type(e).__name__, b"", None
+            latency = time.perf_counter() - start
+            with self.lock:
+                if status == 200:
+                    self.samples.append((latency, len(body), len(data), parse_server_timing(timing)))
+                else:
+                    self.errors[str(status)] = self.errors.get(str(status), 0) + 1
+        conn.close()
+
+    def run(self):
+        start = time.perf_counter()
+        deadline = start + self.duration if self.duration else None
+        threads = [threading.Thread(target=self._worker, args=(deadline,)) for _ in range(self.concurrency)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        return time.perf_counter() - start
+
+    def report(self, elapsed):
+        latencies = [s[0] for s in self.samples]
+        phases = {}
+        for phase in PHASES:
+            values = [s[3][phase] for s in self.samples if phase in s[3]]
+            if values:
+                phases[phase] = summarize(values)
+        phases["other"] = summarize([s[0] - sum(s[3].get(p, 0.0) for p in PHASES) for s in self.samples])
+        return {
+            "requests": len(self.samples),
+            "errors": self.errors,
+            "elapsed": elapsed,
+            "throughput_rps": len(self.samples) / elapsed if elapsed > 0 else 0.0,
+            "upload_mbps": sum(s[1] for s in self.samples) / elapsed / 1e6 if elapsed > 0 else 0.0,
+            "latency": summarize(latencies),
+            "phases": phases,
+        }
+
+
+def print_report(report, config):
+    print(f"\n{config['concurrency']} concurrent clients, {config['docs']} docs x "
+          f"{config['doc_bytes']} bytes per request, mode={config['mode']}")
+    print(f"requests: {report['requests']} ok, errors: {report['errors'] or 'none'}, "
+          f"elapsed {report['elapsed']:.2f}s")
+    print(f"throughput: {report['throughput_rps']:.2f} req/s, upload {report['upload_mbps']:.2f} MB/s")
+    print(f"\n{'':<10}{'mean':>10}{'p50':>10}{'p95':>10}{'p99':>10}{'max':>10}  (ms)")
+    rows = [("latency", report["latency"])] + list(report["phases"].items())
+    for name, stats in rows:
+        print(f"{name:<10}" + "".join(f"{stats[k] * 1000:>10.2f}" for k in ("mean", "p50", "p95", "p99", "max")))
+
+
+def wait_for_server(host, port, process, timeout=30.0):
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        if process.poll() is not None:
+            raise RuntimeError("Flask app exited during startup")
+        try:
+            with socket.create_connection((host, port), timeout=1.0):
+                return
+        except OSError:
+            time.sleep(0.2)
+    raise RuntimeError(f"Flask app did not start listening on {host}:{port}")
+
+
+def start_local_app(port):
+    """Run app.py's Flask app without the debug reloader, one thread per request."""
+    web_dir = os.path.dirname(os.path.abspath(__file__))
+    code = f"from app import app; app.run(host='127.0.0.1', port={port}, threaded=True)"
+    process = subprocess.Popen([sys.executable, "-c", code], cwd=web_dir,
+                               stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    try:
+        wait_for_server("127.0.0.1", port, process)
+    except RuntimeError:
+        process.kill()
+        raise
+    return process
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Load test for POST /analyze")
+    parser.add_argument("--url", help="target a running server instead of starting app.py")
+    parser.add_argument("--port", type=int, default=5057, help="port for the local app")
+    parser.add_argument("--concurrency", type=int, default=4)
+    parser.add_argument("--requests", type=int, default=100, help="total requests (0: use --duration)")
+    parser.add_argument("--duration", type=float, default=0, help="seconds to run when --requests is 0")
+    parser.add_argument("--docs", type=int, default=20, help="documents per request")
+    parser.add_argument("--doc-bytes", type=int, default=4096, help="bytes per document")
+    parser.add_argument("--vocabulary", type=int, default=20000)
+    parser.add_argument("--mode", default="dense", choices=("dense", "topk", "threshold", "binary"))
+    parser.add_argument("--repeat", action="store_true", help="send the same upload every time")
+    parser.add_argument("--payloads", type=int, default=0,
+                        help="distinct uploads to pre-generate (default: one per request, at most 1000)")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--json", help="write the report as JSON")
+    args = parser.parse_args()
+
+    if args.requests <= 0 and args.duration <= 0:
+        parser.error("set --requests or --duration")
+
+    # Uploads are generated up front so the client does not compete with the server for CPU
+    corpus = Corpus(args.vocabulary)
+    count = 1 if args.repeat else (args.payloads or min(args.requests or 1000, 1000))
+    fields = {"mode": args.mode}
+    payloads = []
+    for p in range(count):
+        rng = random.Random(args.seed * 1000003 + p)
+        documents = [(f"req{p:04d}_doc{d:04d}.txt", corpus.document(rng, args.doc_bytes))
+                     for d in range(args.docs)]
+        payloads.append(encode_multipart(documents, fields))
+
+    process = None
+    url = args.url
+    if not url:
+        process = start_local_app(args.port)
+        url = f"http://127.0.0.1:{args.port}"
+    try:
+        runner = LoadRunner(url, payloads, args.concurrency, args.requests, args.duration)
+        report = runner.report(runner.run())
+    finally:
+        if process:
+            process.terminate()
+            process.wait()
+
+    config = {"concurrency": args.concurrency, "docs": args.docs, "doc_bytes": args.doc_bytes,
+              "mode": args.mode, "repeat": args.repeat}
+    print_report(report, config)
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump({"config": config, "report": report}, f, indent=2)
+        print(f"\nreport written to {args.json}")
+    return 0 if report["requests"] > 0 and not report["errors"] else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())